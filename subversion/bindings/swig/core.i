@@ -655,6 +655,7 @@ typedef int apr_status_t;
 */
 %rename (svn_pool_create) svn_pool_create_ex;
 %ignore svn_pool_create_ex_debug;
+%ignore svn_pool__clear;
 %typemap(default) apr_allocator_t *allocator {
     $1 = NULL;
 }
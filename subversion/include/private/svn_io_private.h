@@ -85,6 +85,96 @@ svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
 
+/** Copy all data from the current position of @a from_file to the end of
+ * that file to the current position of @a to_file without moving it
+ * through user-space buffers, e.g. using copy_file_range() or sendfile().
+ * Afterwards, both file positions will be just behind the data that has
+ * been copied.
+ *
+ * Set @a *copied to TRUE if the data has been copied completely.  If the
+ * platform, the kernel or the kind of files involved don't support that,
+ * set @a *copied to FALSE and leave the remaining data for the caller to
+ * copy the usual way.
+ *
+ * Call @a cancel_func with @a cancel_baton, if not NULL, between chunks.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_copy_in_kernel(svn_boolean_t *copied,
+                            apr_file_t *from_file,
+                            apr_file_t *to_file,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool);
+
+/** A batch of file system requests that may be executed concurrently.
+ *
+ * Callers add any number of independent read and stat requests and then
+ * run them all at once.  On Linux, the batch hands them to the kernel
+ * through io_uring, keeping many requests in flight.  Elsewhere, or if
+ * the running kernel does not support io_uring or its STATX operation,
+ * the requests are simply executed one after another when the batch is
+ * run.
+ */
+typedef struct svn_io__batch_t svn_io__batch_t;
+
+/** Create a new, empty request batch in @a result_pool and return it in
+ * @a *batch.  At most @a depth requests will be in flight at any time.
+ * When @a result_pool is cleaned up, the batch's kernel resources are
+ * kept in a process-wide cache, so later batches of the same @a depth
+ * can reuse them instead of setting up new ones.
+ */
+svn_error_t *
+svn_io__batch_create(svn_io__batch_t **batch,
+                     int depth,
+                     apr_pool_t *result_pool);
+
+/** Return TRUE if @a batch executes its requests asynchronously, i.e. if
+ * batching requests is worth the effort.
+ */
+svn_boolean_t
+svn_io__batch_is_async(svn_io__batch_t *batch);
+
+/** Return the number of requests added to @a batch since it was run last.
+ */
+int
+svn_io__batch_size(svn_io__batch_t *batch);
+
+/** Add a request to @a batch to read up to @a size bytes from @a file at
+ * @a offset into @a buffer.  The number of bytes read, which is less than
+ * @a size only if the end of the file was hit, will be returned in
+ * @a *bytes_read.  @a file must not have buffered data pending to be
+ * written and its position is undefined after the batch has been run.
+ *
+ * @a buffer and @a bytes_read must remain valid until the batch has run.
+ */
+svn_error_t *
+svn_io__batch_read(svn_io__batch_t *batch,
+                   apr_file_t *file,
+                   apr_off_t offset,
+                   void *buffer,
+                   apr_size_t size,
+                   apr_size_t *bytes_read);
+
+/** Add a request to @a batch to fill @a *dirent with information about
+ * the node at @a path, not following symlinks, like svn_io_stat_dirent2()
+ * with @a ignore_enoent set would do.
+ *
+ * @a dirent must remain valid until the batch has run.
+ */
+svn_error_t *
+svn_io__batch_stat(svn_io__batch_t *batch,
+                   svn_io_dirent2_t *dirent,
+                   const char *path);
+
+/** Execute all requests added to @a batch since it was run last and
+ * wait for them to complete.  Return the first error, if any.  @a batch
+ * may be reused afterwards.  Use @a scratch_pool for temporaries.
+ */
+svn_error_t *
+svn_io__batch_run(svn_io__batch_t *batch,
+                  apr_pool_t *scratch_pool);
+
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
  */
@@ -135,6 +225,41 @@ svn_stream__from_aprfile(apr_file_t *file,
                          svn_boolean_t truncate_on_seek,
                          apr_pool_t *pool);
 
+/* Return in *STREAM a readable stream that delivers the contents of
+   SOURCE.  A separate thread reads SOURCE ahead of the caller, buffering
+   up to MAX_BUFFERED bytes (0 selects a default).  SOURCE must not be
+   used by the caller anymore.  Errors reading SOURCE will be reported
+   after all data read before them has been delivered.  Closing *STREAM
+   closes SOURCE.
+
+   The thread terminates when *STREAM gets closed or RESULT_POOL gets
+   cleaned up.  That waits for any pending read from SOURCE to return.
+   Without thread support, *STREAM will simply be SOURCE.
+ */
+svn_error_t *
+svn_stream__create_read_ahead(svn_stream_t **stream,
+                              svn_stream_t *source,
+                              apr_size_t max_buffered,
+                              apr_pool_t *result_pool);
+
+/* Return in *STREAM a writable stream that forwards all data to TARGET.
+   A separate thread does the writing to TARGET, so the caller only
+   blocks when more than MAX_BUFFERED bytes (0 selects a default) are
+   pending.  TARGET must not be used by the caller anymore.  The first
+   error reported by TARGET will be returned by a later write to *STREAM
+   or, at the latest, by closing it.  Closing *STREAM waits for all data
+   to be written and closes TARGET.
+
+   Pools used by TARGET will be accessed from the writer thread.  The
+   caller must not use them until *STREAM has been closed.  Without
+   thread support, *STREAM will simply be TARGET.
+ */
+svn_error_t *
+svn_stream__create_async_writer(svn_stream_t **stream,
+                                svn_stream_t *target,
+                                apr_size_t max_buffered,
+                                apr_pool_t *result_pool);
+
 #if defined(WIN32)
 
 /* ### Move to something like io.h or subr.h, to avoid making it
@@ -865,6 +865,21 @@ svn_ra_svn__write_cmd_get_file_revs(svn_ra_svn_conn_t *conn,
                                     svn_revnum_t end,
                                     svn_boolean_t include_merged_revisions);
 
+/** Send a "get-blame" command over connection @a conn.
+ * @a ignore_space is one of the words "none", "change" and "all".
+ * Use @a pool for allocations.
+ *
+ * @see #svn_ra_get_blame for a description.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_get_blame(svn_ra_svn_conn_t *conn,
+                                apr_pool_t *pool,
+                                const char *path,
+                                svn_revnum_t start,
+                                svn_revnum_t end,
+                                const char *ignore_space,
+                                svn_boolean_t ignore_eol_style);
+
 /** Send a "lock" command over connection @a conn.
  * Use @a pool for allocations.
  *
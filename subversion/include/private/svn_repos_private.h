@@ -122,6 +122,58 @@ const char *
 svn_repos__post_commit_error_str(svn_error_t *err,
                                  apr_pool_t *pool);
 
+/* Baton for svn_repos__authz_read_func(). */
+typedef struct svn_repos__authz_read_baton_t
+{
+  /* The rules to check, the name of the repository in there and the user
+   * to check for, as passed to svn_repos_authz_check_access(). */
+  svn_authz_t *authz;
+  const char *repos_name;
+  const char *user;
+
+  /* If not NULL, called with DENIED_BATON for every path to which read
+   * access has been denied. */
+  svn_error_t *(*denied_func)(const char *path,
+                              void *denied_baton,
+                              apr_pool_t *scratch_pool);
+  void *denied_baton;
+} svn_repos__authz_read_baton_t;
+
+/* Implements svn_repos_authz_func_t for the svn_repos__authz_read_baton_t
+ * BATON.  Paths not starting with '/' get canonicalized first.
+ *
+ * The repository functions that check many directory entries recognize
+ * this callback and check all entries of a directory at once with
+ * svn_repos_authz_check_children().  Servers should pass it instead of
+ * their own wrappers around svn_repos_authz_check_access().
+ */
+svn_error_t *
+svn_repos__authz_read_func(svn_boolean_t *allowed,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           void *baton,
+                           apr_pool_t *pool);
+
+/* Set *READABLE to an array of svn_boolean_t telling for each of the
+ * CHILD_NAMES (const char * path segments) of PARENT_PATH in ROOT whether
+ * AUTHZ_READ_FUNC with AUTHZ_READ_BATON grants read access to it.  If
+ * AUTHZ_READ_FUNC is svn_repos__authz_read_func(), check all children in
+ * a single svn_repos_authz_check_children() call.  Otherwise, call
+ * AUTHZ_READ_FUNC for each child.  AUTHZ_READ_FUNC must not be NULL.
+ *
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_repos__authz_read_children(apr_array_header_t **readable,
+                               svn_fs_root_t *root,
+                               const char *parent_path,
+                               const apr_array_header_t *child_names,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* A repos version of svn_fs_type */
 svn_error_t *
 svn_repos__fs_type(const char **fs_type,
@@ -350,6 +402,19 @@ svn_repos__dump_node_record(svn_stream_t *dump_stream,
                             svn_boolean_t content_length_always,
                             apr_pool_t *scratch_pool);
 
+/* Set *STREAM to a writable stream that stores the dump data written to
+ * it in block-compressed form in TARGET.  Every block gets compressed and
+ * checksummed independently and records which revisions start within it.
+ * svn_repos_parse_dumpstream3() and the functions based on it read such
+ * streams just like plain dump streams.
+ *
+ * Closing *STREAM writes the final block and closes TARGET.
+ */
+svn_error_t *
+svn_repos__dump_compress(svn_stream_t **stream,
+                         svn_stream_t *target,
+                         apr_pool_t *result_pool);
+
 /**
  * Get a dump editor @a editor along with a @a edit_baton allocated in
  * @a pool.  The editor will write output to @a stream.
@@ -359,10 +424,10 @@ svn_repos__dump_node_record(svn_stream_t *dump_stream,
  * if a replay-style drive will instead be used, it should be passed
  * as @c NULL.
  *
- * In contrast to the dump editor used inside svn_repos_dump_fs4(), this
+ * In contrast to the dump editor used inside svn_repos_dump_fs5(), this
  * one supports only deltas mode.
  *
- * ### TODO: Unify with the dump editor inside svn_repos_dump_fs4().
+ * ### TODO: Unify with the dump editor inside svn_repos_dump_fs5().
  */
 svn_error_t *
 svn_repos__get_dump_editor(const svn_delta_editor_t **editor,
@@ -0,0 +1,101 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_simd_private.h
+ * @brief Helpers for vectorized string processing - Internal routines
+ */
+
+#ifndef SVN_SIMD_PRIVATE_H
+#define SVN_SIMD_PRIVATE_H
+
+#include <apr.h>
+
+#include "svn_types.h"
+
+/* SSE2 is part of the x86-64 baseline, so it can be used without any
+ * runtime detection whenever the compiler targets it.  Define
+ * SVN_DISABLE_SIMD to fall back to the portable code paths, e.g. to
+ * compare results and performance.
+ */
+#if !defined(SVN_DISABLE_SIMD) \
+    && (defined(__SSE2__) || defined(_M_X64) \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define SVN__HAVE_SSE2 1
+#  include <emmintrin.h>
+#else
+#  define SVN__HAVE_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Return the index of the lowest bit set in the non-zero MASK.
+ * This is typically used to find the first matching byte in the result
+ * of a vector compare.
+ */
+static APR_INLINE unsigned int
+svn__lowest_bit_index(apr_uint32_t mask)
+{
+#if defined(__GNUC__)
+  return (unsigned int)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (unsigned int)index;
+#else
+  unsigned int index = 0;
+  while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      ++index;
+    }
+  return index;
+#endif
+}
+
+/* Return the number of bits set in MASK.
+ * This is typically used to count matching bytes in the result of a
+ * vector compare.
+ */
+static APR_INLINE unsigned int
+svn__bit_count(apr_uint32_t mask)
+{
+#if defined(__GNUC__)
+  return (unsigned int)__builtin_popcount(mask);
+#else
+  mask = mask - ((mask >> 1) & 0x55555555);
+  mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+  mask = (mask + (mask >> 4)) & 0x0f0f0f0f;
+  return (unsigned int)((mask * 0x01010101) >> 24);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_SIMD_PRIVATE_H */
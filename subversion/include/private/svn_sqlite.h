@@ -105,6 +105,23 @@ svn_sqlite__read_schema_version(int *version,
 
 
 
+/* Optional connection tuning parameters for svn_sqlite__open(). */
+typedef struct svn_sqlite__tuning_t
+{
+  /* Use write-ahead logging instead of a truncated rollback journal.
+     This allows readers to proceed while a writer is active but requires
+     shared memory support and will not work on network file systems. */
+  svn_boolean_t wal;
+
+  /* Maximum number of bytes of the database file to access through
+     memory-mapped I/O.  Values <= 0 keep the SQLite default. */
+  apr_int64_t mmap_size;
+
+  /* Size of the per-connection page cache in bytes.  Values <= 0 keep
+     the SQLite default. */
+  apr_int64_t cache_size;
+} svn_sqlite__tuning_t;
+
 /* Open a connection in *DB to the database at PATH. Validate the schema,
    creating/upgrading to LATEST_SCHEMA if needed using the instructions
    in UPGRADE_SQL. The resulting DB is allocated in RESULT_POOL, and any
@@ -120,6 +137,8 @@ svn_sqlite__read_schema_version(int *version,
    TIMEOUT defines the SQLite busy timeout, values <= 0 cause a Subversion
    default to be used.
 
+   TUNING may be NULL, in which case the Subversion defaults will be used.
+
    The statements will be finalized and the SQLite database will be closed
    when RESULT_POOL is cleaned up. */
 svn_error_t *
@@ -127,6 +146,7 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  svn_sqlite__mode_t mode, const char * const statements[],
                  int latest_schema, const char * const *upgrade_sql,
                  apr_int32_t timeout,
+                 const svn_sqlite__tuning_t *tuning,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
 
 /* Explicitly close the connection in DB. */
@@ -359,6 +379,35 @@ svn_sqlite__column_bytes(svn_sqlite__stmt_t *stmt, int column);
 void
 svn_sqlite__dbg_enable_errorlog(void);
 
+/* Name of the environment variable enabling statement profiling in our
+   command line tools.  Its value is the file to append the report to.
+   An empty value or "-" selects stderr. */
+#define SVN_SQLITE__PROFILE_ENV "SVN_SQLITE_PROFILE"
+
+/* If the environment variable SVN_SQLITE__PROFILE_ENV is set, start
+   statement profiling and arrange for a report to be written at exit.
+   PROGNAME is used to label the report. */
+void
+svn_sqlite__profile_init(const char *progname);
+
+/* Unconditionally start statement profiling.  Only connections opened
+   after this call will be tracked. */
+void
+svn_sqlite__profile_start(void);
+
+/* Write the statement profile to STREAM.  Statements are identified by
+   the database file name and their index in the STATEMENTS array passed
+   to svn_sqlite__open(), i.e. the STMT_* constants generated from
+   wc-queries.sql, rep-cache-db.sql etc.  For each statement, report the
+   number of executions, steps and result rows, the number of full table
+   scan steps and sort operations, and the total and maximum execution
+   time.
+
+   Statistics are collected per connection and are only included once
+   that connection has been closed. */
+void
+svn_sqlite__profile_report(FILE *stream);
+
 
 /* --------------------------------------------------------------------- */
 
@@ -104,6 +104,42 @@ svn_spillbuf__create_extended(apr_size_t blocksize,
                               const char* dirpath,
                               apr_pool_t *result_pool);
 
+/* Create a spill buffer like svn_spillbuf__create() does, but write
+   spilled content from a background thread and read it back through
+   memory mapping.  Writing to the buffer only blocks if the disk can't
+   keep up with the data rate.
+
+   On platforms without threads or memory mapping, this is the same as
+   svn_spillbuf__create().  */
+svn_spillbuf_t *
+svn_spillbuf__create_async(apr_size_t blocksize,
+                           apr_size_t maxsize,
+                           apr_pool_t *result_pool);
+
+/* Usage statistics of a spill buffer.  */
+typedef struct svn_spillbuf_stats_t
+{
+  /* Number of memory blocks allocated so far.  */
+  apr_size_t blocks_allocated;
+
+  /* Maximum amount of content cached in memory at any time.  */
+  apr_size_t memory_peak;
+
+  /* Number of spill files created and total amount of content written
+     to them.  */
+  apr_size_t spill_files;
+  svn_filesize_t spilled;
+
+  /* Number of times that a write had to wait for the background writer
+     to catch up.  */
+  apr_size_t write_waits;
+} svn_spillbuf_stats_t;
+
+/* Return the usage statistics of BUF in *STATS.  */
+void
+svn_spillbuf__get_stats(svn_spillbuf_stats_t *stats,
+                        const svn_spillbuf_t *buf);
+
 /* Determine how much content is stored in the spill buffer.  */
 svn_filesize_t
 svn_spillbuf__get_size(const svn_spillbuf_t *buf);
@@ -118,7 +154,9 @@ const char *
 svn_spillbuf__get_filename(const svn_spillbuf_t *buf);
 
 /* Retrieve the handle of the spill file. The returned value will be
-   NULL if the file has not been created yet. */
+   NULL if the file has not been created yet.  For buffers created by
+   svn_spillbuf__create_async(), the file may lack recently written
+   content. */
 apr_file_t *
 svn_spillbuf__get_file(const svn_spillbuf_t *buf);
 
@@ -268,6 +306,52 @@ svn_checksum_t *
 svn_checksum__from_digest_fnv1a_32x4(const unsigned char *digest,
                                      apr_pool_t *result_pool);
 
+/**
+ * Return a checksum context, allocated in @a pool, that calculates the
+ * checksums of all @a count kinds given in @a kinds in a single pass over
+ * the data.  Use it with svn_checksum_update() and svn_checksum_ctx_reset()
+ * like any other context.  svn_checksum_final() returns the checksum of
+ * the first kind; use svn_checksum__final_kind() to get the others.
+ *
+ * @since New in 1.12
+ */
+svn_checksum_ctx_t *
+svn_checksum__ctx_create_multi(const svn_checksum_kind_t *kinds,
+                               int count,
+                               apr_pool_t *pool);
+
+/**
+ * Like svn_checksum_final() but return the checksum of the given @a kind,
+ * which must be one of the kinds calculated by @a ctx.  Each kind may be
+ * finalized only once.
+ *
+ * @since New in 1.12
+ */
+svn_error_t *
+svn_checksum__final_kind(svn_checksum_t **checksum,
+                         const svn_checksum_ctx_t *ctx,
+                         svn_checksum_kind_t kind,
+                         apr_pool_t *pool);
+
+/**
+ * Like svn_stream_checksummed2() but calculate the checksums of all
+ * @a count kinds in @a kinds in a single pass over the data.  For every
+ * kind <tt>kinds[i]</tt>, set <tt>*read_checksums[i]</tt> and
+ * <tt>*write_checksums[i]</tt> when the returned stream gets closed.
+ * Either array as well as any of their elements may be NULL, in which
+ * case the respective checksum will not be calculated.
+ *
+ * @since New in 1.12
+ */
+svn_stream_t *
+svn_stream__checksummed_multi(svn_stream_t *stream,
+                              svn_checksum_t **read_checksums[],
+                              svn_checksum_t **write_checksums[],
+                              const svn_checksum_kind_t *kinds,
+                              int count,
+                              svn_boolean_t read_all,
+                              apr_pool_t *pool);
+
 
 /**
  * Return a stream that calculates a checksum of type @a kind over all
@@ -430,6 +514,72 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
 
 /** @} */
 
+/**
+ * @defgroup svn_proplist Random-access binary property lists
+ * @{
+ */
+
+/* Besides the "K n / V n / END" hash dump format written by
+ * svn_hash_write2(), property lists may be serialized into a compact
+ * binary format that allows for looking up individual properties without
+ * parsing the whole list.  It consists of a small header, a table of
+ * fixed-size entries sorted by property name and the NUL-terminated names
+ * and values.  The serialized data contains no pointers and may be copied
+ * or stored as a whole, e.g. in caches or as part of larger serialized
+ * structures.  All readers below accept either format.
+ */
+
+/** Serialize the property list @a props (mapping const char * names to
+ * svn_string_t * values) into the binary format and return it in
+ * @a *serialized, allocated in @a pool.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_proplist__create(svn_stringbuf_t **serialized,
+                     apr_hash_t *props,
+                     apr_pool_t *pool);
+
+/** Return TRUE if the @a len bytes at @a data are a property list in
+ * binary format and FALSE, if they should be a hash dump.
+ *
+ * @since New in 1.12.
+ */
+svn_boolean_t
+svn_proplist__is_binary(const void *data,
+                        apr_size_t len);
+
+/** Set @a *value to the value of property @a name in the serialized
+ * property list of @a len bytes at @a data, allocated in @a result_pool.
+ * Set it to NULL if there is no such property.  @a data may be in either
+ * serialization format.  Only the parts of @a data that are required to
+ * find @a name will be parsed; in binary format, this is O(log n).
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_proplist__get(svn_string_t **value,
+                  const void *data,
+                  apr_size_t len,
+                  const char *name,
+                  apr_pool_t *result_pool);
+
+/** Parse the serialized property list of @a len bytes at @a data into
+ * a new hash in @a *props, allocated in @a pool.  @a data may be in either
+ * serialization format.  For the binary format, the names and values in
+ * @a *props will point into @a data instead of being copied, i.e. @a data
+ * must remain valid at least as long as @a *props.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_proplist__parse(apr_hash_t **props,
+                    const void *data,
+                    apr_size_t len,
+                    apr_pool_t *pool);
+
+/** @} */
+
 /** @} */
 
 
@@ -555,6 +705,34 @@ svn__decode_int(apr_int64_t *val,
                 const unsigned char *p,
                 const unsigned char *end);
 
+/* Encode the COUNT integers in VALUES into the buffer P using the
+ * little-endian variant of the 7b/8b format, i.e. the lowest-order data
+ * bits come first ("LEB128").  This is the format used by packed data
+ * containers and the FSFS / FSX indexes; it is incompatible with
+ * svn__encode_uint.  P must provide SVN__MAX_ENCODED_UINT_LEN bytes per
+ * value.  Return the position behind the last byte written.
+ */
+unsigned char *
+svn__leb128_encode(unsigned char *p,
+                   const apr_uint64_t *values,
+                   apr_size_t count);
+
+/* Decode up to *COUNT integers encoded by svn__leb128_encode from the
+ * range [P..END-1] into VALUES.  If ENDS is not NULL, store the offset
+ * behind each value, relative to P, in the respective element.  Stop
+ * early at the first incomplete value and set *COUNT to the number of
+ * values actually decoded.  Return the position behind the last decoded
+ * value.  If a value is longer than SVN__MAX_ENCODED_UINT_LEN bytes,
+ * return NULL and set *COUNT to the number of values preceding it.
+ * Values exceeding 64 bits are silently truncated.
+ */
+const unsigned char *
+svn__leb128_decode(apr_uint64_t *values,
+                   apr_size_t *ends,
+                   apr_size_t *count,
+                   const unsigned char *p,
+                   const unsigned char *end);
+
 /* Compress the data from DATA with length LEN, it according to the
  * specified COMPRESSION_METHOD and write the result to OUT.
  * SVN__COMPRESSION_NONE is valid for COMPRESSION_METHOD.
@@ -626,6 +804,52 @@ svn_root_pools__release_pool(apr_pool_t *pool,
 
 /** @} */
 
+/**
+ * @defgroup svn_pool_profile Pool allocation profiling
+ * @{
+ */
+
+/* Name of the environment variable enabling pool allocation profiling
+ * in our command line tools.  Its value is the file to append the report
+ * to.  An empty value or "-" selects stderr.
+ */
+#define SVN_POOL__PROFILE_ENV "SVN_POOL_PROFILE"
+
+/* If the environment variable SVN_POOL__PROFILE_ENV is set, start pool
+ * allocation profiling and arrange for a report to be written at exit
+ * and, where supported, whenever the process receives SIGUSR1.
+ * PROGNAME identifies the process in the report.  Call this only once,
+ * before any other threads have been started.
+ */
+void
+svn_pool__profile_init(const char *progname);
+
+/* Unconditionally start pool allocation profiling.  Only pools created
+ * after this call will be tracked.  Call this before any other threads
+ * have been started.
+ */
+void
+svn_pool__profile_start(void);
+
+/* Write the current pool allocation profile to STREAM.  Pools are grouped
+ * by the source location that created them.  For each location, report
+ * the number of pools created, the number of pools currently alive and
+ * their maximum, the number of cycles (periods between creation, clears
+ * and destruction), the total and maximum lifetime of a cycle and the
+ * total and peak number of bytes allocated during a cycle.  Clears are
+ * seen through svn_pool_clear(); a direct apr_pool_clear() ends the
+ * tracking of a pool as if it had been destroyed.
+ *
+ * Unless APR has been compiled with pool debugging, the latter two are
+ * the growth of the global process heap during each cycle, i.e. they will
+ * include allocations made elsewhere at the same time, and the report
+ * labels them as such.  Where even that is not available, they will be 0.
+ */
+void
+svn_pool__profile_report(FILE *stream);
+
+/** @} */
+
 /**
  * @defgroup svn_config_private Private configuration handling API
  * @{
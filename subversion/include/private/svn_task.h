@@ -0,0 +1,158 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_task.h
+ * @brief ordered task queue with concurrent processing
+ *
+ * A task queue lets the caller split a sequential job into independent
+ * tasks.  Every task consists of a PROCESS step and an OUTPUT step.  The
+ * PROCESS steps may run concurrently in a set of worker threads owned by
+ * the queue.  The OUTPUT steps are always executed by the thread that
+ * owns the queue and strictly in the order in which the tasks have been
+ * added.  Hence, the observable result is the same as if all tasks had
+ * been run sequentially.
+ *
+ * The number of tasks that have been added but not been output yet is
+ * limited, i.e. the queue provides back-pressure and the memory used by
+ * in-flight tasks is bounded.
+ *
+ * If APR does not support threads or only a single thread has been
+ * requested, the queue degenerates to running each task synchronously
+ * within svn_task__queue_add().
+ */
+
+
+
+#ifndef SVN_TASK_H
+#define SVN_TASK_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+
+/* The opaque task queue type. */
+typedef struct svn_task__queue_t svn_task__queue_t;
+
+/* Callback executing the potentially expensive part of a task.  It may
+ * be called from an arbitrary thread and must therefore only access data
+ * that is private to the task or that is read-only while the queue is
+ * active.  In particular, the cancellation function of the caller should
+ * not be used here.
+ *
+ * TASK_BATON is the baton passed to svn_task__queue_add().  Return the
+ * processing result in *RESULT, allocated in RESULT_POOL.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+typedef svn_error_t *
+(*svn_task__process_func_t)(void **result,
+                            void *task_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Callback consuming the RESULT of the process step of the task given by
+ * TASK_BATON.  It will be called from the thread owning the queue, in task
+ * submission order, and only if the process step succeeded.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+typedef svn_error_t *
+(*svn_task__output_func_t)(void *result,
+                           void *task_baton,
+                           apr_pool_t *scratch_pool);
+
+/* Create a new task queue in *QUEUE, allocated in RESULT_POOL, using up
+ * to THREAD_COUNT worker threads.  At most MAX_PENDING tasks may be in
+ * flight at any time; a value <= 0 selects a default based on
+ * THREAD_COUNT.
+ *
+ * Any tasks not output when RESULT_POOL gets cleaned up will be discarded
+ * after their process step has completed.
+ */
+svn_error_t *
+svn_task__queue_create(svn_task__queue_t **queue,
+                       int thread_count,
+                       int max_pending,
+                       apr_pool_t *result_pool);
+
+/* Return the number of worker threads used by QUEUE.  0 means that all
+ * tasks get executed synchronously.
+ */
+int
+svn_task__queue_thread_count(svn_task__queue_t *queue);
+
+/* Add a new task to QUEUE.  PROCESS_FUNC and OUTPUT_FUNC, which may be
+ * NULL, will be called with TASK_BATON.
+ *
+ * TASK_POOL must be a pool that can be used from a different thread, e.g.
+ * a pool created with svn_pool_create(NULL).  It should contain TASK_BATON
+ * and all data referenced by it.  The queue takes over ownership of
+ * TASK_POOL and destroys it after OUTPUT_FUNC has been called or when the
+ * task has been discarded - even if this function returns an error.
+ *
+ * If the queue is full, this will output completed tasks until there is
+ * room for the new one.  Any error returned by the process or output
+ * steps of those will be returned here.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_task__queue_add(svn_task__queue_t *queue,
+                    svn_task__process_func_t process_func,
+                    svn_task__output_func_t output_func,
+                    void *task_baton,
+                    apr_pool_t *task_pool,
+                    apr_pool_t *scratch_pool);
+
+/* Wait until at least one more task in QUEUE has been processed since
+ * the last call to this function, unless no tasks are pending at all.
+ * Then output all tasks at the head of QUEUE that have been processed,
+ * without waiting for the remaining ones.  Return the first error
+ * reported by any of the tasks output.  Use SCRATCH_POOL for temporary
+ * allocations.
+ *
+ * This allows the caller to add new tasks as soon as workers become
+ * available, e.g. when the set of tasks that may run depends on the
+ * completion of earlier ones.
+ */
+svn_error_t *
+svn_task__queue_wait(svn_task__queue_t *queue,
+                     apr_pool_t *scratch_pool);
+
+/* Wait for all tasks in QUEUE to complete and output them in order.
+ * Return the first error reported by any of these tasks.
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * New tasks may be added after this call.
+ */
+svn_error_t *
+svn_task__queue_drain(svn_task__queue_t *queue,
+                      apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TASK_H */
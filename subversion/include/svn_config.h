@@ -161,6 +161,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_DIFF_JOBS                 "diff-jobs"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -171,6 +173,12 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_SQLITE_WAL                "write-ahead-logging"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE          "mmap-size"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE         "page-cache-size"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
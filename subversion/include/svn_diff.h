@@ -455,6 +455,23 @@ typedef enum svn_diff_file_ignore_space_t
   svn_diff_file_ignore_space_all
 } svn_diff_file_ignore_space_t;
 
+/** The algorithms that can be used to find the common lines of two files.
+ *
+ * @since New in 1.12.
+ */
+typedef enum svn_diff_algorithm_t
+{
+  /** The O(NP) algorithm by Wu, Manber and Myers.  It finds a minimal
+   * diff, but gets slow on large inputs with many differences. */
+  svn_diff_algorithm_myers = 0,
+
+  /** The patience diff algorithm.  It anchors the diff on lines that are
+   * unique in both files and only runs the O(NP) algorithm between these
+   * anchors.  The result is not always minimal, but it tends to be easier
+   * to read and is much faster on heavily reordered files. */
+  svn_diff_algorithm_patience
+} svn_diff_algorithm_t;
+
 /** Options to control the behaviour of the file diff routines.
  *
  * @since New in 1.4.
@@ -487,6 +504,19 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** The algorithm used to match up the lines of the files.  The default
+   * is @c svn_diff_algorithm_myers.
+   *
+   * @since New in 1.12 */
+  svn_diff_algorithm_t algorithm;
+
+  /** Whether git-style binary diffs may describe changes as binary deltas
+   * instead of the literal file content.  The default is @c FALSE.
+   * @see svn_diff_output_binary2().
+   *
+   * @since New in 1.12 */
+  svn_boolean_t git_binary_deltas;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -511,6 +541,9 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
  * - --unified, -u (for compatibility, does nothing).
+ * - --diff-algorithm ARG, where ARG is 'myers' or 'patience'
+ *   @since New in 1.12.
+ * - --patience, the same as '--diff-algorithm patience' @since New in 1.12.
  */
 svn_error_t *
 svn_diff_file_options_parse(svn_diff_file_options_t *options,
@@ -794,11 +827,37 @@ svn_diff_file_output_merge(svn_stream_t *output_stream,
  *
  * Writes the output to @a output_stream.
  *
+ * If @a allow_deltas is TRUE, each of the two hunks will describe the
+ * transformation from the other version as a git binary delta, if that
+ * is smaller than the literal content.  Subversion's patch code can only
+ * apply literal hunks, so this is only useful for patches consumed by git.
+ *
+ * The data gets processed in a streaming fashion, so memory usage does not
+ * depend on the size of the files.  Temporary files are used to hold the
+ * compressed content and, if @a allow_deltas is TRUE, a copy of the
+ * uncompressed content.
+ *
  * If not @c NULL, call @a cancel_func with @a cancel_baton once or multiple
  * times while processing larger diffs.
  *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_diff_output_binary2(svn_stream_t *output_stream,
+                        svn_stream_t *original,
+                        svn_stream_t *latest,
+                        svn_boolean_t allow_deltas,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool);
+
+/** Similar to svn_diff_output_binary2() but with @a allow_deltas set to
+ * FALSE.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.11 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_diff_output_binary(svn_stream_t *output_stream,
                        svn_stream_t *original,
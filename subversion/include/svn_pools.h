@@ -61,22 +61,37 @@ svn_pool_create_ex_debug(apr_pool_t *parent_pool,
                          apr_allocator_t *allocator,
                          const char *file_line);
 
-#if APR_POOL_DEBUG
+/* Pass the creating source location on even without APR pool debugging,
+ * so pool allocation profiling can attribute pools to it. */
+#if APR_POOL_DEBUG || !defined(SWIG)
 #define svn_pool_create_ex(pool, allocator) \
 svn_pool_create_ex_debug(pool, allocator, APR_POOL__FILE_LINE__)
 
-#endif /* APR_POOL_DEBUG */
+#endif /* APR_POOL_DEBUG || !SWIG */
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
 
 /** Create a pool as a subpool of @a parent_pool */
 #define svn_pool_create(parent_pool) svn_pool_create_ex(parent_pool, NULL)
 
+/** Clear a @a pool destroying its children, like apr_pool_clear().  If
+ * pool allocation profiling is active, also end the current allocation
+ * cycle of @a pool and start a new one.
+ *
+ * This is the implementation of #svn_pool_clear.  Don't call this
+ * function directly.
+ *
+ * @since New in 1.12.
+ */
+void
+svn_pool__clear(apr_pool_t *pool);
+
 /** Clear a @a pool destroying its children.
  *
- * This define for @c svn_pool_clear exists for completeness.
+ * Unlike a plain apr_pool_clear(), this keeps the pool allocation
+ * profiler tracking @a pool.
  */
-#define svn_pool_clear apr_pool_clear
+#define svn_pool_clear svn_pool__clear
 
 
 /** Destroy a @a pool and all of its children.
@@ -37,6 +37,7 @@
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_auth.h"
 #include "svn_mergeinfo.h"
 
@@ -1889,6 +1890,62 @@ svn_ra_get_file_revs(svn_ra_session_t *session,
                      void *handler_baton,
                      apr_pool_t *pool);
 
+/**
+ * Callback type to be used with svn_ra_get_blame().  It will be invoked
+ * once for every line of the file, in order.
+ *
+ * @a line_no is the 0-based line number and @a line the contents of that
+ * line without its terminating LF.  As with svn_client_blame5(), lines
+ * are only split at LF, i.e. a CR remains part of @a line.  @a revision
+ * is the revision that last changed the line and @a rev_props contains
+ * the properties of that revision, as far as they are readable.  If the
+ * line has not been changed within the requested revision range,
+ * @a revision will be #SVN_INVALID_REVNUM and @a rev_props will be
+ * @c NULL.
+ *
+ * @a baton is the user-provided receiver baton.  @a scratch_pool may be
+ * used for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+typedef svn_error_t *(*svn_ra_blame_receiver_t)(
+  void *baton,
+  apr_int64_t line_no,
+  svn_revnum_t revision,
+  apr_hash_t *rev_props,
+  const svn_string_t *line,
+  apr_pool_t *scratch_pool);
+
+/**
+ * Let the server annotate the file @a path as seen in revision @a end
+ * with the revisions from @a start to @a end that last changed each of
+ * its lines, and invoke @a receiver with @a receiver_baton for each
+ * line.  Only the final annotations get transmitted, instead of every
+ * file revision as with svn_ra_get_file_revs2().
+ *
+ * @a path is relative to the @a session's session URL.  @a start must
+ * not be larger than @a end.  Subsequent file revisions are compared
+ * using @a diff_options, which may be @c NULL to use the defaults.
+ * Merged revisions are not taken into account.
+ *
+ * If the server doesn't support the 'blame' command, return
+ * #SVN_ERR_UNSUPPORTED_FEATURE in preference to any other error that
+ * might otherwise be returned.
+ *
+ * Use @a scratch_pool for temporary memory allocation.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_ra_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const svn_diff_file_options_t *diff_options,
+                 svn_ra_blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool);
+
 /**
  * Lock each path in @a path_revs, which is a hash whose keys are the
  * paths to be locked, and whose values are the corresponding base
@@ -2239,6 +2296,13 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_LIST "list"
 
+/**
+ * The capability of a server to annotate files using svn_ra_get_blame().
+ *
+ * @since New in 1.12.
+ */
+#define SVN_RA_CAPABILITY_BLAME "blame"
+
 
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
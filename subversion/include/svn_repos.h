@@ -35,6 +35,7 @@
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_fs.h"
 #include "svn_io.h"
 #include "svn_mergeinfo.h"
@@ -250,7 +251,17 @@ typedef enum svn_repos_notify_action_t
   svn_repos_notify_pack_noop,
 
   /** The revision properties got set. @since New in 1.10. */
-  svn_repos_notify_load_revprop_set
+  svn_repos_notify_load_revprop_set,
+
+  /** A revision was not verified again because it did not change since
+   * its last successful verification. @since New in 1.12. */
+  svn_repos_notify_verify_rev_skipped,
+
+  /** A queued hook has been run successfully. @since New in 1.12. */
+  svn_repos_notify_hook_run,
+
+  /** A queued hook failed. @since New in 1.12. */
+  svn_repos_notify_hook_failed
 } svn_repos_notify_action_t;
 
 /** The type of warning occurring.
@@ -319,10 +330,13 @@ typedef struct svn_repos_notify_t
 
   /** For #svn_repos_notify_dump_rev_end and #svn_repos_notify_verify_rev_end,
    * the revision which just completed.
-   * For #svn_fs_upgrade_format_bumped, the new format version. */
+   * For #svn_fs_upgrade_format_bumped, the new format version.
+   * For #svn_repos_notify_hook_run and #svn_repos_notify_hook_failed,
+   * the revision the hook has been run for. */
   svn_revnum_t revision;
 
-  /** For #svn_repos_notify_warning, the warning message. */
+  /** For #svn_repos_notify_warning, the warning message.
+   * For #svn_repos_notify_hook_failed, the error message. */
   const char *warning_str;
   /** For #svn_repos_notify_warning, the warning type. */
   svn_repos_notify_warning_t warning;
@@ -348,7 +362,9 @@ typedef struct svn_repos_notify_t
       node. */
   enum svn_node_action node_action;
 
-  /** For #svn_repos_notify_load_node_start, the path of the node. */
+  /** For #svn_repos_notify_load_node_start, the path of the node.
+      For #svn_repos_notify_hook_run and #svn_repos_notify_hook_failed,
+      the name of the hook. */
   const char *path;
 
   /** For #svn_repos_notify_hotcopy_rev_range, the start of the copied
@@ -1000,6 +1016,135 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
 
 /** @} */
 
+/**
+ * @defgroup svn_repos_hook_queue Asynchronous post-commit hooks
+ *
+ * If the hook queue of a repository is enabled, the post-commit and
+ * post-revprop-change hooks are not run by the committing process.
+ * Instead, an event describing the hook invocation gets stored within
+ * the repository and the operation completes without waiting for the
+ * hook.  svn_repos_hook_queue_run() then executes the queued hooks.
+ *
+ * Events are processed in the order in which they have been queued.
+ * Events for different revisions may run concurrently, but an event is
+ * never started before all earlier events for the same revision have
+ * completed.  Failed hooks are retried.  If the runner gets interrupted,
+ * the events in progress will be run again, i.e. every hook runs at
+ * least once.
+ *
+ * @since New in 1.12.
+ * @{
+ */
+
+/** A hook invocation waiting in the hook queue of a repository.
+ *
+ * @since New in 1.12.
+ */
+typedef struct svn_repos_hook_event_t
+{
+  /** Position of the event within the queue.  Events get processed in
+   * ascending order of their ids. */
+  apr_uint64_t id;
+
+  /** Name of the hook to run, e.g. "post-commit". */
+  const char *hook;
+
+  /** The revision that the hook is being run for. */
+  svn_revnum_t revision;
+
+  /** Number of failed attempts to run the hook so far. */
+  int attempts;
+
+  /** Earliest time for the next attempt, 0 if there is none yet. */
+  apr_time_t next_attempt;
+
+  /** Error message of the last failed attempt, @c NULL if there is none. */
+  const char *last_error;
+
+  /** TRUE if the runner gave up on this event after too many failed
+   * attempts.  Failed events no longer delay later events. */
+  svn_boolean_t failed;
+} svn_repos_hook_event_t;
+
+/** Enable the hook queue of @a repos if @a enable is set.  Otherwise,
+ * disable the queue and return to running the hooks synchronously.
+ * An error will be returned if there are still queued events when
+ * disabling the queue.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_hook_queue_enable(svn_repos_t *repos,
+                            svn_boolean_t enable,
+                            apr_pool_t *scratch_pool);
+
+/** Set @a *enabled to whether the hook queue of @a repos is enabled and
+ * @a *events to an array of all queued #svn_repos_hook_event_t *,
+ * including the failed ones, in the order in which they will be run.
+ * @a events may be @c NULL.
+ *
+ * Allocate the results in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_hook_queue_status(svn_boolean_t *enabled,
+                            apr_array_header_t **events,
+                            svn_repos_t *repos,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/** Run the hooks queued in the hook queue of @a repos, using up to
+ * @a runners concurrent hook processes.  Remove events from the queue
+ * when their hook succeeded.  Failed hooks are retried with increasing
+ * delays until they have been tried @a max_attempts times.
+ *
+ * If @a follow is not set, return as soon as there are no events left
+ * that can be run immediately.  Otherwise, keep waiting for new events
+ * until cancelled.
+ *
+ * Only one runner may process a queue at any time.  If another runner is
+ * active, return #SVN_ERR_REPOS_LOCKED.  If the queue is not enabled,
+ * return #SVN_ERR_REPOS_DISABLED_FEATURE.
+ *
+ * If @a notify_func is not @c NULL, call it with @a notify_baton after
+ * each attempt to run a hook, using #svn_repos_notify_hook_run or
+ * #svn_repos_notify_hook_failed.
+ *
+ * Use @a cancel_func and @a cancel_baton for cancellation and
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_hook_queue_run(svn_repos_t *repos,
+                         int runners,
+                         int max_attempts,
+                         svn_boolean_t follow,
+                         svn_repos_notify_func_t notify_func,
+                         void *notify_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool);
+
+/** Remove all failed events from the hook queue of @a repos.  If
+ * @a retry is set, put them back into the queue to be run again, with
+ * their attempt counters reset.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_hook_queue_clear_failed(svn_repos_t *repos,
+                                  svn_boolean_t retry,
+                                  apr_pool_t *scratch_pool);
+
+/** @} */
+
 /* ---------------------------------------------------------------*/
 
 /* Reporting the state of a working copy, for updates. */
@@ -1692,6 +1837,26 @@ svn_repos_dated_revision(svn_revnum_t *revision,
                          apr_time_t tm,
                          apr_pool_t *pool);
 
+/** (Re-)create the date index of @a repos from the @c svn:date properties
+ * of all its revisions.
+ *
+ * The date index speeds up svn_repos_dated_revision().  Once created, it
+ * gets updated whenever a revision is committed or its @c svn:date
+ * property is changed through this library.  The index is only a hint,
+ * so a missing or outdated index never produces wrong results.  It can
+ * be rebuilt at any time.
+ *
+ * Use @a cancel_func and @a cancel_baton for cancellation and
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_rebuild_date_index(svn_repos_t *repos,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool);
+
 
 /** Given a @a root/@a path within some filesystem, return three pieces of
  * information allocated in @a pool:
@@ -2424,6 +2589,73 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
                          void *handler_baton,
                          apr_pool_t *pool);
 
+/**
+ * Callback type to be used with svn_repos_get_blame().  It will be invoked
+ * once for every line of the file, in order.
+ *
+ * @a line_no is the 0-based line number and @a line the contents of that
+ * line without its terminating LF.  As with svn_client_blame5(), lines
+ * are only split at LF, i.e. a CR remains part of @a line.  @a revision
+ * is the revision that last changed the line and @a rev_props contains
+ * the properties of that revision, as far as they are readable.  If the
+ * line has not been changed within the requested revision range,
+ * @a revision will be #SVN_INVALID_REVNUM and @a rev_props will be
+ * @c NULL.
+ *
+ * @a baton is the user-provided receiver baton.  @a scratch_pool may be
+ * used for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+typedef svn_error_t *(*svn_repos_blame_receiver_t)(
+  void *baton,
+  apr_int64_t line_no,
+  svn_revnum_t revision,
+  apr_hash_t *rev_props,
+  const svn_string_t *line,
+  apr_pool_t *scratch_pool);
+
+/**
+ * Determine for every line of file @a path in @a repos as seen in
+ * revision @a end, which revision from @a start to @a end last changed
+ * it and report that to @a receiver with @a receiver_baton.  This is the
+ * server-side equivalent to the line annotation that clients otherwise
+ * compute from the svn_repos_get_file_revs2() output.
+ *
+ * Subsequent file revisions are compared using @a diff_options, which may
+ * be @c NULL to use the defaults.  Merged revisions are not taken into
+ * account.  @a start must not be larger than @a end.  If @a start is
+ * #SVN_INVALID_REVNUM, start at revision 0.  If @a end is
+ * #SVN_INVALID_REVNUM, use the youngest revision.
+ *
+ * Readability is checked with the optional @a authz_read_func and
+ * @a authz_read_baton as described for svn_repos_get_file_revs2().
+ *
+ * If @a start is 0 or 1, the final annotations are cached per node-revision
+ * within the repository.  Subsequent calls for the same or later versions
+ * of the file will only process the file revisions not covered by the
+ * cache.  The cache is not used if any part of the file's history is not
+ * readable.
+ *
+ * Use @a cancel_func and @a cancel_baton for cancellation and
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_get_blame(svn_repos_t *repos,
+                    const char *path,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    const svn_diff_file_options_t *diff_options,
+                    svn_repos_authz_func_t authz_read_func,
+                    void *authz_read_baton,
+                    svn_repos_blame_receiver_t receiver,
+                    void *receiver_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool);
+
 /**
  * Similar to #svn_file_rev_handler_t, but without the @a
  * result_of_merge parameter.
@@ -3134,10 +3366,10 @@ enum svn_repos_load_uuid
   svn_repos_load_uuid_force
 };
 
-/** Callback type for use with svn_repos_verify_fs3().  @a revision
+/** Callback type for use with svn_repos_verify_fs4().  @a revision
  * and @a verify_err are the details of a single verification failure
- * that occurred during the svn_repos_verify_fs3() call.  @a baton is
- * the same baton given to svn_repos_verify_fs3().  @a scratch_pool is
+ * that occurred during the svn_repos_verify_fs4() call.  @a baton is
+ * the same baton given to svn_repos_verify_fs4().  @a scratch_pool is
  * provided for the convenience of the implementor, who should not
  * expect it to live longer than a single callback call.
  *
@@ -3147,7 +3379,7 @@ enum svn_repos_load_uuid
  * should also call svn_error_dup() for @a verify_err.  Implementors of this
  * callback are forbidden to call svn_error_clear() for @a verify_err.
  *
- * @see svn_repos_verify_fs3
+ * @see svn_repos_verify_fs4
  *
  * @since New in 1.9.
  */
@@ -3176,6 +3408,16 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  * file context reconstruction and verification.  For FSFS format 7+ and
  * FSX, this allows for a very fast check against external corruption.
  *
+ * If @a since_last_verify is @c TRUE, skip all revisions that passed an
+ * earlier verification with @a since_last_verify set and did not change
+ * since.  A revision counts as changed if its root node or its revision
+ * properties are different.  The backend-specific checks will then only
+ * cover the range from the oldest changed revision to @a end_rev.  Record
+ * the revisions that pass the full verification in a ledger file in the
+ * repository.  This makes repeated verification of large repositories
+ * much cheaper but it will not detect corruption of older revisions on
+ * the storage level.
+ *
  * If @a verify_callback is not @c NULL, call it with @a verify_baton upon
  * receiving an FS-specific structure failure or a revision verification
  * failure.  Set @c revision callback argument to #SVN_INVALID_REVNUM or
@@ -3210,6 +3452,10 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *      @c action = #svn_repos_notify_verify_rev_end
  *      @c revision = the revision
  *
+ *   For each revision skipped due to @a since_last_verify:
+ *      @c action = #svn_repos_notify_verify_rev_skipped
+ *      @c revision = the revision
+ *
  *   At the end:
  *      @c action = svn_repos_notify_verify_end
  *        ### Do we really need a callback to tell us the function we
@@ -3224,8 +3470,31 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     svn_boolean_t since_last_verify,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a since_last_verify set to
+ * @c FALSE.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.11 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3283,7 +3552,7 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
  * @c NULL, this is effectively a primitive verify.  It is not complete,
- * however; see instead svn_repos_verify_fs3().
+ * however; see instead svn_repos_verify_fs4().
  *
  * Begin at revision @a start_rev, and dump every revision up through
  * @a end_rev.  If @a start_rev is #SVN_INVALID_REVNUM, start at revision
@@ -3331,6 +3600,12 @@ svn_repos_verify_fs(svn_repos_t *repos,
  *            reiterating the existence of previous warnings
  *        ### This is a presentation issue. Caller could do this itself.
  *
+ * If @a thread_count is larger than 1, up to that many revisions will
+ * be dumped concurrently, each using a separate filesystem handle.  The
+ * output and notifications will be the same as with a single thread.
+ * In that case, @a filter_func may be called from different threads at
+ * the same time.
+ *
  * If @a filter_func is not @c NULL, it is called for each node being
  * dumped, allowing the caller to exclude it from dump.
  *
@@ -3340,8 +3615,33 @@ svn_repos_verify_fs(svn_repos_t *repos,
  *
  * Use @a scratch_pool for temporary allocation.
  *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_dump_fs5(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   int thread_count,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_dump_fs5(), but with @a thread_count set to 1.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.11 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_stream_t *stream,
@@ -3472,6 +3772,14 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * @note The details or the performed normalizations are deliberately
  * left unspecified and may change in the future.
  *
+ * If @a pipelined is set, @a dumpstream will be read ahead in a separate
+ * thread, and larger file contents will be decoded and stored in the
+ * repository from yet another thread while reading continues.  Revisions
+ * are still committed in order.  In that mode, @a dumpstream must support
+ * being read from a different thread and the function may read beyond
+ * the end of the dump data.  Without thread support, @a pipelined has no
+ * effect.
+ *
  * If non-NULL, use @a notify_func and @a notify_baton to send notification
  * of events to the caller.
  *
@@ -3479,8 +3787,35 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the load.
  *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_load_fs7(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   svn_boolean_t ignore_dates,
+                   svn_boolean_t normalize_props,
+                   svn_boolean_t pipelined,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_load_fs7(), but with the @a pipelined parameter
+ * always set to @c FALSE.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.11 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_load_fs6(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
@@ -4146,6 +4481,31 @@ typedef struct svn_authz_t svn_authz_t;
 svn_error_t *
 svn_repos_authz_initialize(apr_pool_t *pool);
 
+/**
+ * Share compiled authz rules between processes through directory @a dir.
+ *
+ * Whenever svn_repos_authz_read3() needs to parse an authz file, it will
+ * first look for a compiled binary image of that file's contents in
+ * @a dir and load it instead.  If there is no such image, the authz file
+ * will be parsed and its image be written to @a dir.  Since images are
+ * keyed by the contents of the authz and global groups files, they never
+ * need to be invalidated.  Loading an image is much faster than parsing
+ * large authz files.
+ *
+ * @a dir must only be writable by the server processes, since the images
+ * in it define the access rights.  Set @a dir to @c NULL to neither read
+ * nor write images, which is the default.  @a dir will be copied into
+ * @a pool.
+ *
+ * This should be called before any other authz function except
+ * svn_repos_authz_initialize().
+ *
+ * @since New in 1.12.
+ */
+void
+svn_repos_authz_set_image_dir(const char *dir,
+                              apr_pool_t *pool);
+
 /**
  * Read authz configuration data from @a path (a dirent, an absolute file url
  * or a registry path) into @a *authz_p, allocated in @a pool.
@@ -4232,6 +4592,11 @@ svn_repos_authz_parse(svn_authz_t **authz_p,
  * For compatibility with 1.6, and earlier, @a repos_name can be NULL
  * in which case it is equivalent to a @a repos_name of "".
  *
+ * @a authz remembers the lookup results for the parent paths of @a path
+ * for as long as @a user and @a repos_name don't change.  Checking
+ * siblings and paths in depth-first tree walk order is therefore much
+ * cheaper than checking unrelated paths.
+ *
  * @note Presently, @a repos_name must byte-for-byte match the repos_name
  * specified in the authz file; it is treated as an opaque string, and not
  * as a dirent.
@@ -4247,6 +4612,32 @@ svn_repos_authz_check_access(svn_authz_t *authz,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool);
 
+/**
+ * Like svn_repos_authz_check_access() but check the access to all
+ * @a child_names, given as <tt>const char *</tt> path segments, of the
+ * directory @a parent_path at once.  Set @a *access_granted to an array
+ * of #svn_boolean_t with one entry per element of @a child_names,
+ * allocated in @a result_pool.  @a parent_path must be an absolute path.
+ *
+ * This is cheaper than checking each child separately because the rules
+ * for @a user are selected only once and all children share the rule
+ * tree walk down to @a parent_path.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos_authz_check_children(apr_array_header_t **access_granted,
+                               svn_authz_t *authz,
+                               const char *repos_name,
+                               const char *parent_path,
+                               const apr_array_header_t *child_names,
+                               const char *user,
+                               svn_repos_authz_access_t required_access,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 
 
 /** Revision Access Levels
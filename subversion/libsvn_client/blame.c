@@ -108,6 +108,14 @@ struct file_rev_baton {
   apr_hash_t *last_props;
 };
 
+/* The baton used by server_blame_receiver. */
+struct server_blame_baton {
+  svn_revnum_t start_rev, end_rev;
+  svn_client_blame_receiver3_t receiver;
+  void *receiver_baton;
+  svn_client_ctx_t *ctx;
+};
+
 /* The baton used by the txdelta window handler. Allocated per revision */
 struct delta_baton {
   /* Our underlying handler/baton that we wrap */
@@ -655,6 +663,29 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
+/* Implements svn_ra_blame_receiver_t, forwarding the line annotations
+   calculated by the server to the svn_client_blame_receiver3_t in the
+   server_blame_baton BATON. */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      apr_int64_t line_no,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      const svn_string_t *line,
+                      apr_pool_t *scratch_pool)
+{
+  struct server_blame_baton *sbb = baton;
+
+  if (sbb->ctx->cancel_func)
+    SVN_ERR(sbb->ctx->cancel_func(sbb->ctx->cancel_baton));
+
+  return svn_error_trace(sbb->receiver(sbb->receiver_baton,
+                                       sbb->start_rev, sbb->end_rev,
+                                       line_no, revision, rev_props,
+                                       SVN_INVALID_REVNUM, NULL, NULL,
+                                       line->data, FALSE, scratch_pool));
+}
+
 svn_error_t *
 svn_client_blame5(const char *target,
                   const svn_opt_revision_t *peg_revision,
@@ -767,6 +798,35 @@ svn_client_blame5(const char *target,
         }
     }
 
+  /* Unless we have to combine the result with local modifications or
+     merge history, let the server annotate the file if it can.  That
+     saves us from fetching and diffing every single file revision. */
+  if (!include_merged_revisions
+      && start_revnum <= end_revnum
+      && end->kind != svn_opt_revision_working)
+    {
+      svn_boolean_t has_blame;
+
+      SVN_ERR(svn_ra_has_capability(ra_session, &has_blame,
+                                    SVN_RA_CAPABILITY_BLAME, pool));
+      if (has_blame)
+        {
+          struct server_blame_baton sbb;
+
+          sbb.start_rev = start_revnum;
+          sbb.end_rev = end_revnum;
+          sbb.receiver = receiver;
+          sbb.receiver_baton = receiver_baton;
+          sbb.ctx = ctx;
+
+          return svn_error_trace(svn_ra_get_blame(ra_session, "",
+                                                  start_revnum, end_revnum,
+                                                  diff_options,
+                                                  server_blame_receiver,
+                                                  &sbb, pool));
+        }
+    }
+
   frb.start_rev = start_revnum;
   frb.end_rev = end_revnum;
   frb.target = target;
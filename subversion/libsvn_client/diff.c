@@ -49,6 +49,7 @@
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_subst.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "private/svn_wc_private.h"
@@ -56,6 +57,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_io_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_task.h"
 
 #include "svn_private_config.h"
 
@@ -745,9 +747,26 @@ typedef struct diff_writer_info_t
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
 
+  /* If not NULL, file content diffs may be calculated concurrently.
+     Their output gets serialized through this queue. */
+  svn_task__queue_t *diff_queue;
+
   struct diff_driver_info_t ddi;
 } diff_writer_info_t;
 
+/* Output all file diffs that are still queued in DWI->diff_queue.
+   This must be called before anything else gets written to the output
+   stream to keep the output in order. */
+static svn_error_t *
+flush_queued_diffs(diff_writer_info_t *dwi,
+                   apr_pool_t *scratch_pool)
+{
+  if (dwi->diff_queue)
+    SVN_ERR(svn_task__queue_drain(dwi->diff_queue, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* An helper for diff_dir_props_changed, diff_file_changed and diff_file_added
  */
 static svn_error_t *
@@ -966,10 +985,13 @@ diff_content_changed(svn_boolean_t *wrote_header,
                                            scratch_pool, scratch_pool));
           SVN_ERR(svn_stream_open_readonly(&right_stream, tmpfile2,
                                            scratch_pool, scratch_pool));
-          SVN_ERR(svn_diff_output_binary(outstream,
-                                         left_stream, right_stream,
-                                         dwi->cancel_func, dwi->cancel_baton,
-                                         scratch_pool));
+          SVN_ERR(svn_diff_output_binary2(outstream,
+                                          left_stream, right_stream,
+                                          !dwi->diff_cmd
+                                            && dwi->options.for_internal
+                                                 ->git_binary_deltas,
+                                          dwi->cancel_func, dwi->cancel_baton,
+                                          scratch_pool));
         }
       else
         {
@@ -1119,6 +1141,277 @@ diff_content_changed(svn_boolean_t *wrote_header,
   return SVN_NO_ERROR;
 }
 
+/* Baton for a file content diff that gets calculated in a worker thread
+   of the diff queue.  It is allocated in the task's pool together with
+   everything it references. */
+typedef struct file_diff_task_t
+{
+  diff_writer_info_t *dwi;
+
+  /* Private copies of the files to compare. */
+  const char *tmpfile1;
+  const char *tmpfile2;
+
+  /* Arguments to diff_content_changed() and diff_props_changed(). */
+  const char *diff_relpath;
+  svn_revnum_t rev1;
+  svn_revnum_t rev2;
+  apr_hash_t *left_props;
+  apr_hash_t *right_props;
+  svn_diff_operation_kind_t operation;
+  svn_boolean_t force_diff;
+  const char *copyfrom_path;
+  svn_revnum_t copyfrom_rev;
+  apr_array_header_t *prop_changes;
+
+  /* Pre-calculated diff headers.  In git mode, LABEL1 and LABEL2 are
+     the git labels and GIT_HEADER is the rendered git diff header. */
+  const char *index_path;
+  const char *label1;
+  const char *label2;
+  svn_stringbuf_t *git_header;
+} file_diff_task_t;
+
+/* Result of a file_diff_task_t. */
+typedef struct file_diff_result_t
+{
+  /* Whether the files differ. */
+  svn_boolean_t has_diffs;
+
+  /* The unified diff body, in DWI->header_encoding. */
+  svn_stringbuf_t *text;
+} file_diff_result_t;
+
+/* Implements svn_task__process_func_t.  Calculate the diff for the
+   file_diff_task_t in TASK_BATON.  This runs in a worker thread. */
+static svn_error_t *
+process_file_diff(void **result,
+                  void *task_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  file_diff_task_t *task = task_baton;
+  diff_writer_info_t *dwi = task->dwi;
+  file_diff_result_t *diff_result = apr_pcalloc(result_pool,
+                                                sizeof(*diff_result));
+  svn_diff_t *diff;
+
+  SVN_ERR(svn_diff_file_diff_2(&diff, task->tmpfile1, task->tmpfile2,
+                               dwi->options.for_internal, scratch_pool));
+
+  diff_result->has_diffs = svn_diff_contains_diffs(diff);
+  diff_result->text = svn_stringbuf_create_empty(result_pool);
+
+  /* The client's cancel function might not be thread-safe.  The thread
+     that owns the queue checks for cancellation often enough. */
+  if (task->force_diff || diff_result->has_diffs)
+    SVN_ERR(svn_diff_file_output_unified4(
+              svn_stream_from_stringbuf(diff_result->text, scratch_pool),
+              diff, task->tmpfile1, task->tmpfile2,
+              task->label1, task->label2,
+              dwi->header_encoding, dwi->relative_to_dir,
+              dwi->options.for_internal->show_c_function,
+              dwi->options.for_internal->context_size,
+              NULL, NULL, scratch_pool));
+
+  *result = diff_result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Write the diff calculated by
+   process_file_diff() along with its headers and the property changes
+   of the file, exactly like diff_content_changed() and
+   diff_props_changed() would. */
+static svn_error_t *
+output_file_diff(void *result,
+                 void *task_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_diff_task_t *task = task_baton;
+  file_diff_result_t *diff_result = result;
+  diff_writer_info_t *dwi = task->dwi;
+  svn_boolean_t wrote_header = FALSE;
+  apr_size_t len;
+
+  if (task->force_diff
+      || dwi->use_git_diff_format
+      || diff_result->has_diffs)
+    {
+      SVN_ERR(print_diff_index_header(dwi->outstream, dwi->header_encoding,
+                                      task->index_path, "", scratch_pool));
+      wrote_header = TRUE;
+
+      if (task->git_header)
+        {
+          len = task->git_header->len;
+          SVN_ERR(svn_stream_write(dwi->outstream, task->git_header->data,
+                                   &len));
+        }
+
+      len = diff_result->text->len;
+      SVN_ERR(svn_stream_write(dwi->outstream, diff_result->text->data,
+                               &len));
+    }
+
+  if (task->prop_changes && task->prop_changes->nelts > 0)
+    SVN_ERR(diff_props_changed(task->diff_relpath, task->rev1, task->rev2,
+                               task->prop_changes,
+                               task->left_props, task->right_props,
+                               !wrote_header, dwi, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *COPY_PATH to the path of a temporary copy of the file at PATH.
+   The copy will be removed when RESULT_POOL gets cleaned up. */
+static svn_error_t *
+copy_to_tempfile(const char **copy_path,
+                 const char *path,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stream_t *source;
+  svn_stream_t *target;
+
+  SVN_ERR(svn_stream_open_readonly(&source, path, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&target, copy_path, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+
+  return svn_error_trace(svn_stream_copy3(source, target, NULL, NULL,
+                                          scratch_pool));
+}
+
+/* Like diff_content_changed() followed by diff_props_changed() for
+   PROP_CHANGES, but calculate the content diff in a worker thread of
+   DWI->diff_queue.  Set *QUEUED to FALSE and do nothing if the diff
+   cannot be done that way, e.g. because there is no queue, an external
+   diff command must be used or there is special output for binary files
+   and symlinks.  PROP_CHANGES may be NULL.
+
+   The tree processor may remove TMPFILE1 and TMPFILE2 as soon as we
+   return, so the worker operates on copies of them. */
+static svn_error_t *
+queue_file_diff(svn_boolean_t *queued,
+                const char *diff_relpath,
+                const char *tmpfile1,
+                const char *tmpfile2,
+                svn_revnum_t rev1,
+                svn_revnum_t rev2,
+                apr_hash_t *left_props,
+                apr_hash_t *right_props,
+                svn_diff_operation_kind_t operation,
+                svn_boolean_t force_diff,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_rev,
+                const apr_array_header_t *prop_changes,
+                diff_writer_info_t *dwi,
+                apr_pool_t *scratch_pool)
+{
+  const char *mimetype1 = svn_prop_get_value(left_props, SVN_PROP_MIME_TYPE);
+  const char *mimetype2 = svn_prop_get_value(right_props, SVN_PROP_MIME_TYPE);
+  const char *label_path1, *label_path2;
+  file_diff_task_t *task;
+  apr_pool_t *task_pool;
+  svn_error_t *err;
+
+  *queued = FALSE;
+
+  if (!dwi->diff_queue || dwi->diff_cmd || dwi->properties_only)
+    return SVN_NO_ERROR;
+
+  if (!dwi->force_binary
+      && ((mimetype1 && svn_mime_type_is_binary(mimetype1))
+          || (mimetype2 && svn_mime_type_is_binary(mimetype2))))
+    return SVN_NO_ERROR;
+
+  if (dwi->use_git_diff_format
+      && (svn_prop_get_value(left_props, SVN_PROP_SPECIAL)
+          || svn_prop_get_value(right_props, SVN_PROP_SPECIAL)))
+    return SVN_NO_ERROR;
+
+  /* The task pool must be usable from the worker threads. */
+  task_pool = svn_pool_create(NULL);
+  task = apr_pcalloc(task_pool, sizeof(*task));
+  task->dwi = dwi;
+  task->diff_relpath = apr_pstrdup(task_pool, diff_relpath);
+  task->rev1 = rev1;
+  task->rev2 = rev2;
+  task->left_props = left_props ? svn_prop_hash_dup(left_props, task_pool)
+                                : NULL;
+  task->right_props = right_props ? svn_prop_hash_dup(right_props, task_pool)
+                                  : NULL;
+  task->operation = operation;
+  task->force_diff = force_diff;
+  task->copyfrom_path = apr_pstrdup(task_pool, copyfrom_path);
+  task->copyfrom_rev = copyfrom_rev;
+  task->prop_changes = prop_changes
+                     ? svn_prop_array_dup(prop_changes, task_pool)
+                     : NULL;
+
+  err = adjust_paths_for_diff_labels(&task->index_path,
+                                     &label_path1, &label_path2,
+                                     dwi->relative_to_dir, dwi->ddi.anchor,
+                                     diff_relpath,
+                                     dwi->ddi.orig_path_1,
+                                     dwi->ddi.orig_path_2,
+                                     task_pool, scratch_pool);
+  if (!err)
+    {
+      task->label1 = diff_label(label_path1, rev1, task_pool);
+      task->label2 = diff_label(label_path2, rev2, task_pool);
+
+      /* The worker writes the ---/+++ lines, so the git labels must be
+         known up front.  Render the git header with them; it needs the
+         working copy context, which the workers must not use. */
+      if (dwi->use_git_diff_format)
+        {
+          task->git_header = svn_stringbuf_create_empty(task_pool);
+          err = print_git_diff_header(
+                  svn_stream_from_stringbuf(task->git_header, scratch_pool),
+                  &task->label1, &task->label2,
+                  operation, rev1, rev2, diff_relpath,
+                  copyfrom_path, copyfrom_rev,
+                  left_props, right_props, NULL,
+                  dwi->header_encoding, &dwi->ddi, task_pool);
+        }
+    }
+  if (!err)
+    {
+      /* DWI->empty_file outlives the queue.  Everything else gets
+         copied. */
+      if (tmpfile1 == dwi->empty_file)
+        task->tmpfile1 = tmpfile1;
+      else
+        err = copy_to_tempfile(&task->tmpfile1, tmpfile1, task_pool,
+                               scratch_pool);
+    }
+  if (!err)
+    {
+      if (tmpfile2 == dwi->empty_file)
+        task->tmpfile2 = tmpfile2;
+      else
+        err = copy_to_tempfile(&task->tmpfile2, tmpfile2, task_pool,
+                               scratch_pool);
+    }
+
+  if (err)
+    {
+      svn_pool_destroy(task_pool);
+      return svn_error_trace(err);
+    }
+
+  *queued = TRUE;
+
+  return svn_error_trace(svn_task__queue_add(dwi->diff_queue,
+                                             process_file_diff,
+                                             output_file_diff,
+                                             task, task_pool,
+                                             scratch_pool));
+}
+
 /* An svn_diff_tree_processor_t callback. */
 static svn_error_t *
 diff_file_changed(const char *relpath,
@@ -1137,6 +1430,23 @@ diff_file_changed(const char *relpath,
   diff_writer_info_t *dwi = processor->baton;
   svn_boolean_t wrote_header = FALSE;
 
+  if (file_modified)
+    {
+      svn_boolean_t queued;
+
+      SVN_ERR(queue_file_diff(&queued, relpath, left_file, right_file,
+                              left_source->revision,
+                              right_source->revision,
+                              left_props, right_props,
+                              svn_diff_op_modified, FALSE,
+                              NULL, SVN_INVALID_REVNUM,
+                              prop_changes, dwi, scratch_pool));
+      if (queued)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
+
   if (file_modified)
     SVN_ERR(diff_content_changed(&wrote_header, relpath,
                                  left_file, right_file,
@@ -1187,6 +1497,7 @@ diff_file_added(const char *relpath,
         index_path = svn_dirent_join(dwi->ddi.anchor, relpath,
                                      scratch_pool);
 
+      SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
       SVN_ERR(print_diff_index_header(dwi->outstream, dwi->header_encoding,
                                       index_path, " (added)",
                                       scratch_pool));
@@ -1217,6 +1528,39 @@ diff_file_added(const char *relpath,
 
   SVN_ERR(svn_prop_diffs(&prop_changes, right_props, left_props, scratch_pool));
 
+  if (right_file)
+    {
+      svn_boolean_t queued;
+
+      if (copyfrom_source)
+        SVN_ERR(queue_file_diff(&queued, relpath, left_file, right_file,
+                                copyfrom_source->revision,
+                                right_source->revision,
+                                left_props, right_props,
+                                copyfrom_source->moved_from_relpath
+                                   ? svn_diff_op_moved
+                                   : svn_diff_op_copied,
+                                TRUE /* force diff output */,
+                                copyfrom_source->moved_from_relpath
+                                   ? copyfrom_source->moved_from_relpath
+                                   : copyfrom_source->repos_relpath,
+                                copyfrom_source->revision,
+                                prop_changes, dwi, scratch_pool));
+      else
+        SVN_ERR(queue_file_diff(&queued, relpath, left_file, right_file,
+                                DIFF_REVNUM_NONEXISTENT,
+                                right_source->revision,
+                                left_props, right_props,
+                                svn_diff_op_added,
+                                TRUE /* force diff output */,
+                                NULL, SVN_INVALID_REVNUM,
+                                prop_changes, dwi, scratch_pool));
+      if (queued)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
+
   if (copyfrom_source && right_file)
     SVN_ERR(diff_content_changed(&wrote_header, relpath,
                                  left_file, right_file,
@@ -1275,6 +1619,7 @@ diff_file_deleted(const char *relpath,
         index_path = svn_dirent_join(dwi->ddi.anchor, relpath,
                                      scratch_pool);
 
+      SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
       SVN_ERR(print_diff_index_header(dwi->outstream, dwi->header_encoding,
                                       index_path, " (deleted)",
                                       scratch_pool));
@@ -1282,12 +1627,35 @@ diff_file_deleted(const char *relpath,
   else
     {
       svn_boolean_t wrote_header = FALSE;
+      apr_array_header_t *prop_changes = NULL;
 
       if (!dwi->empty_file)
         SVN_ERR(svn_io_open_unique_file3(NULL, &dwi->empty_file,
                                          NULL, svn_io_file_del_on_pool_cleanup,
                                          dwi->pool, scratch_pool));
 
+      if (left_props && apr_hash_count(left_props))
+        SVN_ERR(svn_prop_diffs(&prop_changes, apr_hash_make(scratch_pool),
+                               left_props, scratch_pool));
+
+      if (left_file)
+        {
+          svn_boolean_t queued;
+
+          SVN_ERR(queue_file_diff(&queued, relpath,
+                                  left_file, dwi->empty_file,
+                                  left_source->revision,
+                                  DIFF_REVNUM_NONEXISTENT,
+                                  left_props, NULL,
+                                  svn_diff_op_deleted, FALSE,
+                                  NULL, SVN_INVALID_REVNUM,
+                                  prop_changes, dwi, scratch_pool));
+          if (queued)
+            return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
+
       if (left_file)
         SVN_ERR(diff_content_changed(&wrote_header, relpath,
                                      left_file, dwi->empty_file,
@@ -1300,20 +1668,13 @@ diff_file_deleted(const char *relpath,
                                      dwi,
                                      scratch_pool));
 
-      if (left_props && apr_hash_count(left_props))
-        {
-          apr_array_header_t *prop_changes;
-
-          SVN_ERR(svn_prop_diffs(&prop_changes, apr_hash_make(scratch_pool),
-                                 left_props, scratch_pool));
-
-          SVN_ERR(diff_props_changed(relpath,
-                                     left_source->revision,
-                                     DIFF_REVNUM_NONEXISTENT,
-                                     prop_changes,
-                                     left_props, NULL,
-                                     ! wrote_header, dwi, scratch_pool));
-        }
+      if (prop_changes)
+        SVN_ERR(diff_props_changed(relpath,
+                                   left_source->revision,
+                                   DIFF_REVNUM_NONEXISTENT,
+                                   prop_changes,
+                                   left_props, NULL,
+                                   ! wrote_header, dwi, scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -1333,6 +1694,7 @@ diff_dir_changed(const char *relpath,
 {
   diff_writer_info_t *dwi = processor->baton;
 
+  SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
   SVN_ERR(diff_props_changed(relpath,
                              left_source->revision,
                              right_source->revision,
@@ -1377,6 +1739,7 @@ diff_dir_added(const char *relpath,
   SVN_ERR(svn_prop_diffs(&prop_changes, right_props, left_props,
                          scratch_pool));
 
+  SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
   return svn_error_trace(diff_props_changed(relpath,
                                             copyfrom_source ? copyfrom_source->revision
                                                             : DIFF_REVNUM_NONEXISTENT,
@@ -1408,6 +1771,7 @@ diff_dir_deleted(const char *relpath,
   SVN_ERR(svn_prop_diffs(&prop_changes, right_props,
                          left_props, scratch_pool));
 
+  SVN_ERR(flush_queued_diffs(dwi, scratch_pool));
   SVN_ERR(diff_props_changed(relpath,
                              left_source->revision,
                              DIFF_REVNUM_NONEXISTENT,
@@ -2616,8 +2980,18 @@ create_diff_writer_info(diff_writer_info_t *dwi,
   return SVN_NO_ERROR;
 }
 
+/* Number of threads to use for file content diffs if the
+ * SVN_CONFIG_OPTION_DIFF_JOBS option has not been set. */
+#define DEFAULT_DIFF_JOBS 4
+
 /* Set up *DIFF_PROCESSOR and *DDI for normal and git-style diffs (but not
  * summary diffs).
+ *
+ * If DIFF_QUEUE is not NULL, allow file content diffs to be calculated
+ * concurrently and set *DIFF_QUEUE to the queue that serializes their
+ * output, or to NULL if everything will be written synchronously.
+ * In the former case, the caller must drain *DIFF_QUEUE after driving
+ * *DIFF_PROCESSOR.
  */
 static svn_error_t *
 get_diff_processor(svn_diff_tree_processor_t **diff_processor,
@@ -2635,6 +3009,7 @@ get_diff_processor(svn_diff_tree_processor_t **diff_processor,
                    const char *header_encoding,
                    svn_stream_t *outstream,
                    svn_stream_t *errstream,
+                   svn_task__queue_t **diff_queue,
                    svn_client_ctx_t *ctx,
                    apr_pool_t *pool)
 {
@@ -2667,6 +3042,34 @@ get_diff_processor(svn_diff_tree_processor_t **diff_processor,
   dwi->ddi.session_relpath = NULL;
   dwi->ddi.anchor = NULL;
 
+  /* External diff commands and property-only diffs are always run
+     synchronously. */
+  if (diff_queue && !dwi->diff_cmd && !properties_only)
+    {
+      svn_config_t *cfg = ctx->config
+                        ? svn_hash_gets(ctx->config,
+                                        SVN_CONFIG_CATEGORY_CONFIG)
+                        : NULL;
+      apr_int64_t jobs;
+
+      SVN_ERR(svn_config_get_int64(cfg, &jobs, SVN_CONFIG_SECTION_MISCELLANY,
+                                   SVN_CONFIG_OPTION_DIFF_JOBS,
+                                   DEFAULT_DIFF_JOBS));
+      if (jobs > 1)
+        {
+          SVN_ERR(svn_task__queue_create(&dwi->diff_queue,
+                                         (int)MIN(jobs, APR_INT32_MAX),
+                                         0, pool));
+
+          /* Without thread support, the queue would not gain anything. */
+          if (svn_task__queue_thread_count(dwi->diff_queue) == 0)
+            dwi->diff_queue = NULL;
+        }
+    }
+
+  if (diff_queue)
+    *diff_queue = dwi->diff_queue;
+
   processor = svn_diff__tree_processor_create(dwi, pool);
 
   processor->dir_added = diff_dir_added;
@@ -2718,6 +3121,7 @@ svn_client__get_diff_writer_svn(
                              pretty_print_mergeinfo,
                              header_encoding,
                              outstream, errstream,
+                             NULL /* diff_queue */,
                              ctx, pool));
   ddi->anchor = anchor;
   ddi->orig_path_1 = orig_path_1;
@@ -2788,6 +3192,7 @@ svn_client_diff7(const apr_array_header_t *options,
   svn_opt_revision_t peg_revision;
   svn_diff_tree_processor_t *diff_processor;
   struct diff_driver_info_t *ddi;
+  svn_task__queue_t *diff_queue;
 
   if (ignore_properties && properties_only)
     return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
@@ -2814,15 +3219,22 @@ svn_client_diff7(const apr_array_header_t *options,
                              pretty_print_mergeinfo,
                              header_encoding,
                              outstream, errstream,
+                             &diff_queue,
                              ctx, pool));
 
-  return svn_error_trace(do_diff(ddi,
-                                 path_or_url1, path_or_url2,
-                                 revision1, revision2,
-                                 &peg_revision, TRUE /* no_peg_revision */,
-                                 depth, ignore_ancestry, changelists,
-                                 TRUE /* text_deltas */,
-                                 diff_processor, ctx, pool, pool));
+  SVN_ERR(do_diff(ddi,
+                  path_or_url1, path_or_url2,
+                  revision1, revision2,
+                  &peg_revision, TRUE /* no_peg_revision */,
+                  depth, ignore_ancestry, changelists,
+                  TRUE /* text_deltas */,
+                  diff_processor, ctx, pool, pool));
+
+  /* Write the file diffs that are still in flight. */
+  if (diff_queue)
+    SVN_ERR(svn_task__queue_drain(diff_queue, pool));
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -2851,6 +3263,7 @@ svn_client_diff_peg7(const apr_array_header_t *options,
 {
   svn_diff_tree_processor_t *diff_processor;
   struct diff_driver_info_t *ddi;
+  svn_task__queue_t *diff_queue;
 
   if (ignore_properties && properties_only)
     return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
@@ -2874,15 +3287,22 @@ svn_client_diff_peg7(const apr_array_header_t *options,
                              pretty_print_mergeinfo,
                              header_encoding,
                              outstream, errstream,
+                             &diff_queue,
                              ctx, pool));
 
-  return svn_error_trace(do_diff(ddi,
-                                 path_or_url, path_or_url,
-                                 start_revision, end_revision,
-                                 peg_revision, FALSE /* no_peg_revision */,
-                                 depth, ignore_ancestry, changelists,
-                                 TRUE /* text_deltas */,
-                                 diff_processor, ctx, pool, pool));
+  SVN_ERR(do_diff(ddi,
+                  path_or_url, path_or_url,
+                  start_revision, end_revision,
+                  peg_revision, FALSE /* no_peg_revision */,
+                  depth, ignore_ancestry, changelists,
+                  TRUE /* text_deltas */,
+                  diff_processor, ctx, pool, pool));
+
+  /* Write the file diffs that are still in flight. */
+  if (diff_queue)
+    SVN_ERR(svn_task__queue_drain(diff_queue, pool));
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
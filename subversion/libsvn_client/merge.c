@@ -2120,7 +2120,16 @@ merge_file_changed(const char *relpath,
                                       local_abspath, FALSE, scratch_pool));
 
       /* Do property merge and text merge in one step so that keyword expansion
-         takes into account the new property values. */
+         takes into account the new property values.
+
+         Unlike the file diffs of 'svn diff', this is not handed to a
+         svn_task__queue_t.  svn_wc_merge5() interleaves the diff3 with
+         wc.db and work queue updates and may invoke the interactive
+         conflict resolver, and the outcome decides how the following
+         nodes get merged (see CONFLICTED_PATHS and the tree conflict
+         handling).  Running the diff3 concurrently would first require
+         splitting svn_wc_merge5() into a pure content merge and a
+         separate install step. */
       SVN_ERR(svn_wc_merge5(&content_outcome, &property_state, ctx->wc_ctx,
                             left_file, right_file, local_abspath,
                             left_label, right_label, target_label,
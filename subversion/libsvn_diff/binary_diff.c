@@ -26,6 +26,8 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_diff.h"
+#include "svn_delta.h"
+#include "svn_sorts.h"
 #include "svn_types.h"
 
 #include "diff.h"
@@ -33,11 +35,14 @@
 #include "svn_private_config.h"
 
 /* Copies the data from ORIGINAL_STREAM to a temporary file, returning both
-   the original and compressed size. */
+   the original and compressed size.  If RAW_PATH is not NULL, also store an
+   uncompressed copy of the data in another temporary file and return its
+   name in *RAW_PATH. */
 static svn_error_t *
 create_compressed(apr_file_t **result,
                   svn_filesize_t *full_size,
                   svn_filesize_t *compressed_size,
+                  const char **raw_path,
                   svn_stream_t *original_stream,
                   svn_cancel_func_t cancel_func,
                   void *cancel_baton,
@@ -45,6 +50,7 @@ create_compressed(apr_file_t **result,
                   apr_pool_t *scratch_pool)
 {
   svn_stream_t *compressed;
+  svn_stream_t *raw = NULL;
   svn_filesize_t bytes_read = 0;
   apr_size_t rd;
 
@@ -56,6 +62,11 @@ create_compressed(apr_file_t **result,
                   svn_stream_from_aprfile2(*result, TRUE, scratch_pool),
                   scratch_pool);
 
+  if (raw_path)
+    SVN_ERR(svn_stream_open_unique(&raw, raw_path, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   result_pool, scratch_pool));
+
   if (original_stream)
     do
     {
@@ -69,6 +80,9 @@ create_compressed(apr_file_t **result,
 
       bytes_read += rd;
       SVN_ERR(svn_stream_write(compressed, buffer, &rd));
+
+      if (raw)
+        SVN_ERR(svn_stream_write(raw, buffer, &rd));
     }
     while(rd == SVN__STREAM_CHUNK_SIZE);
   else
@@ -78,6 +92,8 @@ create_compressed(apr_file_t **result,
     }
 
   SVN_ERR(svn_stream_close(compressed)); /* Flush compression */
+  if (raw)
+    SVN_ERR(svn_stream_close(raw));
 
   *full_size = bytes_read;
   SVN_ERR(svn_io_file_size_get(compressed_size, *result, scratch_pool));
@@ -85,9 +101,217 @@ create_compressed(apr_file_t **result,
   return SVN_NO_ERROR;
 }
 
+/* Largest source offset that a git delta copy instruction can express. */
+#define GIT_DELTA_MAX_OFFSET APR_UINT32_MAX
+
+/* Largest number of bytes that a git delta insert instruction can add. */
+#define GIT_DELTA_MAX_INSERT 0x7f
+
+/* Append VALUE in the variable-length size encoding used by the git delta
+   header to OPS. */
+static void
+append_delta_size(svn_stringbuf_t *ops,
+                  svn_filesize_t value)
+{
+  apr_uint64_t v = (apr_uint64_t)value;
+
+  while (v >= 0x80)
+    {
+      svn_stringbuf_appendbyte(ops, (char)((v & 0x7f) | 0x80));
+      v >>= 7;
+    }
+
+  svn_stringbuf_appendbyte(ops, (char)v);
+}
+
+/* Append git delta instructions to OPS that insert the LEN bytes at DATA
+   into the target. */
+static void
+append_delta_insert(svn_stringbuf_t *ops,
+                    const char *data,
+                    apr_size_t len)
+{
+  while (len)
+    {
+      apr_size_t chunk = MIN(len, GIT_DELTA_MAX_INSERT);
+
+      svn_stringbuf_appendbyte(ops, (char)chunk);
+      svn_stringbuf_appendbytes(ops, data, chunk);
+
+      data += chunk;
+      len -= chunk;
+    }
+}
+
+/* Append a git delta instruction to OPS that copies LEN bytes from OFFSET
+   in the source to the target.  LEN must be > 0 and < 2^24. */
+static void
+append_delta_copy(svn_stringbuf_t *ops,
+                  apr_uint32_t offset,
+                  apr_uint32_t len)
+{
+  unsigned char insn[8];
+  apr_size_t insn_len = 1;
+  int i;
+
+  /* Only the non-zero bytes of offset and size get stored.  The bits of
+     the first byte tell which ones these are. */
+  insn[0] = 0x80;
+  for (i = 0; i < 4; i++)
+    if ((offset >> (8 * i)) & 0xff)
+      {
+        insn[0] |= 1 << i;
+        insn[insn_len++] = (offset >> (8 * i)) & 0xff;
+      }
+
+  for (i = 0; i < 3; i++)
+    if ((len >> (8 * i)) & 0xff)
+      {
+        insn[0] |= 0x10 << i;
+        insn[insn_len++] = (len >> (8 * i)) & 0xff;
+      }
+
+  svn_stringbuf_appendbytes(ops, (const char *)insn, insn_len);
+}
+
+/* Append the git delta instructions that produce the target view of WINDOW
+   to OPS.  SOURCE_FILE contains the data that WINDOW refers to as source.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+append_window_ops(svn_stringbuf_t *ops,
+                  svn_txdelta_window_t *window,
+                  apr_file_t *source_file,
+                  apr_pool_t *scratch_pool)
+{
+  char *sbuf = NULL;
+  char *tbuf = apr_palloc(scratch_pool, MAX(window->tview_len, 1));
+  apr_size_t tlen = window->tview_len;
+  apr_size_t tpos = 0;
+  apr_size_t insert_start = 0;
+  int i;
+
+  if (window->sview_len)
+    {
+      apr_off_t offset = window->sview_offset;
+
+      sbuf = apr_palloc(scratch_pool, window->sview_len);
+      SVN_ERR(svn_io_file_seek(source_file, APR_SET, &offset, scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(source_file, sbuf, window->sview_len,
+                                     NULL, NULL, scratch_pool));
+    }
+
+  /* Git deltas have no equivalent to our target copies, hence anything
+     but copies from the source gets inserted as literal data taken from
+     the reconstructed target view. */
+  svn_txdelta_apply_instructions(window, sbuf, tbuf, &tlen);
+
+  for (i = 0; i < window->num_ops; i++)
+    {
+      const svn_txdelta_op_t *op = &window->ops[i];
+      svn_filesize_t offset = window->sview_offset + op->offset;
+
+      if (op->action_code == svn_txdelta_source
+          && offset <= GIT_DELTA_MAX_OFFSET)
+        {
+          append_delta_insert(ops, tbuf + insert_start, tpos - insert_start);
+          append_delta_copy(ops, (apr_uint32_t)offset,
+                            (apr_uint32_t)op->length);
+          insert_start = tpos + op->length;
+        }
+
+      tpos += op->length;
+    }
+
+  append_delta_insert(ops, tbuf + insert_start, tpos - insert_start);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the git delta that transforms the SOURCE_SIZE bytes in the file
+   SOURCE_PATH into the TARGET_SIZE bytes in the file TARGET_PATH to a
+   temporary file, compressed.  Return that file in *RESULT, the size of
+   the uncompressed delta in *DELTA_SIZE and the size of the compressed
+   data in *COMPRESSED_SIZE.
+
+   The delta gets calculated window by window, so memory usage does not
+   depend on the size of the files. */
+static svn_error_t *
+create_compressed_delta(apr_file_t **result,
+                        svn_filesize_t *delta_size,
+                        svn_filesize_t *compressed_size,
+                        const char *source_path,
+                        svn_filesize_t source_size,
+                        const char *target_path,
+                        svn_filesize_t target_size,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stream_t *compressed;
+  svn_stream_t *source;
+  svn_stream_t *target;
+  apr_file_t *source_file;
+  svn_txdelta_stream_t *txdelta;
+  svn_txdelta_window_t *window;
+  svn_stringbuf_t *ops = svn_stringbuf_create_empty(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_io_open_uniquely_named(result, NULL, NULL, "diffgz",
+                                     NULL, svn_io_file_del_on_pool_cleanup,
+                                     result_pool, scratch_pool));
+
+  compressed = svn_stream_compressed(
+                  svn_stream_from_aprfile2(*result, TRUE, scratch_pool),
+                  scratch_pool);
+
+  SVN_ERR(svn_stream_open_readonly(&source, source_path,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_readonly(&target, target_path,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_file_open(&source_file, source_path, APR_READ,
+                           APR_OS_DEFAULT, scratch_pool));
+
+  svn_txdelta2(&txdelta, source, target, FALSE, scratch_pool);
+
+  append_delta_size(ops, source_size);
+  append_delta_size(ops, target_size);
+  *delta_size = 0;
+
+  do
+    {
+      apr_size_t len;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_txdelta_next_window(&window, txdelta, iterpool));
+      if (window)
+        SVN_ERR(append_window_ops(ops, window, source_file, iterpool));
+
+      len = ops->len;
+      *delta_size += len;
+      SVN_ERR(svn_stream_write(compressed, ops->data, &len));
+      svn_stringbuf_setempty(ops);
+    }
+  while (window);
+
+  SVN_ERR(svn_stream_close(compressed)); /* Flush compression */
+  SVN_ERR(svn_stream_close(source));
+  SVN_ERR(svn_stream_close(target));
+  SVN_ERR(svn_io_file_close(source_file, scratch_pool));
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_io_file_size_get(compressed_size, *result, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 #define GIT_BASE85_CHUNKSIZE 52
 
-/* Git Base-85 table for write_literal */
+/* Git Base-85 table for append_base85_line */
 static const char b85str[] =
     "0123456789"
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
@@ -154,127 +378,196 @@ svn_diff__base85_decode_line(char *output_data,
 }
 
 
-/* Git length encoding table for write_literal */
+/* Git length encoding table for append_base85_line */
 static const char b85lenstr[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
     "abcdefghijklmnopqrstuvwxyz";
 
-/* Writes out a git-like literal output of the compressed data in
-   COMPRESSED_DATA to OUTPUT_STREAM, describing that its normal length is
-   UNCOMPRESSED_SIZE. */
+/* Size of the blocks in which write_base85() reads the compressed data.
+   A multiple of GIT_BASE85_CHUNKSIZE, so that only the last block can
+   produce a partial line. */
+#define BASE85_BLOCK_SIZE (GIT_BASE85_CHUNKSIZE * 256)
+
+/* Append the base85 encoding of the LEN bytes at DATA, as a single line of
+   the git binary patch format, to LINES.  LEN must be in the range
+   1 .. GIT_BASE85_CHUNKSIZE. */
+static void
+append_base85_line(svn_stringbuf_t *lines,
+                   const unsigned char *data,
+                   apr_size_t len)
+{
+  svn_stringbuf_appendbyte(lines, b85lenstr[len - 1]);
+
+  while (len)
+    {
+      char five[5];
+      unsigned info = 0;
+      int n;
+
+      /* Push 4 bytes into the 32 bit info, when available */
+      for (n = 24; n >= 0 && len; n -= 8, data++, len--)
+        info |= (*data) << n;
+
+      /* Write out info as base85 */
+      for (n = 4; n >= 0; n--)
+        {
+          five[n] = b85str[info % 85];
+          info /= 85;
+        }
+
+      svn_stringbuf_appendbytes(lines, five, sizeof(five));
+    }
+
+  svn_stringbuf_appendcstr(lines, APR_EOL_STR);
+}
+
+/* Writes out the data in COMPRESSED_DATA, base85-encoded in git binary
+   patch lines, to OUTPUT_STREAM.  The data gets encoded and written in
+   blocks of limited size. */
 static svn_error_t *
-write_literal(svn_filesize_t uncompressed_size,
-              svn_stream_t *compressed_data,
-              svn_stream_t *output_stream,
-              svn_cancel_func_t cancel_func,
-              void *cancel_baton,
-              apr_pool_t *scratch_pool)
+write_base85(svn_stream_t *compressed_data,
+             svn_stream_t *output_stream,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *scratch_pool)
 {
+  unsigned char *block = apr_palloc(scratch_pool, BASE85_BLOCK_SIZE);
+  svn_stringbuf_t *lines
+    = svn_stringbuf_create_ensure(BASE85_BLOCK_SIZE / 4 * 5
+                                  + (BASE85_BLOCK_SIZE / GIT_BASE85_CHUNKSIZE)
+                                    * (1 + sizeof(APR_EOL_STR)),
+                                  scratch_pool);
   apr_size_t rd;
-  SVN_ERR(svn_stream_seek(compressed_data, NULL)); /* Seek to start */
 
-  SVN_ERR(svn_stream_printf(output_stream, scratch_pool,
-                            "literal %" SVN_FILESIZE_T_FMT APR_EOL_STR,
-                            uncompressed_size));
+  SVN_ERR(svn_stream_seek(compressed_data, NULL)); /* Seek to start */
 
   do
     {
-      char chunk[GIT_BASE85_CHUNKSIZE];
-      const unsigned char *next;
-      apr_size_t left;
+      apr_size_t offset;
+      apr_size_t len;
 
-      rd = sizeof(chunk);
+      rd = BASE85_BLOCK_SIZE;
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      SVN_ERR(svn_stream_read_full(compressed_data, chunk, &rd));
+      SVN_ERR(svn_stream_read_full(compressed_data, (char *)block, &rd));
 
-      {
-        apr_size_t one = 1;
-        SVN_ERR(svn_stream_write(output_stream, &b85lenstr[rd-1], &one));
-      }
+      svn_stringbuf_setempty(lines);
+      for (offset = 0; offset < rd; offset += GIT_BASE85_CHUNKSIZE)
+        append_base85_line(lines, block + offset,
+                           MIN(rd - offset, GIT_BASE85_CHUNKSIZE));
 
-      left = rd;
-      next = (void*)chunk;
-      while (left)
-      {
-        char five[5];
-        unsigned info = 0;
-        int n;
-        apr_size_t five_sz;
+      len = lines->len;
+      SVN_ERR(svn_stream_write(output_stream, lines->data, &len));
+    }
+  while (rd == BASE85_BLOCK_SIZE);
 
-        /* Push 4 bytes into the 32 bit info, when available */
-        for (n = 24; n >= 0 && left; n -= 8, next++, left--)
-        {
-            info |= (*next) << n;
-        }
+  return SVN_NO_ERROR;
+}
+
+/* Writes out a git-like binary hunk to OUTPUT_STREAM that produces the
+   TARGET_SIZE bytes of target data.  COMPRESSED_TARGET is a file containing
+   these data compressed, COMPRESSED_SIZE bytes in total.
+
+   If SOURCE_PATH and TARGET_PATH are not NULL, they are files containing
+   the SOURCE_SIZE bytes of source data and the uncompressed target data.
+   In that case, write a delta against the source data instead of the
+   literal target data if that is smaller. */
+static svn_error_t *
+write_hunk(svn_stream_t *output_stream,
+           apr_file_t *compressed_target,
+           svn_filesize_t target_size,
+           svn_filesize_t compressed_size,
+           const char *source_path,
+           svn_filesize_t source_size,
+           const char *target_path,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *scratch_pool)
+{
+  apr_file_t *data = compressed_target;
+  const char *kind = "literal";
+  svn_filesize_t size = target_size;
 
-        /* Write out info as base85 */
-        for (n = 4; n >= 0; n--)
+  /* Like git, don't bother with deltas from or to empty files. */
+  if (source_path && target_path && source_size && target_size)
+    {
+      apr_file_t *delta;
+      svn_filesize_t delta_size;
+      svn_filesize_t compressed_delta_size;
+
+      SVN_ERR(create_compressed_delta(&delta, &delta_size,
+                                      &compressed_delta_size,
+                                      source_path, source_size,
+                                      target_path, target_size,
+                                      cancel_func, cancel_baton,
+                                      scratch_pool, scratch_pool));
+
+      if (compressed_delta_size < compressed_size)
         {
-            five[n] = b85str[info % 85];
-            info /= 85;
+          data = delta;
+          kind = "delta";
+          size = delta_size;
         }
+    }
 
-        five_sz = 5;
-        SVN_ERR(svn_stream_write(output_stream, five, &five_sz));
-      }
+  SVN_ERR(svn_stream_printf(output_stream, scratch_pool,
+                            "%s %" SVN_FILESIZE_T_FMT APR_EOL_STR,
+                            kind, size));
 
-      SVN_ERR(svn_stream_puts(output_stream, APR_EOL_STR));
-    }
-  while (rd == GIT_BASE85_CHUNKSIZE);
+  SVN_ERR(write_base85(svn_stream_from_aprfile2(data, TRUE, scratch_pool),
+                       output_stream, cancel_func, cancel_baton,
+                       scratch_pool));
 
   return SVN_NO_ERROR;
 }
 
 svn_error_t *
-svn_diff_output_binary(svn_stream_t *output_stream,
-                       svn_stream_t *original,
-                       svn_stream_t *latest,
-                       svn_cancel_func_t cancel_func,
-                       void *cancel_baton,
-                       apr_pool_t *scratch_pool)
+svn_diff_output_binary2(svn_stream_t *output_stream,
+                        svn_stream_t *original,
+                        svn_stream_t *latest,
+                        svn_boolean_t allow_deltas,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool)
 {
   apr_file_t *original_apr;
   svn_filesize_t original_full;
   svn_filesize_t original_deflated;
+  const char *original_path = NULL;
   apr_file_t *latest_apr;
   svn_filesize_t latest_full;
   svn_filesize_t latest_deflated;
+  const char *latest_path = NULL;
   apr_pool_t *subpool = svn_pool_create(scratch_pool);
 
   SVN_ERR(create_compressed(&original_apr, &original_full, &original_deflated,
+                            allow_deltas ? &original_path : NULL,
                             original, cancel_func, cancel_baton,
                             scratch_pool, subpool));
   svn_pool_clear(subpool);
 
   SVN_ERR(create_compressed(&latest_apr, &latest_full, &latest_deflated,
+                            allow_deltas ? &latest_path : NULL,
                             latest,  cancel_func, cancel_baton,
                             scratch_pool, subpool));
   svn_pool_clear(subpool);
 
   SVN_ERR(svn_stream_puts(output_stream, "GIT binary patch" APR_EOL_STR));
 
-  /* ### git would first calculate if a git-delta latest->original would be
-         shorter than the zipped data. For now lets assume that it is not
-         and just dump the literal data */
-  SVN_ERR(write_literal(latest_full,
-                        svn_stream_from_aprfile2(latest_apr, FALSE, subpool),
-                        output_stream,
-                        cancel_func, cancel_baton,
-                        scratch_pool));
+  /* Forward hunk: latest, possibly as delta against original. */
+  SVN_ERR(write_hunk(output_stream, latest_apr, latest_full, latest_deflated,
+                     original_path, original_full, latest_path,
+                     cancel_func, cancel_baton, subpool));
   svn_pool_clear(subpool);
   SVN_ERR(svn_stream_puts(output_stream, APR_EOL_STR));
 
-  /* ### git would first calculate if a git-delta original->latest would be
-         shorter than the zipped data. For now lets assume that it is not
-         and just dump the literal data */
-  SVN_ERR(write_literal(original_full,
-                        svn_stream_from_aprfile2(original_apr, FALSE, subpool),
-                        output_stream,
-                        cancel_func, cancel_baton,
-                        scratch_pool));
+  /* Reverse hunk: original, possibly as delta against latest. */
+  SVN_ERR(write_hunk(output_stream, original_apr, original_full,
+                     original_deflated,
+                     latest_path, latest_full, original_path,
+                     cancel_func, cancel_baton, subpool));
   svn_pool_destroy(subpool);
 
   return SVN_NO_ERROR;
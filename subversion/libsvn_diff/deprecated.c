@@ -462,3 +462,18 @@ svn_diff_mem_string_output_unified2(svn_stream_t *output_stream,
                                                              NULL, NULL,
                                                              pool));
 }
+
+svn_error_t *
+svn_diff_output_binary(svn_stream_t *output_stream,
+                       svn_stream_t *original,
+                       svn_stream_t *latest,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_diff_output_binary2(output_stream,
+                                                 original, latest,
+                                                 FALSE /* allow_deltas */,
+                                                 cancel_func, cancel_baton,
+                                                 scratch_pool));
+}
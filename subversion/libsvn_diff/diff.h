@@ -115,6 +115,27 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               apr_pool_t *pool);
 
 
+/*
+ * Like svn_diff__lcs(), but use the patience diff algorithm: lines that
+ * occur exactly once in both datasources are matched up first and only
+ * the (typically small) ranges between those anchors are compared.  Ranges
+ * without unique lines use their least frequent lines as anchors.  Only if
+ * those are too frequent as well, svn_diff__lcs() gets used, with a limit
+ * on its work per range.  This bounds the cost of the O(NP) algorithm on
+ * inputs with many differences, e.g. reordered blocks of code.
+ *
+ * NUM_TOKENS is the number of distinct tokens in both position lists.
+ * Allocations will be made from POOL.
+ */
+svn_diff__lcs_t *
+svn_diff__lcs_patience(svn_diff__position_t *position_list1, /* tail (ring) */
+                       svn_diff__position_t *position_list2, /* tail (ring) */
+                       svn_diff__token_index_t num_tokens,
+                       apr_off_t prefix_lines,
+                       apr_off_t suffix_lines,
+                       apr_pool_t *pool);
+
+
 /*
  * Returns number of tokens in a tree
  */
@@ -158,6 +179,22 @@ svn_diff__diff(svn_diff__lcs_t *lcs,
                svn_boolean_t want_common,
                apr_pool_t *pool);
 
+/* Like svn_diff_diff_2(), but calculate the LCS using ALGORITHM. */
+svn_error_t *
+svn_diff__diff_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 svn_diff_algorithm_t algorithm,
+                 apr_pool_t *pool);
+
+/* Like svn_diff_diff3_2(), but calculate the LCS using ALGORITHM. */
+svn_error_t *
+svn_diff__diff3_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_diff_algorithm_t algorithm,
+                  apr_pool_t *pool);
+
 void
 svn_diff__resolve_conflict(svn_diff_t *hunk,
                            svn_diff__position_t **position_list1,
@@ -51,6 +51,7 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_adler32.h"
 #include "private/svn_diff_private.h"
+#include "private/svn_simd_private.h"
 
 /* A token, i.e. a line read from a file. */
 typedef struct svn_diff__file_token_t
@@ -396,9 +397,9 @@ find_identical_prefix(svn_boolean_t *reached_one_eof, apr_off_t *prefix_lines,
     is_match = is_match && *file[0].curp == *file[i].curp;
   while (is_match)
     {
-#if SVN_UNALIGNED_ACCESS_IS_OK
+#if SVN__HAVE_SSE2 || SVN_UNALIGNED_ACCESS_IS_OK
       apr_ssize_t max_delta, delta;
-#endif /* SVN_UNALIGNED_ACCESS_IS_OK */
+#endif /* SVN__HAVE_SSE2 || SVN_UNALIGNED_ACCESS_IS_OK */
 
       /* ### TODO: see if we can take advantage of
          diff options like ignore_eol_style or ignore_space. */
@@ -419,7 +420,54 @@ find_identical_prefix(svn_boolean_t *reached_one_eof, apr_off_t *prefix_lines,
 
       INCREMENT_POINTERS(file, file_len, pool);
 
-#if SVN_UNALIGNED_ACCESS_IS_OK
+#if SVN__HAVE_SSE2
+
+      /* Try to advance as far as possible in blocks of 16 bytes.
+       * Determine how far we may advance that way without reaching
+       * endp for any of the files.
+       * Signedness is important here if curp gets close to endp.
+       */
+      max_delta = file[0].endp - file[0].curp - sizeof(__m128i);
+      for (i = 1; i < file_len; i++)
+        {
+          delta = file[i].endp - file[i].curp - sizeof(__m128i);
+          if (delta < max_delta)
+            max_delta = delta;
+        }
+
+      /* Unlike the word-wise scan below, don't stop at EOLs but count
+       * them on the fly:  Every CR starts a new line and so does every LF
+       * that does not follow a CR. */
+      for (delta = 0; delta < max_delta; delta += sizeof(__m128i))
+        {
+          const __m128i block
+            = _mm_loadu_si128((const __m128i *)(file[0].curp + delta));
+          __m128i equal = _mm_set1_epi8(-1);
+          apr_uint32_t cr_mask, lf_mask;
+
+          for (i = 1; i < file_len; i++)
+            equal = _mm_and_si128(equal, _mm_cmpeq_epi8(block,
+                      _mm_loadu_si128((const __m128i *)(file[i].curp
+                                                        + delta))));
+
+          if (_mm_movemask_epi8(equal) != 0xffff)
+            break;
+
+          cr_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block,
+                                                     _mm_set1_epi8('\r')));
+          lf_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block,
+                                                     _mm_set1_epi8('\n')));
+          lines += svn__bit_count(cr_mask)
+                 + svn__bit_count(lf_mask
+                                  & ~((cr_mask << 1) | (had_cr ? 1 : 0)));
+          had_cr = (cr_mask & 0x8000) != 0;
+        }
+
+      /* Everything up to curp + delta is equal. */
+      for (i = 0; i < file_len; i++)
+        file[i].curp += delta;
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
 
       /* Try to advance as far as possible with machine-word granularity.
        * Determine how far we may advance with chunky ops without reaching
@@ -611,7 +659,11 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
   while (is_match)
     {
       svn_boolean_t reached_prefix;
-#if SVN_UNALIGNED_ACCESS_IS_OK
+#if SVN__HAVE_SSE2
+      /* Initialize the minimum pointer positions. */
+      const char *min_curp[4];
+      svn_boolean_t can_read_block;
+#elif SVN_UNALIGNED_ACCESS_IS_OK
       /* Initialize the minimum pointer positions. */
       const char *min_curp[4];
       svn_boolean_t can_read_word;
@@ -636,7 +688,67 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
 
       DECREMENT_POINTERS(file_for_suffix, file_len, pool);
 
-#if SVN_UNALIGNED_ACCESS_IS_OK
+#if SVN__HAVE_SSE2
+      for (i = 0; i < file_len; i++)
+        min_curp[i] = file_for_suffix[i].buffer;
+
+      /* If we are in the same chunk that contains the last part of the common
+         prefix, use the min_curp[0] pointer to make sure we don't get a
+         suffix that overlaps the already determined common prefix. */
+      if (file_for_suffix[0].chunk == suffix_min_chunk0)
+        min_curp[0] += suffix_min_offset0;
+
+      /* Scan quickly in blocks of 16 bytes. */
+      for (i = 0, can_read_block = TRUE; can_read_block && i < file_len; i++)
+        can_read_block = ((file_for_suffix[i].curp + 1 - sizeof(__m128i))
+                          > min_curp[i]);
+
+      while (can_read_block)
+        {
+          /* For each file curp is positioned at the current byte, but we
+             want to examine the current byte and the ones before the current
+             location as one block. */
+          const __m128i block
+            = _mm_loadu_si128((const __m128i *)(file_for_suffix[0].curp + 1
+                                                - sizeof(__m128i)));
+          __m128i equal = _mm_set1_epi8(-1);
+          apr_uint32_t cr_mask, lf_mask;
+
+          for (i = 1; i < file_len; i++)
+            equal = _mm_and_si128(equal, _mm_cmpeq_epi8(block,
+                      _mm_loadu_si128((const __m128i *)
+                                        (file_for_suffix[i].curp + 1
+                                         - sizeof(__m128i)))));
+
+          if (_mm_movemask_epi8(equal) != 0xffff)
+            break;
+
+          /* Count EOLs while scanning backwards:  Every LF ends a line and
+             so does every CR that is not followed by a LF. */
+          cr_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block,
+                                                     _mm_set1_epi8('\r')));
+          lf_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block,
+                                                     _mm_set1_epi8('\n')));
+          lines += svn__bit_count(lf_mask)
+                 + svn__bit_count(cr_mask
+                                  & ~((lf_mask >> 1)
+                                      | (had_nl ? 0x8000 : 0)));
+          had_nl = (lf_mask & 1) != 0;
+
+          for (i = 0; i < file_len; i++)
+            {
+              file_for_suffix[i].curp -= sizeof(__m128i);
+              can_read_block = can_read_block
+                               && (  (file_for_suffix[i].curp + 1
+                                        - sizeof(__m128i))
+                                   > min_curp[i]);
+            }
+        }
+
+      /* The > min_curp[i] check leaves at least one final byte for checking
+         in the non block optimized case below. */
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
       for (i = 0; i < file_len; i++)
         min_curp[i] = file_for_suffix[i].buffer;
 
@@ -1181,6 +1293,11 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
 
 /* Id for the --ignore-eol-style option, which doesn't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
+/* Ids for the --diff-algorithm and --patience options. */
+#define SVN_DIFF__OPT_DIFF_ALGORITHM 257
+#define SVN_DIFF__OPT_PATIENCE 258
+/* Id for the --git-binary-deltas option. */
+#define SVN_DIFF__OPT_GIT_BINARY_DELTAS 259
 
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
@@ -1193,6 +1310,9 @@ static const apr_getopt_option_t diff_options[] =
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
   { "context", 'U', 1, NULL },
+  { "diff-algorithm", SVN_DIFF__OPT_DIFF_ALGORITHM, 1, NULL },
+  { "patience", SVN_DIFF__OPT_PATIENCE, 0, NULL },
+  { "git-binary-deltas", SVN_DIFF__OPT_GIT_BINARY_DELTAS, 0, NULL },
   { NULL, 0, 0, NULL }
 };
 
@@ -1298,6 +1418,22 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case 'U':
           SVN_ERR(svn_cstring_atoi(&options->context_size, opt_arg));
           break;
+        case SVN_DIFF__OPT_DIFF_ALGORITHM:
+          if (strcmp(opt_arg, "myers") == 0)
+            options->algorithm = svn_diff_algorithm_myers;
+          else if (strcmp(opt_arg, "patience") == 0)
+            options->algorithm = svn_diff_algorithm_patience;
+          else
+            return svn_error_createf(SVN_ERR_INVALID_DIFF_OPTION, NULL,
+                                     _("Unknown diff algorithm '%s'"),
+                                     opt_arg);
+          break;
+        case SVN_DIFF__OPT_PATIENCE:
+          options->algorithm = svn_diff_algorithm_patience;
+          break;
+        case SVN_DIFF__OPT_GIT_BINARY_DELTAS:
+          options->git_binary_deltas = TRUE;
+          break;
         default:
           break;
         }
@@ -1326,7 +1462,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, &baton, &svn_diff__file_vtable,
+                           options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1348,7 +1485,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -26,6 +26,9 @@
 #include <apr_pools.h>
 #include <apr_general.h>
 
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
 #include "diff.h"
 
 
@@ -228,15 +231,19 @@ prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t lines,
 }
 
 
-svn_diff__lcs_t *
-svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
-              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
-              svn_diff__token_index_t *token_counts_list1, /* array of counts */
-              svn_diff__token_index_t *token_counts_list2, /* array of counts */
-              svn_diff__token_index_t num_tokens,
-              apr_off_t prefix_lines,
-              apr_off_t suffix_lines,
-              apr_pool_t *pool)
+/* Implements svn_diff__lcs().  If MAX_P is not negative, give up and
+ * return NULL once more than MAX_P deletions (or insertions, see above)
+ * would be needed, i.e. after O((M + N) * MAX_P) work. */
+static svn_diff__lcs_t *
+find_lcs(svn_diff__position_t *position_list1,
+         svn_diff__position_t *position_list2,
+         svn_diff__token_index_t *token_counts_list1,
+         svn_diff__token_index_t *token_counts_list2,
+         svn_diff__token_index_t num_tokens,
+         apr_off_t prefix_lines,
+         apr_off_t suffix_lines,
+         apr_off_t max_p,
+         apr_pool_t *pool)
 {
   apr_off_t length[2];
   svn_diff__token_index_t *token_counts[2];
@@ -352,6 +359,15 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
         }
 
       p++;
+
+      if (max_p >= 0 && p > max_p
+          && fp[0].position[1] != &sentinel_position[1])
+        {
+          position_list1->next = sentinel_position[0].next;
+          position_list2->next = sentinel_position[1].next;
+
+          return NULL;
+        }
     }
   while (fp[0].position[1] != &sentinel_position[1]);
 
@@ -373,3 +389,439 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
   else
     return lcs;
 }
+
+svn_diff__lcs_t *
+svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
+              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+              svn_diff__token_index_t *token_counts_list1, /* array of counts */
+              svn_diff__token_index_t *token_counts_list2, /* array of counts */
+              svn_diff__token_index_t num_tokens,
+              apr_off_t prefix_lines,
+              apr_off_t suffix_lines,
+              apr_pool_t *pool)
+{
+  return find_lcs(position_list1, position_list2,
+                  token_counts_list1, token_counts_list2, num_tokens,
+                  prefix_lines, suffix_lines, -1, pool);
+}
+
+
+/* If a range has no unique common lines, patience diff anchors on the
+ * common lines that occur least often, as long as that is no more than
+ * this many times in either range (like git's histogram diff). */
+#define PATIENCE_MAX_OCCURRENCES 64
+
+/* Ranges without such anchors are compared using the O(NP) algorithm,
+ * but that may spend only about this many steps (lines times edit
+ * distance) on each of them.  Beyond that, the whole range is reported
+ * as changed. */
+#define PATIENCE_MAX_FALLBACK_WORK 0x1000000
+
+/* State shared by the helpers of svn_diff__lcs_patience(). */
+typedef struct patience_baton_t
+{
+  /* The positions of both datasources, indexed by line (0-based). */
+  svn_diff__position_t **position[2];
+
+  /* Number of occurrences of each token in the range being examined.
+   * All entries are zero between calls to patience_diff_range(). */
+  svn_diff__token_index_t *count[2];
+
+  /* Line in the second datasource at which the next unpaired occurrence
+   * of each token within the range can be found, -1 if there is none. */
+  apr_off_t *where;
+
+  /* Line of the next occurrence of the same token within the range in
+   * the second datasource, -1 if there is none.  Indexed by line. */
+  apr_off_t *next_same;
+
+  /* Maps the global token indices to those passed to svn_diff__lcs()
+   * by patience_fallback().  All entries are -1 between calls. */
+  svn_diff__token_index_t *local_index;
+
+  /* Scratch arrays for the unique line pairs and their longest
+   * increasing subsequence. */
+  apr_off_t *candidate[2];
+  apr_off_t *pile_top;
+  apr_off_t *backlink;
+
+  /* The lcs found so far, in reverse order. */
+  svn_diff__lcs_t *lcs;
+
+  apr_pool_t *pool;
+} patience_baton_t;
+
+/* Record that LENGTH lines starting at line IDX0 of the first datasource
+ * match those starting at line IDX1 of the second one in PB. */
+static void
+patience_add_match(patience_baton_t *pb,
+                   apr_off_t idx0,
+                   apr_off_t idx1,
+                   apr_off_t length)
+{
+  svn_diff__lcs_t *lcs = pb->lcs;
+
+  if (length == 0)
+    return;
+
+  /* Extend the previous chunk, if we continue it. */
+  if (lcs
+      && lcs->position[0]->offset + lcs->length
+         == pb->position[0][idx0]->offset
+      && lcs->position[1]->offset + lcs->length
+         == pb->position[1][idx1]->offset)
+    {
+      lcs->length += length;
+      return;
+    }
+
+  lcs = apr_palloc(pb->pool, sizeof(*lcs));
+  lcs->position[0] = pb->position[0][idx0];
+  lcs->position[1] = pb->position[1][idx1];
+  lcs->length = length;
+  lcs->refcount = 1;
+  lcs->next = pb->lcs;
+  pb->lcs = lcs;
+}
+
+/* Find the matching lines in the non-empty ranges [START0, END0) and
+ * [START1, END1) of PB that have no suitable anchor lines, using the O(NP)
+ * algorithm of svn_diff__lcs().  If that takes more than about
+ * PATIENCE_MAX_FALLBACK_WORK steps, don't match any lines. */
+static void
+patience_fallback(patience_baton_t *pb,
+                  apr_off_t start0,
+                  apr_off_t end0,
+                  apr_off_t start1,
+                  apr_off_t end1)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pb->pool);
+  svn_diff__position_t *ring[2];
+  svn_diff__token_index_t *token_counts[2];
+  svn_diff__token_index_t num_tokens = 0;
+  apr_off_t start[2];
+  apr_off_t end[2];
+  apr_off_t base[2];
+  svn_diff__lcs_t *lcs;
+  int i;
+
+  start[0] = start0;
+  start[1] = start1;
+  end[0] = end0;
+  end[1] = end1;
+
+  /* Copy both ranges into new rings, renumbering the tokens such that
+   * svn_diff__lcs() does not have to look at all tokens of the files. */
+  for (i = 0; i < 2; i++)
+    {
+      apr_off_t length = end[i] - start[i];
+      svn_diff__position_t *positions
+        = apr_palloc(scratch_pool, length * sizeof(*positions));
+      apr_off_t k;
+
+      for (k = 0; k < length; k++)
+        {
+          svn_diff__position_t *position = pb->position[i][start[i] + k];
+          svn_diff__token_index_t *local_index
+            = &pb->local_index[position->token_index];
+
+          if (*local_index < 0)
+            *local_index = num_tokens++;
+
+          positions[k].token_index = *local_index;
+          positions[k].offset = position->offset;
+          positions[k].next = &positions[(k + 1) % length];
+        }
+
+      ring[i] = &positions[length - 1];
+      base[i] = pb->position[i][0]->offset;
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      apr_off_t k;
+
+      for (k = start[i]; k < end[i]; k++)
+        pb->local_index[pb->position[i][k]->token_index] = -1;
+
+      token_counts[i] = svn_diff__get_token_counts(ring[i], num_tokens,
+                                                   scratch_pool);
+    }
+
+  lcs = find_lcs(ring[0], ring[1], token_counts[0], token_counts[1],
+                 num_tokens, 0, 0,
+                 PATIENCE_MAX_FALLBACK_WORK / (end0 - start0 + end1 - start1),
+                 scratch_pool);
+
+  /* The positions in LCS are our copies.  Map them back. */
+  for (; lcs && lcs->length > 0; lcs = lcs->next)
+    patience_add_match(pb,
+                       lcs->position[0]->offset - base[0],
+                       lcs->position[1]->offset - base[1],
+                       lcs->length);
+
+  svn_pool_destroy(scratch_pool);
+}
+
+/* Add to the candidate arrays of PB the lines of [START0, END0) whose
+ * token occurs in both ranges, but no more than OCCURRENCES times in
+ * either of them.  The n-th occurrence of a token in the first range gets
+ * paired with its n-th occurrence in the second one.  Return the number
+ * of candidates.
+ *
+ * The token counts, PB->WHERE and PB->NEXT_SAME must have been set up
+ * for the current ranges by the caller. */
+static apr_off_t
+patience_collect(patience_baton_t *pb,
+                 apr_off_t start0,
+                 apr_off_t end0,
+                 svn_diff__token_index_t occurrences)
+{
+  apr_off_t num_candidates = 0;
+  apr_off_t i;
+
+  for (i = start0; i < end0; i++)
+    {
+      svn_diff__token_index_t token_index
+        = pb->position[0][i]->token_index;
+
+      if (pb->count[1][token_index] > 0
+          && pb->count[0][token_index] <= occurrences
+          && pb->count[1][token_index] <= occurrences
+          && pb->where[token_index] >= 0)
+        {
+          pb->candidate[0][num_candidates] = i;
+          pb->candidate[1][num_candidates] = pb->where[token_index];
+          pb->where[token_index] = pb->next_same[pb->where[token_index]];
+          num_candidates++;
+        }
+    }
+
+  return num_candidates;
+}
+
+/* Find the matching lines between the ranges [START0, END0) and
+ * [START1, END1) of PB and add them to PB->LCS.
+ *
+ * After skipping common leading and trailing lines, the lines that occur
+ * exactly once in both ranges are matched up.  If there are none, the
+ * common lines with the lowest number of occurrences are used instead,
+ * unless that number exceeds PATIENCE_MAX_OCCURRENCES.  The longest
+ * increasing subsequence of those pairs is used as a set of fixed anchors
+ * and the ranges between the anchors are handled recursively. */
+static void
+patience_diff_range(patience_baton_t *pb,
+                    apr_off_t start0,
+                    apr_off_t end0,
+                    apr_off_t start1,
+                    apr_off_t end1)
+{
+  svn_diff__position_t **position0 = pb->position[0];
+  svn_diff__position_t **position1 = pb->position[1];
+  apr_off_t head = 0;
+  apr_off_t tail = 0;
+
+  while (start0 + head < end0 && start1 + head < end1
+         && position0[start0 + head]->token_index
+            == position1[start1 + head]->token_index)
+    head++;
+
+  patience_add_match(pb, start0, start1, head);
+  start0 += head;
+  start1 += head;
+
+  while (end0 - tail > start0 && end1 - tail > start1
+         && position0[end0 - tail - 1]->token_index
+            == position1[end1 - tail - 1]->token_index)
+    tail++;
+
+  end0 -= tail;
+  end1 -= tail;
+
+  if (start0 < end0 && start1 < end1)
+    {
+      apr_off_t num_candidates = 0;
+      apr_off_t lis_length = 0;
+      apr_off_t *anchors;
+      apr_off_t i, c;
+
+      for (i = start0; i < end0; i++)
+        pb->count[0][position0[i]->token_index]++;
+
+      /* Chain the occurrences of each token in the second range. */
+      for (i = end1 - 1; i >= start1; i--)
+        {
+          svn_diff__token_index_t token_index = position1[i]->token_index;
+
+          pb->next_same[i] = pb->count[1][token_index]
+                           ? pb->where[token_index]
+                           : -1;
+          pb->count[1][token_index]++;
+          pb->where[token_index] = i;
+        }
+
+      /* Collect the lines unique to both ranges, in first range order. */
+      num_candidates = patience_collect(pb, start0, end0, 1);
+
+      /* Otherwise, try the least frequent lines common to both ranges. */
+      if (num_candidates == 0)
+        {
+          svn_diff__token_index_t lowest = PATIENCE_MAX_OCCURRENCES + 1;
+
+          for (i = start0; i < end0; i++)
+            {
+              svn_diff__token_index_t token_index
+                = position0[i]->token_index;
+
+              if (pb->count[1][token_index] > 0)
+                lowest = MIN(lowest, MAX(pb->count[0][token_index],
+                                         pb->count[1][token_index]));
+            }
+
+          if (lowest <= PATIENCE_MAX_OCCURRENCES)
+            num_candidates = patience_collect(pb, start0, end0, lowest);
+        }
+
+      for (i = start0; i < end0; i++)
+        pb->count[0][position0[i]->token_index] = 0;
+      for (i = start1; i < end1; i++)
+        pb->count[1][position1[i]->token_index] = 0;
+
+      if (num_candidates == 0)
+        {
+          patience_fallback(pb, start0, end0, start1, end1);
+          patience_add_match(pb, end0, end1, tail);
+          return;
+        }
+
+      /* Patience sorting: find the longest subsequence of candidates
+       * that is increasing in the second range as well. */
+      for (c = 0; c < num_candidates; c++)
+        {
+          apr_off_t low = 0;
+          apr_off_t high = lis_length;
+
+          while (low < high)
+            {
+              apr_off_t mid = low + (high - low) / 2;
+
+              if (pb->candidate[1][pb->pile_top[mid]] < pb->candidate[1][c])
+                low = mid + 1;
+              else
+                high = mid;
+            }
+
+          pb->backlink[c] = low > 0 ? pb->pile_top[low - 1] : -1;
+          pb->pile_top[low] = c;
+          if (low == lis_length)
+            lis_length++;
+        }
+
+      /* The scratch arrays get reused by the recursion below, so copy
+       * the anchor lines.  Every line becomes an anchor at most once,
+       * so this needs O(N) memory in total. */
+      anchors = apr_palloc(pb->pool, 2 * lis_length * sizeof(*anchors));
+      i = lis_length;
+      for (c = pb->pile_top[lis_length - 1]; c >= 0; c = pb->backlink[c])
+        {
+          i--;
+          anchors[2 * i] = pb->candidate[0][c];
+          anchors[2 * i + 1] = pb->candidate[1][c];
+        }
+
+      for (i = 0; i < lis_length; i++)
+        {
+          patience_diff_range(pb, start0, anchors[2 * i],
+                              start1, anchors[2 * i + 1]);
+          patience_add_match(pb, anchors[2 * i], anchors[2 * i + 1], 1);
+          start0 = anchors[2 * i] + 1;
+          start1 = anchors[2 * i + 1] + 1;
+        }
+
+      patience_diff_range(pb, start0, end0, start1, end1);
+    }
+
+  patience_add_match(pb, end0, end1, tail);
+}
+
+svn_diff__lcs_t *
+svn_diff__lcs_patience(svn_diff__position_t *position_list1,
+                       svn_diff__position_t *position_list2,
+                       svn_diff__token_index_t num_tokens,
+                       apr_off_t prefix_lines,
+                       apr_off_t suffix_lines,
+                       apr_pool_t *pool)
+{
+  patience_baton_t pb = { { 0 } };
+  svn_diff__position_t *position_list[2];
+  svn_diff__lcs_t *lcs;
+  apr_off_t length[2];
+  svn_diff__token_index_t token_index;
+  int i;
+
+  /* Nothing to anchor on; the default algorithm handles this trivially. */
+  if (position_list1 == NULL || position_list2 == NULL)
+    return svn_diff__lcs(position_list1, position_list2, NULL, NULL,
+                         num_tokens, prefix_lines, suffix_lines, pool);
+
+  position_list[0] = position_list1;
+  position_list[1] = position_list2;
+  pb.pool = pool;
+
+  for (i = 0; i < 2; i++)
+    {
+      svn_diff__position_t *position = position_list[i]->next;
+      apr_off_t k;
+
+      length[i] = position_list[i]->offset - position->offset + 1;
+      pb.position[i] = apr_palloc(pool,
+                                  length[i] * sizeof(*pb.position[i]));
+      for (k = 0; k < length[i]; k++, position = position->next)
+        pb.position[i][k] = position;
+
+      pb.count[i] = apr_pcalloc(pool, num_tokens * sizeof(*pb.count[i]));
+    }
+
+  /* There can't be more candidates than lines in the shorter range. */
+  pb.candidate[0] = apr_palloc(pool, MIN(length[0], length[1])
+                                     * sizeof(*pb.candidate[0]));
+  pb.candidate[1] = apr_palloc(pool, MIN(length[0], length[1])
+                                     * sizeof(*pb.candidate[1]));
+  pb.pile_top = apr_palloc(pool, MIN(length[0], length[1])
+                                 * sizeof(*pb.pile_top));
+  pb.backlink = apr_palloc(pool, MIN(length[0], length[1])
+                                 * sizeof(*pb.backlink));
+  pb.where = apr_palloc(pool, num_tokens * sizeof(*pb.where));
+  pb.next_same = apr_palloc(pool, length[1] * sizeof(*pb.next_same));
+  pb.local_index = apr_palloc(pool, num_tokens * sizeof(*pb.local_index));
+  for (token_index = 0; token_index < num_tokens; token_index++)
+    pb.local_index[token_index] = -1;
+
+  patience_diff_range(&pb, 0, length[0], 0, length[1]);
+
+  /* Since EOF is always a sync point we tack on an EOF link
+   * with sentinel positions, just like svn_diff__lcs() does.
+   */
+  lcs = apr_palloc(pool, sizeof(*lcs));
+  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
+  lcs->position[0]->offset = position_list1->offset + suffix_lines + 1;
+  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
+  lcs->position[1]->offset = position_list2->offset + suffix_lines + 1;
+  lcs->length = 0;
+  lcs->refcount = 1;
+
+  if (suffix_lines)
+    lcs->next = prepend_lcs(pb.lcs, suffix_lines,
+                            lcs->position[0]->offset - suffix_lines,
+                            lcs->position[1]->offset - suffix_lines,
+                            pool);
+  else
+    lcs->next = pb.lcs;
+
+  lcs = svn_diff__lcs_reverse(lcs);
+
+  if (prefix_lines)
+    return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+  else
+    return lcs;
+}
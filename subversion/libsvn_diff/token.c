@@ -22,37 +22,65 @@
  */
 
 
+#include <string.h>
+
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
 
 #include "svn_error.h"
 #include "svn_diff.h"
+#include "svn_pools.h"
 #include "svn_types.h"
 
 #include "diff.h"
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * Initial number of slots in the token hash table.  Must be a power of 2.
+ * The table doubles in size whenever it becomes 3/4 full.
+ */
+#define SVN_DIFF__HASH_INITIAL_SIZE 256
+
+/*
+ * Number of token pointers per block in the token array.  Must be a power
+ * of 2.
  */
-#define SVN_DIFF__HASH_SIZE 127
+#define SVN_DIFF__TOKEN_BLOCK_SHIFT 10
+#define SVN_DIFF__TOKEN_BLOCK_SIZE (1 << SVN_DIFF__TOKEN_BLOCK_SHIFT)
 
+/* A slot in the token hash table.  INDEX is the token index + 1, i.e.
+ * 0 marks an unused slot.  The token itself is kept in the token array,
+ * so a slot takes only 8 bytes. */
 struct svn_diff__node_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
-
   apr_uint32_t            hash;
-  svn_diff__token_index_t index;
-  void                   *token;
+  apr_uint32_t            index;
 };
 
+/* Open-addressing hash table (linear probing) of all distinct tokens.
+ * Only the hashes supplied by the datasource get compared while probing;
+ * the (potentially expensive) token_compare callback is invoked only
+ * if they are equal.
+ *
+ * With the load factor being between 3/8 and 3/4, the slots take 11 to
+ * 22 bytes per token.  The token pointers add another 8 bytes. */
 struct svn_diff__tree_t
 {
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
+  svn_diff__node_t       *slots;
+  apr_size_t              size;
+  int                     shift;
+
+  /* Pool containing SLOTS only.  It gets replaced when the table grows. */
+  apr_pool_t             *slots_pool;
+
+  /* The latest token for each token index, in blocks of
+   * SVN_DIFF__TOKEN_BLOCK_SIZE entries.  Blocks never move, so growing
+   * only needs to copy the BLOCKS array of BLOCKS_SIZE elements. */
+  void                 ***blocks;
+  apr_size_t              block_count;
+  apr_size_t              blocks_size;
+
   apr_pool_t             *pool;
   svn_diff__token_index_t node_count;
 };
@@ -77,66 +105,143 @@ svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
   *tree = apr_pcalloc(pool, sizeof(**tree));
   (*tree)->pool = pool;
   (*tree)->node_count = 0;
+  (*tree)->size = SVN_DIFF__HASH_INITIAL_SIZE;
+  (*tree)->shift = 32 - 8;
+  (*tree)->slots_pool = svn_pool_create(pool);
+  (*tree)->slots = apr_pcalloc((*tree)->slots_pool,
+                               SVN_DIFF__HASH_INITIAL_SIZE
+                               * sizeof(*(*tree)->slots));
+}
+
+/* Return the address of the token pointer for INDEX in TREE. */
+static APR_INLINE void **
+token_ref(const svn_diff__tree_t *tree, apr_uint32_t index)
+{
+  return &tree->blocks[index >> SVN_DIFF__TOKEN_BLOCK_SHIFT]
+                      [index & (SVN_DIFF__TOKEN_BLOCK_SIZE - 1)];
 }
 
+/* Append TOKEN to the token array in TREE at index TREE->NODE_COUNT. */
+static void
+append_token(svn_diff__tree_t *tree, void *token)
+{
+  apr_size_t block = (apr_size_t)tree->node_count
+                   >> SVN_DIFF__TOKEN_BLOCK_SHIFT;
+
+  if (block == tree->block_count)
+    {
+      if (block == tree->blocks_size)
+        {
+          void ***blocks;
+
+          tree->blocks_size = tree->blocks_size ? tree->blocks_size * 2 : 4;
+          blocks = apr_palloc(tree->pool,
+                              tree->blocks_size * sizeof(*blocks));
+          if (block)
+            memcpy(blocks, tree->blocks, block * sizeof(*blocks));
+
+          tree->blocks = blocks;
+        }
+
+      tree->blocks[block] = apr_palloc(tree->pool,
+                                       SVN_DIFF__TOKEN_BLOCK_SIZE
+                                       * sizeof(**tree->blocks));
+      tree->block_count++;
+    }
+
+  *token_ref(tree, (apr_uint32_t)tree->node_count) = token;
+}
+
+/* Return the first slot to probe for HASH in TREE.  The token hashes
+ * (e.g. adler32) tend to be poorly distributed in their lower bits,
+ * so use the upper bits of a multiplicative hash of them. */
+static APR_INLINE apr_size_t
+hash_to_slot(const svn_diff__tree_t *tree, apr_uint32_t hash)
+{
+  return (apr_uint32_t)(hash * 0x9e3779b1U) >> tree->shift;
+}
+
+/* Double the number of slots in TREE. */
+static void
+tree_grow(svn_diff__tree_t *tree)
+{
+  svn_diff__node_t *old_slots = tree->slots;
+  apr_pool_t *old_pool = tree->slots_pool;
+  apr_size_t old_size = tree->size;
+  apr_size_t i;
+
+  tree->size *= 2;
+  tree->shift--;
+  tree->slots_pool = svn_pool_create(tree->pool);
+  tree->slots = apr_pcalloc(tree->slots_pool,
+                            tree->size * sizeof(*tree->slots));
+
+  for (i = 0; i < old_size; i++)
+    if (old_slots[i].index)
+      {
+        apr_size_t slot = hash_to_slot(tree, old_slots[i].hash);
+
+        while (tree->slots[slot].index)
+          slot = (slot + 1) & (tree->size - 1);
+
+        tree->slots[slot] = old_slots[i];
+      }
+
+  svn_pool_destroy(old_pool);
+}
 
 static svn_error_t *
-tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
+tree_insert_token(svn_diff__token_index_t *index, svn_diff__tree_t *tree,
                   void *diff_baton,
                   const svn_diff_fns2_t *vtable,
                   apr_uint32_t hash, void *token)
 {
-  svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
-  int rv;
+  svn_diff__node_t *node;
+  apr_size_t slot;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
+  /* Keep the table at most 3/4 full, so probe sequences stay short. */
+  if ((apr_size_t)tree->node_count * 4 >= tree->size * 3)
+    tree_grow(tree);
 
-  while (*node_ref != NULL)
+  for (slot = hash_to_slot(tree, hash);
+       tree->slots[slot].index != 0;
+       slot = (slot + 1) & (tree->size - 1))
     {
-      parent = *node_ref;
-
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
-
-      if (rv == 0)
+      node = &tree->slots[slot];
+      if (node->hash == hash)
         {
-          /* Discard the previous token.  This helps in cases where
-           * only recently read tokens are still in memory.
-           */
-          if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
-
-          parent->token = token;
-          *node = parent;
-
-          return SVN_NO_ERROR;
-        }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
+          void **ref = token_ref(tree, node->index - 1);
+          int rv;
+
+          SVN_ERR(vtable->token_compare(diff_baton, *ref, token, &rv));
+          if (rv == 0)
+            {
+              /* Discard the previous token.  This helps in cases where
+               * only recently read tokens are still in memory.
+               */
+              if (vtable->token_discard != NULL)
+                vtable->token_discard(diff_baton, *ref);
+
+              *ref = token;
+              *index = node->index - 1;
+
+              return SVN_NO_ERROR;
+            }
         }
     }
 
-  /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
-  new_node->hash = hash;
-  new_node->token = token;
-  new_node->index = tree->node_count++;
+  /* Slots store the token index + 1 in 32 bits. */
+  SVN_ERR_ASSERT(tree->node_count < APR_UINT32_MAX);
 
-  *node = *node_ref = new_node;
+  /* Use the empty slot for the new token */
+  append_token(tree, token);
+  node = &tree->slots[slot];
+  node->hash = hash;
+  node->index = (apr_uint32_t)(++tree->node_count);
+
+  *index = node->index - 1;
 
   return SVN_NO_ERROR;
 }
@@ -158,7 +263,7 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
   svn_diff__position_t *start_position;
   svn_diff__position_t *position = NULL;
   svn_diff__position_t **position_ref;
-  svn_diff__node_t *node;
+  svn_diff__token_index_t token_index;
   void *token;
   apr_off_t offset;
   apr_uint32_t hash;
@@ -176,12 +281,13 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
         break;
 
       offset++;
-      SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+      SVN_ERR(tree_insert_token(&token_index, tree, diff_baton, vtable,
+                                hash, token));
 
       /* Create a new position */
       position = apr_palloc(pool, sizeof(*position));
       position->next = NULL;
-      position->token_index = node->index;
+      position->token_index = token_index;
       position->offset = offset;
 
       *position_ref = position;
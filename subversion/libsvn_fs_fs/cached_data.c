@@ -3040,6 +3040,41 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_property(svn_string_t **value,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        const char *name,
+                        apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *rep = noderev->prop_rep;
+  apr_hash_t *proplist;
+
+  /* Committed property lists can be looked up in the cache directly. */
+  if (   rep && ffd->properties_cache && SVN_IS_VALID_REVNUM(rep->revision)
+      && !svn_fs_fs__id_txn_used(&rep->txn_id))
+    {
+      svn_boolean_t is_cached;
+      pair_cache_key_t key = { 0 };
+
+      key.revision = rep->revision;
+      key.second = rep->item_index;
+      SVN_ERR(svn_cache__get_partial((void **)value, &is_cached,
+                                     ffd->properties_cache, &key,
+                                     svn_fs_fs__extract_property,
+                                     (void *)name, pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  /* Read and cache the whole list. */
+  SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev, pool));
+  *value = svn_hash_gets(proplist, name);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__create_changes_context(svn_fs_fs__changes_context_t **context,
                                   svn_fs_t *fs,
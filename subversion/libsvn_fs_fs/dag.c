@@ -498,6 +498,20 @@ svn_fs_fs__dag_get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__dag_get_property(svn_string_t **value_p,
+                            dag_node_t *node,
+                            const char *name,
+                            apr_pool_t *pool)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(get_node_revision(&noderev, node));
+  SVN_ERR(svn_fs_fs__get_property(value_p, node->fs, noderev, name, pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__dag_has_props(svn_boolean_t *has_props,
                          dag_node_t *node,
@@ -177,6 +177,17 @@ svn_error_t *svn_fs_fs__dag_get_proplist(apr_hash_t **proplist_p,
                                          dag_node_t *node,
                                          apr_pool_t *pool);
 
+/* Set *VALUE_P to the value of property NAME of NODE, or to NULL if
+   NODE has no such property.  This is cheaper than fetching the whole
+   list with svn_fs_fs__dag_get_proplist.
+
+   Use POOL for all allocations.
+ */
+svn_error_t *svn_fs_fs__dag_get_property(svn_string_t **value_p,
+                                         dag_node_t *node,
+                                         const char *name,
+                                         apr_pool_t *pool);
+
 /* Set *HAS_PROPS to TRUE if NODE has properties. Use SCRATCH_POOL
    for temporary allocations */
 svn_error_t *svn_fs_fs__dag_has_props(svn_boolean_t *has_props,
@@ -760,6 +760,23 @@ read_config(fs_fs_data_t *ffd,
   else
     ffd->rep_sharing_allowed = FALSE;
 
+  /* Initialize ffd->rep_cache_tuning.  Sizes are given in MB. */
+  SVN_ERR(svn_config_get_bool(config, &ffd->rep_cache_tuning.wal,
+                              CONFIG_SECTION_REP_SHARING,
+                              CONFIG_OPTION_REP_CACHE_WAL, FALSE));
+  SVN_ERR(svn_config_get_int64(config, &ffd->rep_cache_tuning.mmap_size,
+                               CONFIG_SECTION_REP_SHARING,
+                               CONFIG_OPTION_REP_CACHE_MMAP_SIZE, 0));
+  SVN_ERR(svn_config_get_int64(config, &ffd->rep_cache_tuning.cache_size,
+                               CONFIG_SECTION_REP_SHARING,
+                               CONFIG_OPTION_REP_CACHE_CACHE_SIZE, 0));
+  if (ffd->rep_cache_tuning.mmap_size > APR_INT64_MAX / (1024 * 1024))
+    ffd->rep_cache_tuning.mmap_size = 0;
+  if (ffd->rep_cache_tuning.cache_size > APR_INT64_MAX / (1024 * 1024))
+    ffd->rep_cache_tuning.cache_size = 0;
+  ffd->rep_cache_tuning.mmap_size *= 1024 * 1024;
+  ffd->rep_cache_tuning.cache_size *= 1024 * 1024;
+
   /* Initialize deltification settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -993,6 +1010,19 @@ write_config(svn_fs_t *fs,
 "### 'svnadmin verify' will check the rep-cache regardless of this setting." NL
 "### rep-sharing is enabled by default."                                     NL
 "# " CONFIG_OPTION_ENABLE_REP_SHARING " = true"                              NL
+"###"                                                                        NL
+"### The following parameters tune the SQLite database that holds the"       NL
+"### shared representations.  Write-ahead logging allows lookups to proceed" NL
+"### while a commit adds new entries.  It requires all processes accessing"  NL
+"### the repository to run on the same host and will create additional"      NL
+"### rep-cache.db-wal and rep-cache.db-shm files."                           NL
+"# " CONFIG_OPTION_REP_CACHE_WAL " = false"                                  NL
+"### The number of megabytes of the database that SQLite may access through" NL
+"### memory-mapped I/O.  0, the default, uses regular file reads."           NL
+"# " CONFIG_OPTION_REP_CACHE_MMAP_SIZE " = 0"                                NL
+"### The size of SQLite's page cache per connection in megabytes."           NL
+"### 0 selects the SQLite default of about 2 megabytes."                     NL
+"# " CONFIG_OPTION_REP_CACHE_CACHE_SIZE " = 0"                               NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DELTIFICATION "]"                                         NL
 "### To conserve space, the filesystem stores data as differences against"   NL
@@ -2198,13 +2228,9 @@ svn_fs_fs__revision_prop(svn_string_t **value_p,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool)
 {
-  apr_hash_t *table;
-
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
-  SVN_ERR(svn_fs_fs__get_revision_proplist(&table, fs, rev, refresh,
-                                           scratch_pool, scratch_pool));
-
-  *value_p = svn_string_dup(svn_hash_gets(table, propname), result_pool);
+  SVN_ERR(svn_fs_fs__get_revision_prop(value_p, fs, rev, propname, refresh,
+                                       result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -167,17 +167,6 @@ typedef struct p2l_header_t
  */
 enum { MAX_NUMBER_PREFETCH = 64 };
 
-/* Prefetched number entry in a packed number stream.
- */
-typedef struct value_position_pair_t
-{
-  /* prefetched number */
-  apr_uint64_t value;
-
-  /* number of bytes read, *including* this number, since the buffer start */
-  apr_size_t total_len;
-} value_position_pair_t;
-
 /* State of a prefetching packed number stream.  It will read compressed
  * index data efficiently and present it as a series of non-packed uint64.
  */
@@ -215,7 +204,11 @@ struct svn_fs_fs__packed_number_stream_t
   apr_pool_t *pool;
 
   /* buffer for prefetched values */
-  value_position_pair_t buffer[MAX_NUMBER_PREFETCH];
+  apr_uint64_t values[MAX_NUMBER_PREFETCH];
+
+  /* number of bytes read, *including* the respective number in VALUES,
+   * since the buffer start */
+  apr_size_t total_lens[MAX_NUMBER_PREFETCH];
 };
 
 /* Return an svn_error_t * object for error ERR on STREAM with the given
@@ -252,8 +245,7 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 {
   unsigned char buffer[MAX_NUMBER_PREFETCH];
   apr_size_t bytes_read = 0;
-  apr_size_t i;
-  value_position_pair_t *target;
+  apr_size_t count = MAX_NUMBER_PREFETCH;
   apr_off_t block_start = 0;
   apr_off_t block_left = 0;
   apr_status_t err;
@@ -298,46 +290,19 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
     return stream_error_create(stream, err,
       _("Unexpected end of index file %s at offset 0x%s"));
 
-  /* parse file buffer and expand into stream buffer */
-  target = stream->buffer;
-  for (i = 0; i < bytes_read;)
-    {
-      if (buffer[i] < 0x80)
-        {
-          /* numbers < 128 are relatively frequent and particularly easy
-           * to decode.  Give them special treatment. */
-          target->value = buffer[i];
-          ++i;
-          target->total_len = i;
-          ++target;
-        }
-      else
-        {
-          apr_uint64_t value = 0;
-          apr_uint64_t shift = 0;
-          while (buffer[i] >= 0x80)
-            {
-              value += ((apr_uint64_t)buffer[i] & 0x7f) << shift;
-              shift += 7;
-              ++i;
-            }
-
-          target->value = value + ((apr_uint64_t)buffer[i] << shift);
-          ++i;
-          target->total_len = i;
-          ++target;
-
-          /* let's catch corrupted data early.  It would surely cause
-           * havoc further down the line. */
-          if SVN__PREDICT_FALSE(shift > 8 * sizeof(value))
-            return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
-                                     _("Corrupt index: number too large"));
-       }
-    }
+  /* parse file buffer and expand into stream buffer.  Let's catch
+   * corrupted data early.  It would surely cause havoc further down the
+   * line. */
+  if SVN__PREDICT_FALSE(!svn__leb128_decode(stream->values,
+                                            stream->total_lens, &count,
+                                            buffer, buffer + bytes_read))
+    return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                             _("Corrupt index: number too large"));
 
   /* update stream state */
-  stream->used = target - stream->buffer;
-  stream->next_offset = stream->start_offset + i;
+  stream->used = count;
+  stream->next_offset = stream->start_offset
+                      + stream->total_lens[count - 1];
   stream->current = 0;
 
   return SVN_NO_ERROR;
@@ -411,7 +376,7 @@ packed_stream_get(apr_uint64_t *value,
   if (stream->current == stream->used)
     SVN_ERR(packed_stream_read(stream));
 
-  *value = stream->buffer[stream->current].value;
+  *value = stream->values[stream->current];
   ++stream->current;
 
   return SVN_NO_ERROR;
@@ -443,7 +408,7 @@ packed_stream_seek(svn_fs_fs__packed_number_stream_t *stream,
        * it for the desired position. */
       apr_size_t i;
       for (i = 0; i < stream->used; ++i)
-        if (stream->buffer[i].total_len > file_offset - stream->start_offset)
+        if (stream->total_lens[i] > file_offset - stream->start_offset)
           break;
 
       stream->current = i;
@@ -459,7 +424,7 @@ packed_stream_offset(svn_fs_fs__packed_number_stream_t *stream)
   apr_off_t file_offset
        = stream->current == 0
        ? stream->start_offset
-       : stream->buffer[stream->current-1].total_len + stream->start_offset;
+       : stream->total_lens[stream->current-1] + stream->start_offset;
 
   return file_offset - stream->stream_start;
 }
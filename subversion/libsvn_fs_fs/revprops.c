@@ -761,6 +761,47 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_revision_prop(svn_string_t **value_p,
+                             svn_fs_t *fs,
+                             svn_revnum_t rev,
+                             const char *name,
+                             svn_boolean_t refresh,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_t *table;
+
+  if (!refresh)
+    {
+      /* Try to extract just NAME from the cached revprops. */
+      svn_boolean_t is_cached;
+      pair_cache_key_t key;
+
+      SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, scratch_pool));
+      SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
+      key.revision = rev;
+      key.second = ffd->revprop_prefix;
+
+      SVN_ERR_W(svn_cache__get_partial((void **)value_p, &is_cached,
+                                       ffd->revprop_cache, &key,
+                                       svn_fs_fs__extract_property,
+                                       (void *)name, result_pool),
+                apr_psprintf(scratch_pool,
+                             "Failed to parse revprops for r%ld.",
+                             rev));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_fs__get_revision_proplist(&table, fs, rev, refresh,
+                                           scratch_pool, scratch_pool));
+  *value_p = svn_string_dup(svn_hash_gets(table, name), result_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Serialize the revision property list PROPLIST of revision REV in
  * filesystem FS to a non-packed file.  Return the name of that temporary
  * file in *TMP_PATH and the file path that it must be moved to in
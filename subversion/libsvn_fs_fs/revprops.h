@@ -76,6 +76,23 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool);
 
+/* Set *VALUE_P to the value of revprop NAME of revision REV in FS or to
+ * NULL if there is no such property.  If REFRESH is set, clear the revprop
+ * cache before accessing the data.  For cached revprops, this avoids
+ * parsing the whole list.
+ *
+ * The result will be allocated in RESULT_POOL; SCRATCH_POOL is used for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs_fs__get_revision_prop(svn_string_t **value_p,
+                             svn_fs_t *fs,
+                             svn_revnum_t rev,
+                             const char *name,
+                             svn_boolean_t refresh,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
 /* Set the revision property list of revision REV in filesystem FS to
    PROPLIST.  Use POOL for temporary allocations. */
 svn_error_t *
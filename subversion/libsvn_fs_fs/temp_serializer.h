@@ -178,6 +178,19 @@ svn_fs_fs__deserialize_revprops(void **out,
                                 apr_size_t data_len,
                                 apr_pool_t *pool);
 
+/**
+ * Implements #svn_cache__partial_getter_func_t for a single property
+ * value, identified by its name (in (const char *) @a *baton), within
+ * a serialized properties hash.  Works for node properties as well as
+ * revprops.  @a *out will be NULL if there is no such property.
+ */
+svn_error_t *
+svn_fs_fs__extract_property(void **out,
+                            const void *data,
+                            apr_size_t data_len,
+                            void *baton,
+                            apr_pool_t *pool);
+
 /**
  * Implements #svn_cache__serialize_func_t for #svn_fs_id_t
  */
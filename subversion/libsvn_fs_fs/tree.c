@@ -1533,13 +1533,9 @@ fs_node_prop(svn_string_t **value_p,
              apr_pool_t *pool)
 {
   dag_node_t *node;
-  apr_hash_t *proplist;
 
   SVN_ERR(get_dag(&node, root, path, pool));
-  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, node, pool));
-  *value_p = NULL;
-  if (proplist)
-    *value_p = svn_hash_gets(proplist, propname);
+  SVN_ERR(svn_fs_fs__dag_get_property(value_p, node, propname, pool));
 
   return SVN_NO_ERROR;
 }
@@ -4180,13 +4176,12 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
       if (has_mergeinfo)
         {
           /* Save this particular node's mergeinfo. */
-          apr_hash_t *proplist;
           svn_mergeinfo_t kid_mergeinfo;
           svn_string_t *mergeinfo_string;
           svn_error_t *err;
 
-          SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, kid_dag, iterpool));
-          mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+          SVN_ERR(svn_fs_fs__dag_get_property(&mergeinfo_string, kid_dag,
+                                              SVN_PROP_MERGEINFO, iterpool));
           if (!mergeinfo_string)
             {
               svn_string_t *idstr = svn_fs_fs__id_unparse(dirent->id, iterpool);
@@ -4262,7 +4257,6 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
                                 apr_pool_t *scratch_pool)
 {
   parent_path_t *parent_path, *nearest_ancestor;
-  apr_hash_t *proplist;
   svn_string_t *mergeinfo_string;
 
   path = svn_fs__canonicalize_abspath(path, scratch_pool);
@@ -4301,9 +4295,9 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
         }
     }
 
-  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, nearest_ancestor->node,
-                                      scratch_pool));
-  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+  SVN_ERR(svn_fs_fs__dag_get_property(&mergeinfo_string,
+                                      nearest_ancestor->node,
+                                      SVN_PROP_MERGEINFO, scratch_pool));
   if (!mergeinfo_string)
     return svn_error_createf
       (SVN_ERR_FS_CORRUPT, NULL,
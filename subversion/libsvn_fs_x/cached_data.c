@@ -2914,6 +2914,42 @@ svn_fs_x__get_proplist(apr_hash_t **proplist,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__get_property(svn_string_t **value,
+                       svn_fs_t *fs,
+                       svn_fs_x__noderev_t *noderev,
+                       const char *name,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_fs_x__representation_t *rep = noderev->prop_rep;
+  apr_hash_t *proplist;
+
+  /* Committed property lists can be looked up in the cache directly. */
+  if (rep && svn_fs_x__is_revision(rep->id.change_set))
+    {
+      svn_fs_x__data_t *ffd = fs->fsap_data;
+      svn_fs_x__pair_cache_key_t key = { 0 };
+      svn_boolean_t is_cached;
+
+      key.revision = svn_fs_x__get_revnum(rep->id.change_set);
+      key.second = rep->id.number;
+      SVN_ERR(svn_cache__get_partial((void **)value, &is_cached,
+                                     ffd->properties_cache, &key,
+                                     svn_fs_x__extract_property,
+                                     (void *)name, result_pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  /* Read and cache the whole list. */
+  SVN_ERR(svn_fs_x__get_proplist(&proplist, fs, noderev, scratch_pool,
+                                 scratch_pool));
+  *value = svn_string_dup(svn_hash_gets(proplist, name), result_pool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_x__create_changes_context(svn_fs_x__changes_context_t **context,
                                  svn_fs_t *fs,
@@ -180,6 +180,19 @@ svn_fs_x__get_proplist(apr_hash_t **proplist,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool);
 
+/* Set *VALUE to the value of property NAME of node-revision NODEREV as
+   seen in filesystem FS, or to NULL if there is no such property.  Unlike
+   svn_fs_x__get_proplist, this will not deserialize the whole property
+   list if it is cached.  Allocate the result in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_x__get_property(svn_string_t **value,
+                       svn_fs_t *fs,
+                       svn_fs_x__noderev_t *noderev,
+                       const char *name,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
 /* Create a changes retrieval context object in *RESULT_POOL and return it
  * in *CONTEXT.  It will allow svn_fs_x__get_changes to fetch consecutive
  * blocks (one per invocation) from REV's changed paths list in FS.
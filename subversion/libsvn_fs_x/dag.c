@@ -426,6 +426,18 @@ svn_fs_x__dag_get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__dag_get_property(svn_string_t **value_p,
+                           dag_node_t *node,
+                           const char *name,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_fs_x__get_property(value_p, node->fs, node->node_revision,
+                                 name, result_pool, scratch_pool));
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_fs_x__dag_set_proplist(dag_node_t *node,
@@ -181,6 +181,19 @@ svn_fs_x__dag_get_proplist(apr_hash_t **proplist_p,
                            apr_pool_t *result_pool,
                            apr_pool_t *scratch_pool);
 
+/* Set *VALUE_P to the value of property NAME of NODE, or to NULL if
+   NODE has no such property.  This is cheaper than fetching the whole
+   list with svn_fs_x__dag_get_proplist.
+
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_x__dag_get_property(svn_string_t **value_p,
+                           dag_node_t *node,
+                           const char *name,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
 /* Set the property list of NODE to PROPLIST, allocating from POOL.
    The node being changed must be mutable.
 
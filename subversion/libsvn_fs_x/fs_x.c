@@ -1159,13 +1159,9 @@ svn_fs_x__revision_prop(svn_string_t **value_p,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool)
 {
-  apr_hash_t *table;
-
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
-  SVN_ERR(svn_fs_x__get_revision_proplist(&table, fs, rev, FALSE, refresh,
-                                          scratch_pool, scratch_pool));
-
-  *value_p = svn_string_dup(svn_hash_gets(table, propname), result_pool);
+  SVN_ERR(svn_fs_x__get_revision_prop(value_p, fs, rev, propname, refresh,
+                                      result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -31,6 +31,7 @@
 #include "fs_x.h"
 #include "low_level.h"
 #include "revprops.h"
+#include "temp_serializer.h"
 #include "util.h"
 #include "transaction.h"
 
@@ -1012,6 +1013,48 @@ svn_fs_x__get_revision_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__get_revision_prop(svn_string_t **value_p,
+                            svn_fs_t *fs,
+                            svn_revnum_t rev,
+                            const char *name,
+                            svn_boolean_t refresh,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  apr_hash_t *table;
+
+  /* Try to extract just NAME from the cached revprops. */
+  if (has_revprop_cache(fs, scratch_pool))
+    {
+      svn_boolean_t is_cached;
+      svn_fs_x__pair_cache_key_t key = { 0 };
+
+      SVN_ERR(svn_fs_x__ensure_revision_exists(rev, fs, scratch_pool));
+      if (refresh || !is_generation_valid(fs))
+        SVN_ERR(read_revprop_generation(fs, scratch_pool));
+
+      key.revision = rev;
+      key.second = ffd->revprop_generation;
+      SVN_ERR(svn_cache__get_partial((void **)value_p, &is_cached,
+                                     ffd->revprop_cache, &key,
+                                     svn_fs_x__extract_property,
+                                     (void *)name, result_pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+
+      /* We just refreshed the generation info. */
+      refresh = FALSE;
+    }
+
+  SVN_ERR(svn_fs_x__get_revision_proplist(&table, fs, rev, FALSE, refresh,
+                                          scratch_pool, scratch_pool));
+  *value_p = svn_string_dup(svn_hash_gets(table, name), result_pool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_x__write_non_packed_revprops(apr_file_t *file,
                                     apr_hash_t *proplist,
@@ -110,6 +110,19 @@ svn_fs_x__deserialize_properties(void **out,
                                  apr_size_t data_len,
                                  apr_pool_t *result_pool);
 
+/**
+ * Implements #svn_cache__partial_getter_func_t for a single property
+ * value, identified by its name (in (const char *) @a *baton), within
+ * a serialized properties hash.  @a *out will be NULL if there is no
+ * such property.
+ */
+svn_error_t *
+svn_fs_x__extract_property(void **out,
+                           const void *data,
+                           apr_size_t data_len,
+                           void *baton,
+                           apr_pool_t *result_pool);
+
 /**
  * Implements #svn_cache__serialize_func_t for #svn_fs_x__noderev_t
  */
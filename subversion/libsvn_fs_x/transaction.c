@@ -1974,6 +1974,21 @@ svn_fs_x__add_change(svn_fs_t *fs,
   return svn_io_file_close(file, scratch_pool);
 }
 
+/* Return a checksum context for digests_final(), allocated in
+ * RESULT_POOL.  It calculates the MD5 and, if WITH_SHA1 is set, the SHA1
+ * checksum in a single pass over the data.
+ */
+static svn_checksum_ctx_t *
+digests_ctx_create(svn_boolean_t with_sha1,
+                   apr_pool_t *result_pool)
+{
+  static const svn_checksum_kind_t kinds[]
+    = { svn_checksum_md5, svn_checksum_sha1 };
+
+  return svn_checksum__ctx_create_multi(kinds, with_sha1 ? 2 : 1,
+                                        result_pool);
+}
+
 /* This baton is used by the representation writing streams.  It keeps
    track of the checksum information as well as the total size of the
    representation so far. */
@@ -2007,8 +2022,8 @@ typedef struct rep_write_baton_t
      writing to it. */
   void *lockcookie;
 
-  svn_checksum_ctx_t *md5_checksum_ctx;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
+  /* MD5 and SHA1 over the contents, see digests_ctx_create(). */
+  svn_checksum_ctx_t *checksum_ctx;
 
   /* Receives the low-level checksum when closing REP_STREAM. */
   apr_uint32_t fnv1a_checksum;
@@ -2031,8 +2046,7 @@ rep_write_contents(void *baton,
 {
   rep_write_baton_t *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum_update(b->checksum_ctx, data, *len));
   b->rep_size += *len;
 
   return svn_stream_write(b->delta_stream, data, len);
@@ -2257,10 +2271,7 @@ rep_write_get_baton(rep_write_baton_t **wb_p,
 
   b = apr_pcalloc(result_pool, sizeof(*b));
 
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1,
-                                                 result_pool);
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5,
-                                                result_pool);
+  b->checksum_ctx = digests_ctx_create(TRUE, result_pool);
 
   b->fs = fs;
   b->result_pool = result_pool;
@@ -2551,24 +2562,26 @@ get_shared_rep(svn_fs_x__representation_t **old_rep,
   return SVN_NO_ERROR;
 }
 
-/* Copy the hash sum calculation results from MD5_CTX, SHA1_CTX into REP.
- * SHA1 results are only be set if SHA1_CTX is not NULL.
- * Use SCRATCH_POOL for temporary allocations.
+/* Copy the hash sum calculation results from CTX, created by
+ * digests_ctx_create(), into REP.  SHA1 results are only be set if
+ * WITH_SHA1 is set.  Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 digests_final(svn_fs_x__representation_t *rep,
-              const svn_checksum_ctx_t *md5_ctx,
-              const svn_checksum_ctx_t *sha1_ctx,
+              const svn_checksum_ctx_t *ctx,
+              svn_boolean_t with_sha1,
               apr_pool_t *scratch_pool)
 {
   svn_checksum_t *checksum;
 
-  SVN_ERR(svn_checksum_final(&checksum, md5_ctx, scratch_pool));
+  SVN_ERR(svn_checksum__final_kind(&checksum, ctx, svn_checksum_md5,
+                                   scratch_pool));
   memcpy(rep->md5_digest, checksum->digest, svn_checksum_size(checksum));
-  rep->has_sha1 = sha1_ctx != NULL;
+  rep->has_sha1 = with_sha1;
   if (rep->has_sha1)
     {
-      SVN_ERR(svn_checksum_final(&checksum, sha1_ctx, scratch_pool));
+      SVN_ERR(svn_checksum__final_kind(&checksum, ctx, svn_checksum_sha1,
+                                       scratch_pool));
       memcpy(rep->sha1_digest, checksum->digest, svn_checksum_size(checksum));
     }
 
@@ -2603,8 +2616,7 @@ rep_write_contents_close(void *baton)
   rep->id.change_set = svn_fs_x__change_set_by_txn(txn_id);
 
   /* Finalize the checksum. */
-  SVN_ERR(digests_final(rep, b->md5_checksum_ctx, b->sha1_checksum_ctx,
-                        b->result_pool));
+  SVN_ERR(digests_final(rep, b->checksum_ctx, TRUE, b->result_pool));
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -2778,10 +2790,11 @@ typedef struct write_container_baton_t
 
   apr_size_t size;
 
-  svn_checksum_ctx_t *md5_ctx;
+  /* MD5 and optionally SHA1 over the contents. */
+  svn_checksum_ctx_t *checksum_ctx;
 
-  /* SHA1 calculation is optional. If not needed, this will be NULL. */
-  svn_checksum_ctx_t *sha1_ctx;
+  /* SHA1 calculation is optional. If not needed, this will be FALSE. */
+  svn_boolean_t with_sha1;
 } write_container_baton_t;
 
 /* The handler for the write_container_rep stream.  BATON is a
@@ -2794,9 +2807,7 @@ write_container_handler(void *baton,
 {
   write_container_baton_t *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  if (whb->sha1_ctx)
-    SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum_update(whb->checksum_ctx, data, *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -2929,9 +2940,8 @@ write_container_delta_rep(svn_fs_x__representation_t *rep,
   whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
                                         scratch_pool);
   whb->size = 0;
-  whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
-  if (item_type != SVN_FS_X__ITEM_TYPE_DIR_REP)
-    whb->sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
+  whb->with_sha1 = (item_type != SVN_FS_X__ITEM_TYPE_DIR_REP);
+  whb->checksum_ctx = digests_ctx_create(whb->with_sha1, scratch_pool);
 
   /* serialize the hash */
   stream = svn_stream_create(whb, scratch_pool);
@@ -2941,7 +2951,8 @@ write_container_delta_rep(svn_fs_x__representation_t *rep,
   SVN_ERR(svn_stream_close(whb->stream));
 
   /* Store the results. */
-  SVN_ERR(digests_final(rep, whb->md5_ctx, whb->sha1_ctx, scratch_pool));
+  SVN_ERR(digests_final(rep, whb->checksum_ctx, whb->with_sha1,
+                        scratch_pool));
 
   /* Update size info. */
   SVN_ERR(svn_io_file_get_offset(&rep_end, file, scratch_pool));
@@ -427,15 +427,11 @@ x_node_prop(svn_string_t **value_p,
             apr_pool_t *pool)
 {
   dag_node_t *node;
-  apr_hash_t *proplist;
   apr_pool_t *scratch_pool = svn_pool_create(pool);
 
   SVN_ERR(svn_fs_x__get_temp_dag_node(&node, root, path, scratch_pool));
-  SVN_ERR(svn_fs_x__dag_get_proplist(&proplist, node, scratch_pool,
+  SVN_ERR(svn_fs_x__dag_get_property(value_p, node, propname, pool,
                                      scratch_pool));
-  *value_p = NULL;
-  if (proplist)
-    *value_p = svn_string_dup(svn_hash_gets(proplist, propname), pool);
 
   svn_pool_destroy(scratch_pool);
   return SVN_NO_ERROR;
@@ -2941,14 +2937,13 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
       if (svn_fs_x__dag_has_mergeinfo(kid_dag))
         {
           /* Save this particular node's mergeinfo. */
-          apr_hash_t *proplist;
           svn_mergeinfo_t kid_mergeinfo;
           svn_string_t *mergeinfo_string;
           svn_error_t *err;
 
-          SVN_ERR(svn_fs_x__dag_get_proplist(&proplist, kid_dag, iterpool,
+          SVN_ERR(svn_fs_x__dag_get_property(&mergeinfo_string, kid_dag,
+                                             SVN_PROP_MERGEINFO, iterpool,
                                              iterpool));
-          mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
           if (!mergeinfo_string)
             {
               svn_string_t *idstr
@@ -3006,7 +3001,6 @@ get_mergeinfo_for_path(svn_mergeinfo_t *mergeinfo,
                        apr_pool_t *scratch_pool)
 {
   svn_fs_x__dag_path_t *dag_path, *nearest_ancestor;
-  apr_hash_t *proplist;
   svn_string_t *mergeinfo_string;
 
   *mergeinfo = NULL;
@@ -3041,9 +3035,10 @@ get_mergeinfo_for_path(svn_mergeinfo_t *mergeinfo,
         }
     }
 
-  SVN_ERR(svn_fs_x__dag_get_proplist(&proplist, nearest_ancestor->node,
-                                     scratch_pool, scratch_pool));
-  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+  SVN_ERR(svn_fs_x__dag_get_property(&mergeinfo_string,
+                                     nearest_ancestor->node,
+                                     SVN_PROP_MERGEINFO, scratch_pool,
+                                     scratch_pool));
   if (!mergeinfo_string)
     return svn_error_createf
       (SVN_ERR_FS_CORRUPT, NULL,
@@ -50,7 +50,8 @@ svn_ra_serf__copy_into_spillbuf(svn_spillbuf_t **spillbuf,
                                 apr_pool_t *result_pool,
                                 apr_pool_t *scratch_pool)
 {
-  *spillbuf = svn_spillbuf__create(SB_BLOCKSIZE, SB_MAXSIZE, result_pool);
+  *spillbuf = svn_spillbuf__create_async(SB_BLOCKSIZE, SB_MAXSIZE,
+                                         result_pool);
 
   /* Copy all data from the bucket into the spillbuf.  */
   while (TRUE)
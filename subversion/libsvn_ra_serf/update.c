@@ -2295,9 +2295,9 @@ update_delay_handler(serf_request_t *request,
         }
 
       /* Let's start using the spill infrastructure */
-      udb->spillbuf = svn_spillbuf__create(SPILLBUF_BLOCKSIZE,
-                                           SPILLBUF_MAXBUFFSIZE,
-                                           udb->report->pool);
+      udb->spillbuf = svn_spillbuf__create_async(SPILLBUF_BLOCKSIZE,
+                                                 SPILLBUF_MAXBUFFSIZE,
+                                                 udb->report->pool);
     }
 
   /* Read everything we can to a spillbuffer */
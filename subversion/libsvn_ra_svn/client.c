@@ -3073,6 +3073,7 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA_CAPABILITY_BLAME, SVN_RA_SVN_CAP_BLAME},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -3242,6 +3243,95 @@ ra_svn_list(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const svn_diff_file_options_t *diff_options,
+                 svn_ra_blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *rev_props = apr_hash_make(scratch_pool);
+  const char *ignore_space = "none";
+  svn_boolean_t ignore_eol_style = FALSE;
+  apr_int64_t line_no;
+
+  if (diff_options)
+    {
+      if (diff_options->ignore_space == svn_diff_file_ignore_space_change)
+        ignore_space = "change";
+      else if (diff_options->ignore_space == svn_diff_file_ignore_space_all)
+        ignore_space = "all";
+      ignore_eol_style = diff_options->ignore_eol_style;
+    }
+
+  path = reparent_path(session, path, scratch_pool);
+
+  /* Send the blame request. */
+  SVN_ERR(svn_ra_svn__write_cmd_get_blame(conn, scratch_pool, path,
+                                          start, end, ignore_space,
+                                          ignore_eol_style));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the lines.  The properties of each revision are
+   * sent only once and live in SCRATCH_POOL. */
+  for (line_no = 0; ; ++line_no)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *proplist;
+      svn_revnum_t rev;
+      svn_string_t *line;
+      apr_hash_t *props = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next line or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame entry not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "(?r)(?l)s",
+                                      &rev, &proplist, &line));
+
+      if (SVN_IS_VALID_REVNUM(rev))
+        {
+          props = apr_hash_get(rev_props, &rev, sizeof(rev));
+          if (!props)
+            {
+              svn_revnum_t *key;
+
+              if (!proplist)
+                return svn_error_createf(SVN_ERR_RA_SVN_MALFORMED_DATA,
+                                         NULL,
+                                         _("Missing properties for r%ld"),
+                                         rev);
+
+              key = apr_pmemdup(scratch_pool, &rev, sizeof(rev));
+              SVN_ERR(svn_ra_svn__parse_proplist(proplist, scratch_pool,
+                                                 &props));
+              apr_hash_set(rev_props, key, sizeof(*key), props);
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, line_no, rev, props, line,
+                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
   ra_svn_get_description,
@@ -3282,6 +3372,7 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  ra_svn_get_blame,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
@@ -2605,6 +2605,30 @@ svn_ra_svn__write_cmd_get_file_revs(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_cmd_get_blame(svn_ra_svn_conn_t *conn,
+                                apr_pool_t *pool,
+                                const char *path,
+                                svn_revnum_t start,
+                                svn_revnum_t end,
+                                const char *ignore_space,
+                                svn_boolean_t ignore_eol_style)
+{
+  SVN_ERR(writebuf_write_literal(conn, pool, "( get-blame ( "));
+  SVN_ERR(write_tuple_cstring(conn, pool, path));
+  SVN_ERR(write_tuple_start_list(conn, pool));
+  SVN_ERR(write_tuple_revision_opt(conn, pool, start));
+  SVN_ERR(write_tuple_end_list(conn, pool));
+  SVN_ERR(write_tuple_start_list(conn, pool));
+  SVN_ERR(write_tuple_revision_opt(conn, pool, end));
+  SVN_ERR(write_tuple_end_list(conn, pool));
+  SVN_ERR(svn_ra_svn__write_word(conn, pool, ignore_space));
+  SVN_ERR(write_tuple_boolean(conn, pool, ignore_eol_style));
+  SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__write_cmd_lock(svn_ra_svn_conn_t *conn,
                            apr_pool_t *pool,
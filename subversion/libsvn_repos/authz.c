@@ -130,6 +130,10 @@ static svn_object_pool__t *authz_pool = NULL;
 static svn_object_pool__t *filtered_pool = NULL;
 static svn_atomic_t authz_pool_initialized = FALSE;
 
+/* Directory in which compiled authz images get shared between processes.
+ * NULL, if images shall neither be read nor written. */
+static const char *authz_image_dir = NULL;
+
 /* Implements svn_atomic__err_init_func_t. */
 static svn_error_t *
 synchronized_authz_initialize(void *baton, apr_pool_t *pool)
@@ -155,6 +159,13 @@ svn_repos_authz_initialize(apr_pool_t *pool)
                                                NULL, pool));
 }
 
+void
+svn_repos_authz_set_image_dir(const char *dir,
+                              apr_pool_t *pool)
+{
+  authz_image_dir = dir ? apr_pstrdup(pool, dir) : NULL;
+}
+
 /* Return a combination of AUTHZ_KEY and GROUPS_KEY, allocated in RESULT_POOL.
  * GROUPS_KEY may be NULL.  This is the key for the AUTHZ_POOL.
  */
@@ -967,6 +978,20 @@ create_user_authz(authz_full_t *authz,
 
 /*** Lookup. ***/
 
+/* Lookup results for one of the parent paths of the latest lookup. */
+typedef struct lookup_level_t
+{
+  /* Length of this parent path, i.e. of the respective prefix of
+   * lookup_state_t::PARENT_PATH. */
+  apr_size_t path_len;
+
+  /* Rights that apply at this parent path. */
+  limited_rights_t rights;
+
+  /* Nodes applying to this parent path. */
+  apr_array_header_t *nodes;
+} lookup_level_t;
+
 /* Reusable lookup state object. It is easy to pass to functions and
  * recycling it between lookups saves significant setup costs. */
 typedef struct lookup_state_t
@@ -992,6 +1017,14 @@ typedef struct lookup_state_t
   /* Rights that apply at PARENT_PATH, if PARENT_PATH is not empty. */
   limited_rights_t parent_rights;
 
+  /* Stack of lookup_level_t for all non-empty prefixes of PARENT_PATH,
+   * i.e. the top element corresponds to PARENT_PATH itself.  Only the
+   * first DEPTH elements are valid.  The others are being kept to reuse
+   * their node arrays.  This allows lookups to continue from any parent
+   * path of the previous lookup, e.g. in depth-first tree walks. */
+  apr_array_header_t *levels;
+  int depth;
+
 } lookup_state_t;
 
 /* Constructor for lookup_state_t. */
@@ -1015,9 +1048,37 @@ create_lookup_state(apr_pool_t *result_pool)
    * above applies. */
   state->parent_path = svn_stringbuf_create_ensure(200, result_pool);
 
+  state->levels = apr_array_make(result_pool, 8, sizeof(lookup_level_t));
+  state->depth = 0;
+
   return state;
 }
 
+/* Push the current PARENT_PATH, PARENT_RIGHTS and CURRENT nodes of STATE
+ * onto its stack of parent path levels. */
+static void
+push_lookup_level(lookup_state_t *state)
+{
+  lookup_level_t *level;
+  if (state->depth == state->levels->nelts)
+    {
+      level = apr_array_push(state->levels);
+      level->nodes = apr_array_make(state->levels->pool, 4,
+                                    sizeof(node_t *));
+    }
+  else
+    {
+      level = &APR_ARRAY_IDX(state->levels, state->depth, lookup_level_t);
+      apr_array_clear(level->nodes);
+    }
+
+  level->path_len = state->parent_path->len;
+  level->rights = state->parent_rights;
+  apr_array_cat(level->nodes, state->current);
+
+  ++state->depth;
+}
+
 /* Clear the current contents of STATE and re-initialize it for ROOT.
  * Check whether we can reuse a previous parent path lookup to shorten
  * the current PATH walk.  Return the full or remaining portion of
@@ -1028,18 +1089,39 @@ init_lockup_state(lookup_state_t *state,
                   const char *path)
 {
   apr_size_t len = strlen(path);
-  if (   (len > state->parent_path->len)
-      && state->parent_path->len
-      && (path[state->parent_path->len] == '/')
-      && !memcmp(path, state->parent_path->data, state->parent_path->len))
+  int top = state->depth;
+
+  /* Find the deepest parent path of the previous lookup that is also
+   * a parent path of PATH. */
+  while (state->depth)
     {
-      /* The PARENT_PATH of the previous lookup is actually a parent path
-       * of PATH.  The CURRENT node list already matches the parent path
-       * and we only have to set the correct rights info. */
-      state->rights = state->parent_rights;
+      lookup_level_t *level = &APR_ARRAY_IDX(state->levels,
+                                             state->depth - 1,
+                                             lookup_level_t);
+      if (   (len > level->path_len)
+          && (path[level->path_len] == '/')
+          && !memcmp(path, state->parent_path->data, level->path_len))
+        {
+          /* If this is the PARENT_PATH of the previous lookup, the CURRENT
+           * node list already matches it.  Otherwise, restore it. */
+          if (state->depth != top)
+            {
+              state->parent_path->len = level->path_len;
+              state->parent_path->data[level->path_len] = '\0';
+              state->parent_rights = level->rights;
+
+              apr_array_clear(state->current);
+              apr_array_cat(state->current, level->nodes);
+            }
 
-      /* Tell the caller where to proceed. */
-      return path + state->parent_path->len;
+          /* We only have to set the correct rights info. */
+          state->rights = state->parent_rights;
+
+          /* Tell the caller where to proceed. */
+          return path + level->path_len;
+        }
+
+      --state->depth;
     }
 
   /* Start lookup at ROOT for the full PATH. */
@@ -1359,6 +1441,7 @@ lookup(lookup_state_t *state,
 
           /* In STATE, PARENT_PATH, PARENT_RIGHTS and CURRENT are now in sync. */
           state->parent_rights = state->rights;
+          push_lookup_level(state);
         }
     }
 
@@ -1528,6 +1611,85 @@ filter_tree(svn_authz_t *authz,
 }
 
 
+/* Return the path of the compiled image for the authz rules with
+ * RULES_CHECKSUM and the optional global groups with GROUPS_CHECKSUM.
+ * Allocate the result in RESULT_POOL.
+ */
+static const char *
+construct_image_path(const svn_checksum_t *rules_checksum,
+                     const svn_checksum_t *groups_checksum,
+                     apr_pool_t *result_pool)
+{
+  const char *name = svn_checksum_to_cstring(rules_checksum, result_pool);
+  if (groups_checksum)
+    name = apr_pstrcat(result_pool, name, "-",
+                       svn_checksum_to_cstring(groups_checksum, result_pool),
+                       SVN_VA_NULL);
+
+  return svn_dirent_join(authz_image_dir,
+                         apr_pstrcat(result_pool, name, ".authz",
+                                     SVN_VA_NULL),
+                         result_pool);
+}
+
+/* Like svn_authz__parse, construct the full authz model in *AUTHZ_P from
+ * RULES and the optional GROUPS.  If an image directory has been set,
+ * load the compiled image for RULES_CHECKSUM and GROUPS_CHECKSUM from
+ * there instead and only parse the rules, if that image does not exist
+ * yet.  In that case, write the image for other processes to use.
+ */
+static svn_error_t *
+parse_or_load_authz(authz_full_t **authz_p,
+                    svn_stream_t *rules,
+                    svn_stream_t *groups,
+                    const svn_checksum_t *rules_checksum,
+                    const svn_checksum_t *groups_checksum,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const char *image_path;
+  svn_stream_t *stream;
+  svn_stringbuf_t *image;
+  svn_error_t *err;
+
+  if (!authz_image_dir)
+    return svn_error_trace(svn_authz__parse(authz_p, rules, groups,
+                                            result_pool, scratch_pool));
+
+  /* Images are keyed by content, i.e. an existing one is never outdated.
+   * Any problem reading it simply makes us parse the rules again. */
+  image_path = construct_image_path(rules_checksum, groups_checksum,
+                                    scratch_pool);
+  err = svn_stream_open_readonly(&stream, image_path, scratch_pool,
+                                 scratch_pool);
+  if (!err)
+    {
+      err = svn_error_compose_create(svn_authz__read_image(authz_p, stream,
+                                                           result_pool,
+                                                           scratch_pool),
+                                     svn_stream_close(stream));
+      if (!err)
+        return SVN_NO_ERROR;
+    }
+
+  svn_error_clear(err);
+  SVN_ERR(svn_authz__parse(authz_p, rules, groups, result_pool,
+                           scratch_pool));
+
+  /* The image is only an optimization.  Failing to write it is not fatal.
+   * Write it atomically such that concurrent readers never see partial
+   * images. */
+  image = svn_stringbuf_create_empty(scratch_pool);
+  err = svn_authz__write_image(svn_stream_from_stringbuf(image, scratch_pool),
+                               *authz_p, scratch_pool);
+  if (!err)
+    err = svn_io_write_atomic2(image_path, image->data, image->len, NULL,
+                               FALSE, scratch_pool);
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Read authz configuration data from PATH into *AUTHZ_P, allocated in
    RESULT_POOL.  Return the cache key in *AUTHZ_ID.  If GROUPS_PATH is set,
@@ -1586,8 +1748,9 @@ authz_read(authz_full_t **authz_p,
 
           /* Parse the configuration(s) and construct the full authz model
            * from it. */
-          err = svn_authz__parse(authz_p, rules_stream, groups_stream,
-                                item_pool, scratch_pool);
+          err = parse_or_load_authz(authz_p, rules_stream, groups_stream,
+                                    rules_checksum, groups_checksum,
+                                    item_pool, scratch_pool);
           if (err != SVN_NO_ERROR)
             {
               /* That pool would otherwise never get destroyed. */
@@ -1611,9 +1774,12 @@ authz_read(authz_full_t **authz_p,
     {
       /* Parse the configuration(s) and construct the full authz model from
        * it. */
-      err = svn_error_quick_wrapf(svn_authz__parse(authz_p, rules_stream,
-                                                   groups_stream,
-                                                   result_pool, scratch_pool),
+      err = svn_error_quick_wrapf(parse_or_load_authz(authz_p, rules_stream,
+                                                      groups_stream,
+                                                      rules_checksum,
+                                                      groups_checksum,
+                                                      result_pool,
+                                                      scratch_pool),
                                   "Error while parsing authz file: '%s':",
                                   path);
     }
@@ -1727,3 +1893,168 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos_authz_check_children(apr_array_header_t **access_granted,
+                               svn_authz_t *authz,
+                               const char *repos_name,
+                               const char *parent_path,
+                               const apr_array_header_t *child_names,
+                               const char *user,
+                               svn_repos_authz_access_t required_access,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  const authz_access_t required =
+    ((required_access & svn_authz_read ? authz_access_read_flag : 0)
+     | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  const svn_boolean_t recursive = !!(required_access & svn_authz_recursive);
+  authz_user_rules_t *rules;
+  svn_stringbuf_t *path;
+  apr_size_t parent_len;
+  int i;
+
+  SVN_ERR_ASSERT(parent_path[0] == '/');
+
+  *access_granted = apr_array_make(result_pool, child_names->nelts,
+                                   sizeof(svn_boolean_t));
+
+  /* Pick or create the suitable pre-filtered path rule tree. */
+  rules = get_user_rules(authz,
+                         (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
+                         user);
+
+  /* Uniform access to the whole repository? */
+  if (   ((rules->global_rights.min_access & required) == required)
+      || ((rules->global_rights.max_access & required) != required))
+    {
+      const svn_boolean_t granted
+        = ((rules->global_rights.min_access & required) == required);
+
+      for (i = 0; i < child_names->nelts; ++i)
+        APR_ARRAY_PUSH(*access_granted, svn_boolean_t) = granted;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Did we already filter the data model? */
+  if (!rules->root)
+    SVN_ERR(filter_tree(authz, scratch_pool));
+
+  /* Construct all child paths in the same buffer.  After the first one,
+   * the lookup state is positioned at PARENT_PATH and every lookup only
+   * has to follow the last path segment. */
+  path = svn_stringbuf_create(parent_path, scratch_pool);
+  if (path->data[path->len - 1] != '/')
+    svn_stringbuf_appendbyte(path, '/');
+  parent_len = path->len;
+
+  for (i = 0; i < child_names->nelts; ++i)
+    {
+      const char *remainder;
+
+      path->len = parent_len;
+      path->data[parent_len] = '\0';
+      svn_stringbuf_appendcstr(path,
+                               APR_ARRAY_IDX(child_names, i, const char *));
+
+      remainder = init_lockup_state(authz->filtered->lookup_state,
+                                    authz->filtered->root, path->data);
+      APR_ARRAY_PUSH(*access_granted, svn_boolean_t)
+        = lookup(rules->lookup_state, remainder, required, recursive,
+                 scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Read access checks through svn_repos_authz_func_t. ***/
+
+svn_error_t *
+svn_repos__authz_read_func(svn_boolean_t *allowed,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           void *baton,
+                           apr_pool_t *pool)
+{
+  svn_repos__authz_read_baton_t *b = baton;
+
+  if (path && *path != '/')
+    path = svn_fspath__canonicalize(path, pool);
+
+  SVN_ERR(svn_repos_authz_check_access(b->authz, b->repos_name, path,
+                                       b->user, svn_authz_read, allowed,
+                                       pool));
+  if (!*allowed && b->denied_func)
+    SVN_ERR(b->denied_func(path, b->denied_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__authz_read_children(apr_array_header_t **readable,
+                               svn_fs_root_t *root,
+                               const char *parent_path,
+                               const apr_array_header_t *child_names,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  if (*parent_path != '/')
+    parent_path = svn_fspath__canonicalize(parent_path, scratch_pool);
+
+  /* Our own callback?  Then check all children in one go. */
+  if (authz_read_func == svn_repos__authz_read_func)
+    {
+      svn_repos__authz_read_baton_t *b = authz_read_baton;
+
+      SVN_ERR(svn_repos_authz_check_children(readable, b->authz,
+                                             b->repos_name, parent_path,
+                                             child_names, b->user,
+                                             svn_authz_read, result_pool,
+                                             scratch_pool));
+      if (!b->denied_func)
+        return SVN_NO_ERROR;
+
+      iterpool = svn_pool_create(scratch_pool);
+      for (i = 0; i < child_names->nelts; ++i)
+        if (!APR_ARRAY_IDX(*readable, i, svn_boolean_t))
+          {
+            svn_pool_clear(iterpool);
+            SVN_ERR(b->denied_func(
+                      svn_fspath__join(parent_path,
+                                       APR_ARRAY_IDX(child_names, i,
+                                                     const char *),
+                                       iterpool),
+                      b->denied_baton, iterpool));
+          }
+      svn_pool_destroy(iterpool);
+
+      return SVN_NO_ERROR;
+    }
+
+  *readable = apr_array_make(result_pool, child_names->nelts,
+                             sizeof(svn_boolean_t));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < child_names->nelts; ++i)
+    {
+      svn_boolean_t allowed;
+      const char *name = APR_ARRAY_IDX(child_names, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(authz_read_func(&allowed, root,
+                              svn_fspath__join(parent_path, name, iterpool),
+                              authz_read_baton, iterpool));
+      APR_ARRAY_PUSH(*readable, svn_boolean_t) = allowed;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
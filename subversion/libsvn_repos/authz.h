@@ -307,6 +307,32 @@ svn_authz__parse(authz_full_t **authz,
                  apr_pool_t *scratch_pool);
 
 
+/* Write the authz model AUTHZ to STREAM as a compiled binary image that
+ * svn_authz__read_image() can load much faster than svn_authz__parse()
+ * can process the original rules.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_authz__write_image(svn_stream_t *stream,
+                       const authz_full_t *authz,
+                       apr_pool_t *scratch_pool);
+
+/* Read the compiled binary image written by svn_authz__write_image()
+ * from STREAM and return the authz model in *AUTHZ.
+ *
+ * If the image is invalid, return SVN_ERR_AUTHZ_INVALID_CONFIG.
+ *
+ * **AUTHZ and its contents will be allocated from RESULT_POOL.
+ * The function uses SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_authz__read_image(authz_full_t **authz,
+                      svn_stream_t *stream,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
+
 /* Reverse a STRING of length LEN in place. */
 void
 svn_authz__reverse_string(char *string, apr_size_t len);
@@ -0,0 +1,592 @@
+/* authz_image.c : compiled binary images of parsed authz rules
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+
+#include "private/svn_packed_data.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+#include "authz.h"
+
+
+/* The image starts with this line, followed by svn_packed__data_t
+ * content with one byte stream and three integer streams:
+ *
+ *   STRINGS   all distinct strings, in order of first reference
+ *   MEMBERS   group member sets, in order of first reference;
+ *             each is a count followed by that many string IDs
+ *   ACLS      the ACL count followed by all ACLs
+ *   RIGHTS    the anonymous, authenticated and per-user global rights
+ *
+ * Strings and member sets are referenced by their 0-based index.  An
+ * index that equals the number of entries read so far introduces the
+ * next entry in STRINGS resp. MEMBERS.  Thus, each string and member
+ * set gets stored exactly once and the reader will intern them again.
+ */
+#define IMAGE_HEADER "SVN-authz-image: 1\n"
+
+/* Marker value for the empty member set in ACEs that don't refer to
+ * a group. */
+#define NO_MEMBERS 0
+
+/* State used while writing an image. */
+typedef struct image_writer_t
+{
+  /* The output streams. */
+  svn_packed__byte_stream_t *strings;
+  svn_packed__int_stream_t *members;
+  svn_packed__int_stream_t *acls;
+  svn_packed__int_stream_t *rights;
+
+  /* Map string contents to apr_size_t* IDs. */
+  apr_hash_t *string_ids;
+
+  /* Map apr_hash_t* member sets (by address) to apr_size_t* IDs. */
+  apr_hash_t *member_ids;
+
+  /* Pool for the maps above. */
+  apr_pool_t *pool;
+} image_writer_t;
+
+/* State used while reading an image. */
+typedef struct image_reader_t
+{
+  /* The input streams. */
+  svn_packed__byte_stream_t *strings;
+  svn_packed__int_stream_t *members;
+  svn_packed__int_stream_t *acls;
+  svn_packed__int_stream_t *rights;
+
+  /* The svn_string_t* read so far, indexed by ID. */
+  apr_array_header_t *string_table;
+
+  /* The apr_hash_t* member sets read so far, indexed by ID. */
+  apr_array_header_t *member_table;
+
+  /* Pool for the authz model. */
+  apr_pool_t *result_pool;
+} image_reader_t;
+
+/* Members of group member sets map to this value. */
+static const char member_value[] = "";
+
+
+/*** Writing images. ***/
+
+/* Add the ID of the LEN bytes string at DATA to STREAM.  If WRITER has not
+ * seen that string before, append it to the string table.
+ */
+static void
+write_string(image_writer_t *writer,
+             svn_packed__int_stream_t *stream,
+             const char *data,
+             apr_size_t len)
+{
+  apr_size_t *id = apr_hash_get(writer->string_ids, data, len);
+  if (!id)
+    {
+      id = apr_palloc(writer->pool, sizeof(*id));
+      *id = apr_hash_count(writer->string_ids);
+      apr_hash_set(writer->string_ids, data, len, id);
+      svn_packed__add_bytes(writer->strings, data, len);
+    }
+
+  svn_packed__add_uint(stream, *id);
+}
+
+/* Add the ID of the group member set MEMBERS to STREAM.  If WRITER has
+ * not seen that set before, append it to the member sets.  MEMBERS may
+ * be NULL.
+ */
+static void
+write_members(image_writer_t *writer,
+              svn_packed__int_stream_t *stream,
+              apr_hash_t *members,
+              apr_pool_t *scratch_pool)
+{
+  apr_size_t *id;
+  apr_hash_index_t *hi;
+
+  if (!members)
+    {
+      svn_packed__add_uint(stream, NO_MEMBERS);
+      return;
+    }
+
+  id = apr_hash_get(writer->member_ids, &members, sizeof(members));
+  if (!id)
+    {
+      id = apr_palloc(writer->pool, sizeof(*id));
+      *id = apr_hash_count(writer->member_ids) + 1;
+      apr_hash_set(writer->member_ids,
+                   apr_pmemdup(writer->pool, &members, sizeof(members)),
+                   sizeof(members), id);
+
+      svn_packed__add_uint(writer->members, apr_hash_count(members));
+      for (hi = apr_hash_first(scratch_pool, members);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *member = apr_hash_this_key(hi);
+          write_string(writer, writer->members, member,
+                       apr_hash_this_key_len(hi));
+        }
+    }
+
+  svn_packed__add_uint(stream, *id);
+}
+
+/* Add RIGHTS to WRITER's rights stream. */
+static void
+write_rights(image_writer_t *writer,
+             const authz_rights_t *rights)
+{
+  svn_packed__add_uint(writer->rights, rights->min_access);
+  svn_packed__add_uint(writer->rights, rights->max_access);
+}
+
+/* Add the global rights RIGHTS to WRITER's rights stream. */
+static void
+write_global_rights(image_writer_t *writer,
+                    const authz_global_rights_t *rights,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  write_string(writer, writer->rights, rights->user, strlen(rights->user));
+  write_rights(writer, &rights->any_repos_rights);
+  write_rights(writer, &rights->all_repos_rights);
+
+  svn_packed__add_uint(writer->rights,
+                       apr_hash_count(rights->per_repos_rights));
+  for (hi = apr_hash_first(scratch_pool, rights->per_repos_rights);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *repos = apr_hash_this_key(hi);
+      write_string(writer, writer->rights, repos, apr_hash_this_key_len(hi));
+      write_rights(writer, apr_hash_this_val(hi));
+    }
+}
+
+/* Add ACL to WRITER's ACL stream. */
+static void
+write_acl(image_writer_t *writer,
+          const authz_acl_t *acl,
+          apr_pool_t *scratch_pool)
+{
+  svn_packed__int_stream_t *stream = writer->acls;
+  int i;
+
+  svn_packed__add_uint(stream, acl->sequence_number);
+
+  write_string(writer, stream, acl->rule.repos, strlen(acl->rule.repos));
+  svn_packed__add_uint(stream, acl->rule.len);
+  for (i = 0; i < acl->rule.len; ++i)
+    {
+      const authz_rule_segment_t *segment = &acl->rule.path[i];
+      svn_packed__add_uint(stream, segment->kind);
+      write_string(writer, stream, segment->pattern.data,
+                   segment->pattern.len);
+    }
+
+  svn_packed__add_uint(stream, acl->has_anon_access);
+  svn_packed__add_uint(stream, acl->anon_access);
+  svn_packed__add_uint(stream, acl->has_authn_access);
+  svn_packed__add_uint(stream, acl->authn_access);
+
+  svn_packed__add_uint(stream, acl->user_access->nelts);
+  for (i = 0; i < acl->user_access->nelts; ++i)
+    {
+      const authz_ace_t *ace = &APR_ARRAY_IDX(acl->user_access, i,
+                                              authz_ace_t);
+      write_string(writer, stream, ace->name, strlen(ace->name));
+      write_members(writer, stream, ace->members, scratch_pool);
+      svn_packed__add_uint(stream, ace->inverted);
+      svn_packed__add_uint(stream, ace->access);
+    }
+}
+
+svn_error_t *
+svn_authz__write_image(svn_stream_t *stream,
+                       const authz_full_t *authz,
+                       apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  image_writer_t writer;
+  apr_hash_index_t *hi;
+  apr_size_t len = sizeof(IMAGE_HEADER) - 1;
+  int i;
+
+  writer.strings = svn_packed__create_bytes_stream(root);
+  writer.members = svn_packed__create_int_stream(root, FALSE, FALSE);
+  writer.acls = svn_packed__create_int_stream(root, FALSE, FALSE);
+  writer.rights = svn_packed__create_int_stream(root, FALSE, FALSE);
+  writer.string_ids = svn_hash__make(scratch_pool);
+  writer.member_ids = apr_hash_make(scratch_pool);
+  writer.pool = scratch_pool;
+
+  svn_packed__add_uint(writer.acls, authz->acls->nelts);
+  for (i = 0; i < authz->acls->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      write_acl(&writer, &APR_ARRAY_IDX(authz->acls, i, authz_acl_t),
+                iterpool);
+    }
+
+  svn_packed__add_uint(writer.rights, authz->has_anon_rights);
+  write_global_rights(&writer, &authz->anon_rights, iterpool);
+  svn_packed__add_uint(writer.rights, authz->has_authn_rights);
+  write_global_rights(&writer, &authz->authn_rights, iterpool);
+
+  svn_packed__add_uint(writer.rights, apr_hash_count(authz->user_rights));
+  for (hi = apr_hash_first(scratch_pool, authz->user_rights);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_pool_clear(iterpool);
+      write_global_rights(&writer, apr_hash_this_val(hi), iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_stream_write(stream, IMAGE_HEADER, &len));
+  return svn_error_trace(svn_packed__data_write(stream, root, scratch_pool));
+}
+
+
+/*** Reading images. ***/
+
+/* Return the error to report for inconsistent image data, wrapping the
+ * optional error CAUSE. */
+static svn_error_t *
+image_corrupt(svn_error_t *cause)
+{
+  return svn_error_create(SVN_ERR_AUTHZ_INVALID_CONFIG, cause,
+                          _("Compiled authz image is corrupt"));
+}
+
+/* Read the next number from STREAM into *VALUE and verify that it does
+ * not exceed LIMIT.
+ */
+static svn_error_t *
+read_uint(apr_size_t *value,
+          svn_packed__int_stream_t *stream,
+          apr_uint64_t limit)
+{
+  apr_uint64_t number;
+
+  if (svn_packed__int_count(stream) == 0)
+    return image_corrupt(NULL);
+
+  number = svn_packed__get_uint(stream);
+  if (number > limit)
+    return image_corrupt(NULL);
+
+  *value = (apr_size_t)number;
+  return SVN_NO_ERROR;
+}
+
+/* Read an element count from STREAM into *COUNT.  Every element uses at
+ * least one more number in STREAM, which gives us an upper limit.
+ */
+static svn_error_t *
+read_count(apr_size_t *count,
+           svn_packed__int_stream_t *stream)
+{
+  SVN_ERR(read_uint(count, stream, APR_INT32_MAX));
+  if (*count > svn_packed__int_count(stream))
+    return image_corrupt(NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read access rights from STREAM into *ACCESS. */
+static svn_error_t *
+read_access(authz_access_t *access,
+            svn_packed__int_stream_t *stream)
+{
+  apr_size_t value;
+
+  SVN_ERR(read_uint(&value, stream, authz_access_write));
+  if (value & ~(apr_size_t)authz_access_write)
+    return image_corrupt(NULL);
+
+  *access = (authz_access_t)value;
+  return SVN_NO_ERROR;
+}
+
+/* Read a boolean flag from STREAM into *FLAG. */
+static svn_error_t *
+read_flag(svn_boolean_t *flag,
+          svn_packed__int_stream_t *stream)
+{
+  apr_size_t value;
+
+  SVN_ERR(read_uint(&value, stream, 1));
+  *flag = (svn_boolean_t)value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read a string ID from STREAM and return the interned string in
+ * *STRING.  Fetch new strings from READER's string table.
+ */
+static svn_error_t *
+read_string(const svn_string_t **string,
+            image_reader_t *reader,
+            svn_packed__int_stream_t *stream)
+{
+  apr_size_t id;
+  apr_size_t count = reader->string_table->nelts;
+
+  SVN_ERR(read_uint(&id, stream, count));
+  if (id == count)
+    {
+      const char *data;
+      apr_size_t len;
+
+      if (svn_packed__byte_block_count(reader->strings) == 0)
+        return image_corrupt(NULL);
+
+      data = svn_packed__get_bytes(reader->strings, &len);
+      if (memchr(data, '\0', len))
+        return image_corrupt(NULL);
+
+      APR_ARRAY_PUSH(reader->string_table, const svn_string_t *)
+        = svn_string_ncreate(data, len, reader->result_pool);
+    }
+
+  *string = APR_ARRAY_IDX(reader->string_table, id, const svn_string_t *);
+  return SVN_NO_ERROR;
+}
+
+/* Like read_string but return the C string in *STRING. */
+static svn_error_t *
+read_cstring(const char **string,
+             image_reader_t *reader,
+             svn_packed__int_stream_t *stream)
+{
+  const svn_string_t *value;
+
+  SVN_ERR(read_string(&value, reader, stream));
+  *string = value->data;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read a member set ID from STREAM and return the set in *MEMBERS.
+ * Fetch new sets from READER's member sets.
+ */
+static svn_error_t *
+read_members(apr_hash_t **members,
+             image_reader_t *reader,
+             svn_packed__int_stream_t *stream)
+{
+  apr_size_t id;
+  apr_size_t count = reader->member_table->nelts;
+
+  SVN_ERR(read_uint(&id, stream, count + 1));
+  if (id == NO_MEMBERS)
+    {
+      *members = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (id == count + 1)
+    {
+      apr_hash_t *set = svn_hash__make(reader->result_pool);
+      apr_size_t i, member_count;
+
+      SVN_ERR(read_count(&member_count, reader->members));
+      for (i = 0; i < member_count; ++i)
+        {
+          const char *member;
+          SVN_ERR(read_cstring(&member, reader, reader->members));
+          svn_hash_sets(set, member, member_value);
+        }
+
+      APR_ARRAY_PUSH(reader->member_table, apr_hash_t *) = set;
+    }
+
+  *members = APR_ARRAY_IDX(reader->member_table, id - 1, apr_hash_t *);
+  return SVN_NO_ERROR;
+}
+
+/* Read RIGHTS from READER's rights stream. */
+static svn_error_t *
+read_rights(authz_rights_t *rights,
+            image_reader_t *reader)
+{
+  SVN_ERR(read_access(&rights->min_access, reader->rights));
+  SVN_ERR(read_access(&rights->max_access, reader->rights));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read global RIGHTS from READER's rights stream. */
+static svn_error_t *
+read_global_rights(authz_global_rights_t *rights,
+                   image_reader_t *reader)
+{
+  apr_size_t i, count;
+
+  SVN_ERR(read_cstring(&rights->user, reader, reader->rights));
+  SVN_ERR(read_rights(&rights->any_repos_rights, reader));
+  SVN_ERR(read_rights(&rights->all_repos_rights, reader));
+
+  rights->per_repos_rights = apr_hash_make(reader->result_pool);
+  SVN_ERR(read_count(&count, reader->rights));
+  for (i = 0; i < count; ++i)
+    {
+      const char *repos;
+      authz_rights_t *repos_rights = apr_palloc(reader->result_pool,
+                                                sizeof(*repos_rights));
+
+      SVN_ERR(read_cstring(&repos, reader, reader->rights));
+      SVN_ERR(read_rights(repos_rights, reader));
+      svn_hash_sets(rights->per_repos_rights, repos, repos_rights);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read ACL from READER's ACL stream. */
+static svn_error_t *
+read_acl(authz_acl_t *acl,
+         image_reader_t *reader)
+{
+  svn_packed__int_stream_t *stream = reader->acls;
+  apr_size_t value, i, count;
+
+  SVN_ERR(read_uint(&value, stream, APR_INT32_MAX));
+  acl->sequence_number = (int)value;
+
+  SVN_ERR(read_cstring(&acl->rule.repos, reader, stream));
+  SVN_ERR(read_count(&count, stream));
+  acl->rule.len = (int)count;
+  acl->rule.path = count
+                 ? apr_palloc(reader->result_pool,
+                              count * sizeof(*acl->rule.path))
+                 : NULL;
+  for (i = 0; i < count; ++i)
+    {
+      authz_rule_segment_t *segment = &acl->rule.path[i];
+      const svn_string_t *pattern;
+
+      SVN_ERR(read_uint(&value, stream, authz_rule_fnmatch));
+      segment->kind = (int)value;
+      SVN_ERR(read_string(&pattern, reader, stream));
+      segment->pattern = *pattern;
+    }
+
+  SVN_ERR(read_flag(&acl->has_anon_access, stream));
+  SVN_ERR(read_access(&acl->anon_access, stream));
+  SVN_ERR(read_flag(&acl->has_authn_access, stream));
+  SVN_ERR(read_access(&acl->authn_access, stream));
+
+  SVN_ERR(read_count(&count, stream));
+  acl->user_access = apr_array_make(reader->result_pool, (int)count,
+                                    sizeof(authz_ace_t));
+  for (i = 0; i < count; ++i)
+    {
+      authz_ace_t *ace = apr_array_push(acl->user_access);
+
+      SVN_ERR(read_cstring(&ace->name, reader, stream));
+      SVN_ERR(read_members(&ace->members, reader, stream));
+      SVN_ERR(read_flag(&ace->inverted, stream));
+      SVN_ERR(read_access(&ace->access, stream));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_authz__read_image(authz_full_t **authz_p,
+                      svn_stream_t *stream,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  char header[sizeof(IMAGE_HEADER) - 1];
+  apr_size_t len = sizeof(header);
+  svn_packed__data_root_t *root;
+  authz_full_t *authz;
+  image_reader_t reader;
+  apr_size_t i, count;
+  svn_error_t *err;
+
+  SVN_ERR(svn_stream_read_full(stream, header, &len));
+  if (len != sizeof(header) || memcmp(header, IMAGE_HEADER, len))
+    return image_corrupt(NULL);
+
+  err = svn_packed__data_read(&root, stream, scratch_pool, scratch_pool);
+  if (err)
+    return image_corrupt(err);
+
+  reader.strings = svn_packed__first_byte_stream(root);
+  reader.members = svn_packed__first_int_stream(root);
+  reader.acls = reader.members ? svn_packed__next_int_stream(reader.members)
+                               : NULL;
+  reader.rights = reader.acls ? svn_packed__next_int_stream(reader.acls)
+                              : NULL;
+  if (!reader.strings || !reader.rights)
+    return image_corrupt(NULL);
+
+  reader.string_table = apr_array_make(scratch_pool, 64,
+                                       sizeof(const svn_string_t *));
+  reader.member_table = apr_array_make(scratch_pool, 16,
+                                       sizeof(apr_hash_t *));
+  reader.result_pool = result_pool;
+
+  authz = apr_pcalloc(result_pool, sizeof(*authz));
+  authz->pool = result_pool;
+
+  SVN_ERR(read_count(&count, reader.acls));
+  authz->acls = apr_array_make(result_pool, (int)count, sizeof(authz_acl_t));
+  for (i = 0; i < count; ++i)
+    SVN_ERR(read_acl(apr_array_push(authz->acls), &reader));
+
+  SVN_ERR(read_flag(&authz->has_anon_rights, reader.rights));
+  SVN_ERR(read_global_rights(&authz->anon_rights, &reader));
+  SVN_ERR(read_flag(&authz->has_authn_rights, reader.rights));
+  SVN_ERR(read_global_rights(&authz->authn_rights, &reader));
+
+  authz->user_rights = svn_hash__make(result_pool);
+  SVN_ERR(read_count(&count, reader.rights));
+  for (i = 0; i < count; ++i)
+    {
+      authz_global_rights_t *rights = apr_palloc(result_pool,
+                                                 sizeof(*rights));
+      SVN_ERR(read_global_rights(rights, &reader));
+      svn_hash_sets(authz->user_rights, rights->user, rights);
+    }
+
+  *authz_p = authz;
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,785 @@
+/* blame.c : server-side line-origin annotation of files
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_checksum.h"
+#include "svn_diff.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+
+#include "private/svn_packed_data.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+/* Name of the directory within the repository's db directory that holds
+ * the blame cache.  Each file in it contains the final annotations for
+ * one node-revision and set of diff options.  Entries never get outdated
+ * and the whole directory may be deleted at any time. */
+#define BLAME_CACHE_DIR "blame-cache"
+
+/* A cache entry starts with this line, followed by svn_packed__data_t
+ * content with one byte stream and one integer stream:
+ *
+ *   CHECKSUM  the MD5 digest of the annotated file contents
+ *   REVS      the revision that last changed each line, in line order
+ */
+#define BLAME_CACHE_HEADER "SVN-blame-cache: 1\n"
+
+/* State kept while walking the interesting revisions of a file. */
+typedef struct blame_baton_t
+{
+  /* Lines from revisions before this one don't get attributed. */
+  svn_revnum_t start;
+
+  /* How to compare subsequent file revisions. */
+  const svn_diff_file_options_t *diff_options;
+
+  /* Contents of the last interesting revision and, for each of its lines,
+   * the svn_revnum_t that last changed it.  TEXT is NULL before the first
+   * revision has been processed. */
+  svn_stringbuf_t *text;
+  apr_array_header_t *revs;
+
+  /* Contents of the revision currently being received and the revision
+   * to attribute its changes to. */
+  svn_stringbuf_t *next_text;
+  svn_revnum_t next_rev;
+
+  /* If not NULL, annotations from the blame cache for the first revision
+   * being received.  Set to NULL once they have been used. */
+  apr_array_header_t *initial_revs;
+
+  /* Set, if INITIAL_REVS turned out not to match the file contents. */
+  svn_boolean_t cache_mismatch;
+
+  /* TEXT and REVS live in CURRENT_POOL, NEXT_TEXT in NEXT_POOL.  The two
+   * get swapped after each revision. */
+  apr_pool_t *current_pool;
+  apr_pool_t *next_pool;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} blame_baton_t;
+
+/* Baton for the diff output functions used to update the annotations. */
+typedef struct diff_baton_t
+{
+  /* Annotations for the old contents. */
+  const apr_array_header_t *old_revs;
+
+  /* Annotations for the new contents, being built. */
+  apr_array_header_t *new_revs;
+
+  /* Revision to attribute changed lines to. */
+  svn_revnum_t rev;
+} diff_baton_t;
+
+/* Baton for our delta window handler. */
+typedef struct delta_baton_t
+{
+  svn_txdelta_window_handler_t wrapped_handler;
+  void *wrapped_baton;
+  blame_baton_t *blame_baton;
+} delta_baton_t;
+
+
+/* Starting at *POS within TEXT, find the next line.  Make *LINE point to
+ * it, excluding the line terminator, and advance *POS to the start of the
+ * following line.  Return FALSE, if there is no further line.
+ *
+ * Lines are split the same way svn_diff_mem_string_diff() tokenizes its
+ * input, i.e. at CRLF, CR and LF.
+ */
+static svn_boolean_t
+next_line(svn_string_t *line,
+          apr_size_t *pos,
+          const svn_stringbuf_t *text)
+{
+  apr_size_t i = *pos;
+  if (i == text->len)
+    return FALSE;
+
+  while (i < text->len && text->data[i] != '\r' && text->data[i] != '\n')
+    ++i;
+
+  line->data = text->data + *pos;
+  line->len = i - *pos;
+  if (i < text->len)
+    {
+      if (text->data[i] == '\r' && i + 1 < text->len
+          && text->data[i + 1] == '\n')
+        ++i;
+      ++i;
+    }
+
+  *pos = i;
+  return TRUE;
+}
+
+/* Like next_line(), but split TEXT into the lines that we report.  Like
+ * svn_client_blame5() does for the annotations it calculates locally,
+ * only split at LF and keep any CR as part of the line.  The annotation
+ * of the N-th line reported is the one of the N-th line (token) found by
+ * next_line().  Both are the same unless TEXT contains a bare CR.
+ */
+static svn_boolean_t
+next_report_line(svn_string_t *line,
+                 apr_size_t *pos,
+                 const svn_stringbuf_t *text)
+{
+  const char *eol;
+
+  if (*pos == text->len)
+    return FALSE;
+
+  line->data = text->data + *pos;
+  eol = memchr(line->data, '\n', text->len - *pos);
+  line->len = eol ? (apr_size_t)(eol - line->data) : text->len - *pos;
+
+  *pos += line->len + (eol ? 1 : 0);
+  return TRUE;
+}
+
+/* Return the number of lines in TEXT. */
+static int
+count_lines(const svn_stringbuf_t *text)
+{
+  svn_string_t line;
+  apr_size_t pos = 0;
+  int count = 0;
+
+  while (next_line(&line, &pos, text))
+    ++count;
+
+  return count;
+}
+
+/* Return a read-only view on the contents of BUF, allocated in POOL. */
+static const svn_string_t *
+as_string(const svn_stringbuf_t *buf,
+          apr_pool_t *pool)
+{
+  svn_string_t *result = apr_palloc(pool, sizeof(*result));
+  result->data = buf->data;
+  result->len = buf->len;
+
+  return result;
+}
+
+/* Implements svn_diff_output_fns_t.output_common.
+ * Unchanged lines keep their annotations. */
+static svn_error_t *
+output_common(void *baton,
+              apr_off_t original_start,
+              apr_off_t original_length,
+              apr_off_t modified_start,
+              apr_off_t modified_length,
+              apr_off_t latest_start,
+              apr_off_t latest_length)
+{
+  diff_baton_t *db = baton;
+  apr_off_t i;
+
+  SVN_ERR_ASSERT(original_start + original_length <= db->old_revs->nelts);
+  for (i = 0; i < original_length; ++i)
+    APR_ARRAY_PUSH(db->new_revs, svn_revnum_t)
+      = APR_ARRAY_IDX(db->old_revs, original_start + i, svn_revnum_t);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t.output_diff_modified.
+ * Added and changed lines get attributed to the new revision. */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  diff_baton_t *db = baton;
+  apr_off_t i;
+
+  for (i = 0; i < modified_length; ++i)
+    APR_ARRAY_PUSH(db->new_revs, svn_revnum_t) = db->rev;
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t output_fns = {
+        output_common,
+        output_diff_modified
+};
+
+/* Annotate BB->NEXT_TEXT based on the annotations of BB->TEXT and make it
+ * the new BB->TEXT.
+ */
+static svn_error_t *
+update_blame(blame_baton_t *bb)
+{
+  apr_pool_t *pool = bb->next_pool;
+  apr_array_header_t *revs;
+
+  if (bb->initial_revs)
+    {
+      /* Continue from where the cached blame left off. */
+      revs = bb->initial_revs;
+      bb->initial_revs = NULL;
+      if (revs->nelts != count_lines(bb->next_text))
+        bb->cache_mismatch = TRUE;
+    }
+  else if (!bb->text)
+    {
+      /* Every line has been added in the first revision. */
+      int count = count_lines(bb->next_text);
+      int i;
+
+      revs = apr_array_make(pool, count, sizeof(svn_revnum_t));
+      for (i = 0; i < count; ++i)
+        APR_ARRAY_PUSH(revs, svn_revnum_t) = bb->next_rev;
+    }
+  else
+    {
+      svn_diff_t *diff;
+      diff_baton_t db;
+
+      revs = apr_array_make(pool, bb->revs->nelts, sizeof(svn_revnum_t));
+      db.old_revs = bb->revs;
+      db.new_revs = revs;
+      db.rev = bb->next_rev;
+
+      SVN_ERR(svn_diff_mem_string_diff(&diff, as_string(bb->text, pool),
+                                       as_string(bb->next_text, pool),
+                                       bb->diff_options, pool));
+      SVN_ERR(svn_diff_output2(diff, &db, &output_fns,
+                               bb->cancel_func, bb->cancel_baton));
+    }
+
+  bb->text = bb->next_text;
+  bb->revs = revs;
+  bb->next_text = NULL;
+
+  bb->next_pool = bb->current_pool;
+  bb->current_pool = pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_window_handler_t.
+ * Reconstruct the next file revision and annotate it once complete. */
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window,
+               void *baton)
+{
+  delta_baton_t *db = baton;
+
+  SVN_ERR(db->wrapped_handler(window, db->wrapped_baton));
+  if (window)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(update_blame(db->blame_baton));
+}
+
+/* Implements svn_file_rev_handler_t. */
+static svn_error_t *
+file_rev_handler(void *baton,
+                 const char *path,
+                 svn_revnum_t rev,
+                 apr_hash_t *rev_props,
+                 svn_boolean_t result_of_merge,
+                 svn_txdelta_window_handler_t *delta_handler,
+                 void **delta_baton,
+                 apr_array_header_t *prop_diffs,
+                 apr_pool_t *pool)
+{
+  blame_baton_t *bb = baton;
+  delta_baton_t *db;
+  svn_stream_t *source;
+
+  if (bb->cancel_func)
+    SVN_ERR(bb->cancel_func(bb->cancel_baton));
+
+  /* Revisions that did not change the contents don't affect the blame. */
+  if (!delta_handler || bb->cache_mismatch)
+    return SVN_NO_ERROR;
+
+  svn_pool_clear(bb->next_pool);
+  bb->next_text = svn_stringbuf_create_empty(bb->next_pool);
+  bb->next_rev = rev < bb->start ? SVN_INVALID_REVNUM : rev;
+
+  source = bb->text
+         ? svn_stream_from_string(as_string(bb->text, bb->next_pool),
+                                  bb->next_pool)
+         : svn_stream_empty(bb->next_pool);
+
+  db = apr_pcalloc(bb->next_pool, sizeof(*db));
+  db->blame_baton = bb;
+  svn_txdelta_apply(source,
+                    svn_stream_from_stringbuf(bb->next_text, bb->next_pool),
+                    NULL, NULL, bb->next_pool,
+                    &db->wrapped_handler, &db->wrapped_baton);
+
+  *delta_handler = window_handler;
+  *delta_baton = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE_PATH to the blame cache entry in REPOS for PATH in ROOT and
+ * DIFF_OPTIONS.  Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+get_cache_path(const char **cache_path,
+               svn_repos_t *repos,
+               svn_fs_root_t *root,
+               const char *path,
+               const svn_diff_file_options_t *diff_options,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const svn_fs_id_t *id;
+  const char *key;
+  svn_checksum_t *checksum;
+
+  SVN_ERR(svn_fs_node_id(&id, root, path, scratch_pool));
+  key = apr_psprintf(scratch_pool, "%s %d %d",
+                     svn_fs_unparse_id(id, scratch_pool)->data,
+                     (int)diff_options->ignore_space,
+                     (int)diff_options->ignore_eol_style);
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, key, strlen(key),
+                       scratch_pool));
+
+  *cache_path = svn_dirent_join_many(result_pool, repos->db_path,
+                                     BLAME_CACHE_DIR,
+                                     svn_checksum_to_cstring(checksum,
+                                                             scratch_pool),
+                                     SVN_VA_NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the blame cache entry at CACHE_PATH and return its annotations in
+ * *REVS, allocated in RESULT_POOL.  The entry must belong to contents with
+ * the MD5 CHECKSUM and must not reference revisions after REV.  Set *REVS
+ * to NULL, if there is no such entry.
+ */
+static svn_error_t *
+read_cache_entry(apr_array_header_t **revs,
+                 const char *cache_path,
+                 const svn_checksum_t *checksum,
+                 svn_revnum_t rev,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  svn_packed__data_root_t *root;
+  svn_packed__byte_stream_t *digests;
+  svn_packed__int_stream_t *numbers;
+  char header[sizeof(BLAME_CACHE_HEADER) - 1];
+  apr_size_t len = sizeof(header);
+  const char *digest;
+  apr_size_t count;
+  apr_size_t i;
+  svn_error_t *err;
+
+  *revs = NULL;
+
+  /* Any problem with the entry simply means that we don't use it. */
+  err = svn_stream_open_readonly(&stream, cache_path, scratch_pool,
+                                 scratch_pool);
+  if (!err)
+    err = svn_stream_read_full(stream, header, &len);
+  if (!err && (len != sizeof(header)
+               || memcmp(header, BLAME_CACHE_HEADER, len)))
+    return SVN_NO_ERROR;
+  if (!err)
+    err = svn_packed__data_read(&root, stream, scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  digests = svn_packed__first_byte_stream(root);
+  numbers = svn_packed__first_int_stream(root);
+  if (!digests || !numbers)
+    return SVN_NO_ERROR;
+
+  digest = svn_packed__get_bytes(digests, &len);
+  if (len != svn_checksum_size(checksum)
+      || memcmp(digest, checksum->digest, len))
+    return SVN_NO_ERROR;
+
+  count = svn_packed__int_count(numbers);
+  if (count > APR_INT32_MAX)
+    return SVN_NO_ERROR;
+
+  *revs = apr_array_make(result_pool, (int)count, sizeof(svn_revnum_t));
+  for (i = 0; i < count; ++i)
+    {
+      apr_uint64_t value = svn_packed__get_uint(numbers);
+      if (value == 0 || value > (apr_uint64_t)rev)
+        {
+          *revs = NULL;
+          break;
+        }
+
+      APR_ARRAY_PUSH(*revs, svn_revnum_t) = (svn_revnum_t)value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the annotations REVS for TEXT in the blame cache entry at
+ * CACHE_PATH.  Failures are ignored as the cache is only an optimization.
+ */
+static void
+write_cache_entry(const char *cache_path,
+                  const svn_stringbuf_t *text,
+                  const apr_array_header_t *revs,
+                  apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  svn_packed__byte_stream_t *digests = svn_packed__create_bytes_stream(root);
+  svn_packed__int_stream_t *numbers
+    = svn_packed__create_int_stream(root, TRUE, FALSE);
+  svn_stringbuf_t *entry = svn_stringbuf_create(BLAME_CACHE_HEADER,
+                                                scratch_pool);
+  svn_checksum_t *checksum;
+  svn_error_t *err;
+  int i;
+
+  err = svn_checksum(&checksum, svn_checksum_md5, text->data, text->len,
+                     scratch_pool);
+  if (!err)
+    {
+      svn_packed__add_bytes(digests, (const char *)checksum->digest,
+                            svn_checksum_size(checksum));
+      for (i = 0; i < revs->nelts; ++i)
+        svn_packed__add_uint(numbers, APR_ARRAY_IDX(revs, i, svn_revnum_t));
+
+      err = svn_packed__data_write(svn_stream_from_stringbuf(entry,
+                                                             scratch_pool),
+                                   root, scratch_pool);
+    }
+
+  /* Entries get replaced atomically such that concurrent readers never
+   * see partial data. */
+  if (!err)
+    err = svn_io_make_dir_recursively(svn_dirent_dirname(cache_path,
+                                                         scratch_pool),
+                                      scratch_pool);
+  if (!err)
+    err = svn_io_write_atomic2(cache_path, entry->data, entry->len, NULL,
+                               FALSE, scratch_pool);
+
+  svn_error_clear(err);
+}
+
+/* Walk the history of PATH in REPOS as seen in revision END and look for
+ * blame cache entries for DIFF_OPTIONS.
+ *
+ * If all locations in that history are readable according to the
+ * optional AUTHZ_READ_FUNC and AUTHZ_READ_BATON, set *END_CACHE_PATH to
+ * the cache entry for PATH@END.  Otherwise, set it to NULL and don't use
+ * the cache at all, as cached results might contain information that the
+ * user must not see.
+ *
+ * If a cache entry exists for any location, set *CACHED_REV to the
+ * revision of the latest such location and *CACHED_REVS to its
+ * annotations, allocated in RESULT_POOL.  Otherwise, set *CACHED_REV to
+ * SVN_INVALID_REVNUM and *CACHED_REVS to NULL.  Set *END_CACHED, if that
+ * location is PATH@END itself.
+ */
+static svn_error_t *
+find_cache_entries(const char **end_cache_path,
+                   svn_boolean_t *end_cached,
+                   svn_revnum_t *cached_rev,
+                   apr_array_header_t **cached_revs,
+                   svn_repos_t *repos,
+                   const char *path,
+                   svn_revnum_t end,
+                   const svn_diff_file_options_t *diff_options,
+                   svn_repos_authz_func_t authz_read_func,
+                   void *authz_read_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_history_t *history;
+  svn_fs_root_t *root;
+
+  *end_cache_path = NULL;
+  *end_cached = FALSE;
+  *cached_rev = SVN_INVALID_REVNUM;
+  *cached_revs = NULL;
+
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, end, scratch_pool));
+  SVN_ERR(svn_fs_node_history2(&history, root, path, scratch_pool,
+                               scratch_pool));
+  while (1)
+    {
+      const char *history_path;
+      svn_revnum_t history_rev;
+      svn_fs_root_t *history_root;
+
+      svn_pool_clear(iterpool);
+
+      /* The history object must survive ITERPOOL. */
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, scratch_pool,
+                                   iterpool));
+      if (!history)
+        break;
+
+      SVN_ERR(svn_fs_history_location(&history_path, &history_rev,
+                                      history, iterpool));
+      SVN_ERR(svn_fs_revision_root(&history_root, repos->fs, history_rev,
+                                   iterpool));
+
+      if (authz_read_func)
+        {
+          svn_boolean_t readable;
+
+          SVN_ERR(authz_read_func(&readable, history_root, history_path,
+                                  authz_read_baton, iterpool));
+          if (!readable)
+            {
+              *end_cache_path = NULL;
+              *end_cached = FALSE;
+              *cached_rev = SVN_INVALID_REVNUM;
+              *cached_revs = NULL;
+              break;
+            }
+        }
+
+      if (!*cached_revs)
+        {
+          const char *cache_path;
+          svn_checksum_t *checksum;
+
+          SVN_ERR(get_cache_path(&cache_path, repos, history_root,
+                                 history_path, diff_options, result_pool,
+                                 iterpool));
+          SVN_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5,
+                                       history_root, history_path, TRUE,
+                                       iterpool));
+          SVN_ERR(read_cache_entry(cached_revs, cache_path, checksum,
+                                   history_rev, result_pool, iterpool));
+          if (*cached_revs)
+            {
+              *cached_rev = history_rev;
+              *end_cached = (*end_cache_path == NULL);
+            }
+
+          if (!*end_cache_path)
+            *end_cache_path = cache_path;
+        }
+
+      /* Without authz restrictions, there is nothing left to check. */
+      if (*cached_revs && !authz_read_func)
+        break;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Annotate PATH@END in REPOS, using the history from START onwards.
+ * If CACHED_REVS is not NULL, start at CACHED_REV instead and use
+ * CACHED_REVS as annotations for that revision.
+ *
+ * Return the final contents in *TEXT and their annotations in *REVS,
+ * both allocated in RESULT_POOL.  If the cached annotations don't match
+ * the contents, set both to NULL.  The other parameters are as for
+ * svn_repos_get_blame.
+ */
+static svn_error_t *
+annotate(svn_stringbuf_t **text,
+         apr_array_header_t **revs,
+         svn_repos_t *repos,
+         const char *path,
+         svn_revnum_t start,
+         svn_revnum_t end,
+         svn_revnum_t cached_rev,
+         apr_array_header_t *cached_revs,
+         const svn_diff_file_options_t *diff_options,
+         svn_repos_authz_func_t authz_read_func,
+         void *authz_read_baton,
+         svn_cancel_func_t cancel_func,
+         void *cancel_baton,
+         apr_pool_t *result_pool,
+         apr_pool_t *scratch_pool)
+{
+  blame_baton_t bb = { 0 };
+
+  bb.start = start;
+  bb.diff_options = diff_options;
+  bb.initial_revs = cached_revs;
+  bb.current_pool = svn_pool_create(scratch_pool);
+  bb.next_pool = svn_pool_create(scratch_pool);
+  bb.cancel_func = cancel_func;
+  bb.cancel_baton = cancel_baton;
+
+  /* We need one revision before START to know what changed in START. */
+  SVN_ERR(svn_repos_get_file_revs2(repos, path,
+                                   cached_revs ? cached_rev
+                                               : MAX(0, start - 1),
+                                   end, FALSE,
+                                   authz_read_func, authz_read_baton,
+                                   file_rev_handler, &bb, scratch_pool));
+
+  if (bb.cache_mismatch)
+    {
+      *text = NULL;
+      *revs = NULL;
+    }
+  else
+    {
+      SVN_ERR_ASSERT(bb.text != NULL);
+      *text = svn_stringbuf_dup(bb.text, result_pool);
+      *revs = apr_array_copy(result_pool, bb.revs);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_get_blame(svn_repos_t *repos,
+                    const char *path,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    const svn_diff_file_options_t *diff_options,
+                    svn_repos_authz_func_t authz_read_func,
+                    void *authz_read_baton,
+                    svn_repos_blame_receiver_t receiver,
+                    void *receiver_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  svn_diff_file_options_t *default_options = NULL;
+  const char *end_cache_path = NULL;
+  svn_boolean_t end_cached = FALSE;
+  svn_revnum_t cached_rev = SVN_INVALID_REVNUM;
+  apr_array_header_t *cached_revs = NULL;
+  svn_stringbuf_t *text;
+  apr_array_header_t *revs;
+  apr_hash_t *rev_props;
+  apr_pool_t *iterpool;
+  svn_string_t line;
+  apr_size_t pos;
+  int i;
+
+  if (!SVN_IS_VALID_REVNUM(end))
+    SVN_ERR(svn_fs_youngest_rev(&end, repos->fs, scratch_pool));
+  if (!SVN_IS_VALID_REVNUM(start))
+    start = 0;
+
+  if (start > end)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Server-side blame does not support reverse "
+                               "revision ranges (r%ld:%ld)"), start, end);
+
+  if (!diff_options)
+    {
+      default_options = svn_diff_file_options_create(scratch_pool);
+      diff_options = default_options;
+    }
+
+  /* The cache holds complete annotations, i.e. we can only use it if the
+   * whole history is being considered. */
+  if (start <= 1)
+    SVN_ERR(find_cache_entries(&end_cache_path, &end_cached,
+                               &cached_rev, &cached_revs,
+                               repos, path, end, diff_options,
+                               authz_read_func, authz_read_baton,
+                               scratch_pool, scratch_pool));
+
+  SVN_ERR(annotate(&text, &revs, repos, path, start, end,
+                   cached_rev, cached_revs, diff_options,
+                   authz_read_func, authz_read_baton,
+                   cancel_func, cancel_baton, scratch_pool, scratch_pool));
+  if (!text)
+    {
+      /* Stale cache entry.  Start over without it. */
+      end_cached = FALSE;
+      SVN_ERR(annotate(&text, &revs, repos, path, start, end,
+                       SVN_INVALID_REVNUM, NULL, diff_options,
+                       authz_read_func, authz_read_baton,
+                       cancel_func, cancel_baton, scratch_pool,
+                       scratch_pool));
+    }
+
+  /* Remember the result unless it came straight from the cache. */
+  if (end_cache_path && !end_cached)
+    write_cache_entry(end_cache_path, text, revs, scratch_pool);
+
+  /* Report all lines with the properties of the revisions that changed
+   * them.  Fetch these only once per revision. */
+  rev_props = apr_hash_make(scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  pos = 0;
+  for (i = 0; i < revs->nelts && next_report_line(&line, &pos, text); ++i)
+    {
+      svn_revnum_t rev = APR_ARRAY_IDX(revs, i, svn_revnum_t);
+      apr_hash_t *props = NULL;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (SVN_IS_VALID_REVNUM(rev))
+        {
+          props = apr_hash_get(rev_props, &rev, sizeof(rev));
+          if (!props)
+            {
+              svn_revnum_t *key = apr_pmemdup(scratch_pool, &rev,
+                                              sizeof(rev));
+
+              SVN_ERR(svn_repos_fs_revision_proplist(&props, repos, rev,
+                                                     authz_read_func,
+                                                     authz_read_baton,
+                                                     scratch_pool));
+              apr_hash_set(rev_props, key, sizeof(*key), props);
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, i, rev, props,
+                       svn_string_ncreate(line.data, line.len, iterpool),
+                       iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,289 @@
+/* date_index.c --- mapping dates to revisions without reading revprops
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_mmap.h>
+
+#include "svn_private_config.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_fs.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+#include "svn_time.h"
+#include "repos.h"
+
+
+/* The date index is a file within the repository's db directory.  It
+ * consists of the DATE_INDEX_MAGIC header, followed by one fixed-size
+ * record per revision, in revision order.  Each record is the svn:date
+ * of that revision as an apr_time_t, stored as a big-endian 64 bit
+ * number.  A record of 0 means "unknown" and so do records beyond the
+ * end of the file.
+ *
+ * Records are written at their fixed offsets, so writers never need to
+ * coordinate and a gap left by a concurrent or failed update simply
+ * reads as "unknown".  Since the index may also be out of date, e.g.
+ * after svn:date has been changed directly through the FS layer, readers
+ * must never trust it blindly.
+ */
+#define DATE_INDEX "date-index"
+#define DATE_INDEX_MAGIC "SVNDIDX1"
+#define DATE_INDEX_HEADER_LEN (sizeof(DATE_INDEX_MAGIC) - 1)
+#define DATE_INDEX_RECORD_LEN 8
+
+/* Return the path of REPOS' date index, allocated in POOL. */
+static const char *
+date_index_path(svn_repos_t *repos,
+                apr_pool_t *pool)
+{
+  return svn_dirent_join(repos->db_path, DATE_INDEX, pool);
+}
+
+/* Write TM as a date index record to BUF. */
+static void
+encode_time(unsigned char *buf,
+            apr_time_t tm)
+{
+  apr_uint64_t value = (apr_uint64_t)tm;
+  int i;
+
+  for (i = DATE_INDEX_RECORD_LEN - 1; i >= 0; --i)
+    {
+      buf[i] = (unsigned char)(value & 0xff);
+      value >>= 8;
+    }
+}
+
+/* Return the time stored in the date index record at BUF. */
+static apr_time_t
+decode_time(const unsigned char *buf)
+{
+  apr_uint64_t value = 0;
+  int i;
+
+  for (i = 0; i < DATE_INDEX_RECORD_LEN; ++i)
+    value = (value << 8) | buf[i];
+
+  return (apr_time_t)value;
+}
+
+/* Set *TM to the svn:date of REV in FS or to 0, if it has none or an
+ * invalid one.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_revision_time(apr_time_t *tm,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  apr_pool_t *scratch_pool)
+{
+  svn_string_t *date_str;
+
+  *tm = 0;
+  SVN_ERR(svn_fs_revision_prop2(&date_str, fs, rev, SVN_PROP_REVISION_DATE,
+                                FALSE, scratch_pool, scratch_pool));
+  if (date_str)
+    {
+      svn_error_t *err = svn_time_from_cstring(tm, date_str->data,
+                                               scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          *tm = 0;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__date_index_update(svn_repos_t *repos,
+                             svn_revnum_t rev,
+                             apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_filesize_t size;
+  apr_off_t offset;
+  apr_time_t tm;
+  unsigned char record[DATE_INDEX_RECORD_LEN];
+  svn_error_t *err;
+
+  /* Only repositories that have an index get it updated. */
+  err = svn_io_file_open(&file, date_index_path(repos, scratch_pool),
+                         APR_WRITE | APR_BINARY, APR_OS_DEFAULT,
+                         scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Don't extend foreign or truncated files. */
+  SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+  if (size < DATE_INDEX_HEADER_LEN)
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  SVN_ERR(get_revision_time(&tm, repos->fs, rev, scratch_pool));
+  encode_time(record, tm);
+
+  offset = DATE_INDEX_HEADER_LEN + (apr_off_t)rev * DATE_INDEX_RECORD_LEN;
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, record, sizeof(record), NULL,
+                                 scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+svn_error_t *
+svn_repos__date_index_lookup(svn_revnum_t *revision,
+                             svn_repos_t *repos,
+                             apr_time_t tm,
+                             svn_revnum_t youngest,
+                             apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_filesize_t size;
+  const unsigned char *data = NULL;
+  svn_revnum_t count, bot, top;
+  svn_revnum_t found = 0;
+  svn_error_t *err;
+
+  *revision = SVN_INVALID_REVNUM;
+
+  err = svn_io_file_open(&file, date_index_path(repos, scratch_pool),
+                         APR_READ | APR_BINARY, APR_OS_DEFAULT,
+                         scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+  if (size <= DATE_INDEX_HEADER_LEN || size > APR_SIZE_MAX)
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+#if APR_HAS_MMAP
+  {
+    apr_mmap_t *map;
+    if (apr_mmap_create(&map, file, 0, (apr_size_t)size, APR_MMAP_READ,
+                        scratch_pool) == APR_SUCCESS)
+      data = map->mm;
+  }
+#endif
+
+  /* Without a mapping, simply read the whole index. */
+  if (data == NULL)
+    {
+      unsigned char *buf = apr_palloc(scratch_pool, (apr_size_t)size);
+      SVN_ERR(svn_io_file_read_full2(file, buf, (apr_size_t)size, NULL,
+                                     NULL, scratch_pool));
+      data = buf;
+    }
+
+  if (memcmp(data, DATE_INDEX_MAGIC, DATE_INDEX_HEADER_LEN) != 0)
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  /* Revisions beyond YOUNGEST may have been committed after our caller
+   * looked, so ignore their records. */
+  count = (svn_revnum_t)((size - DATE_INDEX_HEADER_LEN)
+                         / DATE_INDEX_RECORD_LEN);
+  if (count > youngest + 1)
+    count = youngest + 1;
+  if (count == 0)
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  /* Find the youngest revision not younger than TM.  Give up as soon as
+   * we hit an unknown entry. */
+  data += DATE_INDEX_HEADER_LEN;
+  bot = 0;
+  top = count - 1;
+  while (bot <= top)
+    {
+      svn_revnum_t mid = bot + (top - bot) / 2;
+      apr_time_t this_time = decode_time(data + mid * DATE_INDEX_RECORD_LEN);
+
+      if (this_time == 0)
+        return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+      if (this_time <= tm)
+        {
+          found = mid;
+          bot = mid + 1;
+        }
+      else
+        {
+          top = mid - 1;
+        }
+    }
+
+  *revision = found;
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+svn_error_t *
+svn_repos_rebuild_date_index(svn_repos_t *repos,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest, rev;
+  svn_stringbuf_t *index;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_refresh_revision_props(repos->fs, scratch_pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, scratch_pool));
+
+  index = svn_stringbuf_create_ensure(DATE_INDEX_HEADER_LEN
+                                        + (apr_size_t)(youngest + 1)
+                                          * DATE_INDEX_RECORD_LEN,
+                                      scratch_pool);
+  svn_stringbuf_appendbytes(index, DATE_INDEX_MAGIC, DATE_INDEX_HEADER_LEN);
+
+  for (rev = 0; rev <= youngest; ++rev)
+    {
+      apr_time_t tm;
+      unsigned char record[DATE_INDEX_RECORD_LEN];
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(get_revision_time(&tm, repos->fs, rev, iterpool));
+      encode_time(record, tm);
+      svn_stringbuf_appendbytes(index, (const char *)record, sizeof(record));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Revisions committed while we were busy may be missing from the new
+   * index.  Their records will simply read as "unknown". */
+  return svn_error_trace(svn_io_write_atomic2(date_index_path(repos,
+                                                              scratch_pool),
+                                              index->data, index->len,
+                                              NULL, TRUE, scratch_pool));
+}
@@ -44,6 +44,11 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
+
+#include "repos.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1978,9 +1983,420 @@ dump_filter_authz_func(svn_boolean_t *allowed,
 
 
 
+/* Parameters of a dump that apply to all revisions. */
+typedef struct dump_params_t
+{
+  svn_revnum_t start_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+  svn_repos_authz_func_t authz_func;
+  void *authz_baton;
+} dump_params_t;
+
+/* Write the revision record and, if requested, the node records of
+   revision REV in REPOS to STREAM according to PARAMS.  Set
+   *FOUND_OLD_REFERENCE and *FOUND_OLD_MERGEINFO if there were references
+   to revisions before PARAMS->START_REV, and send warnings about them
+   to NOTIFY_FUNC with NOTIFY_BATON.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+dump_revision(svn_stream_t *stream,
+              svn_repos_t *repos,
+              svn_revnum_t rev,
+              const dump_params_t *params,
+              svn_boolean_t *found_old_reference,
+              svn_boolean_t *found_old_mergeinfo,
+              svn_repos_notify_func_t notify_func,
+              void *notify_baton,
+              apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, repos, rev, params->include_revprops,
+                                params->authz_func, params->authz_baton,
+                                scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !params->include_changes)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = params->use_deltas
+                    && (params->incremental || rev != params->start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          params->start_rev, use_deltas_for_rev,
+                          FALSE, FALSE, scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == params->start_rev) && (! params->incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   params->authz_func, params->authz_baton,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                params->authz_func, params->authz_baton,
+                                scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/** Concurrent dumps.
+ *
+ * Revision records are independent of each other, so we can generate
+ * them in worker threads, buffer them and write them out in revision
+ * order.  svn_fs_t objects must not be shared between threads, hence
+ * every worker uses a separate repository handle.
+ */
+
+/* Revision records up to this size will be buffered in memory,
+   larger ones get spilled to a temporary file. */
+#define DUMP_SPILL_BLOCKSIZE (16 * 1024)
+#define DUMP_SPILL_MAXSIZE   (1024 * 1024)
+
+/* State shared by all tasks of a concurrent dump. */
+typedef struct dump_context_t
+{
+  const dump_params_t *params;
+
+  /* Destination and feedback of the caller. */
+  svn_stream_t *stream;
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+  svn_repos_notify_t *rev_end_notify;
+  svn_boolean_t *found_old_reference;
+  svn_boolean_t *found_old_mergeinfo;
+
+  /* Repository handles (svn_repos_t *) that are currently not used by
+     any worker.  Access is serialized by MUTEX. */
+  apr_array_header_t *idle_repos;
+  svn_mutex__t *mutex;
+} dump_context_t;
+
+/* A single revision to dump. */
+typedef struct dump_task_t
+{
+  dump_context_t *context;
+  svn_revnum_t revision;
+} dump_task_t;
+
+/* Output of a dump_task_t. */
+typedef struct dump_result_t
+{
+  /* The dump data of the revision. */
+  svn_spillbuf_t *buffer;
+
+  /* Notifications (svn_repos_notify_t *) to send to the caller and the
+     pool to allocate them in. */
+  apr_array_header_t *notifications;
+  apr_pool_t *pool;
+
+  /* Whether the revision referred to revisions that were not dumped. */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+} dump_result_t;
+
+/* Implements svn_repos_notify_func_t.  Add a copy of NOTIFY to the
+   dump_result_t in BATON. */
+static void
+record_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  dump_result_t *result = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(result->pool, notify,
+                                         sizeof(*notify));
+
+  copy->warning_str = apr_pstrdup(result->pool, notify->warning_str);
+  copy->path = apr_pstrdup(result->pool, notify->path);
+  APR_ARRAY_PUSH(result->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Take an idle repository handle from CONTEXT and return it in *REPOS. */
+static svn_error_t *
+acquire_repos(svn_repos_t **repos,
+              dump_context_t *context)
+{
+  /* There is one handle per worker thread, so we never run out. */
+  SVN_ERR_ASSERT(context->idle_repos->nelts > 0);
+  *repos = APR_ARRAY_IDX(context->idle_repos,
+                         context->idle_repos->nelts - 1, svn_repos_t *);
+  apr_array_pop(context->idle_repos);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return REPOS to the idle handles in CONTEXT. */
+static svn_error_t *
+release_repos(dump_context_t *context,
+              svn_repos_t *repos)
+{
+  APR_ARRAY_PUSH(context->idle_repos, svn_repos_t *) = repos;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Dump the revision given by the
+   dump_task_t in TASK_BATON to a dump_result_t. */
+static svn_error_t *
+process_dump_task(void **result,
+                  void *task_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  dump_task_t *task = task_baton;
+  dump_context_t *context = task->context;
+  dump_result_t *dump_result = apr_pcalloc(result_pool, sizeof(*dump_result));
+  svn_stream_t *stream;
+  svn_repos_t *repos;
+  svn_error_t *err;
+
+  dump_result->buffer = svn_spillbuf__create(DUMP_SPILL_BLOCKSIZE,
+                                             DUMP_SPILL_MAXSIZE,
+                                             result_pool);
+  dump_result->notifications = apr_array_make(result_pool, 0,
+                                              sizeof(svn_repos_notify_t *));
+  dump_result->pool = result_pool;
+  stream = svn_stream__from_spillbuf(dump_result->buffer, scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(context->mutex, acquire_repos(&repos, context));
+  err = dump_revision(stream, repos, task->revision, context->params,
+                      &dump_result->found_old_reference,
+                      &dump_result->found_old_mergeinfo,
+                      context->notify_func ? record_notification : NULL,
+                      dump_result, scratch_pool);
+  SVN_MUTEX__WITH_LOCK(context->mutex, release_repos(context, repos));
+  SVN_ERR(err);
+
+  *result = dump_result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Write the dump_result_t RESULT
+   of the dump_task_t in TASK_BATON to the caller's stream and send the
+   notifications that the serial dump would have sent. */
+static svn_error_t *
+output_dump_task(void *result,
+                 void *task_baton,
+                 apr_pool_t *scratch_pool)
+{
+  dump_task_t *task = task_baton;
+  dump_context_t *context = task->context;
+  dump_result_t *dump_result = result;
+  int i;
+
+  while (TRUE)
+    {
+      const char *data;
+      apr_size_t len;
+
+      SVN_ERR(svn_spillbuf__read(&data, &len, dump_result->buffer,
+                                 scratch_pool));
+      if (data == NULL)
+        break;
+
+      SVN_ERR(svn_stream_write(context->stream, data, &len));
+    }
+
+  if (dump_result->found_old_reference)
+    *context->found_old_reference = TRUE;
+  if (dump_result->found_old_mergeinfo)
+    *context->found_old_mergeinfo = TRUE;
+
+  if (context->notify_func)
+    {
+      for (i = 0; i < dump_result->notifications->nelts; ++i)
+        context->notify_func(context->notify_baton,
+                             APR_ARRAY_IDX(dump_result->notifications, i,
+                                           svn_repos_notify_t *),
+                             scratch_pool);
+
+      context->rev_end_notify->revision = task->revision;
+      context->notify_func(context->notify_baton, context->rev_end_notify,
+                           scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Open a separate handle to REPOS for each of the THREAD_COUNT workers
+   and add them to CONTEXT->IDLE_REPOS.  Each handle gets allocated in
+   its own root pool, which will be listed in *HANDLE_POOLS.  Allocate
+   that list in RESULT_POOL.
+ */
+static svn_error_t *
+open_worker_repos(apr_array_header_t **handle_pools,
+                  dump_context_t *context,
+                  svn_repos_t *repos,
+                  int thread_count,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_t *fs_config = svn_fs_config(repos->fs, scratch_pool);
+  int i;
+
+  *handle_pools = apr_array_make(result_pool, thread_count,
+                                 sizeof(apr_pool_t *));
+  for (i = 0; i < thread_count; ++i)
+    {
+      /* Handles will be used from different threads. */
+      apr_pool_t *handle_pool = svn_pool_create(NULL);
+      svn_repos_t *handle = apr_pmemdup(handle_pool, repos, sizeof(*repos));
+
+      APR_ARRAY_PUSH(*handle_pools, apr_pool_t *) = handle_pool;
+      handle->pool = handle_pool;
+      handle->repository_capabilities = apr_hash_make(handle_pool);
+      SVN_ERR(svn_fs_open2(&handle->fs, repos->db_path, fs_config,
+                           handle_pool, scratch_pool));
+
+      APR_ARRAY_PUSH(context->idle_repos, svn_repos_t *) = handle;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump revisions PARAMS->START_REV to END_REV in REPOS to STREAM using
+   up to THREAD_COUNT threads, otherwise like svn_repos_dump_fs5().  Set
+   *HANDLED to FALSE and do nothing if no threads are available.  Use
+   SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+dump_revisions_concurrently(svn_boolean_t *handled,
+                            svn_repos_t *repos,
+                            svn_stream_t *stream,
+                            svn_revnum_t end_rev,
+                            const dump_params_t *params,
+                            int thread_count,
+                            svn_boolean_t *found_old_reference,
+                            svn_boolean_t *found_old_mergeinfo,
+                            svn_repos_notify_func_t notify_func,
+                            void *notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *queue_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool;
+  apr_array_header_t *handle_pools = NULL;
+  dump_context_t *context;
+  svn_task__queue_t *queue;
+  svn_revnum_t rev;
+  svn_error_t *err;
+  int i;
+
+  /* The queue may decide to run tasks synchronously. */
+  SVN_ERR(svn_task__queue_create(&queue, thread_count, 0, queue_pool));
+  thread_count = svn_task__queue_thread_count(queue);
+  if (thread_count == 0)
+    {
+      *handled = FALSE;
+      svn_pool_destroy(queue_pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  *handled = TRUE;
+  iterpool = svn_pool_create(scratch_pool);
+
+  context = apr_pcalloc(scratch_pool, sizeof(*context));
+  context->params = params;
+  context->stream = stream;
+  context->notify_func = notify_func;
+  context->notify_baton = notify_baton;
+  context->found_old_reference = found_old_reference;
+  context->found_old_mergeinfo = found_old_mergeinfo;
+  context->idle_repos = apr_array_make(scratch_pool, thread_count,
+                                       sizeof(svn_repos_t *));
+  if (notify_func)
+    context->rev_end_notify
+      = svn_repos_notify_create(svn_repos_notify_dump_rev_end, scratch_pool);
+
+  err = svn_mutex__init(&context->mutex, TRUE, scratch_pool);
+  if (!err)
+    err = open_worker_repos(&handle_pools, context, repos, thread_count,
+                            scratch_pool, scratch_pool);
+
+  for (rev = params->start_rev; !err && rev <= end_rev; rev++)
+    {
+      apr_pool_t *task_pool;
+      dump_task_t *task;
+
+      svn_pool_clear(iterpool);
+
+      /* Check for cancellation.  Our workers don't do that. */
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      /* The task pool must be usable from the worker threads. */
+      task_pool = svn_pool_create(NULL);
+      task = apr_pcalloc(task_pool, sizeof(*task));
+      task->context = context;
+      task->revision = rev;
+
+      err = svn_task__queue_add(queue, process_dump_task, output_dump_task,
+                                task, task_pool, iterpool);
+    }
+
+  if (!err)
+    err = svn_task__queue_drain(queue, iterpool);
+
+  /* Wait for all workers to finish before closing their handles. */
+  svn_pool_destroy(queue_pool);
+  for (i = 0; handle_pools && i < handle_pools->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(handle_pools, i, apr_pool_t *));
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+
 /* The main dumper. */
 svn_error_t *
-svn_repos_dump_fs4(svn_repos_t *repos,
+svn_repos_dump_fs5(svn_repos_t *repos,
                    svn_stream_t *stream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -1988,6 +2404,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_boolean_t use_deltas,
                    svn_boolean_t include_revprops,
                    svn_boolean_t include_changes,
+                   int thread_count,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_repos_dump_filter_func_t filter_func,
@@ -1996,8 +2413,6 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
@@ -2006,8 +2421,9 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   int version;
   svn_boolean_t found_old_reference = FALSE;
   svn_boolean_t found_old_mergeinfo = FALSE;
+  svn_boolean_t handled = FALSE;
   svn_repos_notify_t *notify;
-  svn_repos_authz_func_t authz_func;
+  dump_params_t params = {0};
   dump_filter_baton_t authz_baton = {0};
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
@@ -2037,19 +2453,22 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                                "(youngest revision is %ld)"),
                              end_rev, youngest);
 
+  params.start_rev = start_rev;
+  params.incremental = incremental;
+  params.use_deltas = use_deltas;
+  params.include_revprops = include_revprops;
+  params.include_changes = include_changes;
+
   /* We use read authz callback to implement dump filtering. If there is no
    * read access for some node, it will be excluded from dump as well as
    * references to it (e.g. copy source). */
   if (filter_func)
     {
-      authz_func = dump_filter_authz_func;
+      params.authz_func = dump_filter_authz_func;
+      params.authz_baton = &authz_baton;
       authz_baton.filter_func = filter_func;
       authz_baton.filter_baton = filter_baton;
     }
-  else
-    {
-      authz_func = NULL;
-    }
 
   /* Write out the UUID. */
   SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
@@ -2068,78 +2487,34 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   SVN_ERR(svn_stream_printf(stream, pool, SVN_REPOS_DUMPFILE_UUID
                             ": %s\n\n", uuid));
 
+  /* A single revision gains nothing from extra threads. */
+  if (thread_count > 1 && start_rev < end_rev)
+    SVN_ERR(dump_revisions_concurrently(&handled, repos, stream, end_rev,
+                                        &params, thread_count,
+                                        &found_old_reference,
+                                        &found_old_mergeinfo,
+                                        notify_func, notify_baton,
+                                        cancel_func, cancel_baton,
+                                        pool));
+
   /* Create a notify object that we can reuse in the loop. */
   if (notify_func)
     notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
                                      pool);
 
   /* Main loop:  we're going to dump revision REV.  */
-  for (rev = start_rev; rev <= end_rev; rev++)
+  for (rev = start_rev; !handled && rev <= end_rev; rev++)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
       svn_pool_clear(iterpool);
 
       /* Check for cancellation. */
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
-                                    authz_func, &authz_baton, iterpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       authz_func, &authz_baton,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    authz_func, &authz_baton, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
+      SVN_ERR(dump_revision(stream, repos, rev, &params,
+                            &found_old_reference, &found_old_mergeinfo,
+                            notify_func, notify_baton, iterpool));
 
-    loop_end:
       if (notify_func)
         {
           notify->revision = rev;
@@ -2419,12 +2794,168 @@ report_error(svn_revnum_t revision,
     }
 }
 
+/* Name of the verification ledger file within the repository's db
+ * directory.  It lists the revisions that passed a full verification
+ * together with a fingerprint of their state at that time:
+ *
+ *   <UUID of the filesystem>
+ *   <revision> <fingerprint>
+ *   ...
+ *
+ * Revisions are immutable apart from their revprops, so a revision whose
+ * fingerprint did not change need not be verified again.
+ */
+#define VERIFY_LEDGER "verified-revs"
+
+/* Set *FINGERPRINT to a string identifying the current state of revision
+ * REV in FS, i.e. its root node ID and its revision properties.  Allocate
+ * it in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+get_rev_fingerprint(const char **fingerprint,
+                    svn_fs_t *fs,
+                    svn_revnum_t rev,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  const svn_fs_id_t *id;
+  const svn_string_t *id_str;
+  apr_hash_t *props;
+  apr_array_header_t *sorted;
+  svn_checksum_ctx_t *ctx;
+  svn_checksum_t *checksum;
+  int i;
+
+  ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, scratch_pool));
+  SVN_ERR(svn_fs_node_id(&id, root, "/", scratch_pool));
+  id_str = svn_fs_unparse_id(id, scratch_pool);
+  SVN_ERR(svn_checksum_update(ctx, id_str->data, id_str->len + 1));
+
+  SVN_ERR(svn_fs_revision_proplist2(&props, fs, rev, FALSE, scratch_pool,
+                                    scratch_pool));
+  sorted = svn_sort__hash(props, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const svn_string_t *value = item->value;
+      const char *header = apr_psprintf(scratch_pool,
+                                        "%s %" APR_SIZE_T_FMT "\n",
+                                        (const char *)item->key, value->len);
+
+      SVN_ERR(svn_checksum_update(ctx, header, strlen(header)));
+      SVN_ERR(svn_checksum_update(ctx, value->data, value->len));
+    }
+
+  SVN_ERR(svn_checksum_final(&checksum, ctx, scratch_pool));
+  *fingerprint = svn_checksum_to_cstring_display(checksum, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the verification ledger at PATH for FS and return it in *LEDGER,
+ * mapping svn_revnum_t to the (const char *) fingerprint of the revision.
+ * A missing, malformed or foreign ledger results in an empty *LEDGER.
+ * Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+read_verify_ledger(apr_hash_t **ledger,
+                   svn_fs_t *fs,
+                   const char *path,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  const char *uuid;
+  svn_error_t *err;
+  int i;
+
+  *ledger = apr_hash_make(result_pool);
+
+  err = svn_stringbuf_from_file2(&contents, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
+  lines = svn_cstring_split(contents->data, "\n", TRUE, scratch_pool);
+  if (lines->nelts == 0
+      || strcmp(APR_ARRAY_IDX(lines, 0, const char *), uuid) != 0)
+    return SVN_NO_ERROR;
+
+  for (i = 1; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      svn_revnum_t *rev = apr_palloc(result_pool, sizeof(*rev));
+      const char *end;
+
+      err = svn_revnum_parse(rev, line, &end);
+      if (err || *end != ' ')
+        {
+          /* Don't trust any of it. */
+          svn_error_clear(err);
+          *ledger = apr_hash_make(result_pool);
+          return SVN_NO_ERROR;
+        }
+
+      apr_hash_set(*ledger, rev, sizeof(*rev),
+                   apr_pstrdup(result_pool, end + 1));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write LEDGER for FS, as returned by read_verify_ledger(), to PATH.
+ * YOUNGEST is the youngest revision in FS.
+ */
+static svn_error_t *
+write_verify_ledger(apr_hash_t *ledger,
+                    svn_fs_t *fs,
+                    svn_revnum_t youngest,
+                    const char *path,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(scratch_pool);
+  const char *uuid;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
+  svn_stringbuf_appendcstr(contents, uuid);
+  svn_stringbuf_appendbyte(contents, '\n');
+
+  for (rev = 0; rev <= youngest; ++rev)
+    {
+      const char *fingerprint = apr_hash_get(ledger, &rev, sizeof(rev));
+      if (fingerprint)
+        {
+          char buffer[SVN_INT64_BUFFER_SIZE];
+          svn_stringbuf_appendbytes(contents, buffer,
+                                    svn__i64toa(buffer, rev));
+          svn_stringbuf_appendbyte(contents, ' ');
+          svn_stringbuf_appendcstr(contents, fingerprint);
+          svn_stringbuf_appendbyte(contents, '\n');
+        }
+    }
+
+  return svn_error_trace(svn_io_write_atomic2(path, contents->data,
+                                              contents->len, NULL, TRUE,
+                                              scratch_pool));
+}
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     svn_boolean_t since_last_verify,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2440,7 +2971,13 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   svn_repos_notify_t *notify;
   svn_fs_progress_notify_func_t verify_notify = NULL;
   struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
-  svn_error_t *err;
+  svn_revnum_t verify_start_rev = start_rev;
+  const char *ledger_path = NULL;
+  apr_hash_t *ledger = NULL;
+  const char **fingerprints = NULL;
+  svn_boolean_t ledger_changed = FALSE;
+  svn_boolean_t metadata_ok = TRUE;
+  svn_error_t *err = SVN_NO_ERROR;
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
    * time we will refresh the revprop data in this query. */
@@ -2481,11 +3018,46 @@ svn_repos_verify_fs3(svn_repos_t *repos,
         = svn_repos_notify_create(svn_repos_notify_verify_rev_structure, pool);
     }
 
+  /* Find the revisions that changed since they were last verified.
+     If we can't determine a fingerprint, verify the revision to find
+     out why. */
+  if (since_last_verify)
+    {
+      ledger_path = svn_dirent_join(repos->db_path, VERIFY_LEDGER, pool);
+      SVN_ERR(read_verify_ledger(&ledger, fs, ledger_path, pool, iterpool));
+
+      fingerprints = apr_pcalloc(pool, (end_rev - start_rev + 1)
+                                       * sizeof(*fingerprints));
+      verify_start_rev = SVN_INVALID_REVNUM;
+      for (rev = start_rev; rev <= end_rev; rev++)
+        {
+          const char **fingerprint = &fingerprints[rev - start_rev];
+          const char *verified = apr_hash_get(ledger, &rev, sizeof(rev));
+
+          svn_pool_clear(iterpool);
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          err = get_rev_fingerprint(fingerprint, fs, rev, pool, iterpool);
+          if (err && err->apr_err == SVN_ERR_CANCELLED)
+            return svn_error_trace(err);
+          svn_error_clear(err);
+
+          if (!SVN_IS_VALID_REVNUM(verify_start_rev)
+              && (!verified || !*fingerprint
+                  || strcmp(verified, *fingerprint) != 0))
+            verify_start_rev = rev;
+        }
+
+      err = SVN_NO_ERROR;
+    }
+
   /* Verify global metadata and backend-specific data first. */
-  err = svn_fs_verify(svn_fs_path(fs, pool), svn_fs_config(fs, pool),
-                      start_rev, end_rev,
-                      verify_notify, verify_notify_baton,
-                      cancel_func, cancel_baton, pool);
+  if (SVN_IS_VALID_REVNUM(verify_start_rev))
+    err = svn_fs_verify(svn_fs_path(fs, pool), svn_fs_config(fs, pool),
+                        verify_start_rev, end_rev,
+                        verify_notify, verify_notify_baton,
+                        cancel_func, cancel_baton, pool);
 
   if (err && err->apr_err == SVN_ERR_CANCELLED)
     {
@@ -2493,6 +3065,7 @@ svn_repos_verify_fs3(svn_repos_t *repos,
     }
   else if (err)
     {
+      metadata_ok = FALSE;
       SVN_ERR(report_error(SVN_INVALID_REVNUM, err, verify_callback,
                            verify_baton, iterpool));
     }
@@ -2500,8 +3073,33 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   if (!metadata_only)
     for (rev = start_rev; rev <= end_rev; rev++)
       {
+        const char *fingerprint = NULL;
+
         svn_pool_clear(iterpool);
 
+        /* Skip revisions that have not changed since their last
+           successful verification. */
+        if (since_last_verify)
+          {
+            const char *verified = apr_hash_get(ledger, &rev, sizeof(rev));
+
+            fingerprint = fingerprints[rev - start_rev];
+            if (verified && fingerprint && strcmp(verified, fingerprint) == 0)
+              {
+                if (notify_func)
+                  {
+                    svn_repos_notify_t *skipped
+                      = svn_repos_notify_create(
+                                          svn_repos_notify_verify_rev_skipped,
+                                          iterpool);
+                    skipped->revision = rev;
+                    notify_func(notify_baton, skipped, iterpool);
+                  }
+
+                continue;
+              }
+          }
+
         /* Wrapper function to catch the possible errors. */
         err = verify_one_revision(fs, rev, notify_func, notify_baton,
                                   start_rev, check_normalization,
@@ -2517,14 +3115,28 @@ svn_repos_verify_fs3(svn_repos_t *repos,
             SVN_ERR(report_error(rev, err, verify_callback, verify_baton,
                                  iterpool));
           }
-        else if (notify_func)
+        else
           {
+            /* Remember that this revision is fine. */
+            if (fingerprint && metadata_ok)
+              {
+                svn_revnum_t *key = apr_pmemdup(pool, &rev, sizeof(rev));
+                apr_hash_set(ledger, key, sizeof(*key), fingerprint);
+                ledger_changed = TRUE;
+              }
+
             /* Tell the caller that we're done with this revision. */
-            notify->revision = rev;
-            notify_func(notify_baton, notify, iterpool);
+            if (notify_func)
+              {
+                notify->revision = rev;
+                notify_func(notify_baton, notify, iterpool);
+              }
           }
       }
 
+  if (ledger_changed)
+    SVN_ERR(write_verify_ledger(ledger, fs, youngest, ledger_path, iterpool));
+
   /* We're done. */
   if (notify_func)
     {
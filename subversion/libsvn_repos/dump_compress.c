@@ -0,0 +1,638 @@
+/*
+ * dump_compress.c: block-compressed container for dump streams
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_repos.h"
+#include "svn_string.h"
+#include "svn_sorts.h"
+
+#include "private/svn_repos_private.h"
+#include "private/svn_io_private.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+
+#include "repos.h"
+#include "svn_private_config.h"
+
+/* A block-compressed dump stream consists of the SVN_REPOS__DUMP_BLOCKS_MAGIC
+ * line followed by a sequence of blocks, each containing a part of the
+ * plain dump stream:
+ *
+ *   SIZE        size of the compressed data
+ *   FIRST_REV   1 + revision of the first revision record starting in
+ *               the block; 0 if there is none
+ *   FIRST_POS   offset of that record within the uncompressed data
+ *   LAST_REV    1 + revision of the last revision record starting in
+ *               the block; 0 if there is none
+ *   CHECKSUM    FNV-1a checksum of the uncompressed data, 4 bytes
+ *               big-endian
+ *   DATA        SIZE bytes of LZ4 compressed data
+ *
+ * All numbers but the checksum are encoded with svn__encode_uint.  A block
+ * with SIZE 0 and no further fields terminates the stream.
+ *
+ * Blocks are independent of each other.  The writer starts a new block
+ * at the next revision record once the current one is BLOCK_SIZE large,
+ * so most blocks start with a revision record.  Very large records get
+ * split into blocks of up to MAX_BLOCK_SIZE bytes.  The revision numbers
+ * in the block headers allow readers to skip whole blocks when they are
+ * only interested in later revisions.
+ */
+
+/* Start a new block at the next revision record beyond this size. */
+#define BLOCK_SIZE 0x100000
+
+/* Never let blocks grow beyond this size. */
+#define MAX_BLOCK_SIZE 0x400000
+
+/* Maximum length of a block header. */
+#define MAX_HEADER_SIZE (4 * SVN__MAX_ENCODED_UINT_LEN + 4)
+
+/* Maximum size of the compressed data of a block, i.e. the LZ4 bound
+ * LZ4_COMPRESSBOUND(MAX_BLOCK_SIZE) plus the length prefix that
+ * svn__compress_lz4() adds. */
+#define MAX_COMPRESSED_SIZE \
+  (MAX_BLOCK_SIZE + MAX_BLOCK_SIZE / 255 + 16 + SVN__MAX_ENCODED_UINT_LEN)
+
+/* Callers usually wrap our streams in svn_stream__create_async_writer()
+ * or svn_stream__create_read_ahead(), i.e. the block processing runs in
+ * a separate thread while the pools of the stream may be used by the
+ * caller's thread at the same time.  Therefore, all buffers are allocated
+ * at their maximum size when the stream gets created and never grow. */
+
+
+/*** Writing ***/
+
+typedef struct compress_baton_t
+{
+  /* Stream to write the compressed data to. */
+  svn_stream_t *target;
+
+  /* Uncompressed data of the current block.  Has a fixed capacity of
+     MAX_BLOCK_SIZE. */
+  svn_stringbuf_t *block;
+
+  /* Compressed data buffer, reused for every block.  Has a fixed capacity
+     of MAX_COMPRESSED_SIZE. */
+  svn_stringbuf_t *compressed;
+
+  /* First and last revision record starting in BLOCK and offset of the
+     first one.  SVN_INVALID_REVNUM if there is none. */
+  svn_revnum_t first_rev;
+  apr_size_t first_pos;
+  svn_revnum_t last_rev;
+
+  /* Whether we have seen any revision record at all. */
+  svn_boolean_t seen_revision;
+
+  /* Offset in BLOCK of the header line currently being written. */
+  apr_size_t line_start;
+
+  /* Whether we are within the header section of a record. */
+  svn_boolean_t in_record;
+
+  /* Content lengths given in the headers of the current record. */
+  svn_filesize_t content_length;
+  svn_filesize_t prop_content_length;
+  svn_filesize_t text_content_length;
+
+  /* Bytes of record content that have still to come. */
+  svn_filesize_t content_left;
+} compress_baton_t;
+
+/* Write the first LEN bytes of the current block in BATON to the target
+ * stream and keep the remainder as the start of the next block.
+ */
+static svn_error_t *
+flush_block(compress_baton_t *baton,
+            apr_size_t len)
+{
+  svn_stringbuf_t *block = baton->block;
+  unsigned char header[MAX_HEADER_SIZE];
+  unsigned char *p;
+  apr_size_t header_len;
+  apr_uint32_t checksum;
+
+  if (len == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn__compress_lz4(block->data, len, baton->compressed));
+  checksum = svn__fnv1a_32(block->data, len);
+
+  p = svn__encode_uint(header, baton->compressed->len);
+  p = svn__encode_uint(p, SVN_IS_VALID_REVNUM(baton->first_rev)
+                            ? baton->first_rev + 1 : 0);
+  p = svn__encode_uint(p, SVN_IS_VALID_REVNUM(baton->first_rev)
+                            ? baton->first_pos : 0);
+  p = svn__encode_uint(p, SVN_IS_VALID_REVNUM(baton->last_rev)
+                            ? baton->last_rev + 1 : 0);
+  *p++ = (unsigned char)(checksum >> 24);
+  *p++ = (unsigned char)(checksum >> 16);
+  *p++ = (unsigned char)(checksum >> 8);
+  *p++ = (unsigned char)checksum;
+
+  header_len = p - header;
+  SVN_ERR(svn_stream_write(baton->target, (const char *)header,
+                           &header_len));
+  SVN_ERR(svn_stream_write(baton->target, baton->compressed->data,
+                           &baton->compressed->len));
+
+  /* Move the remainder to the front. */
+  memmove(block->data, block->data + len, block->len - len);
+  block->len -= len;
+  block->data[block->len] = '\0';
+
+  baton->first_rev = SVN_INVALID_REVNUM;
+  baton->first_pos = 0;
+  baton->last_rev = SVN_INVALID_REVNUM;
+  baton->line_start -= MIN(baton->line_start, len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the number after the header NAME in LINE of length LEN.  Return
+ * TRUE and set *VALUE if LINE is that header.
+ */
+static svn_boolean_t
+parse_header(svn_filesize_t *value,
+             const char *line,
+             apr_size_t len,
+             const char *name)
+{
+  apr_size_t name_len = strlen(name);
+  apr_size_t i;
+  svn_filesize_t number = 0;
+
+  if (len <= name_len + 2
+      || memcmp(line, name, name_len) != 0
+      || line[name_len] != ':'
+      || line[name_len + 1] != ' ')
+    return FALSE;
+
+  for (i = name_len + 2; i < len; ++i)
+    {
+      if (line[i] < '0' || line[i] > '9' || number > APR_INT64_MAX / 10 - 1)
+        return FALSE;
+
+      number = number * 10 + (line[i] - '0');
+    }
+
+  *value = number;
+  return TRUE;
+}
+
+/* The header line in BATON's current block from LINE_START to the end
+ * of the block has been completed.  Track the record structure and start
+ * a new block, if appropriate.
+ */
+static svn_error_t *
+header_line_done(compress_baton_t *baton)
+{
+  svn_stringbuf_t *block = baton->block;
+  const char *line = block->data + baton->line_start;
+  apr_size_t len = block->len - baton->line_start - 1;
+  svn_filesize_t value;
+
+  if (len == 0)
+    {
+      /* A blank line terminates the headers of a record. */
+      if (baton->in_record)
+        {
+          baton->in_record = FALSE;
+          baton->content_left = baton->content_length
+                              ? baton->content_length
+                              : baton->prop_content_length
+                                + baton->text_content_length;
+        }
+    }
+  else
+    {
+      if (!baton->in_record)
+        {
+          baton->in_record = TRUE;
+          baton->content_length = 0;
+          baton->prop_content_length = 0;
+          baton->text_content_length = 0;
+
+          if (parse_header(&value, line, len,
+                           SVN_REPOS_DUMPFILE_REVISION_NUMBER))
+            {
+              /* Let the preamble and large sections of the stream have
+                 blocks of their own. */
+              if (!baton->seen_revision || baton->line_start >= BLOCK_SIZE)
+                SVN_ERR(flush_block(baton, baton->line_start));
+
+              if (!SVN_IS_VALID_REVNUM(baton->first_rev))
+                {
+                  baton->first_rev = (svn_revnum_t)value;
+                  baton->first_pos = baton->line_start;
+                }
+
+              baton->last_rev = (svn_revnum_t)value;
+              baton->seen_revision = TRUE;
+            }
+        }
+      else if (parse_header(&value, line, len,
+                            SVN_REPOS_DUMPFILE_CONTENT_LENGTH))
+        baton->content_length = value;
+      else if (parse_header(&value, line, len,
+                            SVN_REPOS_DUMPFILE_PROP_CONTENT_LENGTH))
+        baton->prop_content_length = value;
+      else if (parse_header(&value, line, len,
+                            SVN_REPOS_DUMPFILE_TEXT_CONTENT_LENGTH))
+        baton->text_content_length = value;
+    }
+
+  baton->line_start = block->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Append LEN bytes at DATA to BLOCK.  BLOCK must have room for them
+ * within its pre-allocated capacity, i.e. this never allocates memory.
+ */
+static void
+append_to_block(svn_stringbuf_t *block,
+                const char *data,
+                apr_size_t len)
+{
+  SVN_ERR_ASSERT_NO_RETURN(block->len + len < block->blocksize);
+
+  memcpy(block->data + block->len, data, len);
+  block->len += len;
+  block->data[block->len] = '\0';
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+compress_write(void *baton,
+               const char *data,
+               apr_size_t *len)
+{
+  compress_baton_t *btn = baton;
+  svn_stringbuf_t *block = btn->block;
+  apr_size_t remaining = *len;
+
+  while (remaining)
+    {
+      apr_size_t to_copy;
+
+      /* Make room in full blocks.  Within headers, keep the current line
+         together. */
+      if (block->len == MAX_BLOCK_SIZE)
+        {
+          if (btn->content_left)
+            SVN_ERR(flush_block(btn, block->len));
+          else if (btn->line_start)
+            SVN_ERR(flush_block(btn, btn->line_start));
+          else
+            return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                    _("Dump stream header line too long"));
+        }
+
+      to_copy = MIN(remaining, MAX_BLOCK_SIZE - block->len);
+      if (btn->content_left)
+        {
+          /* Record content goes into the block as is. */
+          to_copy = (apr_size_t)MIN(to_copy, btn->content_left);
+          append_to_block(block, data, to_copy);
+          btn->content_left -= to_copy;
+          btn->line_start = block->len;
+        }
+      else
+        {
+          /* Header lines. */
+          const char *eol = memchr(data, '\n', to_copy);
+          if (eol)
+            to_copy = eol - data + 1;
+
+          append_to_block(block, data, to_copy);
+          if (eol)
+            SVN_ERR(header_line_done(btn));
+        }
+
+      data += to_copy;
+      remaining -= to_copy;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t. */
+static svn_error_t *
+compress_close(void *baton)
+{
+  compress_baton_t *btn = baton;
+  apr_size_t len = 1;
+
+  SVN_ERR(flush_block(btn, btn->block->len));
+  SVN_ERR(svn_stream_write(btn->target, "\0", &len));
+
+  return svn_error_trace(svn_stream_close(btn->target));
+}
+
+svn_error_t *
+svn_repos__dump_compress(svn_stream_t **stream,
+                         svn_stream_t *target,
+                         apr_pool_t *result_pool)
+{
+  compress_baton_t *baton = apr_pcalloc(result_pool, sizeof(*baton));
+
+  baton->target = target;
+  baton->block = svn_stringbuf_create_ensure(MAX_BLOCK_SIZE, result_pool);
+  baton->compressed = svn_stringbuf_create_ensure(MAX_COMPRESSED_SIZE,
+                                                  result_pool);
+  baton->first_rev = SVN_INVALID_REVNUM;
+  baton->last_rev = SVN_INVALID_REVNUM;
+
+  SVN_ERR(svn_stream_printf(target, result_pool, "%s\n",
+                            SVN_REPOS__DUMP_BLOCKS_MAGIC));
+
+  *stream = svn_stream_create(baton, result_pool);
+  svn_stream_set_write(*stream, compress_write);
+  svn_stream_set_close(*stream, compress_close);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Reading ***/
+
+typedef struct decompress_baton_t
+{
+  /* Stream to read the compressed data from. */
+  svn_stream_t *source;
+
+  /* Skip blocks that contain only revisions older than this, if valid. */
+  svn_revnum_t start_rev;
+
+  /* Whether we skipped the previous block. */
+  svn_boolean_t skipping;
+
+  /* Number of blocks processed so far. */
+  apr_uint64_t block_count;
+
+  /* Compressed data buffer, reused for every block.  Has a fixed capacity
+     of MAX_COMPRESSED_SIZE. */
+  svn_stringbuf_t *compressed;
+
+  /* Uncompressed data of the current block and read position within it.
+     BLOCK has a fixed capacity of MAX_BLOCK_SIZE. */
+  svn_stringbuf_t *block;
+  apr_size_t pos;
+
+  /* Whether we have read the terminating block. */
+  svn_boolean_t eof;
+} decompress_baton_t;
+
+/* Error to return for streams that end before the terminating block. */
+static svn_error_t *
+compressed_stream_ran_dry(void)
+{
+  return svn_error_create(SVN_ERR_INCOMPLETE_DATA, NULL,
+                          _("Premature end of compressed dumpstream"));
+}
+
+/* Read the next encoded unsigned number from SOURCE into *VALUE. */
+static svn_error_t *
+read_uint(apr_uint64_t *value,
+          svn_stream_t *source)
+{
+  unsigned char buffer[SVN__MAX_ENCODED_UINT_LEN];
+  apr_size_t i;
+
+  for (i = 0; i < sizeof(buffer); ++i)
+    {
+      apr_size_t len = 1;
+      SVN_ERR(svn_stream_read_full(source, (char *)&buffer[i], &len));
+      if (len == 0)
+        return compressed_stream_ran_dry();
+
+      if (buffer[i] < 0x80)
+        {
+          svn__decode_uint(value, buffer, buffer + i + 1);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                          _("Invalid block header in compressed dumpstream"));
+}
+
+/* Make the next relevant block of BATON's source the current one.
+ * Set BATON->EOF if there is none.
+ */
+static svn_error_t *
+next_block(decompress_baton_t *baton)
+{
+  while (TRUE)
+    {
+      apr_uint64_t size, first_rev, first_pos, last_rev;
+      unsigned char digest[4];
+      apr_uint32_t checksum;
+      apr_size_t len;
+
+      SVN_ERR(read_uint(&size, baton->source));
+      if (size == 0)
+        {
+          baton->eof = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(read_uint(&first_rev, baton->source));
+      SVN_ERR(read_uint(&first_pos, baton->source));
+      SVN_ERR(read_uint(&last_rev, baton->source));
+
+      len = sizeof(digest);
+      SVN_ERR(svn_stream_read_full(baton->source, (char *)digest, &len));
+      if (len != sizeof(digest))
+        return compressed_stream_ran_dry();
+
+      if (size > MAX_COMPRESSED_SIZE)
+        return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                _("Invalid block header in compressed "
+                                  "dumpstream"));
+
+      /* Skip blocks that contain only revisions older than START_REV.
+         Never skip the first block as it contains the stream headers. */
+      if (SVN_IS_VALID_REVNUM(baton->start_rev)
+          && baton->block_count > 0
+          && (last_rev ? last_rev - 1 < (apr_uint64_t)baton->start_rev
+                       : baton->skipping))
+        {
+          SVN_ERR(svn_stream_skip(baton->source, (apr_size_t)size));
+          baton->skipping = TRUE;
+          baton->block_count++;
+          continue;
+        }
+
+      len = (apr_size_t)size;
+      SVN_ERR(svn_stream_read_full(baton->source, baton->compressed->data,
+                                   &len));
+      if (len != size)
+        return compressed_stream_ran_dry();
+
+      SVN_ERR(svn__decompress_lz4(baton->compressed->data, len, baton->block,
+                                  MAX_BLOCK_SIZE));
+
+      checksum = ((apr_uint32_t)digest[0] << 24)
+               | ((apr_uint32_t)digest[1] << 16)
+               | ((apr_uint32_t)digest[2] << 8)
+               | (apr_uint32_t)digest[3];
+      if (checksum != svn__fnv1a_32(baton->block->data, baton->block->len))
+        {
+          /* Don't allocate from our pools here; see top of file. */
+          char number[SVN_INT64_BUFFER_SIZE];
+          svn__ui64toa(number, baton->block_count);
+
+          return svn_error_createf(SVN_ERR_CHECKSUM_MISMATCH, NULL,
+                                   _("Checksum mismatch in block %s of "
+                                     "compressed dumpstream"),
+                                   number);
+        }
+
+      /* After skipping, continue with the first complete record. */
+      baton->pos = 0;
+      if (baton->skipping)
+        {
+          if (!first_rev || first_pos > baton->block->len)
+            return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                    _("Invalid block header in compressed "
+                                      "dumpstream"));
+
+          baton->pos = (apr_size_t)first_pos;
+          baton->skipping = FALSE;
+        }
+
+      baton->block_count++;
+      if (baton->pos < baton->block->len)
+        return SVN_NO_ERROR;
+    }
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+decompress_read(void *baton,
+                char *buffer,
+                apr_size_t *len)
+{
+  decompress_baton_t *btn = baton;
+  apr_size_t total = 0;
+
+  while (total < *len)
+    {
+      apr_size_t to_copy;
+
+      if (btn->pos == btn->block->len)
+        {
+          if (!btn->eof)
+            SVN_ERR(next_block(btn));
+          if (btn->eof)
+            break;
+        }
+
+      to_copy = MIN(*len - total, btn->block->len - btn->pos);
+      memcpy(buffer + total, btn->block->data + btn->pos, to_copy);
+      btn->pos += to_copy;
+      total += to_copy;
+    }
+
+  *len = total;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_readline_fn_t.  Same semantics as the default
+   implementation, but scan the uncompressed block directly.  */
+static svn_error_t *
+decompress_readline(void *baton,
+                    svn_stringbuf_t **stringbuf,
+                    const char *eol,
+                    svn_boolean_t *eof,
+                    apr_pool_t *pool)
+{
+  decompress_baton_t *btn = baton;
+  svn_stringbuf_t *str = svn_stringbuf_create_ensure(SVN__LINE_CHUNK_SIZE,
+                                                     pool);
+  const char *match = eol;
+
+  while (*match)
+    {
+      const char *data = btn->block->data;
+      apr_size_t start = btn->pos;
+      apr_size_t end = btn->block->len;
+
+      if (start == end)
+        {
+          if (!btn->eof)
+            SVN_ERR(next_block(btn));
+          if (btn->eof)
+            {
+              *eof = TRUE;
+              *stringbuf = str;
+              return SVN_NO_ERROR;
+            }
+
+          continue;
+        }
+
+      for (; btn->pos < end && *match; ++btn->pos)
+        {
+          if (data[btn->pos] == *match)
+            match++;
+          else
+            match = eol;
+        }
+
+      svn_stringbuf_appendbytes(str, data + start, btn->pos - start);
+    }
+
+  *eof = FALSE;
+  svn_stringbuf_chop(str, match - eol);
+  *stringbuf = str;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__dump_decompress(svn_stream_t **stream,
+                           svn_stream_t *source,
+                           svn_revnum_t start_rev,
+                           apr_pool_t *result_pool)
+{
+  decompress_baton_t *baton = apr_pcalloc(result_pool, sizeof(*baton));
+
+  baton->source = source;
+  baton->start_rev = start_rev;
+  baton->compressed = svn_stringbuf_create_ensure(MAX_COMPRESSED_SIZE,
+                                                  result_pool);
+  baton->block = svn_stringbuf_create_ensure(MAX_BLOCK_SIZE, result_pool);
+
+  *stream = svn_stream_create(baton, result_pool);
+  svn_stream_set_read2(*stream, NULL /* only full read support */,
+                       decompress_read);
+  svn_stream_set_readline(*stream, decompress_readline);
+
+  return SVN_NO_ERROR;
+}
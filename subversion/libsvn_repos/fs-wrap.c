@@ -111,6 +111,9 @@ svn_repos_fs_commit_txn(const char **conflict_p,
       return err;
     }
 
+  /* Failing to update the date index only makes date lookups slower. */
+  svn_error_clear(svn_repos__date_index_update(repos, *new_rev, pool));
+
   /* Run post-commit hooks. */
   if ((err2 = svn_repos__hooks_post_commit(repos, hooks_env,
                                            *new_rev, txn_name, pool)))
@@ -439,6 +442,9 @@ svn_repos_fs_change_rev_prop4(svn_repos_t *repos,
       SVN_ERR(svn_fs_change_rev_prop2(repos->fs, rev, name,
                                       &old_value, new_value, pool));
 
+      if (strcmp(name, SVN_PROP_REVISION_DATE) == 0)
+        svn_error_clear(svn_repos__date_index_update(repos, rev, pool));
+
       if (use_post_revprop_change_hook)
         SVN_ERR(svn_repos__hooks_post_revprop_change(repos, hooks_env, rev,
                                                      author, name, old_value,
@@ -0,0 +1,867 @@
+/* hook_queue.c --- running post-commit hooks asynchronously
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_time.h>
+
+#include "svn_private_config.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_ctype.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+#include "svn_repos.h"
+#include "repos.h"
+
+#include "private/svn_io_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
+
+
+/* The hook queue lives in a directory within the repository's db
+ * directory.  Every queued event is stored in a separate file named
+ * after its decimal id, using the hash dump format.  Besides those,
+ * the directory contains the following files:
+ *
+ * HOOK_QUEUE_ENABLED is present iff the queue is enabled.  Removing it
+ * disables the queue without losing any events.
+ *
+ * HOOK_QUEUE_LOCK serializes adding events with changing the queue
+ * state, i.e. enabling or disabling it.
+ *
+ * HOOK_QUEUE_RUNNER is locked by the runner processing the queue.
+ * Since only that runner modifies pending events, it does not need to
+ * take HOOK_QUEUE_LOCK for that.
+ *
+ * HOOK_QUEUE_NEXT_ID contains the id to use for the next event.
+ */
+#define HOOK_QUEUE_DIR "hook-queue"
+#define HOOK_QUEUE_ENABLED "enabled"
+#define HOOK_QUEUE_LOCK "lock"
+#define HOOK_QUEUE_RUNNER "runner"
+#define HOOK_QUEUE_NEXT_ID "next-id"
+
+/* Failed hooks are retried after HOOK_QUEUE_RETRY_DELAY, doubling the
+ * delay with every failed attempt up to HOOK_QUEUE_MAX_RETRY_DELAY. */
+#define HOOK_QUEUE_RETRY_DELAY apr_time_from_sec(10)
+#define HOOK_QUEUE_MAX_RETRY_DELAY apr_time_from_sec(3600)
+
+/* How often a following runner checks for new events. */
+#define HOOK_QUEUE_POLL_INTERVAL apr_time_from_sec(1)
+
+/* Keys used in the event files. */
+#define EVENT_HOOK "hook"
+#define EVENT_REVISION "revision"
+#define EVENT_ARGS "args"
+#define EVENT_ARG "arg-"
+#define EVENT_STDIN "stdin"
+#define EVENT_ATTEMPTS "attempts"
+#define EVENT_NEXT_ATTEMPT "next-attempt"
+#define EVENT_ERROR "error"
+#define EVENT_FAILED "failed"
+
+/* A queued event together with everything needed to run its hook. */
+typedef struct queue_event_t
+{
+  /* Public description of the event. */
+  svn_repos_hook_event_t *event;
+
+  /* The const char * hook arguments following the repository path. */
+  apr_array_header_t *args;
+
+  /* Data to pass as the hook's stdin.  May be NULL. */
+  const svn_string_t *stdin_value;
+
+  /* Path of the event file. */
+  const char *path;
+} queue_event_t;
+
+/* Context shared by all tasks of a svn_repos_hook_queue_run() batch.
+ * The workers only read it. */
+typedef struct run_context_t
+{
+  svn_repos_t *repos;
+  apr_hash_t *hooks_env;
+  int max_attempts;
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+
+  /* Maps svn_revnum_t revisions to the svn_repos_hook_event_t that has
+   * been added to the task queue for them and not been output yet.
+   * Only accessed by the thread running the queue. */
+  apr_hash_t *in_flight;
+} run_context_t;
+
+/* A single hook to run in a worker. */
+typedef struct run_task_t
+{
+  run_context_t *context;
+  queue_event_t *queued;
+} run_task_t;
+
+/* Return the path of the hook queue directory of REPOS and, if NAME is
+ * not NULL, of the file NAME within it.  Allocate it in POOL. */
+static const char *
+queue_path(svn_repos_t *repos,
+           const char *name,
+           apr_pool_t *pool)
+{
+  const char *dir = svn_dirent_join(repos->db_path, HOOK_QUEUE_DIR, pool);
+  return name ? svn_dirent_join(dir, name, pool) : dir;
+}
+
+/* Set *ENABLED to whether the hook queue of REPOS is enabled.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+is_enabled(svn_boolean_t *enabled,
+           svn_repos_t *repos,
+           apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(queue_path(repos, HOOK_QUEUE_ENABLED,
+                                       scratch_pool),
+                            &kind, scratch_pool));
+  *enabled = (kind == svn_node_file);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a formatted error for the malformed event file at PATH. */
+static svn_error_t *
+malformed_event(const char *path,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                           _("Malformed hook queue event '%s'"),
+                           svn_dirent_local_style(path, scratch_pool));
+}
+
+/* Return the value of KEY in HASH as C string or NULL. */
+static const char *
+get_value(apr_hash_t *hash,
+          const char *key)
+{
+  svn_string_t *value = svn_hash_gets(hash, key);
+  return value ? value->data : NULL;
+}
+
+/* Read the event with the given ID from the file at PATH and return it
+ * in *QUEUED.  Set *QUEUED to NULL if the file does not exist (anymore).
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+read_event(queue_event_t **queued,
+           const char *path,
+           apr_uint64_t id,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  apr_hash_t *hash = apr_hash_make(result_pool);
+  svn_repos_hook_event_t *event;
+  queue_event_t *result;
+  const char *value;
+  apr_int64_t number;
+  int arg_count, i;
+  svn_error_t *err;
+
+  err = svn_stream_open_readonly(&stream, path, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *queued = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_hash_read2(hash, stream, SVN_HASH_TERMINATOR, result_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  event = apr_pcalloc(result_pool, sizeof(*event));
+  event->id = id;
+  event->hook = get_value(hash, EVENT_HOOK);
+  value = get_value(hash, EVENT_REVISION);
+  if (!event->hook || !value)
+    return malformed_event(path, scratch_pool);
+
+  SVN_ERR(svn_revnum_parse(&event->revision, value, NULL));
+  value = get_value(hash, EVENT_ATTEMPTS);
+  if (value)
+    SVN_ERR(svn_cstring_atoi(&event->attempts, value));
+  value = get_value(hash, EVENT_NEXT_ATTEMPT);
+  if (value)
+    {
+      SVN_ERR(svn_cstring_atoi64(&number, value));
+      event->next_attempt = (apr_time_t)number;
+    }
+  event->last_error = get_value(hash, EVENT_ERROR);
+  event->failed = svn_hash_gets(hash, EVENT_FAILED) != NULL;
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->event = event;
+  result->path = apr_pstrdup(result_pool, path);
+  result->stdin_value = svn_hash_gets(hash, EVENT_STDIN);
+
+  value = get_value(hash, EVENT_ARGS);
+  if (!value)
+    return malformed_event(path, scratch_pool);
+  SVN_ERR(svn_cstring_atoi(&arg_count, value));
+
+  result->args = apr_array_make(result_pool, arg_count, sizeof(const char *));
+  for (i = 0; i < arg_count; ++i)
+    {
+      value = get_value(hash, apr_psprintf(scratch_pool, EVENT_ARG "%d", i));
+      if (!value)
+        return malformed_event(path, scratch_pool);
+
+      APR_ARRAY_PUSH(result->args, const char *) = value;
+    }
+
+  *queued = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write QUEUED to its event file.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+write_event(const queue_event_t *queued,
+            apr_pool_t *scratch_pool)
+{
+  const svn_repos_hook_event_t *event = queued->event;
+  apr_hash_t *hash = apr_hash_make(scratch_pool);
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(buffer, scratch_pool);
+  int i;
+
+  svn_hash_sets(hash, EVENT_HOOK, svn_string_create(event->hook,
+                                                    scratch_pool));
+  svn_hash_sets(hash, EVENT_REVISION,
+                svn_string_createf(scratch_pool, "%ld", event->revision));
+  svn_hash_sets(hash, EVENT_ARGS,
+                svn_string_createf(scratch_pool, "%d", queued->args->nelts));
+  for (i = 0; i < queued->args->nelts; ++i)
+    svn_hash_sets(hash, apr_psprintf(scratch_pool, EVENT_ARG "%d", i),
+                  svn_string_create(APR_ARRAY_IDX(queued->args, i,
+                                                  const char *),
+                                    scratch_pool));
+
+  if (queued->stdin_value)
+    svn_hash_sets(hash, EVENT_STDIN, queued->stdin_value);
+
+  if (event->attempts)
+    svn_hash_sets(hash, EVENT_ATTEMPTS,
+                  svn_string_createf(scratch_pool, "%d", event->attempts));
+  if (event->next_attempt)
+    svn_hash_sets(hash, EVENT_NEXT_ATTEMPT,
+                  svn_string_createf(scratch_pool, "%" APR_TIME_T_FMT,
+                                     event->next_attempt));
+  if (event->last_error)
+    svn_hash_sets(hash, EVENT_ERROR, svn_string_create(event->last_error,
+                                                       scratch_pool));
+  if (event->failed)
+    svn_hash_sets(hash, EVENT_FAILED, svn_string_create("1", scratch_pool));
+
+  SVN_ERR(svn_hash_write2(hash, stream, SVN_HASH_TERMINATOR, scratch_pool));
+
+  return svn_error_trace(svn_io_write_atomic2(queued->path, buffer->data,
+                                              buffer->len, NULL, TRUE,
+                                              scratch_pool));
+}
+
+/* Sort callback comparing the ids of two queue_event_t *. */
+static int
+compare_events(const void *lhs,
+               const void *rhs)
+{
+  const queue_event_t *left = *(const queue_event_t * const *)lhs;
+  const queue_event_t *right = *(const queue_event_t * const *)rhs;
+
+  if (left->event->id < right->event->id)
+    return -1;
+
+  return left->event->id > right->event->id ? 1 : 0;
+}
+
+/* Set *EVENTS to the list of all queue_event_t * in the hook queue of
+ * REPOS, in the order in which they are to be run.  Allocate the result
+ * in RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_queue(apr_array_header_t **events,
+           svn_repos_t *repos,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  const char *dir = queue_path(repos, NULL, scratch_pool);
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, TRUE, scratch_pool,
+                              scratch_pool));
+
+  *events = apr_array_make(result_pool, apr_hash_count(dirents),
+                           sizeof(queue_event_t *));
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      queue_event_t *queued;
+      apr_uint64_t id;
+
+      /* Event files are the ones with numerical names. */
+      if (!svn_ctype_isdigit(*name)
+          || svn_cstring_strtoui64(&id, name, 0, APR_UINT64_MAX, 10))
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_event(&queued, svn_dirent_join(dir, name, iterpool), id,
+                         result_pool, iterpool));
+      if (queued)
+        APR_ARRAY_PUSH(*events, queue_event_t *) = queued;
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_sort__array(*events, compare_events);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ID to the id to use for the next event added to the queue of
+ * REPOS and update the queue's counter.  The caller must hold the queue
+ * lock.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+allocate_id(apr_uint64_t *id,
+            svn_repos_t *repos,
+            apr_pool_t *scratch_pool)
+{
+  const char *path = queue_path(repos, HOOK_QUEUE_NEXT_ID, scratch_pool);
+  svn_stringbuf_t *content;
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(&content, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      apr_array_header_t *events;
+
+      /* Continue behind the youngest existing event. */
+      svn_error_clear(err);
+      SVN_ERR(read_queue(&events, repos, scratch_pool, scratch_pool));
+      *id = events->nelts
+          ? APR_ARRAY_IDX(events, events->nelts - 1,
+                          queue_event_t *)->event->id + 1
+          : 1;
+    }
+  else
+    {
+      SVN_ERR(err);
+      svn_stringbuf_strip_whitespace(content);
+      SVN_ERR(svn_cstring_strtoui64(id, content->data, 1, APR_UINT64_MAX,
+                                    10));
+    }
+
+  content = svn_stringbuf_createf(scratch_pool, "%" APR_UINT64_T_FMT "\n",
+                                  *id + 1);
+  return svn_error_trace(svn_io_write_atomic2(path, content->data,
+                                              content->len, NULL, TRUE,
+                                              scratch_pool));
+}
+
+svn_error_t *
+svn_repos__hook_queue_add(svn_boolean_t *queued,
+                          svn_repos_t *repos,
+                          const char *name,
+                          svn_revnum_t rev,
+                          const char * const *args,
+                          const svn_string_t *stdin_value,
+                          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *lock_pool;
+  svn_repos_hook_event_t *event;
+  queue_event_t *new_event;
+  apr_uint64_t id;
+  svn_error_t *err;
+
+  /* Quick check without locking. */
+  SVN_ERR(is_enabled(queued, repos, scratch_pool));
+  if (!*queued)
+    return SVN_NO_ERROR;
+
+  /* The queue might get disabled concurrently, so check again once we
+   * hold the lock. */
+  lock_pool = svn_pool_create(scratch_pool);
+  err = svn_io__file_lock_autocreate(queue_path(repos, HOOK_QUEUE_LOCK,
+                                                lock_pool),
+                                     lock_pool);
+  if (!err)
+    err = is_enabled(queued, repos, lock_pool);
+  if (err || !*queued)
+    {
+      svn_pool_destroy(lock_pool);
+      return svn_error_trace(err);
+    }
+
+  event = apr_pcalloc(scratch_pool, sizeof(*event));
+  event->hook = name;
+  event->revision = rev;
+
+  new_event = apr_pcalloc(scratch_pool, sizeof(*new_event));
+  new_event->event = event;
+  new_event->stdin_value = stdin_value;
+  new_event->args = apr_array_make(scratch_pool, 4, sizeof(const char *));
+  for (; *args; ++args)
+    APR_ARRAY_PUSH(new_event->args, const char *) = *args;
+
+  err = allocate_id(&id, repos, lock_pool);
+  if (!err)
+    {
+      event->id = id;
+      new_event->path = queue_path(repos,
+                                   apr_psprintf(scratch_pool,
+                                                "%" APR_UINT64_T_FMT, id),
+                                   scratch_pool);
+      err = write_event(new_event, lock_pool);
+    }
+
+  svn_pool_destroy(lock_pool);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_repos_hook_queue_enable(svn_repos_t *repos,
+                            svn_boolean_t enable,
+                            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *lock_pool = svn_pool_create(scratch_pool);
+  const char *enabled_path = queue_path(repos, HOOK_QUEUE_ENABLED,
+                                        scratch_pool);
+  svn_error_t *err;
+
+  if (enable)
+    SVN_ERR(svn_io_make_dir_recursively(queue_path(repos, NULL,
+                                                   scratch_pool),
+                                        scratch_pool));
+
+  err = svn_io__file_lock_autocreate(queue_path(repos, HOOK_QUEUE_LOCK,
+                                                lock_pool),
+                                     lock_pool);
+
+  /* A queue that never existed is disabled. */
+  if (err && !enable && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(lock_pool);
+      return SVN_NO_ERROR;
+    }
+
+  if (!err && enable)
+    {
+      err = svn_io_file_create_empty(enabled_path, lock_pool);
+      if (err && APR_STATUS_IS_EEXIST(err->apr_err))
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+        }
+    }
+  else if (!err)
+    {
+      apr_array_header_t *events;
+
+      /* Don't strand any events. */
+      err = read_queue(&events, repos, lock_pool, lock_pool);
+      if (!err && events->nelts)
+        err = svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                                _("Can't disable the hook queue while it "
+                                  "still contains %d events"),
+                                events->nelts);
+      if (!err)
+        err = svn_io_remove_file2(enabled_path, TRUE, lock_pool);
+    }
+
+  svn_pool_destroy(lock_pool);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_repos_hook_queue_status(svn_boolean_t *enabled,
+                            apr_array_header_t **events,
+                            svn_repos_t *repos,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+  apr_array_header_t *queued;
+  int i;
+
+  SVN_ERR(is_enabled(enabled, repos, scratch_pool));
+  if (!events)
+    return SVN_NO_ERROR;
+
+  *events = apr_array_make(result_pool, 0, sizeof(svn_repos_hook_event_t *));
+  SVN_ERR(svn_io_check_path(queue_path(repos, NULL, scratch_pool), &kind,
+                            scratch_pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_queue(&queued, repos, result_pool, scratch_pool));
+  for (i = 0; i < queued->nelts; ++i)
+    APR_ARRAY_PUSH(*events, svn_repos_hook_event_t *)
+      = APR_ARRAY_IDX(queued, i, queue_event_t *)->event;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Run the hook of the run_task_t
+ * TASK_BATON and return its error message, or NULL if it succeeded, as
+ * const char * in *RESULT. */
+static svn_error_t *
+process_hook_task(void **result,
+                  void *task_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  run_task_t *task = task_baton;
+  queue_event_t *queued = task->queued;
+  svn_error_t *err;
+
+  err = svn_repos__hooks_run_queued(task->context->repos,
+                                    task->context->hooks_env,
+                                    queued->event->hook, queued->args,
+                                    queued->stdin_value, scratch_pool);
+  if (err)
+    {
+      char buffer[1024];
+      *result = apr_pstrdup(result_pool,
+                            svn_err_best_message(err, buffer,
+                                                 sizeof(buffer)));
+      svn_error_clear(err);
+    }
+  else
+    {
+      *result = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Remove the event of the run_task_t
+ * TASK_BATON from the queue if its hook succeeded, i.e. the error message
+ * in RESULT is NULL.  Otherwise, schedule a retry or give up. */
+static svn_error_t *
+output_hook_task(void *result,
+                 void *task_baton,
+                 apr_pool_t *scratch_pool)
+{
+  run_task_t *task = task_baton;
+  run_context_t *context = task->context;
+  svn_repos_hook_event_t *event = task->queued->event;
+  const char *message = result;
+
+  if (message)
+    {
+      apr_time_t delay = HOOK_QUEUE_RETRY_DELAY;
+      int i;
+
+      event->attempts++;
+      event->last_error = message;
+      if (event->attempts >= context->max_attempts)
+        event->failed = TRUE;
+
+      for (i = 1; i < event->attempts && delay < HOOK_QUEUE_MAX_RETRY_DELAY;
+           ++i)
+        delay *= 2;
+      event->next_attempt = apr_time_now()
+                          + MIN(delay, HOOK_QUEUE_MAX_RETRY_DELAY);
+
+      SVN_ERR(write_event(task->queued, scratch_pool));
+    }
+  else
+    {
+      SVN_ERR(svn_io_remove_file2(task->queued->path, TRUE, scratch_pool));
+    }
+
+  /* Later events for this revision may run now. */
+  apr_hash_set(context->in_flight, &event->revision, sizeof(event->revision),
+               NULL);
+
+  if (context->notify_func)
+    {
+      svn_repos_notify_t *notify
+        = svn_repos_notify_create(message ? svn_repos_notify_hook_failed
+                                          : svn_repos_notify_hook_run,
+                                  scratch_pool);
+
+      notify->revision = event->revision;
+      notify->path = event->hook;
+      notify->warning_str = message;
+      context->notify_func(context->notify_baton, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all events in the hook queue of REPOS that may run now to QUEUE,
+ * as described for svn_repos_hook_queue_run(), unless they are already
+ * in there.  Add the number of events added to *COUNT.  CONTEXT is the
+ * shared task context.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+add_ready_events(int *count,
+                 svn_task__queue_t *queue,
+                 run_context_t *context,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *events;
+  apr_hash_t *blocked = apr_hash_make(scratch_pool);
+  apr_time_t now = apr_time_now();
+  int i;
+
+  SVN_ERR(read_queue(&events, context->repos, scratch_pool, scratch_pool));
+
+  for (i = 0; i < events->nelts; ++i)
+    {
+      queue_event_t *queued = APR_ARRAY_IDX(events, i, queue_event_t *);
+      svn_repos_hook_event_t *event = queued->event;
+      apr_pool_t *task_pool;
+      run_task_t *task;
+
+      /* Later events for the same revision have to wait for this one,
+       * even if it failed permanently. */
+      if (apr_hash_get(blocked, &event->revision, sizeof(event->revision)))
+        continue;
+      apr_hash_set(blocked, &event->revision, sizeof(event->revision),
+                   event);
+
+      if (event->failed || event->next_attempt > now)
+        continue;
+
+      /* Still being run, probably this very event. */
+      if (apr_hash_get(context->in_flight, &event->revision,
+                       sizeof(event->revision)))
+        continue;
+
+      /* The task pool must be usable from the worker threads. */
+      task_pool = svn_pool_create(NULL);
+      task = apr_pcalloc(task_pool, sizeof(*task));
+      task->context = context;
+      SVN_ERR(read_event(&task->queued, queued->path, event->id, task_pool,
+                         scratch_pool));
+      if (!task->queued)
+        {
+          svn_pool_destroy(task_pool);
+          continue;
+        }
+
+      /* Without worker threads, the task will already have been output
+       * when svn_task__queue_add() returns. */
+      event = task->queued->event;
+      apr_hash_set(context->in_flight, &event->revision,
+                   sizeof(event->revision), event);
+      SVN_ERR(svn_task__queue_add(queue, process_hook_task, output_hook_task,
+                                  task, task_pool, scratch_pool));
+      ++*count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Run all events in the hook queue of REPOS that may run now in QUEUE,
+ * as described for svn_repos_hook_queue_run(), until there are none
+ * left.  Whenever a hook finishes, look for events that became ready to
+ * keep the workers busy.  Set *COUNT to the number of events run.
+ * CONTEXT is the shared task context.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+run_batch(int *count,
+          svn_task__queue_t *queue,
+          run_context_t *context,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *count = 0;
+  context->in_flight = apr_hash_make(scratch_pool);
+
+  while (TRUE)
+    {
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(add_ready_events(count, queue, context, iterpool));
+      if (apr_hash_count(context->in_flight) == 0)
+        break;
+
+      SVN_ERR(svn_task__queue_wait(queue, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_hook_queue_run(svn_repos_t *repos,
+                         int runners,
+                         int max_attempts,
+                         svn_boolean_t follow,
+                         svn_repos_notify_func_t notify_func,
+                         void *notify_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *queue_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *runner_path = queue_path(repos, HOOK_QUEUE_RUNNER,
+                                       scratch_pool);
+  svn_boolean_t enabled;
+  svn_task__queue_t *queue;
+  run_context_t context;
+  svn_error_t *err;
+
+  SVN_ERR(is_enabled(&enabled, repos, scratch_pool));
+  if (!enabled)
+    return svn_error_createf(SVN_ERR_REPOS_DISABLED_FEATURE, NULL,
+                             _("The hook queue of repository '%s' is "
+                               "not enabled"),
+                             svn_dirent_local_style(repos->path,
+                                                    scratch_pool));
+
+  /* Make sure that we are the only runner. */
+  err = svn_io_file_lock2(runner_path, TRUE, TRUE, queue_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      err = svn_io_file_create_empty(runner_path, scratch_pool);
+      if (err && APR_STATUS_IS_EEXIST(err->apr_err))
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+        }
+      if (!err)
+        err = svn_io_file_lock2(runner_path, TRUE, TRUE, queue_pool);
+    }
+  if (err && APR_STATUS_IS_EAGAIN(err->apr_err))
+    return svn_error_createf(SVN_ERR_REPOS_LOCKED, err,
+                             _("The hook queue of repository '%s' is "
+                               "being processed by another runner"),
+                             svn_dirent_local_style(repos->path,
+                                                    scratch_pool));
+  SVN_ERR(err);
+
+  context.repos = repos;
+  context.max_attempts = MAX(max_attempts, 1);
+  context.notify_func = notify_func;
+  context.notify_baton = notify_baton;
+
+  SVN_ERR(svn_task__queue_create(&queue, MAX(runners, 1), 0, queue_pool));
+
+  while (TRUE)
+    {
+      int count;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      /* Pick up changes to the hook environment between batches. */
+      err = svn_repos__parse_hooks_env(&context.hooks_env,
+                                       repos->hooks_env_path,
+                                       iterpool, iterpool);
+      if (!err)
+        err = run_batch(&count, queue, &context, cancel_func, cancel_baton,
+                        iterpool);
+      if (err)
+        break;
+
+      if (count == 0)
+        {
+          if (!follow)
+            break;
+
+          apr_sleep(HOOK_QUEUE_POLL_INTERVAL);
+        }
+    }
+
+  /* Wait for all workers to finish and release the runner lock. */
+  svn_pool_destroy(queue_pool);
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_repos_hook_queue_clear_failed(svn_repos_t *repos,
+                                  svn_boolean_t retry,
+                                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *events;
+  apr_pool_t *iterpool;
+  svn_node_kind_t kind;
+  int i;
+
+  SVN_ERR(svn_io_check_path(queue_path(repos, NULL, scratch_pool), &kind,
+                            scratch_pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  /* The runner never touches failed events, so no locking is needed. */
+  SVN_ERR(read_queue(&events, repos, scratch_pool, scratch_pool));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < events->nelts; ++i)
+    {
+      queue_event_t *queued = APR_ARRAY_IDX(events, i, queue_event_t *);
+
+      if (!queued->event->failed)
+        continue;
+
+      svn_pool_clear(iterpool);
+      if (retry)
+        {
+          queued->event->failed = FALSE;
+          queued->event->attempts = 0;
+          queued->event->next_attempt = 0;
+          SVN_ERR(write_event(queued, iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_io_remove_file2(queued->path, TRUE, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
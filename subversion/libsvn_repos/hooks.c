@@ -603,6 +603,8 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
   else if (hook)
     {
       const char *args[5];
+      svn_boolean_t queued;
+      svn_error_t *queue_err;
 
       args[0] = hook;
       args[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
@@ -610,8 +612,17 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
       args[3] = txn_name;
       args[4] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_COMMIT, hook, args,
-                           hooks_env, NULL, pool));
+      /* Leave it to the hook queue runner, if the queue is enabled.
+       * If queueing fails, run the hook right away rather than losing
+       * the event, and report the queue error along with the result. */
+      queue_err = svn_repos__hook_queue_add(&queued, repos,
+                                            SVN_REPOS__HOOK_POST_COMMIT, rev,
+                                            args + 2, NULL, pool);
+      if (queue_err || !queued)
+        return svn_error_compose_create(
+                 run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_COMMIT, hook, args,
+                              hooks_env, NULL, pool),
+                 queue_err);
     }
 
   return SVN_NO_ERROR;
@@ -703,13 +714,9 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
       const char *args[7];
       apr_file_t *stdin_handle = NULL;
       char action_string[2];
-
-      /* Pass the old value as stdin to hook */
-      if (old_value)
-        SVN_ERR(create_temp_file(&stdin_handle, old_value, pool));
-      else
-        SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
-                                 APR_READ, APR_OS_DEFAULT, pool));
+      svn_boolean_t queued;
+      svn_error_t *queue_err;
+      svn_error_t *err;
 
       action_string[0] = action;
       action_string[1] = '\0';
@@ -722,15 +729,85 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
       args[5] = action_string;
       args[6] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_REVPROP_CHANGE, hook,
-                           args, hooks_env, stdin_handle, pool));
+      /* Leave it to the hook queue runner, if the queue is enabled.
+       * If queueing fails, run the hook right away rather than losing
+       * the event, and report the queue error along with the result. */
+      queue_err = svn_repos__hook_queue_add(
+                    &queued, repos, SVN_REPOS__HOOK_POST_REVPROP_CHANGE,
+                    rev, args + 2, old_value, pool);
+      if (!queue_err && queued)
+        return SVN_NO_ERROR;
 
-      SVN_ERR(svn_io_file_close(stdin_handle, pool));
+      /* Pass the old value as stdin to hook */
+      if (old_value)
+        err = create_temp_file(&stdin_handle, old_value, pool);
+      else
+        err = svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
+                               APR_READ, APR_OS_DEFAULT, pool);
+
+      if (!err)
+        err = run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_REVPROP_CHANGE, hook,
+                           args, hooks_env, stdin_handle, pool);
+      if (!err)
+        err = svn_io_file_close(stdin_handle, pool);
+
+      return svn_error_compose_create(err, queue_err);
     }
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_repos__hooks_run_queued(svn_repos_t *repos,
+                            apr_hash_t *hooks_env,
+                            const char *name,
+                            const apr_array_header_t *args,
+                            const svn_string_t *stdin_value,
+                            apr_pool_t *pool)
+{
+  const char *hook;
+  const char **argv;
+  apr_file_t *stdin_handle = NULL;
+  svn_boolean_t broken_link;
+  int i;
+
+  if (strcmp(name, SVN_REPOS__HOOK_POST_COMMIT) == 0)
+    hook = svn_repos_post_commit_hook(repos, pool);
+  else if (strcmp(name, SVN_REPOS__HOOK_POST_REVPROP_CHANGE) == 0)
+    hook = svn_repos_post_revprop_change_hook(repos, pool);
+  else
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("Unknown hook '%s'"), name);
+
+  /* The hook may have been removed since the event got queued. */
+  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+    return hook_symlink_error(hook);
+  else if (!hook)
+    return SVN_NO_ERROR;
+
+  argv = apr_palloc(pool, (args->nelts + 3) * sizeof(*argv));
+  argv[0] = hook;
+  argv[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
+  for (i = 0; i < args->nelts; ++i)
+    argv[i + 2] = APR_ARRAY_IDX(args, i, const char *);
+  argv[i + 2] = NULL;
+
+  /* Post-revprop-change hooks get the old value as stdin. */
+  if (stdin_value)
+    SVN_ERR(create_temp_file(&stdin_handle, stdin_value, pool));
+  else if (strcmp(name, SVN_REPOS__HOOK_POST_REVPROP_CHANGE) == 0)
+    SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
+                             APR_READ, APR_OS_DEFAULT, pool));
+
+  SVN_ERR(run_hook_cmd(NULL, name, hook, argv, hooks_env, stdin_handle,
+                       pool));
+
+  if (stdin_handle)
+    SVN_ERR(svn_io_file_close(stdin_handle, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t  *
 svn_repos__hooks_pre_lock(svn_repos_t *repos,
@@ -184,6 +184,7 @@ do_list(svn_fs_root_t *root,
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
   apr_array_header_t *sorted;
+  apr_array_header_t *readable = NULL;
   int i;
 
   /* Fetch all directory entries, filter and sort them.
@@ -219,6 +220,21 @@ do_list(svn_fs_root_t *root,
 
   svn_sort__array(sorted, compare_filtered_dirent);
 
+  /* Check read access to all remaining entries in one go. */
+  if (authz_read_func)
+    {
+      apr_array_header_t *names = apr_array_make(scratch_pool, sorted->nelts,
+                                                 sizeof(const char *));
+      for (i = 0; i < sorted->nelts; ++i)
+        APR_ARRAY_PUSH(names, const char *)
+          = APR_ARRAY_IDX(sorted, i, filtered_dirent_t).dirent->name;
+
+      SVN_ERR(svn_repos__authz_read_children(&readable, root, path, names,
+                                             authz_read_func,
+                                             authz_read_baton,
+                                             scratch_pool, iterpool));
+    }
+
   /* Iterate over all remaining directory entries and report them.
    * Recurse into sub-directories if requested. */
   for (i = 0; i < sorted->nelts; ++i)
@@ -233,15 +249,10 @@ do_list(svn_fs_root_t *root,
       dirent = filtered->dirent;
 
       /* Skip paths that we don't have access to? */
+      if (readable && !APR_ARRAY_IDX(readable, i, svn_boolean_t))
+        continue;
+
       sub_path = svn_dirent_join(path, dirent->name, iterpool);
-      if (authz_read_func)
-        {
-          svn_boolean_t has_access;
-          SVN_ERR(authz_read_func(&has_access, root, sub_path,
-                                  authz_read_baton, iterpool));
-          if (!has_access)
-            continue;
-        }
 
       /* Report entry, if it passed the filter. */
       if (filtered->is_match)
@@ -175,8 +175,14 @@ change_rev_prop(svn_repos_t *repos,
                                          NULL, value, FALSE, FALSE,
                                          NULL, NULL, pool);
   else
-    return svn_fs_change_rev_prop2(svn_repos_fs(repos), revision, name,
-                                   NULL, value, pool);
+    {
+      SVN_ERR(svn_fs_change_rev_prop2(svn_repos_fs(repos), revision, name,
+                                      NULL, value, pool));
+      if (strcmp(name, SVN_PROP_REVISION_DATE) == 0)
+        svn_error_clear(svn_repos__date_index_update(repos, revision, pool));
+
+      return SVN_NO_ERROR;
+    }
 }
 
 /* Change property NAME to VALUE for PATH in TXN_ROOT.  If
@@ -1118,6 +1124,9 @@ close_revision(void *baton)
         return svn_error_trace(err);
     }
 
+  svn_error_clear(svn_repos__date_index_update(pb->repos, committed_rev,
+                                               rb->pool));
+
   /* Run post-commit hook, if so commanded.  */
   if (pb->use_post_commit_hook)
     {
@@ -1251,7 +1260,7 @@ svn_repos_get_fs_build_parser6(const svn_repos_parse_fns3_t **callbacks,
 
 
 svn_error_t *
-svn_repos_load_fs6(svn_repos_t *repos,
+svn_repos_load_fs7(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -1262,6 +1271,7 @@ svn_repos_load_fs6(svn_repos_t *repos,
                    svn_boolean_t validate_props,
                    svn_boolean_t ignore_dates,
                    svn_boolean_t normalize_props,
+                   svn_boolean_t pipelined,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1288,7 +1298,12 @@ svn_repos_load_fs6(svn_repos_t *repos,
                                          notify_baton,
                                          pool));
 
-  return svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
+  /* Our text streams and window handlers only access the FS, which we
+     won't touch from this thread until they are done.  So, they may be
+     driven from a different thread.  Revisions before START_REV would be
+     skipped by the parser anyway, so compressed streams may omit them. */
+  return svn_repos__parse_dumpstream(dumpstream, parser, parse_baton, FALSE,
+                                     pipelined, start_rev,
                                      cancel_func, cancel_baton, pool);
 }
 
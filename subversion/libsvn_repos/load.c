@@ -33,6 +33,12 @@
 #include "svn_ctype.h"
 
 #include "private/svn_dep_compat.h"
+#include "private/svn_io_private.h"
+
+/* Text content blocks of at least this size will be pushed to the parser
+   vtable from a separate thread in pipelined mode.  For smaller ones,
+   starting a thread is not worth the effort. */
+#define ASYNC_TEXT_THRESHOLD 0x20000
 
 /*----------------------------------------------------------------------*/
 
@@ -283,16 +289,64 @@ parse_property_block(svn_stream_t *stream,
 }
 
 
+/* Read CONTENT_LENGTH bytes from STREAM and, unless TEXT_STREAM is NULL,
+   write them to TEXT_STREAM.  Use BUFFER/BUFLEN to transfer the data in
+   "chunks". */
+static svn_error_t *
+copy_text_block(svn_stream_t *stream,
+                svn_stream_t *text_stream,
+                svn_filesize_t content_length,
+                char *buffer,
+                apr_size_t buflen)
+{
+  apr_size_t num_to_read, rlen, wlen;
+
+  /* Regardless of whether or not we have a sink for our data, we
+     need to read it. */
+  while (content_length)
+    {
+      if (content_length >= (svn_filesize_t)buflen)
+        rlen = buflen;
+      else
+        rlen = (apr_size_t) content_length;
+
+      num_to_read = rlen;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &rlen));
+      content_length -= rlen;
+      if (rlen != num_to_read)
+        return stream_ran_dry();
+
+      if (text_stream)
+        {
+          /* write however many bytes you read. */
+          wlen = rlen;
+          SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
+          if (wlen != rlen)
+            {
+              /* Uh oh, didn't write as many bytes as we read. */
+              return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                      _("Unexpected EOF writing contents"));
+            }
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Read CONTENT_LENGTH bytes from STREAM. If IS_DELTA is true, use
    PARSE_FNS->apply_textdelta to push a text delta, otherwise use
    PARSE_FNS->set_fulltext to push those bytes as replace fulltext for
    a node.  Use BUFFER/BUFLEN to push the fulltext in "chunks".
 
+   If PIPELINED is set and the block is large, push the data from a
+   separate thread while we read on.
+
    Use POOL for all allocations.  */
 static svn_error_t *
 parse_text_block(svn_stream_t *stream,
                  svn_filesize_t content_length,
                  svn_boolean_t is_delta,
+                 svn_boolean_t pipelined,
                  const svn_repos_parse_fns3_t *parse_fns,
                  void *record_baton,
                  char *buffer,
@@ -300,7 +354,8 @@ parse_text_block(svn_stream_t *stream,
                  apr_pool_t *pool)
 {
   svn_stream_t *text_stream = NULL;
-  apr_size_t num_to_read, rlen, wlen;
+  svn_boolean_t async = FALSE;
+  svn_error_t *err;
 
   if (is_delta)
     {
@@ -317,34 +372,23 @@ parse_text_block(svn_stream_t *stream,
       SVN_ERR(parse_fns->set_fulltext(&text_stream, record_baton));
     }
 
-  /* Regardless of whether or not we have a sink for our data, we
-     need to read it. */
-  while (content_length)
+  /* Let another thread decode the data and push it into the sink.
+     Until we close TEXT_STREAM, we will only read from STREAM. */
+  if (pipelined && text_stream && content_length >= ASYNC_TEXT_THRESHOLD)
     {
-      if (content_length >= (svn_filesize_t)buflen)
-        rlen = buflen;
-      else
-        rlen = (apr_size_t) content_length;
+      SVN_ERR(svn_stream__create_async_writer(&text_stream, text_stream, 0,
+                                              pool));
+      async = TRUE;
+    }
 
-      num_to_read = rlen;
-      SVN_ERR(svn_stream_read_full(stream, buffer, &rlen));
-      content_length -= rlen;
-      if (rlen != num_to_read)
-        return stream_ran_dry();
+  err = copy_text_block(stream, text_stream, content_length, buffer, buflen);
 
-      if (text_stream)
-        {
-          /* write however many bytes you read. */
-          wlen = rlen;
-          SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
-          if (wlen != rlen)
-            {
-              /* Uh oh, didn't write as many bytes as we read. */
-              return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
-                                      _("Unexpected EOF writing contents"));
-            }
-        }
-    }
+  /* Don't leave the writer thread running and accessing the sink when
+     we bail out. */
+  if (err && async)
+    return svn_error_compose_create(err, svn_stream_close(text_stream));
+
+  SVN_ERR(err);
 
   /* If we opened a stream, we must close it. */
   if (text_stream)
@@ -520,10 +564,12 @@ complete_vtable(const svn_repos_parse_fns3_t *provided,
 /** The public routines **/
 
 svn_error_t *
-svn_repos_parse_dumpstream3(svn_stream_t *stream,
+svn_repos__parse_dumpstream(svn_stream_t *stream,
                             const svn_repos_parse_fns3_t *parse_fns,
                             void *parse_baton,
                             svn_boolean_t deltas_are_text,
+                            svn_boolean_t pipelined,
+                            svn_revnum_t start_rev,
                             svn_cancel_func_t cancel_func,
                             void *cancel_baton,
                             apr_pool_t *pool)
@@ -546,6 +592,22 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
   if (eof)
     return stream_ran_dry();
 
+  /* Block-compressed streams contain a plain dump stream. */
+  if (strcmp(linebuf->data, SVN_REPOS__DUMP_BLOCKS_MAGIC) == 0)
+    {
+      SVN_ERR(svn_repos__dump_decompress(&stream, stream, start_rev, pool));
+      SVN_ERR(svn_stream_readline(stream, &linebuf, "\n", &eof, linepool));
+      if (eof)
+        return stream_ran_dry();
+    }
+
+  /* Read the input in a separate thread while we are busy parsing.
+     That includes the decompression of compressed streams. */
+  if (pipelined)
+    SVN_ERR(svn_stream__create_read_ahead(&stream,
+                                          svn_stream_disown(stream, pool),
+                                          0, pool));
+
   /* The first two lines of the stream are the dumpfile-format version
      number, and a blank line.  To preserve backward compatibility,
      don't assume the existence of newer parser-vtable functions. */
@@ -702,6 +764,7 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
           SVN_ERR(parse_text_block(stream,
                                    svn__atoui64(text_cl),
                                    is_delta,
+                                   pipelined,
                                    parse_fns,
                                    found_node ? node_baton : rev_baton,
                                    buffer,
@@ -736,6 +799,7 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
             SVN_ERR(parse_text_block(stream,
                                      cl_value,
                                      FALSE,
+                                     pipelined,
                                      parse_fns,
                                      found_node ? node_baton : rev_baton,
                                      buffer,
@@ -793,8 +857,31 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
   if (rev_baton != NULL)
     SVN_ERR(parse_fns->close_revision(rev_baton));
 
+  /* Stop the reader thread.  This leaves the caller's stream open. */
+  if (pipelined)
+    SVN_ERR(svn_stream_close(stream));
+
   svn_pool_destroy(linepool);
   svn_pool_destroy(revpool);
   svn_pool_destroy(nodepool);
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos_parse_dumpstream3(svn_stream_t *stream,
+                            const svn_repos_parse_fns3_t *parse_fns,
+                            void *parse_baton,
+                            svn_boolean_t deltas_are_text,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos__parse_dumpstream(stream, parse_fns,
+                                                     parse_baton,
+                                                     deltas_are_text,
+                                                     FALSE,
+                                                     SVN_INVALID_REVNUM,
+                                                     cancel_func,
+                                                     cancel_baton,
+                                                     pool));
+}
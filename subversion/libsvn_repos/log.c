@@ -56,8 +56,17 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* Number of bytes that do_logs() may still use to buffer mergeinfo
+     changes when sending logs in ascending order. */
+  apr_size_t mergeinfo_buffer_left;
 } log_callbacks_t;
 
+/* Upper limit for the total size of the serialized mergeinfo changes that
+   a single svn_repos_get_logs5() call buffers.  Beyond that, the changes
+   get recalculated when needed instead. */
+#define LOG_MERGEINFO_BUFFER_SIZE (16 * 1024 * 1024)
+
 
 svn_repos_path_change_t *
 svn_repos_path_change_create(apr_pool_t *result_pool)
@@ -1821,14 +1830,110 @@ handle_merged_revisions(svn_revnum_t rev,
                                         &empty_log_entry, pool);
 }
 
-/* This is used by do_logs to differentiate between forward and
-   reverse merges. */
+/* This is used by do_logs to remember the mergeinfo changes of a revision
+   until it gets sent in ascending order.  The changes are kept in their
+   compact serialized form while the mergeinfo buffer budget allows it.
+   Otherwise, the ADDED_MERGEINFO and DELETED_MERGEINFO are NULL and the
+   changes will be recalculated from PATHS. */
 struct added_deleted_mergeinfo
 {
-  svn_mergeinfo_t added_mergeinfo;
-  svn_mergeinfo_t deleted_mergeinfo;
+  svn_string_t *added_mergeinfo;
+  svn_string_t *deleted_mergeinfo;
+  apr_array_header_t *paths;
 };
 
+/* Remember the mergeinfo changes ADDED_MERGEINFO and DELETED_MERGEINFO
+   of PATHS in REV in REV_MERGEINFO, charging CALLBACKS' mergeinfo buffer
+   budget.  Add the number of bytes charged to *BUFFERED_SIZE.  Allocate
+   the new entry in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+buffer_mergeinfo_changes(apr_hash_t *rev_mergeinfo,
+                         apr_size_t *buffered_size,
+                         svn_revnum_t rev,
+                         const apr_array_header_t *paths,
+                         svn_mergeinfo_t added_mergeinfo,
+                         svn_mergeinfo_t deleted_mergeinfo,
+                         log_callbacks_t *callbacks,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  svn_revnum_t *cur_rev = apr_pmemdup(result_pool, &rev, sizeof(*cur_rev));
+  struct added_deleted_mergeinfo *add_and_del_mergeinfo
+    = apr_pcalloc(result_pool, sizeof(*add_and_del_mergeinfo));
+  svn_string_t *added, *deleted;
+  apr_size_t size;
+  int i;
+
+  add_and_del_mergeinfo->paths = apr_array_make(result_pool, paths->nelts,
+                                                sizeof(const char *));
+  for (i = 0; i < paths->nelts; i++)
+    APR_ARRAY_PUSH(add_and_del_mergeinfo->paths, const char *)
+      = apr_pstrdup(result_pool, APR_ARRAY_IDX(paths, i, const char *));
+
+  /* Empty rangelists cannot be parsed back and carry no information. */
+  svn_mergeinfo__remove_empty_rangelists(added_mergeinfo, scratch_pool);
+  svn_mergeinfo__remove_empty_rangelists(deleted_mergeinfo, scratch_pool);
+  SVN_ERR(svn_mergeinfo_to_string(&added, added_mergeinfo, scratch_pool));
+  SVN_ERR(svn_mergeinfo_to_string(&deleted, deleted_mergeinfo,
+                                  scratch_pool));
+
+  size = added->len + deleted->len;
+  if (size <= callbacks->mergeinfo_buffer_left)
+    {
+      callbacks->mergeinfo_buffer_left -= size;
+      *buffered_size += size;
+
+      add_and_del_mergeinfo->added_mergeinfo
+        = svn_string_dup(added, result_pool);
+      add_and_del_mergeinfo->deleted_mergeinfo
+        = svn_string_dup(deleted, result_pool);
+    }
+
+  apr_hash_set(rev_mergeinfo, cur_rev, sizeof(*cur_rev),
+               add_and_del_mergeinfo);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ADDED_MERGEINFO and *DELETED_MERGEINFO to the mergeinfo changes
+   in REV remembered in ADD_AND_DEL_MERGEINFO, recalculating them in FS
+   if they have not been buffered.  Allocate the results in RESULT_POOL
+   and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_buffered_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
+                               svn_mergeinfo_t *deleted_mergeinfo,
+                               const struct added_deleted_mergeinfo
+                                 *add_and_del_mergeinfo,
+                               svn_fs_t *fs,
+                               svn_revnum_t rev,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  if (add_and_del_mergeinfo->added_mergeinfo)
+    {
+      svn_error_t *err;
+
+      err = svn_mergeinfo_parse(added_mergeinfo,
+                                add_and_del_mergeinfo->added_mergeinfo->data,
+                                result_pool);
+      if (!err)
+        err = svn_mergeinfo_parse(deleted_mergeinfo,
+                                  add_and_del_mergeinfo->deleted_mergeinfo
+                                    ->data,
+                                  result_pool);
+      if (!err)
+        return SVN_NO_ERROR;
+
+      /* Should not happen, but we can always ask the repository. */
+      svn_error_clear(err);
+    }
+
+  return svn_error_trace(get_combined_mergeinfo_changes(
+                           added_mergeinfo, deleted_mergeinfo, fs,
+                           add_and_del_mergeinfo->paths, rev,
+                           result_pool, scratch_pool));
+}
+
 /* Reduce the search range PATHS, HIST_START, HIST_END by removing
    parts already covered by PROCESSED.  If reduction is possible
    elements may be removed from PATHS and *START_REDUCED and
@@ -1991,6 +2096,7 @@ do_logs(svn_fs_t *fs,
   svn_revnum_t current;
   apr_array_header_t *histories;
   svn_boolean_t any_histories_left = TRUE;
+  apr_size_t buffered_size = 0;
   int send_count = 0;
   int i;
 
@@ -2054,6 +2160,7 @@ do_logs(svn_fs_t *fs,
         {
           svn_mergeinfo_t added_mergeinfo = NULL;
           svn_mergeinfo_t deleted_mergeinfo = NULL;
+          apr_array_header_t *cur_paths = NULL;
           svn_boolean_t has_children = FALSE;
 
           /* If we're including merged revisions, we need to calculate
@@ -2061,8 +2168,8 @@ do_logs(svn_fs_t *fs,
              various paths. */
           if (include_merged_revisions)
             {
-              apr_array_header_t *cur_paths =
-                apr_array_make(iterpool, paths->nelts, sizeof(const char *));
+              cur_paths = apr_array_make(iterpool, paths->nelts,
+                                         sizeof(const char *));
 
               /* Get the current paths of our history objects so we can
                  query mergeinfo. */
@@ -2127,24 +2234,19 @@ do_logs(svn_fs_t *fs,
                 revs = apr_array_make(pool, 64, sizeof(svn_revnum_t));
               APR_ARRAY_PUSH(revs, svn_revnum_t) = current;
 
-              if (added_mergeinfo || deleted_mergeinfo)
+              /* Only revisions that merged something need to be
+                 remembered. */
+              if (has_children)
                 {
-                  svn_revnum_t *cur_rev =
-                    apr_pmemdup(pool, &current, sizeof(*cur_rev));
-                  struct added_deleted_mergeinfo *add_and_del_mergeinfo =
-                    apr_palloc(pool, sizeof(*add_and_del_mergeinfo));
-
-                  /* If we have added or deleted mergeinfo, both are non-null */
-                  SVN_ERR_ASSERT(added_mergeinfo && deleted_mergeinfo);
-                  add_and_del_mergeinfo->added_mergeinfo =
-                    svn_mergeinfo_dup(added_mergeinfo, pool);
-                  add_and_del_mergeinfo->deleted_mergeinfo =
-                    svn_mergeinfo_dup(deleted_mergeinfo, pool);
-
                   if (! rev_mergeinfo)
                     rev_mergeinfo = svn_hash__make(pool);
-                  apr_hash_set(rev_mergeinfo, cur_rev, sizeof(*cur_rev),
-                               add_and_del_mergeinfo);
+                  SVN_ERR(buffer_mergeinfo_changes(rev_mergeinfo,
+                                                   &buffered_size, current,
+                                                   cur_paths,
+                                                   added_mergeinfo,
+                                                   deleted_mergeinfo,
+                                                   callbacks, pool,
+                                                   iterpool));
                 }
             }
         }
@@ -2165,8 +2267,8 @@ do_logs(svn_fs_t *fs,
       iterpool = svn_pool_create(pool);
       for (i = 0; i < revs->nelts; ++i)
         {
-          svn_mergeinfo_t added_mergeinfo;
-          svn_mergeinfo_t deleted_mergeinfo;
+          svn_mergeinfo_t added_mergeinfo = NULL;
+          svn_mergeinfo_t deleted_mergeinfo = NULL;
           svn_boolean_t has_children = FALSE;
 
           svn_pool_clear(iterpool);
@@ -2180,10 +2282,16 @@ do_logs(svn_fs_t *fs,
             {
               struct added_deleted_mergeinfo *add_and_del_mergeinfo =
                 apr_hash_get(rev_mergeinfo, &current, sizeof(current));
-              added_mergeinfo = add_and_del_mergeinfo->added_mergeinfo;
-              deleted_mergeinfo = add_and_del_mergeinfo->deleted_mergeinfo;
-              has_children = (apr_hash_count(added_mergeinfo) > 0
-                              || apr_hash_count(deleted_mergeinfo) > 0);
+
+              if (add_and_del_mergeinfo)
+                {
+                  SVN_ERR(get_buffered_mergeinfo_changes(
+                            &added_mergeinfo, &deleted_mergeinfo,
+                            add_and_del_mergeinfo, fs, current,
+                            iterpool, iterpool));
+                  has_children = (apr_hash_count(added_mergeinfo) > 0
+                                  || apr_hash_count(deleted_mergeinfo) > 0);
+                }
             }
 
           SVN_ERR(send_log(current, fs,
@@ -2194,8 +2302,12 @@ do_logs(svn_fs_t *fs,
             {
               if (!nested_merges)
                 {
+                  /* As in the descending case, share the record of what
+                     has already been searched across all recursions, so
+                     the same merged history is not walked repeatedly. */
                   subpool = svn_pool_create(pool);
                   nested_merges = svn_bit_array__create(current, subpool);
+                  processed = svn_hash__make(subpool);
                 }
 
               SVN_ERR(handle_merged_revisions(current, fs,
@@ -2214,6 +2326,9 @@ do_logs(svn_fs_t *fs,
       svn_pool_destroy(iterpool);
     }
 
+  /* Our buffered mergeinfo goes away with POOL. */
+  callbacks->mergeinfo_buffer_left += buffered_size;
+
   return SVN_NO_ERROR;
 }
 
@@ -2332,6 +2447,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.mergeinfo_buffer_left = LOG_MERGEINFO_BUFFER_SIZE;
 
   if (revprops)
     {
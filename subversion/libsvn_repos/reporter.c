@@ -36,6 +36,7 @@
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 
@@ -755,6 +756,42 @@ check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Set *READABLE to a hash mapping the names of all ENTRIES of directory
+   B->t_root/PATH to svn_boolean_t * telling whether the user is
+   authorized to view them.  Check all entries at once.  Set *READABLE
+   to NULL if there is no authz_read_func.  Allocate the result in
+   RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+check_auth_entries(apr_hash_t **readable, report_baton_t *b,
+                   const char *path, apr_hash_t *entries,
+                   apr_pool_t *result_pool, apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *names, *allowed;
+  apr_hash_index_t *hi;
+  int i;
+
+  *readable = NULL;
+  if (!b->authz_read_func)
+    return SVN_NO_ERROR;
+
+  names = apr_array_make(scratch_pool, apr_hash_count(entries),
+                         sizeof(const char *));
+  for (hi = apr_hash_first(scratch_pool, entries); hi; hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(names, const char *) = apr_hash_this_key(hi);
+
+  SVN_ERR(svn_repos__authz_read_children(&allowed, b->t_root, path, names,
+                                         b->authz_read_func,
+                                         b->authz_read_baton,
+                                         result_pool, scratch_pool));
+
+  *readable = apr_hash_make(result_pool);
+  for (i = 0; i < names->nelts; ++i)
+    svn_hash_sets(*readable, APR_ARRAY_IDX(names, i, const char *),
+                  &APR_ARRAY_IDX(allowed, i, svn_boolean_t));
+
+  return SVN_NO_ERROR;
+}
+
 /* Create a dirent in *ENTRY for the given ROOT and PATH.  We use this to
    replace the source or target dirent when a report pathinfo tells us to
    change paths or revisions. */
@@ -895,7 +932,8 @@ add_file_smartly(report_baton_t *b,
    B->t_root and T_PATH specify the target entry.  T_ENTRY contains
    the already-looked-up information about the node-revision existing
    at that location.  T_PATH and T_ENTRY may be NULL if the entry does
-   not exist in the target.
+   not exist in the target.  If T_ALLOWED is not NULL, it tells whether
+   the user is authorized to view T_PATH; otherwise, check it here.
 
    DIR_BATON and E_PATH contain the parameters which should be passed
    to the editor calls--DIR_BATON for the parent directory baton and
@@ -914,7 +952,8 @@ add_file_smartly(report_baton_t *b,
 static svn_error_t *
 update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
              const svn_fs_dirent_t *s_entry, const char *t_path,
-             const svn_fs_dirent_t *t_entry, void *dir_baton,
+             const svn_fs_dirent_t *t_entry,
+             const svn_boolean_t *t_allowed, void *dir_baton,
              const char *e_path, path_info_t *info, svn_depth_t wc_depth,
              svn_depth_t requested_depth, apr_pool_t *pool)
 {
@@ -928,6 +967,7 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   if (info && info->link_path && !b->is_switch)
     {
       t_path = info->link_path;
+      t_allowed = NULL;
       SVN_ERR(fake_dirent(&t_entry, b->t_root, t_path, pool));
     }
 
@@ -1035,7 +1075,10 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     return svn_error_trace(skip_path_info(b, e_path));
 
   /* Check if the user is authorized to find out about the target. */
-  SVN_ERR(check_auth(b, &allowed, t_path, pool));
+  if (t_allowed)
+    allowed = *t_allowed;
+  else
+    SVN_ERR(check_auth(b, &allowed, t_path, pool));
   if (!allowed)
     {
       if (t_entry->kind == svn_node_dir)
@@ -1160,7 +1203,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
            svn_boolean_t start_empty, svn_depth_t wc_depth,
            svn_depth_t requested_depth, apr_pool_t *pool)
 {
-  apr_hash_t *s_entries = NULL, *t_entries;
+  apr_hash_t *s_entries = NULL, *t_entries, *t_readable;
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_array_header_t *t_ordered_entries = NULL;
@@ -1188,6 +1231,8 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
           SVN_ERR(svn_fs_dir_entries(&s_entries, s_root, s_path, subpool));
         }
       SVN_ERR(svn_fs_dir_entries(&t_entries, b->t_root, t_path, subpool));
+      SVN_ERR(check_auth_entries(&t_readable, b, t_path, t_entries,
+                                 subpool, subpool));
 
       /* Iterate over the report information for this directory. */
       iterpool = svn_pool_create(subpool);
@@ -1240,7 +1285,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                       || (s_entry && s_entry->kind == svn_node_dir)))
                  || (info && info->depth == svn_depth_exclude)))
             SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, t_fullpath,
-                                 t_entry, dir_baton, e_fullpath, info,
+                                 t_entry,
+                                 t_readable && t_entry
+                                   ? svn_hash_gets(t_readable, name)
+                                   : NULL,
+                                 dir_baton, e_fullpath, info,
                                  info ? info->depth
                                       : DEPTH_BELOW_HERE(wc_depth),
                                  DEPTH_BELOW_HERE(requested_depth), iterpool));
@@ -1344,7 +1393,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
           t_fullpath = svn_fspath__join(t_path, t_entry->name, iterpool);
 
           SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, t_fullpath,
-                               t_entry, dir_baton, e_fullpath, NULL,
+                               t_entry,
+                               t_readable
+                                 ? svn_hash_gets(t_readable, t_entry->name)
+                                 : NULL,
+                               dir_baton, e_fullpath, NULL,
                                DEPTH_BELOW_HERE(wc_depth),
                                DEPTH_BELOW_HERE(requested_depth),
                                iterpool));
@@ -1413,7 +1466,7 @@ drive(report_baton_t *b, svn_revnum_t s_rev, path_info_t *info,
                        pool));
   else
     SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, b->t_path,
-                         t_entry, root_baton, b->s_operand, info,
+                         t_entry, NULL, root_baton, b->s_operand, info,
                          info->depth, b->requested_depth, pool));
 
   return svn_error_trace(b->editor->close_directory(root_baton, pool));
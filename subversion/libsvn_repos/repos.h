@@ -362,6 +362,42 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
                              const char *username,
                              apr_pool_t *pool);
 
+/* Run the hook NAME of REPOS for an event taken from the hook queue.
+   NAME must be either SVN_REPOS__HOOK_POST_COMMIT or
+   SVN_REPOS__HOOK_POST_REVPROP_CHANGE.  ARGS are the const char *
+   arguments to pass after the repository path and STDIN_VALUE, if not
+   NULL, is passed as the hook's stdin.  Do nothing if the hook does not
+   exist (anymore).
+
+   HOOKS_ENV is as for the other hook functions.  REPOS and HOOKS_ENV
+   are only read, so this may be called from multiple threads at once.
+   Use POOL for any temporary allocations.  */
+svn_error_t *
+svn_repos__hooks_run_queued(svn_repos_t *repos,
+                            apr_hash_t *hooks_env,
+                            const char *name,
+                            const apr_array_header_t *args,
+                            const svn_string_t *stdin_value,
+                            apr_pool_t *pool);
+
+
+/*** Hook queue ***/
+
+/* If the hook queue of REPOS is enabled, append an event for running the
+   hook NAME for revision REV to it and set *QUEUED to TRUE.  Otherwise,
+   set *QUEUED to FALSE.  ARGS is the NULL-terminated list of arguments
+   following the repository path and STDIN_VALUE, which may be NULL, the
+   data to pass as the hook's stdin.  The event is stored durably before
+   this returns.  Use SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_repos__hook_queue_add(svn_boolean_t *queued,
+                          svn_repos_t *repos,
+                          const char *name,
+                          svn_revnum_t rev,
+                          const char * const *args,
+                          const svn_string_t *stdin_value,
+                          apr_pool_t *scratch_pool);
+
 
 /*** Utility Functions ***/
 
@@ -387,6 +423,71 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+
+/*** Date index ***/
+
+/* If REPOS has a date index, record the current svn:date of revision REV
+   in it.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__date_index_update(svn_repos_t *repos,
+                             svn_revnum_t rev,
+                             apr_pool_t *scratch_pool);
+
+/* Set *REVISION to the youngest revision up to YOUNGEST in REPOS whose
+   svn:date, according to the date index, is not younger than TM, or to 0
+   if there is none.  Set *REVISION to SVN_INVALID_REVNUM if there is no
+   usable index or the index has no answer.
+
+   The index may be outdated, so callers should verify the result.  Use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__date_index_lookup(svn_revnum_t *revision,
+                             svn_repos_t *repos,
+                             apr_time_t tm,
+                             svn_revnum_t youngest,
+                             apr_pool_t *scratch_pool);
+
+
+/*** Dump stream parsing ***/
+
+/* Like svn_repos_parse_dumpstream3().  If PIPELINED is set, read STREAM
+   ahead in a separate thread and push larger text content blocks to
+   PARSE_FNS from another thread while reading on.  PARSE_FNS must then
+   allow their text streams and window handlers to be driven from a
+   different thread than the one calling the other functions.  They will
+   never be called concurrently.
+
+   Block-compressed dump streams are accepted as well.  For those, if
+   START_REV is a valid revision, revisions older than START_REV may be
+   skipped without passing them to PARSE_FNS.  */
+svn_error_t *
+svn_repos__parse_dumpstream(svn_stream_t *stream,
+                            const svn_repos_parse_fns3_t *parse_fns,
+                            void *parse_baton,
+                            svn_boolean_t deltas_are_text,
+                            svn_boolean_t pipelined,
+                            svn_revnum_t start_rev,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool);
+
+/* First line of a block-compressed dump stream, without the newline. */
+#define SVN_REPOS__DUMP_BLOCKS_MAGIC "SVN-fs-dump-blocks-version: 1"
+
+/* Set *STREAM to a stream that returns the plain dump data contained in
+   the block-compressed dump stream SOURCE.  SOURCE must be positioned
+   directly behind the SVN_REPOS__DUMP_BLOCKS_MAGIC line.  The checksum
+   of every block gets verified as it is being read.
+
+   If START_REV is a valid revision, skip blocks that contain only
+   revisions older than START_REV.  The stream headers will always be
+   returned.  Closing *STREAM does not close SOURCE.  */
+svn_error_t *
+svn_repos__dump_decompress(svn_stream_t **stream,
+                           svn_stream_t *source,
+                           svn_revnum_t start_rev,
+                           apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
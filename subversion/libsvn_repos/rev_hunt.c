@@ -89,6 +89,36 @@ svn_repos_dated_revision(svn_revnum_t *revision,
   /* Initialize top and bottom values of binary search. */
   SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
   SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+
+  /* The date index, if present, usually has the answer.  It may be
+     outdated, though, so verify that against the actual revprops. */
+  SVN_ERR(svn_repos__date_index_lookup(&rev_mid, repos, tm, rev_latest,
+                                       pool));
+  if (SVN_IS_VALID_REVNUM(rev_mid))
+    {
+      svn_error_t *err = SVN_NO_ERROR;
+      svn_boolean_t valid = TRUE;
+
+      if (rev_mid > 0)
+        {
+          err = get_time(&this_time, fs, rev_mid, pool);
+          valid = !err && this_time <= tm;
+        }
+
+      if (valid && rev_mid < rev_latest)
+        {
+          err = get_time(&this_time, fs, rev_mid + 1, pool);
+          valid = !err && this_time > tm;
+        }
+
+      svn_error_clear(err);
+      if (valid)
+        {
+          *revision = rev_mid;
+          return SVN_NO_ERROR;
+        }
+    }
+
   rev_bot = 0;
   rev_top = rev_latest;
 
@@ -35,6 +35,7 @@
 
 #include "checksum.h"
 #include "fnv1a.h"
+#include "sha1.h"
 
 #include "private/svn_subr_private.h"
 
@@ -475,7 +476,7 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
+  svn_sha1__context_t sha1_ctx;
 
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
@@ -487,9 +488,9 @@ svn_checksum(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        svn_sha1__init(&sha1_ctx);
+        svn_sha1__update(&sha1_ctx, data, len);
+        svn_sha1__final((unsigned char *)(*checksum)->digest, &sha1_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -529,10 +530,19 @@ svn_checksum_empty_checksum(svn_checksum_kind_t kind,
     }
 }
 
+/* When calculating multiple checksums over the same data, feed the data
+ * to the individual contexts in slices of this size such that they stay
+ * in the L1 cache. */
+#define MULTI_SLICE_SIZE 0x2000
+
 struct svn_checksum_ctx_t
 {
   void *apr_ctx;
   svn_checksum_kind_t kind;
+
+  /* Context for the next kind of checksum to calculate over the same data.
+   * NULL for all but multi-checksum contexts. */
+  struct svn_checksum_ctx_t *next;
 };
 
 svn_checksum_ctx_t *
@@ -542,6 +552,7 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
   svn_checksum_ctx_t *ctx = apr_palloc(pool, sizeof(*ctx));
 
   ctx->kind = kind;
+  ctx->next = NULL;
   switch (kind)
     {
       case svn_checksum_md5:
@@ -550,8 +561,8 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = apr_palloc(pool, sizeof(svn_sha1__context_t));
+        svn_sha1__init(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -569,8 +580,29 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
   return ctx;
 }
 
-svn_error_t *
-svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
+svn_checksum_ctx_t *
+svn_checksum__ctx_create_multi(const svn_checksum_kind_t *kinds,
+                               int count,
+                               apr_pool_t *pool)
+{
+  svn_checksum_ctx_t *ctx = NULL;
+
+  SVN_ERR_ASSERT_NO_RETURN(count > 0);
+
+  /* Build the chain back to front. */
+  while (count-- > 0)
+    {
+      svn_checksum_ctx_t *next = ctx;
+      ctx = svn_checksum_ctx_create(kinds[count], pool);
+      ctx->next = next;
+    }
+
+  return ctx;
+}
+
+/* Reset the single checksum context CTX, ignoring CTX->NEXT. */
+static svn_error_t *
+reset_single(svn_checksum_ctx_t *ctx)
 {
   switch (ctx->kind)
     {
@@ -580,8 +612,7 @@ svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
         break;
 
       case svn_checksum_sha1:
-        memset(ctx->apr_ctx, 0, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        svn_sha1__init(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -600,9 +631,20 @@ svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
 }
 
 svn_error_t *
-svn_checksum_update(svn_checksum_ctx_t *ctx,
-                    const void *data,
-                    apr_size_t len)
+svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
+{
+  for (; ctx; ctx = ctx->next)
+    SVN_ERR(reset_single(ctx));
+
+  return SVN_NO_ERROR;
+}
+
+/* Feed LEN bytes from DATA into the single checksum context CTX, ignoring
+ * CTX->NEXT. */
+static svn_error_t *
+update_single(svn_checksum_ctx_t *ctx,
+              const void *data,
+              apr_size_t len)
 {
   switch (ctx->kind)
     {
@@ -611,7 +653,7 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        svn_sha1__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -630,6 +672,32 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_checksum_update(svn_checksum_ctx_t *ctx,
+                    const void *data,
+                    apr_size_t len)
+{
+  const char *input = data;
+
+  if (ctx->next == NULL)
+    return svn_error_trace(update_single(ctx, data, len));
+
+  /* Single pass over the data for all checksum kinds. */
+  while (len > 0)
+    {
+      apr_size_t slice = MIN(len, MULTI_SLICE_SIZE);
+      svn_checksum_ctx_t *single;
+
+      for (single = ctx; single; single = single->next)
+        SVN_ERR(update_single(single, input, slice));
+
+      input += slice;
+      len -= slice;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_checksum_final(svn_checksum_t **checksum,
                    const svn_checksum_ctx_t *ctx,
@@ -644,7 +712,7 @@ svn_checksum_final(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_sha1__final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -665,6 +733,19 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_checksum__final_kind(svn_checksum_t **checksum,
+                         const svn_checksum_ctx_t *ctx,
+                         svn_checksum_kind_t kind,
+                         apr_pool_t *pool)
+{
+  for (; ctx; ctx = ctx->next)
+    if (ctx->kind == kind)
+      return svn_error_trace(svn_checksum_final(checksum, ctx, pool));
+
+  return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL, NULL);
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
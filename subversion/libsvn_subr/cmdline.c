@@ -66,6 +66,8 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_sqlite.h"
 
 #include "svn_private_config.h"
 
@@ -252,6 +254,11 @@ svn_cmdline_init(const char *progname, FILE *error_stream)
       return EXIT_FAILURE;
     }
 
+  /* Opt-in pool allocation and SQLite statement profiling.  Their reports
+     must be written before apr_terminate() runs. */
+  svn_pool__profile_init(progname);
+  svn_sqlite__profile_init(progname);
+
   /* Create a pool for use by the UTF-8 routines.  It will be cleaned
      up by APR at exit time. */
   pool = svn_pool_create(NULL);
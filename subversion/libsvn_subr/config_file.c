@@ -1514,6 +1514,13 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set diff-jobs to the number of threads that 'svn diff' may"     NL
+        "### use to compare file contents concurrently when running the"     NL
+        "### internal diff implementation.  The output is the same as with"  NL
+        "### a single thread.  Set it to 1 to disable concurrent diffs."     NL
+        "### Text merges done by 'svn merge' always use a single thread."    NL
+        "### [New in 1.12]"                                                  NL
+        "# diff-jobs = 4"                                                    NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -1555,6 +1562,18 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set to true to use SQLite's write-ahead log instead of a"       NL
+        "### rollback journal.  This lets readers proceed while another"     NL
+        "### client writes to the working copy database, but does not work"  NL
+        "### for working copies on network file systems."                    NL
+        "# write-ahead-logging = false"                                      NL
+        "### Set the number of megabytes of the working copy database that"  NL
+        "### SQLite may access through memory-mapped I/O.  The default is 0,"NL
+        "### i.e. to use regular file reads."                                NL
+        "# mmap-size = 0"                                                    NL
+        "### Set the size of SQLite's page cache in megabytes.  By default," NL
+        "### SQLite uses about 2 megabytes per database connection."         NL
+        "# page-cache-size = 2"                                              NL
         ;
 
       err = svn_io_file_open(&f, path,
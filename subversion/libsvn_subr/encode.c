@@ -21,7 +21,11 @@
  * ====================================================================
  */
 
+#include <string.h>
+
+#include "svn_sorts.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_simd_private.h"
 
 #include "svn_private_config.h"
 
@@ -105,3 +109,264 @@ svn__decode_int(apr_int64_t *val,
 
   return result;
 }
+
+
+/*** Little-endian 7b/8b (LEB128) arrays. ***/
+
+/* Set for each byte of a word that is to be interpreted as a LEB128
+   data byte. */
+#define DATA_BITS APR_UINT64_C(0x7f7f7f7f7f7f7f7f)
+
+#if !APR_IS_BIGENDIAN
+
+/* Number of bytes in the LEB128 representation of VALUE. */
+static APR_INLINE int
+leb128_len(apr_uint64_t value)
+{
+#if defined(__GNUC__)
+  return value ? (63 - __builtin_clzll(value)) / 7 + 1 : 1;
+#else
+  int len = 1;
+  while (value >= 0x80)
+    {
+      value >>= 7;
+      ++len;
+    }
+  return len;
+#endif
+}
+
+/* Spread the lowest 56 bits of VALUE over the 7 data bits of each byte.
+   The result still needs continuation bits. */
+static APR_INLINE apr_uint64_t
+spread_7b(apr_uint64_t value)
+{
+  value = ((value & APR_UINT64_C(0x00fffffff0000000)) << 4)
+        |  (value & APR_UINT64_C(0x000000000fffffff));
+  value = ((value & APR_UINT64_C(0x0fffc0000fffc000)) << 2)
+        |  (value & APR_UINT64_C(0x00003fff00003fff));
+  value = ((value & APR_UINT64_C(0x3f803f803f803f80)) << 1)
+        |  (value & APR_UINT64_C(0x007f007f007f007f));
+
+  return value;
+}
+
+/* Invert spread_7b for a WORD read from memory that contains a LEB128
+   value of LEN <= 8 bytes in its lowest bytes. */
+static APR_INLINE apr_uint64_t
+compact_7b(apr_uint64_t word,
+           int len)
+{
+  if (len < 8)
+    word &= (APR_UINT64_C(1) << (8 * len)) - 1;
+  word &= DATA_BITS;
+
+  word = ((word & APR_UINT64_C(0x7f007f007f007f00)) >> 1)
+       |  (word & APR_UINT64_C(0x007f007f007f007f));
+  word = ((word & APR_UINT64_C(0x3fff00003fff0000)) >> 2)
+       |  (word & APR_UINT64_C(0x00003fff00003fff));
+  word = ((word & APR_UINT64_C(0x0fffffff00000000)) >> 4)
+       |  (word & APR_UINT64_C(0x000000000fffffff));
+
+  return word;
+}
+
+#endif /* !APR_IS_BIGENDIAN */
+
+/* Decode a single LEB128 value from [P..END) into *VALUE.  Return the
+   position behind it, P if the value is incomplete, and NULL if it is
+   longer than SVN__MAX_ENCODED_UINT_LEN. */
+static const unsigned char *
+leb128_decode_one(apr_uint64_t *value,
+                  const unsigned char *p,
+                  const unsigned char *end)
+{
+  const unsigned char *start = p;
+  apr_uint64_t result = 0;
+  int shift = 0;
+
+  while (p < end)
+    {
+      unsigned int c = *p++;
+      if (shift < 64)
+        result |= (apr_uint64_t)(c & 0x7f) << shift;
+
+      if (c < 0x80)
+        {
+          *value = result;
+          return p;
+        }
+
+      shift += 7;
+      if (p - start == SVN__MAX_ENCODED_UINT_LEN)
+        return NULL;
+    }
+
+  return start;
+}
+
+unsigned char *
+svn__leb128_encode(unsigned char *p,
+                   const apr_uint64_t *values,
+                   apr_size_t count)
+{
+  apr_size_t i;
+
+  for (i = 0; i < count; ++i)
+    {
+      apr_uint64_t value = values[i];
+
+      if (value < 0x80)
+        {
+          /* By far the most frequent case. */
+          *p++ = (unsigned char)value;
+        }
+#if !APR_IS_BIGENDIAN
+      else if (value < APR_UINT64_C(0x0100000000000000))
+        {
+          /* Up to 8 bytes.  Write them all at once, setting the
+             continuation bit in all but the last one.  Since the buffer
+             has space for SVN__MAX_ENCODED_UINT_LEN bytes per value,
+             writing beyond the last byte is safe. */
+          int len = leb128_len(value);
+          apr_uint64_t word = spread_7b(value)
+                            | (APR_UINT64_C(0x8080808080808080)
+                               & ((APR_UINT64_C(1) << (8 * (len - 1))) - 1));
+
+          memcpy(p, &word, sizeof(word));
+          p += len;
+        }
+#endif
+      else
+        {
+          while (value >= 0x80)
+            {
+              *p++ = (unsigned char)((value & 0x7f) | 0x80);
+              value >>= 7;
+            }
+
+          *p++ = (unsigned char)value;
+        }
+    }
+
+  return p;
+}
+
+#if !APR_IS_BIGENDIAN
+
+/* Return a mask with bit I set iff byte I of the 16 bytes at P has its
+   continuation bit set. */
+static APR_INLINE apr_uint32_t
+continuation_mask(const unsigned char *p)
+{
+#if SVN__HAVE_SSE2
+  return (apr_uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+#else
+  /* Gather the high bits of each word's bytes in its top byte. */
+  const apr_uint64_t gather = APR_UINT64_C(0x0102040810204080);
+  apr_uint64_t low, high;
+
+  memcpy(&low, p, sizeof(low));
+  memcpy(&high, p + 8, sizeof(high));
+  low = (((low >> 7) & APR_UINT64_C(0x0101010101010101)) * gather) >> 56;
+  high = (((high >> 7) & APR_UINT64_C(0x0101010101010101)) * gather) >> 56;
+
+  return (apr_uint32_t)(low | (high << 8));
+#endif
+}
+
+#endif /* !APR_IS_BIGENDIAN */
+
+const unsigned char *
+svn__leb128_decode(apr_uint64_t *values,
+                   apr_size_t *ends,
+                   apr_size_t *count,
+                   const unsigned char *p,
+                   const unsigned char *end)
+{
+  const unsigned char *start = p;
+  apr_size_t n = 0;
+  apr_size_t max = *count;
+
+#if !APR_IS_BIGENDIAN
+  /* Find the value boundaries of 16 bytes at a time.  Walking them is a
+     short dependency chain, so the individual values can be decoded in
+     parallel by the CPU.  The 8 bytes behind the chunk must be readable
+     as well, because we load values as a whole. */
+  while (n < max && end - p >= 16 + 8)
+    {
+      apr_uint32_t mask = continuation_mask(p);
+      apr_uint32_t terminators = ~mask & 0xffff;
+      apr_size_t pos = 0;
+
+      if (mask == 0 && max - n >= 16)
+        {
+          /* Small numbers are frequent: 16 single-byte values. */
+          int k;
+          for (k = 0; k < 16; ++k)
+            values[n + k] = p[k];
+
+          if (ends)
+            for (k = 0; k < 16; ++k)
+              ends[n + k] = (p - start) + k + 1;
+
+          n += 16;
+          p += 16;
+          continue;
+        }
+
+      /* No value ends within 16 bytes. */
+      if (terminators == 0)
+        break;
+
+      while (terminators && n < max)
+        {
+          apr_size_t last = svn__lowest_bit_index(terminators);
+          apr_size_t len = last - pos + 1;
+
+          if (SVN__PREDICT_TRUE(len <= 8))
+            {
+              apr_uint64_t word;
+              memcpy(&word, p + pos, sizeof(word));
+              values[n] = compact_7b(word, (int)len);
+            }
+          else if (len <= SVN__MAX_ENCODED_UINT_LEN)
+            leb128_decode_one(&values[n], p + pos, end);
+          else
+            break;
+
+          pos = last + 1;
+          if (ends)
+            ends[n] = (p - start) + pos;
+          ++n;
+
+          terminators &= terminators - 1;
+        }
+
+      /* Corrupt values will be caught by the loop below. */
+      p += pos;
+      if (terminators && n < max)
+        break;
+    }
+#endif
+
+  while (n < max && p < end)
+    {
+      const unsigned char *next = leb128_decode_one(&values[n], p, end);
+      if (next == NULL)
+        {
+          *count = n;
+          return NULL;
+        }
+      if (next == p)
+        break;
+
+      p = next;
+      if (ends)
+        ends[n] = p - start;
+      ++n;
+    }
+
+  *count = n;
+  return p;
+}
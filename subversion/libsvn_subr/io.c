@@ -69,6 +69,19 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_dep_compat.h"
 
+/* Only Linux provides the copy_file_range() and sendfile() variants used
+ * below; FreeBSD and Solaris have functions of the same names with
+ * different signatures and semantics. */
+#if defined(__linux__) \
+    && (defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE))
+#define SVN__HAVE_KERNEL_COPY
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
+#endif
+
 #define SVN_SLEEP_ENV_VAR "SVN_I_LOVE_CORRUPTED_WORKING_COPIES_SO_DISABLE_SLEEP_FOR_TIMESTAMPS"
 
 /*
@@ -874,6 +887,167 @@ copy_contents(apr_file_t *from_file,
   /* NOTREACHED */
 }
 
+#ifdef SVN__HAVE_KERNEL_COPY
+
+/* Maximum number of bytes to copy in a single system call.  This limits
+ * the time between calls to the cancellation function. */
+#define KERNEL_COPY_CHUNK_SIZE (16 * 1024 * 1024)
+
+/* Return TRUE if ERRNO_VAL, reported by copy_file_range() or sendfile(),
+ * indicates that the files or the kernel don't support this kind of copy,
+ * as opposed to an actual I/O error. */
+static svn_boolean_t
+kernel_copy_unsupported(int errno_val)
+{
+  switch (errno_val)
+    {
+      case ENOSYS:
+      case EXDEV:
+      case EINVAL:
+      case EBADF:
+#ifdef EOPNOTSUPP
+      case EOPNOTSUPP:
+#endif
+#if defined(ENOTSUP) && (!defined(EOPNOTSUPP) || ENOTSUP != EOPNOTSUPP)
+      case ENOTSUP:
+#endif
+        return TRUE;
+
+      default:
+        return FALSE;
+    }
+}
+
+#endif
+
+svn_error_t *
+svn_io__file_copy_in_kernel(svn_boolean_t *copied,
+                            apr_file_t *from_file,
+                            apr_file_t *to_file,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+#ifdef SVN__HAVE_KERNEL_COPY
+  apr_os_file_t from_fd, to_fd;
+  struct stat from_stat, to_stat;
+  apr_off_t from_offset, to_offset;
+  off_t from_pos, to_pos;
+  svn_boolean_t use_sendfile = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  *copied = FALSE;
+
+  /* The kernel would bypass APR's append logic. */
+  if (apr_file_flags_get(to_file) & APR_FOPEN_APPEND)
+    return SVN_NO_ERROR;
+
+  if (apr_os_file_get(&from_fd, from_file)
+      || apr_os_file_get(&to_fd, to_file))
+    return SVN_NO_ERROR;
+
+  /* Pipes, sockets and devices have no usable file offsets. */
+  if (fstat(from_fd, &from_stat) || fstat(to_fd, &to_stat)
+      || !S_ISREG(from_stat.st_mode) || !S_ISREG(to_stat.st_mode))
+    return SVN_NO_ERROR;
+
+  /* Logical positions as seen through APR's buffers.  This flushes any
+   * data buffered for writing. */
+  SVN_ERR(svn_io_file_get_offset(&from_offset, from_file, scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&to_offset, to_file, scratch_pool));
+  from_pos = from_offset;
+  to_pos = to_offset;
+
+#ifndef HAVE_COPY_FILE_RANGE
+  use_sendfile = TRUE;
+  if (lseek(to_fd, to_pos, SEEK_SET) < 0)
+    return SVN_NO_ERROR;
+#endif
+
+  while (TRUE)
+    {
+      ssize_t bytes_copied = -1;
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+#ifdef HAVE_COPY_FILE_RANGE
+      if (!use_sendfile)
+        bytes_copied = copy_file_range(from_fd, &from_pos, to_fd, &to_pos,
+                                       KERNEL_COPY_CHUNK_SIZE, 0);
+#endif
+#ifdef HAVE_SENDFILE
+      if (use_sendfile)
+        {
+          /* sendfile() writes at the current position of TO_FD. */
+          off_t sendfile_pos = from_pos;
+          bytes_copied = sendfile(to_fd, from_fd, &sendfile_pos,
+                                  KERNEL_COPY_CHUNK_SIZE);
+          if (bytes_copied > 0)
+            {
+              from_pos += bytes_copied;
+              to_pos += bytes_copied;
+            }
+        }
+#endif
+
+      if (bytes_copied == 0)
+        {
+          *copied = TRUE;
+          break;
+        }
+
+      if (bytes_copied < 0)
+        {
+          int errno_val = errno;
+
+          if (errno_val == EINTR)
+            continue;
+
+          if (!kernel_copy_unsupported(errno_val))
+            {
+              err = svn_error_wrap_apr(APR_FROM_OS_ERROR(errno_val),
+                                       _("Can't copy file contents"));
+              break;
+            }
+
+#ifdef HAVE_SENDFILE
+          /* copy_file_range() may refuse e.g. to copy across file systems
+           * on older kernels, while sendfile() has no such restriction. */
+          if (!use_sendfile && lseek(to_fd, to_pos, SEEK_SET) >= 0)
+            {
+              use_sendfile = TRUE;
+              continue;
+            }
+#endif
+
+          /* Leave the remainder to the caller. */
+          break;
+        }
+    }
+
+  /* Make APR's view of the file positions reflect what we copied. */
+  from_offset = from_pos;
+  to_offset = to_pos;
+  err = svn_error_compose_create(err,
+                                 svn_io_file_seek(from_file, APR_SET,
+                                                  &from_offset,
+                                                  scratch_pool));
+  err = svn_error_compose_create(err,
+                                 svn_io_file_seek(to_file, APR_SET,
+                                                  &to_offset, scratch_pool));
+
+  return svn_error_trace(err);
+#else
+  *copied = FALSE;
+  return SVN_NO_ERROR;
+#endif
+}
+
 
 svn_error_t *
 svn_io_copy_file(const char *src,
@@ -884,6 +1058,7 @@ svn_io_copy_file(const char *src,
   apr_file_t *from_file, *to_file;
   apr_status_t apr_err;
   const char *dst_tmp;
+  svn_boolean_t copied;
   svn_error_t *err;
 
   /* ### NOTE: sometimes src == dst. In this case, because we copy to a
@@ -914,16 +1089,16 @@ svn_io_copy_file(const char *src,
                                    svn_dirent_dirname(dst, pool),
                                    svn_io_file_del_none, pool, pool));
 
-  apr_err = copy_contents(from_file, to_file, pool);
-
-  if (apr_err)
+  err = svn_io__file_copy_in_kernel(&copied, from_file, to_file,
+                                    NULL, NULL, pool);
+  if (!err && !copied)
     {
-      err = svn_error_wrap_apr(apr_err, _("Can't copy '%s' to '%s'"),
-                               svn_dirent_local_style(src, pool),
-                               svn_dirent_local_style(dst_tmp, pool));
+      apr_err = copy_contents(from_file, to_file, pool);
+      if (apr_err)
+        err = svn_error_wrap_apr(apr_err, _("Can't copy '%s' to '%s'"),
+                                 svn_dirent_local_style(src, pool),
+                                 svn_dirent_local_style(dst_tmp, pool));
     }
-   else
-     err = NULL;
 
   err = svn_error_compose_create(err,
                                  svn_io_file_close(from_file, pool));
@@ -2814,6 +2989,15 @@ svn_io_dirent2_dup(const svn_io_dirent2_t *item,
                      sizeof(*item));
 }
 
+/* Number of entries that svn_io_get_dirents3() reads the usual way
+ * before it switches to batched stat requests. */
+#define DIRENTS_BATCH_THRESHOLD 32
+
+/* Maximum number of stat requests in flight and per batch in
+ * svn_io_get_dirents3(). */
+#define DIRENTS_BATCH_DEPTH 64
+#define DIRENTS_BATCH_SIZE 1024
+
 svn_error_t *
 svn_io_get_dirents3(apr_hash_t **dirents,
                     const char *path,
@@ -2825,6 +3009,8 @@ svn_io_get_dirents3(apr_hash_t **dirents,
   apr_dir_t *this_dir;
   apr_finfo_t this_entry;
   apr_int32_t flags = APR_FINFO_TYPE | APR_FINFO_NAME;
+  svn_io__batch_t *batch = NULL;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
   if (!only_check_type)
     flags |= APR_FINFO_SIZE | APR_FINFO_MTIME;
@@ -2849,19 +3035,45 @@ svn_io_get_dirents3(apr_hash_t **dirents,
           const char *name;
           svn_io_dirent2_t *dirent = svn_io_dirent2_create(result_pool);
 
+          svn_pool_clear(iterpool);
           SVN_ERR(entry_name_to_utf8(&name, this_entry.name, path, result_pool));
 
-          map_apr_finfo_to_node_kind(&(dirent->kind),
-                                     &(dirent->special),
-                                     &this_entry);
-
-          if (!only_check_type)
+          if (batch)
             {
-              dirent->filesize = this_entry.size;
-              dirent->mtime = this_entry.mtime;
+              /* The directory read only gave us the name. */
+              SVN_ERR(svn_io__batch_stat(batch, dirent,
+                                         svn_dirent_join(path, name,
+                                                         iterpool)));
+              if (svn_io__batch_size(batch) >= DIRENTS_BATCH_SIZE)
+                SVN_ERR(svn_io__batch_run(batch, iterpool));
+            }
+          else
+            {
+              map_apr_finfo_to_node_kind(&(dirent->kind),
+                                         &(dirent->special),
+                                         &this_entry);
+
+              if (!only_check_type)
+                {
+                  dirent->filesize = this_entry.size;
+                  dirent->mtime = this_entry.mtime;
+                }
             }
 
           svn_hash_sets(*dirents, name, dirent);
+
+          /* In large directories, stat the remaining entries in batches
+           * instead of letting apr_dir_read() stat them one by one. */
+          if (!only_check_type && !batch
+              && apr_hash_count(*dirents) == DIRENTS_BATCH_THRESHOLD)
+            {
+              SVN_ERR(svn_io__batch_create(&batch, DIRENTS_BATCH_DEPTH,
+                                           scratch_pool));
+              if (svn_io__batch_is_async(batch))
+                flags = APR_FINFO_TYPE | APR_FINFO_NAME;
+              else
+                batch = NULL;
+            }
         }
     }
 
@@ -2874,6 +3086,23 @@ svn_io_get_dirents3(apr_hash_t **dirents,
     return svn_error_wrap_apr(status, _("Error closing directory '%s'"),
                               svn_dirent_local_style(path, scratch_pool));
 
+  if (batch)
+    {
+      apr_hash_index_t *hi;
+
+      SVN_ERR(svn_io__batch_run(batch, iterpool));
+
+      /* Drop entries that got removed while we were reading. */
+      for (hi = apr_hash_first(iterpool, *dirents); hi; hi = apr_hash_next(hi))
+        {
+          const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+          if (dirent->kind == svn_node_none)
+            svn_hash_sets(*dirents, apr_hash_this_key(hi), NULL);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
@@ -0,0 +1,715 @@
+/*
+ * io_batch.c :  batched, asynchronous file system requests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_file_io.h>
+#include <apr_portable.h>
+#include <apr_strings.h>
+
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_io_private.h"
+#include "private/svn_mutex.h"
+
+#include "pools.h"
+
+/* On Linux, we talk to io_uring directly through its system calls.
+ * Headers that define IO_URING_OP_SUPPORTED (5.6+) also know about
+ * IORING_OP_STATX.  Whether the running kernel supports it gets probed
+ * when creating an io_uring instance. */
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__GNUC__)
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) \
+ && defined(__NR_io_uring_register) && defined(IO_URING_OP_SUPPORTED) \
+ && defined(STATX_BASIC_STATS)
+#define SVN__HAVE_IO_URING
+#endif
+#endif
+
+/* Kinds of requests in a batch. */
+typedef enum request_kind_t
+{
+  request_read,
+  request_stat
+} request_kind_t;
+
+/* A single request in a batch. */
+typedef struct request_t
+{
+  request_kind_t kind;
+
+  /* Read requests: read up to SIZE bytes at OFFSET in FILE into BUFFER.
+   * DONE is the number of bytes read so far and will be reported back
+   * in *BYTES_READ. */
+  apr_file_t *file;
+  apr_os_file_t fd;
+  apr_off_t offset;
+  char *buffer;
+  apr_size_t size;
+  apr_size_t done;
+  apr_size_t *bytes_read;
+
+  /* Stat requests: lstat() PATH, which is PATH_APR in native encoding,
+   * and store the result in *DIRENT. */
+  const char *path;
+  const char *path_apr;
+  svn_io_dirent2_t *dirent;
+
+  /* Set if the request still has to be executed synchronously. */
+  svn_boolean_t sync;
+
+#ifdef SVN__HAVE_IO_URING
+  /* Buffers that the kernel accesses while the request is in flight. */
+  struct iovec iov;
+  struct statx stx;
+#endif
+} request_t;
+
+#ifdef SVN__HAVE_IO_URING
+
+/* Maximum number of idle io_uring instances kept for reuse. */
+#define RING_CACHE_SIZE 8
+
+/* An io_uring instance with its memory-mapped queues.  Allocated with
+ * malloc(), since idle instances outlive the batches using them. */
+typedef struct ring_t
+{
+  int fd;
+
+  /* Depth requested when creating the ring and the process that created
+   * it.  A forked child must not share the queues with its parent. */
+  unsigned depth;
+  pid_t pid;
+
+  /* Number of submission queue entries. */
+  unsigned entries;
+
+  /* Submission queue. */
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+
+  /* Completion queue. */
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+
+  /* Mappings to release.  CQ_RING may be the same as SQ_RING. */
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+} ring_t;
+
+#endif
+
+struct svn_io__batch_t
+{
+  /* Requests added since the last run, in order.  Elements are
+   * request_t *. */
+  apr_array_header_t *requests;
+
+  /* Pool for REQUESTS and their contents.  Cleared after each run. */
+  apr_pool_t *request_pool;
+
+#ifdef SVN__HAVE_IO_URING
+  /* Our io_uring instance.  RING is NULL, if the kernel does not
+   * support io_uring or we may not use it. */
+  ring_t *ring;
+#endif
+};
+
+#ifdef SVN__HAVE_IO_URING
+
+/* Setting up an io_uring instance and mapping its queues takes several
+ * system calls, which costs more than batching the stat calls of a
+ * moderately sized directory saves.  Therefore, batches return their
+ * instance to this process-wide cache, and later batches take it from
+ * there.  RING_CACHE_MUTEX serializes access to RING_CACHE. */
+static ring_t *ring_cache[RING_CACHE_SIZE];
+static int ring_cache_count = 0;
+static svn_mutex__t *ring_cache_mutex = NULL;
+static volatile svn_atomic_t ring_cache_init_state = 0;
+
+/* Release RING and all its kernel resources. */
+static void
+ring_destroy(ring_t *ring)
+{
+  if (ring->sqes != MAP_FAILED)
+    munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  if (ring->sq_ring != MAP_FAILED)
+    munmap(ring->sq_ring, ring->sq_ring_size);
+
+  /* Closing the ring waits for or cancels all requests in flight. */
+  close(ring->fd);
+  free(ring);
+}
+
+/* Return TRUE if the kernel behind the io_uring instance FD supports
+ * IORING_OP_STATX.  Kernels that don't know the probe operation don't
+ * support STATX either. */
+static svn_boolean_t
+ring_supports_statx(int fd)
+{
+  enum { PROBE_OPS = IORING_OP_STATX + 1 };
+  struct io_uring_probe *probe;
+  svn_boolean_t supported;
+
+  probe = calloc(1, sizeof(*probe)
+                    + PROBE_OPS * sizeof(struct io_uring_probe_op));
+  if (probe == NULL)
+    return FALSE;
+
+  supported = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE,
+                      probe, PROBE_OPS) >= 0
+           && probe->last_op >= IORING_OP_STATX
+           && (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+
+  free(probe);
+  return supported;
+}
+
+/* Return a new io_uring instance with DEPTH submission queue entries,
+ * or NULL if io_uring is not available or can't do STATX requests.
+ * In the latter case, stat requests are better executed synchronously
+ * than being bounced back by the kernel one by one. */
+static ring_t *
+ring_create(unsigned depth)
+{
+  struct io_uring_params params;
+  ring_t *ring;
+  char *sq;
+  char *cq;
+  int fd;
+
+  memset(&params, 0, sizeof(params));
+  fd = (int)syscall(__NR_io_uring_setup, depth, &params);
+
+  /* ENOSYS, EPERM (e.g. seccomp or sysctl) and friends. */
+  if (fd < 0)
+    return NULL;
+
+  /* Compiled against newer headers than the kernel we run on? */
+  if (!ring_supports_statx(fd))
+    {
+      close(fd);
+      return NULL;
+    }
+
+  ring = calloc(1, sizeof(*ring));
+  if (ring == NULL)
+    {
+      close(fd);
+      return NULL;
+    }
+
+  ring->fd = fd;
+  ring->depth = depth;
+  ring->pid = getpid();
+  ring->entries = params.sq_entries;
+  ring->sq_ring = MAP_FAILED;
+  ring->cq_ring = MAP_FAILED;
+  ring->sqes = MAP_FAILED;
+
+  ring->sq_ring_size = params.sq_off.array
+                     + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = params.cq_off.cqes
+                     + params.cq_entries * sizeof(struct io_uring_cqe);
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      ring->sq_ring_size = MAX(ring->sq_ring_size, ring->cq_ring_size);
+      ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED)
+    {
+      ring_destroy(ring);
+      return NULL;
+    }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    ring->cq_ring = ring->sq_ring;
+  else
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+  if (ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+      ring_destroy(ring);
+      return NULL;
+    }
+
+  sq = ring->sq_ring;
+  ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+  ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+
+  cq = ring->cq_ring;
+  ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+  return ring;
+}
+
+/* Implements svn_atomic__err_init_func_t.  Initialize RING_CACHE_MUTEX. */
+static svn_error_t *
+init_ring_cache(void *baton,
+                apr_pool_t *scratch_pool)
+{
+  /* The mutex must live as long as the process. */
+  return svn_error_trace(svn_mutex__init(&ring_cache_mutex, TRUE,
+                                         svn_pool__create_unmanaged(FALSE)));
+}
+
+/* Set *RING to an idle instance with DEPTH entries from the cache and
+ * remove it from there.  Set it to NULL if there is none.  Destroy any
+ * instances that have been inherited from a parent process. */
+static svn_error_t *
+take_cached_ring(ring_t **ring,
+                 unsigned depth)
+{
+  pid_t pid = getpid();
+  int i;
+
+  *ring = NULL;
+  for (i = ring_cache_count - 1; i >= 0; --i)
+    {
+      ring_t *candidate = ring_cache[i];
+
+      if (candidate->pid != pid)
+        ring_destroy(candidate);
+      else if (candidate->depth == depth && *ring == NULL)
+        *ring = candidate;
+      else
+        continue;
+
+      ring_cache[i] = ring_cache[--ring_cache_count];
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *RING to an io_uring instance with DEPTH entries, preferably taken
+ * from the cache, or to NULL if io_uring is not available.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+acquire_ring(ring_t **ring,
+             unsigned depth,
+             apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_atomic__init_once(&ring_cache_init_state, init_ring_cache,
+                                NULL, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(ring_cache_mutex, take_cached_ring(ring, depth));
+
+  if (*ring == NULL)
+    *ring = ring_create(depth);
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function returning the io_uring instance of the
+ * svn_io__batch_t given as DATA to the cache, or destroying it if the
+ * cache is full. */
+static apr_status_t
+release_ring(void *data)
+{
+  svn_io__batch_t *batch = data;
+  ring_t *ring = batch->ring;
+  svn_error_t *err;
+
+  if (ring == NULL)
+    return APR_SUCCESS;
+
+  batch->ring = NULL;
+  err = svn_mutex__lock(ring_cache_mutex);
+  if (!err)
+    {
+      if (ring_cache_count < RING_CACHE_SIZE)
+        {
+          ring_cache[ring_cache_count++] = ring;
+          ring = NULL;
+        }
+
+      err = svn_mutex__unlock(ring_cache_mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+  if (ring)
+    ring_destroy(ring);
+
+  return APR_SUCCESS;
+}
+
+/* Put the remainder of REQUEST into the submission queue of RING.
+ * The caller must make sure that the queue is not full. */
+static void
+ring_push(ring_t *ring,
+          request_t *request)
+{
+  unsigned tail = *ring->sq_tail;
+  unsigned index = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+
+  memset(sqe, 0, sizeof(*sqe));
+  if (request->kind == request_read)
+    {
+      request->iov.iov_base = request->buffer + request->done;
+      request->iov.iov_len = request->size - request->done;
+
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = request->fd;
+      sqe->off = request->offset + request->done;
+      sqe->addr = (apr_uintptr_t)&request->iov;
+      sqe->len = 1;
+    }
+  else
+    {
+      sqe->opcode = IORING_OP_STATX;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (apr_uintptr_t)request->path_apr;
+      sqe->len = STATX_BASIC_STATS;
+      sqe->off = (apr_uintptr_t)&request->stx;
+      sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+    }
+
+  sqe->user_data = (apr_uintptr_t)request;
+  ring->sq_array[index] = index;
+
+  /* Publish the entry to the kernel. */
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* Process the completion of REQUEST with the io_uring result code RES.
+ * Push REQUEST onto the PENDING stack, if it needs to be resubmitted. */
+static void
+complete_request(request_t *request,
+                 int res,
+                 apr_array_header_t *pending)
+{
+  if (request->kind == request_read)
+    {
+      if (res > 0)
+        {
+          /* Short reads may happen even before EOF.  Continue reading
+           * until we hit EOF or the buffer is full. */
+          request->done += res;
+          if (request->done < request->size)
+            APR_ARRAY_PUSH(pending, request_t *) = request;
+        }
+      else if (res < 0)
+        {
+          /* Let the synchronous code produce the proper error. */
+          request->sync = TRUE;
+        }
+    }
+  else if (res == 0)
+    {
+      const struct statx *stx = &request->stx;
+      svn_io_dirent2_t *dirent = request->dirent;
+
+      dirent->special = FALSE;
+      if (S_ISREG(stx->stx_mode))
+        dirent->kind = svn_node_file;
+      else if (S_ISDIR(stx->stx_mode))
+        dirent->kind = svn_node_dir;
+      else if (S_ISLNK(stx->stx_mode))
+        {
+          dirent->special = TRUE;
+          dirent->kind = svn_node_file;
+        }
+      else
+        dirent->kind = svn_node_unknown;
+
+      dirent->filesize = stx->stx_size;
+      dirent->mtime = apr_time_make(stx->stx_mtime.tv_sec,
+                                    stx->stx_mtime.tv_nsec / 1000);
+    }
+  else if (res == -ENOENT || res == -ENOTDIR)
+    {
+      request->dirent->kind = svn_node_none;
+      request->dirent->special = FALSE;
+      request->dirent->filesize = SVN_INVALID_FILESIZE;
+      request->dirent->mtime = 0;
+    }
+  else
+    {
+      request->sync = TRUE;
+    }
+}
+
+/* Execute all requests of BATCH through its io_uring instance, keeping
+ * the submission queue as full as possible.  Requests that fail or can't
+ * be handled by the kernel will be marked for synchronous execution.
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+run_ring(svn_io__batch_t *batch,
+         apr_pool_t *scratch_pool)
+{
+  ring_t *ring = batch->ring;
+  apr_array_header_t *pending
+    = apr_array_make(scratch_pool, batch->requests->nelts,
+                     sizeof(request_t *));
+  unsigned in_flight = 0;
+  unsigned unsubmitted = 0;
+  int i;
+
+  /* PENDING is a stack.  Put the first request on top. */
+  for (i = batch->requests->nelts - 1; i >= 0; --i)
+    APR_ARRAY_PUSH(pending, request_t *)
+      = APR_ARRAY_IDX(batch->requests, i, request_t *);
+
+  while (pending->nelts || in_flight)
+    {
+      unsigned head, tail;
+      long rc;
+
+      while (pending->nelts && in_flight < ring->entries)
+        {
+          ring_push(ring, *(request_t **)apr_array_pop(pending));
+          ++unsubmitted;
+          ++in_flight;
+        }
+
+      rc = syscall(__NR_io_uring_enter, ring->fd, unsubmitted, 1,
+                   IORING_ENTER_GETEVENTS, NULL, 0);
+      if (rc >= 0)
+        {
+          unsubmitted -= (unsigned)rc;
+        }
+      else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+          /* Give up on the ring.  Tearing it down makes sure that the
+           * kernel won't touch our buffers anymore.  Whatever has not
+           * completed yet will be done synchronously. */
+          for (i = 0; i < batch->requests->nelts; ++i)
+            APR_ARRAY_IDX(batch->requests, i, request_t *)->sync = TRUE;
+
+          ring_destroy(ring);
+          batch->ring = NULL;
+          return;
+        }
+
+      head = *ring->cq_head;
+      tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+      while (head != tail)
+        {
+          struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+
+          complete_request((request_t *)(apr_uintptr_t)cqe->user_data,
+                           cqe->res, pending);
+          ++head;
+          --in_flight;
+        }
+
+      __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+
+#endif
+
+/* Execute REQUEST synchronously.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+run_sync(request_t *request,
+         apr_pool_t *scratch_pool)
+{
+  if (request->kind == request_read)
+    {
+      apr_off_t offset = request->offset + request->done;
+      apr_size_t bytes_read;
+      svn_boolean_t eof;
+
+      SVN_ERR(svn_io_file_seek(request->file, APR_SET, &offset,
+                               scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(request->file,
+                                     request->buffer + request->done,
+                                     request->size - request->done,
+                                     &bytes_read, &eof, scratch_pool));
+      request->done += bytes_read;
+    }
+  else
+    {
+      const svn_io_dirent2_t *dirent;
+
+      SVN_ERR(svn_io_stat_dirent2(&dirent, request->path, FALSE, TRUE,
+                                  scratch_pool, scratch_pool));
+      *request->dirent = *dirent;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_io__batch_create(svn_io__batch_t **batch,
+                     int depth,
+                     apr_pool_t *result_pool)
+{
+  svn_io__batch_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->request_pool = svn_pool_create(result_pool);
+  result->requests = apr_array_make(result->request_pool, 16,
+                                    sizeof(request_t *));
+
+#ifdef SVN__HAVE_IO_URING
+  if (depth > 1)
+    {
+      SVN_ERR(acquire_ring(&result->ring, depth, result_pool));
+      if (result->ring)
+        apr_pool_cleanup_register(result_pool, result, release_ring,
+                                  apr_pool_cleanup_null);
+    }
+#endif
+
+  *batch = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_io__batch_is_async(svn_io__batch_t *batch)
+{
+#ifdef SVN__HAVE_IO_URING
+  return batch->ring != NULL;
+#else
+  return FALSE;
+#endif
+}
+
+int
+svn_io__batch_size(svn_io__batch_t *batch)
+{
+  return batch->requests->nelts;
+}
+
+svn_error_t *
+svn_io__batch_read(svn_io__batch_t *batch,
+                   apr_file_t *file,
+                   apr_off_t offset,
+                   void *buffer,
+                   apr_size_t size,
+                   apr_size_t *bytes_read)
+{
+  request_t *request = apr_pcalloc(batch->request_pool, sizeof(*request));
+  apr_status_t status;
+
+  request->kind = request_read;
+  request->file = file;
+  request->offset = offset;
+  request->buffer = buffer;
+  request->size = size;
+  request->bytes_read = bytes_read;
+
+  status = apr_os_file_get(&request->fd, file);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get file handle"));
+
+  APR_ARRAY_PUSH(batch->requests, request_t *) = request;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_io__batch_stat(svn_io__batch_t *batch,
+                   svn_io_dirent2_t *dirent,
+                   const char *path)
+{
+  request_t *request = apr_pcalloc(batch->request_pool, sizeof(*request));
+
+  request->kind = request_stat;
+  request->path = apr_pstrdup(batch->request_pool, path);
+  request->dirent = dirent;
+  SVN_ERR(svn_path_cstring_from_utf8(&request->path_apr,
+                                     path[0] ? path : ".",
+                                     batch->request_pool));
+
+  APR_ARRAY_PUSH(batch->requests, request_t *) = request;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_io__batch_run(svn_io__batch_t *batch,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t all_sync = TRUE;
+  int i;
+
+#ifdef SVN__HAVE_IO_URING
+  if (batch->ring)
+    {
+      run_ring(batch, iterpool);
+      all_sync = FALSE;
+    }
+#endif
+
+  for (i = 0; i < batch->requests->nelts; ++i)
+    {
+      request_t *request = APR_ARRAY_IDX(batch->requests, i, request_t *);
+
+      svn_pool_clear(iterpool);
+      if ((all_sync || request->sync) && !err)
+        err = run_sync(request, iterpool);
+
+      if (request->kind == request_read)
+        *request->bytes_read = request->done;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  svn_pool_clear(batch->request_pool);
+  batch->requests = apr_array_make(batch->request_pool, 16,
+                                   sizeof(request_t *));
+
+  return svn_error_trace(err);
+}
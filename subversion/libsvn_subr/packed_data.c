@@ -362,8 +362,7 @@ data_flush_buffer(svn_packed__int_stream_t *stream)
           = svn_stringbuf_create_ensure(256, private_data->pool);
 
       /* encode numbers into our temp buffer. */
-      for (i = 0; i < stream->buffer_used; ++i)
-        p = write_packed_uint_body(p, stream->buffer[i]);
+      p = svn__leb128_encode(p, stream->buffer, stream->buffer_used);
 
       /* append them to the final packed data */
       svn_stringbuf_appendbytes(private_data->packed,
@@ -800,31 +799,32 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
       }
   else
     {
-      /* use this local buffer only if the packed data is shorter than this.
-         The goal is that read_packed_uint_body doesn't need check for
-         overflows. */
-      unsigned char local_buffer[10 * SVN__PACKED_DATA_BUFFER_SIZE];
-      unsigned char *p;
-      unsigned char *start;
+      const unsigned char *start
+        = (const unsigned char *)private_data->packed->data;
+      const unsigned char *p;
+      apr_size_t count = end;
       apr_size_t packed_read;
 
-      if (private_data->packed->len < sizeof(local_buffer))
-        {
-          apr_size_t trail = sizeof(local_buffer) - private_data->packed->len;
-          memcpy(local_buffer,
-                 private_data->packed->data,
-                 private_data->packed->len);
-          memset(local_buffer + private_data->packed->len, 0, MIN(trail, end));
+      /* unpack numbers in bulk */
+      p = svn__leb128_decode(stream->buffer, NULL, &count, start,
+                             start + private_data->packed->len);
 
-          p = local_buffer;
+      /* corrupted or truncated data.  Return 0 for the missing numbers
+         and consume everything. */
+      if (p == NULL || count < end)
+        {
+          memset(stream->buffer + count, 0,
+                 (end - count) * sizeof(stream->buffer[0]));
+          p = start + private_data->packed->len;
         }
-      else
-        p = (unsigned char *)private_data->packed->data;
 
-      /* unpack numbers */
-      start = p;
-      for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
+      /* we hand out numbers from the end of the buffer */
+      for (i = 0; i < end / 2; ++i)
+        {
+          apr_uint64_t temp = stream->buffer[i];
+          stream->buffer[i] = stream->buffer[end - 1 - i];
+          stream->buffer[end - 1 - i] = temp;
+        }
 
       /* adjust remaining packed data buffer */
       packed_read = p - start;
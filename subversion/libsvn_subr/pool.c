@@ -25,20 +25,27 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <apr.h>
 #include <apr_version.h>
 #include <apr_general.h>
 #include <apr_pools.h>
+#include <apr_signal.h>
 
 #include "svn_pools.h"
+#include "private/svn_subr_private.h"
 
 #include "pools.h"
+#include "profile.h"
+#include "svn_private_config.h"
+
+#ifdef HAVE_MALLINFO2
+#include <malloc.h>
+#endif
 
-#if APR_POOL_DEBUG
 /* file_line for the non-debug case. */
 static const char SVN_FILE_LINE_UNDEFINED[] = "svn:<undefined>";
-#endif /* APR_POOL_DEBUG */
 
 
 
@@ -66,37 +73,346 @@ abort_on_pool_failure(int retcode)
 }
 
 
-#if APR_POOL_DEBUG
-#undef svn_pool_create_ex
-#endif /* APR_POOL_DEBUG */
 
-#if !APR_POOL_DEBUG
+/*
+ * apr_pool_create_core_ex was introduced in APR 1.3.0, then
+ * deprecated and renamed to apr_pool_create_unmanaged_ex in 1.3.3.
+ * Since our minimum requirement is APR 1.3.0, one or the other of
+ * these functions will always be available.
+ */
+#if !APR_VERSION_AT_LEAST(1,3,3)
+#define apr_pool_create_unmanaged_ex apr_pool_create_core_ex
+#endif
+
 
-apr_pool_t *
-svn_pool_create_ex(apr_pool_t *parent_pool, apr_allocator_t *allocator)
+/*** Pool allocation profiling. ***/
+
+/* Number of buckets in the tag hash table. */
+#define TAG_BUCKETS 1024
+
+/* Userdata key under which pools keep their pool_record_t. */
+#define PROFILE_KEY "svn-pool-profile"
+
+/* Allocation statistics for all pools created at the same source
+   location. */
+typedef struct pool_tag_t
 {
+  /* Creating source location, as in APR_POOL__FILE_LINE__. */
+  const char *file_line;
+
+  /* Next tag in the same hash bucket. */
+  struct pool_tag_t *next;
+
+  /* Number of pools created and of cycles completed.  A cycle ends
+     whenever a pool gets cleared or destroyed. */
+  apr_uint64_t created;
+  apr_uint64_t cycles;
+
+  /* Number of pools currently alive and the maximum of that. */
+  apr_uint64_t live;
+  apr_uint64_t live_peak;
+
+  /* Sum and maximum of the bytes allocated per cycle. */
+  apr_uint64_t bytes_total;
+  apr_uint64_t bytes_peak;
+
+  /* Sum and maximum of the cycle lifetimes. */
+  apr_interval_time_t lifetime_total;
+  apr_interval_time_t lifetime_max;
+} pool_tag_t;
+
+/* Per-pool data.  Allocated in the pool it describes. */
+typedef struct pool_record_t
+{
+  pool_tag_t *tag;
   apr_pool_t *pool;
-  apr_pool_create_ex(&pool, parent_pool, abort_on_pool_failure, allocator);
-  return pool;
+
+  /* Start of the current cycle and heap usage at that time. */
+  apr_time_t start;
+  apr_size_t heap_start;
+
+  /* Set while svn_pool__clear() is running for POOL. */
+  svn_boolean_t clearing;
+} pool_record_t;
+
+/* State of the pool allocation profiler. */
+static svn_profile__t profile
+  = { FALSE, NULL, NULL, svn_pool__profile_report };
+
+/* Tag hash table, allocated with malloc() so that we never have to
+   allocate from pools while creating pools. */
+static pool_tag_t *tag_buckets[TAG_BUCKETS];
+
+/* Set by the signal handler when a report has been requested. */
+static volatile sig_atomic_t report_requested = FALSE;
+
+/* Return the number of bytes currently allocated from the heap by the
+   whole process, or 0 if we can't tell. */
+static apr_size_t
+heap_in_use(void)
+{
+#if defined(HAVE_MALLINFO2) && !APR_POOL_DEBUG
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
 }
 
-/* Wrapper that ensures binary compatibility */
-apr_pool_t *
-svn_pool_create_ex_debug(apr_pool_t *pool, apr_allocator_t *allocator,
-                         const char *file_line)
+/* Return the tag for FILE_LINE, creating it if necessary.  The caller
+   must hold the profiling lock. */
+static pool_tag_t *
+get_tag(const char *file_line)
+{
+  apr_uint32_t hash = 0;
+  const char *p;
+  pool_tag_t *tag;
+
+  for (p = file_line; *p; ++p)
+    hash = hash * 33 + (unsigned char)*p;
+
+  for (tag = tag_buckets[hash % TAG_BUCKETS]; tag; tag = tag->next)
+    if (tag->file_line == file_line || strcmp(tag->file_line, file_line) == 0)
+      return tag;
+
+  tag = calloc(1, sizeof(*tag));
+  if (tag == NULL)
+    return NULL;
+
+  tag->file_line = file_line;
+  tag->next = tag_buckets[hash % TAG_BUCKETS];
+  tag_buckets[hash % TAG_BUCKETS] = tag;
+
+  return tag;
+}
+
+/* Pool cleanup function ending the cycle of the pool_record_t in DATA. */
+static apr_status_t
+end_cycle(void *data)
+{
+  pool_record_t *record = data;
+  pool_tag_t *tag = record->tag;
+  apr_interval_time_t lifetime = apr_time_now() - record->start;
+  apr_size_t bytes;
+
+#if APR_POOL_DEBUG
+  bytes = apr_pool_num_bytes(record->pool, FALSE);
+#else
+  bytes = heap_in_use();
+  bytes = bytes > record->heap_start ? bytes - record->heap_start : 0;
+#endif
+
+  svn_profile__lock(&profile);
+
+  ++tag->cycles;
+  if (!record->clearing)
+    --tag->live;
+
+  tag->bytes_total += bytes;
+  if (bytes > tag->bytes_peak)
+    tag->bytes_peak = bytes;
+
+  tag->lifetime_total += lifetime;
+  if (lifetime > tag->lifetime_max)
+    tag->lifetime_max = lifetime;
+
+  svn_profile__unlock(&profile);
+
+  return APR_SUCCESS;
+}
+
+/* Start a new cycle for POOL, attributing it to TAG. */
+static void
+begin_cycle(apr_pool_t *pool,
+            pool_tag_t *tag)
+{
+  pool_record_t *record = apr_pcalloc(pool, sizeof(*record));
+
+  record->tag = tag;
+  record->pool = pool;
+  record->start = apr_time_now();
+  record->heap_start = heap_in_use();
+
+  apr_pool_userdata_setn(record, PROFILE_KEY, NULL, pool);
+  apr_pool_cleanup_register(pool, record, end_cycle, apr_pool_cleanup_null);
+}
+
+/* Start tracking the newly created POOL under FILE_LINE. */
+static void
+track_pool(apr_pool_t *pool,
+           const char *file_line)
+{
+  pool_tag_t *tag;
+
+  svn_profile__lock(&profile);
+
+  tag = get_tag(file_line ? file_line : SVN_FILE_LINE_UNDEFINED);
+  if (tag)
+    {
+      ++tag->created;
+      if (++tag->live > tag->live_peak)
+        tag->live_peak = tag->live;
+    }
+
+  svn_profile__unlock(&profile);
+
+  if (tag)
+    begin_cycle(pool, tag);
+}
+
+#ifdef SIGUSR1
+/* Signal handler requesting a report.  The report itself will be written
+   from the next pool function call. */
+static void
+request_report(int signum)
+{
+  report_requested = TRUE;
+}
+#endif
+
+/* Write a report if one has been requested through a signal. */
+static void
+maybe_write_report(void)
+{
+  if (report_requested)
+    {
+      report_requested = FALSE;
+      svn_profile__write_report(&profile);
+    }
+}
+
+/* qsort comparison function putting the tags with the largest peak
+   allocation first. */
+static int
+compare_tags(const void *lhs,
+             const void *rhs)
+{
+  const pool_tag_t *left = lhs;
+  const pool_tag_t *right = rhs;
+
+  if (left->bytes_peak != right->bytes_peak)
+    return left->bytes_peak > right->bytes_peak ? -1 : 1;
+  if (left->bytes_total != right->bytes_total)
+    return left->bytes_total > right->bytes_total ? -1 : 1;
+  if (left->created != right->created)
+    return left->created > right->created ? -1 : 1;
+
+  return strcmp(left->file_line, right->file_line);
+}
+
+void
+svn_pool__profile_report(FILE *stream)
+{
+  pool_tag_t *tags;
+  pool_tag_t *tag;
+  apr_size_t count = 0;
+  apr_size_t i;
+
+  if (!profile.active)
+    return;
+
+  /* Take a snapshot, so we don't block other threads while printing. */
+  svn_profile__lock(&profile);
+
+  for (i = 0; i < TAG_BUCKETS; ++i)
+    for (tag = tag_buckets[i]; tag; tag = tag->next)
+      ++count;
+
+  tags = malloc(count * sizeof(*tags) + 1);
+  if (tags != NULL)
+    {
+      count = 0;
+      for (i = 0; i < TAG_BUCKETS; ++i)
+        for (tag = tag_buckets[i]; tag; tag = tag->next)
+          tags[count++] = *tag;
+    }
+
+  svn_profile__unlock(&profile);
+
+  if (tags == NULL)
+    return;
+
+  qsort(tags, count, sizeof(*tags), compare_tags);
+
+  fprintf(stream, "Pool allocation profile of %s:\n",
+          profile.progname ? profile.progname : "<unknown>");
+#if APR_POOL_DEBUG
+  fprintf(stream, "%14s %14s %10s %10s %8s %8s %12s %12s  %s\n",
+          "peak bytes", "total bytes", "created", "cycles", "live",
+          "max live", "max life ms", "avg life ms", "location");
+#else
+  /* Without pool debugging, we can only tell how much the whole heap
+     grew during a cycle.  Make sure nobody mistakes that for the
+     allocations of the pool itself. */
+  fprintf(stream, "(heap columns: growth of the global process heap "
+                  "during each cycle, not per-pool usage)\n");
+  fprintf(stream, "%14s %14s %10s %10s %8s %8s %12s %12s  %s\n",
+          "peak heap", "total heap", "created", "cycles", "live",
+          "max live", "max life ms", "avg life ms", "location");
+#endif
+
+  for (i = 0; i < count; ++i)
+    {
+      tag = &tags[i];
+      fprintf(stream,
+              "%14" APR_UINT64_T_FMT " %14" APR_UINT64_T_FMT
+              " %10" APR_UINT64_T_FMT " %10" APR_UINT64_T_FMT
+              " %8" APR_UINT64_T_FMT " %8" APR_UINT64_T_FMT
+              " %12" APR_INT64_T_FMT " %12" APR_INT64_T_FMT "  %s\n",
+              tag->bytes_peak, tag->bytes_total, tag->created, tag->cycles,
+              tag->live, tag->live_peak,
+              (apr_int64_t)(tag->lifetime_max / 1000),
+              (apr_int64_t)(tag->cycles
+                            ? tag->lifetime_total / tag->cycles / 1000
+                            : 0),
+              tag->file_line);
+    }
+
+  fflush(stream);
+  free(tags);
+}
+
+void
+svn_pool__profile_start(void)
 {
-  return svn_pool_create_ex(pool, allocator);
+  svn_profile__start(&profile);
 }
 
-#else /* APR_POOL_DEBUG */
+void
+svn_pool__profile_init(const char *progname)
+{
+  if (!svn_profile__init(&profile, SVN_POOL__PROFILE_ENV, progname))
+    return;
+
+#ifdef SIGUSR1
+  apr_signal(SIGUSR1, request_report);
+#endif
+}
+
+
+/*** Pool creation. ***/
+
+#undef svn_pool_create_ex
 
 apr_pool_t *
 svn_pool_create_ex_debug(apr_pool_t *parent_pool, apr_allocator_t *allocator,
                          const char *file_line)
 {
   apr_pool_t *pool;
+
+#if APR_POOL_DEBUG
   apr_pool_create_ex_debug(&pool, parent_pool, abort_on_pool_failure,
                            allocator, file_line);
+#else
+  apr_pool_create_ex(&pool, parent_pool, abort_on_pool_failure, allocator);
+#endif
+
+  if (profile.active)
+    {
+      maybe_write_report();
+      track_pool(pool, file_line);
+    }
+
   return pool;
 }
 
@@ -107,7 +423,30 @@ svn_pool_create_ex(apr_pool_t *pool, apr_allocator_t *allocator)
   return svn_pool_create_ex_debug(pool, allocator, SVN_FILE_LINE_UNDEFINED);
 }
 
-#endif /* APR_POOL_DEBUG */
+void
+svn_pool__clear(apr_pool_t *pool)
+{
+  pool_record_t *record = NULL;
+  pool_tag_t *tag = NULL;
+
+  if (profile.active)
+    {
+      maybe_write_report();
+
+      /* Remember the tag; the record will be gone after the clear. */
+      apr_pool_userdata_get((void **)&record, PROFILE_KEY, pool);
+      if (record)
+        {
+          record->clearing = TRUE;
+          tag = record->tag;
+        }
+    }
+
+  apr_pool_clear(pool);
+
+  if (tag)
+    begin_cycle(pool, tag);
+}
 
 apr_allocator_t *
 svn_pool_create_allocator(svn_boolean_t thread_safe)
@@ -125,7 +464,7 @@ svn_pool_create_allocator(svn_boolean_t thread_safe)
 
   /* create the root pool */
 
-  pool = svn_pool_create_ex(NULL, allocator);
+  pool = svn_pool_create_ex_debug(NULL, allocator, APR_POOL__FILE_LINE__);
   apr_allocator_owner_set(allocator, pool);
 
 #if APR_POOL_DEBUG
@@ -151,16 +490,6 @@ svn_pool_create_allocator(svn_boolean_t thread_safe)
 }
 
 
-/*
- * apr_pool_create_core_ex was introduced in APR 1.3.0, then
- * deprecated and renamed to apr_pool_create_unmanaged_ex in 1.3.3.
- * Since our minimum requirement is APR 1.3.0, one or the other of
- * these functions will always be available.
- */
-#if !APR_VERSION_AT_LEAST(1,3,3)
-#define apr_pool_create_unmanaged_ex apr_pool_create_core_ex
-#endif
-
 /* Private function that creates an unmanaged pool. */
 apr_pool_t *
 svn_pool__create_unmanaged(svn_boolean_t thread_safe)
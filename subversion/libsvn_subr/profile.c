@@ -0,0 +1,123 @@
+/*
+ * profile.c:  shared infrastructure of the profilers in libsvn_subr
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_pools.h>
+
+#include "profile.h"
+
+/* All profilers that will report at exit, most recently started first. */
+static svn_profile__t *exit_profiles = NULL;
+
+/* atexit() handler writing the reports of all EXIT_PROFILES. */
+static void
+report_at_exit(void)
+{
+  svn_profile__t *profile;
+
+  for (profile = exit_profiles; profile; profile = profile->next)
+    svn_profile__write_report(profile);
+}
+
+void
+svn_profile__start(svn_profile__t *profile)
+{
+  if (profile->active)
+    return;
+
+#if APR_HAS_THREADS
+  {
+    /* Bypass our pool wrappers, so the pool allocation profiler never
+       tracks this pool. */
+    apr_pool_t *mutex_pool;
+    if (apr_pool_create_unmanaged_ex(&mutex_pool, NULL, NULL) == APR_SUCCESS)
+      apr_thread_mutex_create(&profile->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              mutex_pool);
+  }
+#endif
+
+  profile->active = TRUE;
+}
+
+svn_boolean_t
+svn_profile__init(svn_profile__t *profile,
+                  const char *env_var,
+                  const char *progname)
+{
+  const char *path = getenv(env_var);
+
+  if (path == NULL || profile->active)
+    return FALSE;
+
+  profile->progname = progname;
+  if (*path && strcmp(path, "-") != 0)
+    profile->path = path;
+
+  svn_profile__start(profile);
+
+  if (exit_profiles == NULL)
+    atexit(report_at_exit);
+
+  profile->next = exit_profiles;
+  exit_profiles = profile;
+
+  return TRUE;
+}
+
+void
+svn_profile__lock(svn_profile__t *profile)
+{
+#if APR_HAS_THREADS
+  if (profile->mutex)
+    apr_thread_mutex_lock(profile->mutex);
+#endif
+}
+
+void
+svn_profile__unlock(svn_profile__t *profile)
+{
+#if APR_HAS_THREADS
+  if (profile->mutex)
+    apr_thread_mutex_unlock(profile->mutex);
+#endif
+}
+
+void
+svn_profile__write_report(svn_profile__t *profile)
+{
+  FILE *stream = stderr;
+
+  if (profile->path)
+    stream = fopen(profile->path, "a");
+
+  if (stream)
+    {
+      profile->report(stream);
+      if (stream != stderr)
+        fclose(stream);
+    }
+}
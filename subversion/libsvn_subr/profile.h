@@ -0,0 +1,101 @@
+/*
+ * profile.h:  shared infrastructure of the profilers in libsvn_subr
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_SUBR_PROFILE_H
+#define SVN_LIBSVN_SUBR_PROFILE_H
+
+#include <stdio.h>
+
+#include <apr.h>
+#include <apr_thread_mutex.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* State of one of the runtime profilers in libsvn_subr, e.g. the pool
+ * allocation profiler and the SQLite statement profiler.  Instances are
+ * static and must be zero-initialized except for REPORT.
+ */
+typedef struct svn_profile__t
+{
+  /* Set once profiling has been started.  Never reset. */
+  svn_boolean_t active;
+
+  /* Name of the process and of the report file as given to
+   * svn_profile__init().  PATH is NULL for stderr. */
+  const char *progname;
+  const char *path;
+
+  /* Writes the report of this profiler to STREAM. */
+  void (*report)(FILE *stream);
+
+#if APR_HAS_THREADS
+  /* Serializes access to the profiler's data.  Allocated in an unmanaged
+   * pool that will never be tracked. */
+  apr_thread_mutex_t *mutex;
+#endif
+
+  /* Next profiler to report at exit. */
+  struct svn_profile__t *next;
+} svn_profile__t;
+
+/* Unconditionally start PROFILE.  Call this before any other threads have
+ * been started.  Repeated calls are no-ops.
+ */
+void
+svn_profile__start(svn_profile__t *profile);
+
+/* If the environment variable ENV_VAR is set, start PROFILE, arrange for
+ * its report to be written at exit and return TRUE.  The value of ENV_VAR
+ * is the file to append the report to; an empty value or "-" selects
+ * stderr.  PROGNAME identifies the process in the report.  Return FALSE
+ * if ENV_VAR is not set or PROFILE has already been started.
+ */
+svn_boolean_t
+svn_profile__init(svn_profile__t *profile,
+                  const char *env_var,
+                  const char *progname);
+
+/* Acquire resp. release the lock of PROFILE.  No-ops before PROFILE has
+ * been started.
+ */
+void
+svn_profile__lock(svn_profile__t *profile);
+
+void
+svn_profile__unlock(svn_profile__t *profile);
+
+/* Append the current report of PROFILE to the file given to
+ * svn_profile__init(), or stderr.
+ */
+void
+svn_profile__write_report(svn_profile__t *profile);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_SUBR_PROFILE_H */
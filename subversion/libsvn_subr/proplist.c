@@ -0,0 +1,386 @@
+/*
+ * proplist.c :  random-access binary serialization of property lists
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+
+#include "svn_hash.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+#include "svn_io.h"
+
+#include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+/* The binary format is laid out as follows:
+ *
+ *   MAGIC     4 bytes, see below
+ *   COUNT     number of properties
+ *   ENTRIES   COUNT entries of ENTRY_SIZE bytes each, sorted by name
+ *   STRINGS   NUL-terminated names and values
+ *
+ * Each entry consists of the offset and length of the property name,
+ * followed by offset and length of the property value.  Offsets are
+ * relative to the start of the MAGIC.  All numbers are 32 bit little-endian.
+ *
+ * Hash dumps always start with a "K", "D" or "E", so a leading NUL is
+ * sufficient to tell the formats apart.
+ */
+static const char magic[4] = { '\0', 'P', 'L', '1' };
+
+/* Number of bytes per integer, entry and header. */
+#define INT_SIZE     4
+#define ENTRY_SIZE   (4 * INT_SIZE)
+#define HEADER_SIZE  (sizeof(magic) + INT_SIZE)
+
+/* Little-endian 32 bit integer encoding and decoding.
+ */
+static void
+write_int(unsigned char *p,
+          apr_size_t value)
+{
+  p[0] = (unsigned char)(value);
+  p[1] = (unsigned char)(value >> 8);
+  p[2] = (unsigned char)(value >> 16);
+  p[3] = (unsigned char)(value >> 24);
+}
+
+static apr_size_t
+read_int(const unsigned char *p)
+{
+  return (apr_size_t)p[0]
+       | ((apr_size_t)p[1] << 8)
+       | ((apr_size_t)p[2] << 16)
+       | ((apr_size_t)p[3] << 24);
+}
+
+/* Error to return for binary data that fails our sanity checks. */
+static svn_error_t *
+binary_corrupt(void)
+{
+  return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                          _("Binary property list corrupt"));
+}
+
+/* Read the string starting at entry offset FIELD in the entry at ENTRY of
+ * the binary property list DATA with LEN bytes.  Return its position in
+ * *STRING and its length in *STRING_LEN.  Verify that it lies within DATA
+ * and is NUL-terminated.
+ */
+static svn_error_t *
+read_string(const char **string,
+            apr_size_t *string_len,
+            const unsigned char *data,
+            apr_size_t len,
+            const unsigned char *entry)
+{
+  apr_size_t offset = read_int(entry);
+  apr_size_t size = read_int(entry + INT_SIZE);
+
+  if (offset > len || size >= len - offset || data[offset + size] != '\0')
+    return binary_corrupt();
+
+  *string = (const char *)data + offset;
+  *string_len = size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of entries in the binary property list DATA with LEN
+ * bytes in *COUNT.  Verify that the table fits into DATA.
+ */
+static svn_error_t *
+read_count(apr_size_t *count,
+           const unsigned char *data,
+           apr_size_t len)
+{
+  *count = read_int(data + sizeof(magic));
+  if (*count > (len - HEADER_SIZE) / ENTRY_SIZE)
+    return binary_corrupt();
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_proplist__create(svn_stringbuf_t **serialized,
+                     apr_hash_t *props,
+                     apr_pool_t *pool)
+{
+  apr_array_header_t *sorted
+    = svn_sort__hash(props, svn_sort_compare_items_lexically, pool);
+  apr_size_t size = HEADER_SIZE + sorted->nelts * ENTRY_SIZE;
+  apr_size_t offset;
+  unsigned char *data;
+  unsigned char *entry;
+  int i;
+
+  /* Determine the total size and make sure all offsets fit into 32 bits. */
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const svn_string_t *value = item->value;
+
+      size += item->klen + value->len + 2;
+    }
+
+  if (size > APR_UINT32_MAX)
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("Property list too large for binary format"));
+
+  *serialized = svn_stringbuf_create_ensure(size, pool);
+  data = (unsigned char *)(*serialized)->data;
+
+  memcpy(data, magic, sizeof(magic));
+  write_int(data + sizeof(magic), sorted->nelts);
+
+  /* Fill the table and append the strings. */
+  entry = data + HEADER_SIZE;
+  offset = HEADER_SIZE + sorted->nelts * ENTRY_SIZE;
+  for (i = 0; i < sorted->nelts; ++i, entry += ENTRY_SIZE)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const svn_string_t *value = item->value;
+
+      write_int(entry, offset);
+      write_int(entry + INT_SIZE, item->klen);
+      memcpy(data + offset, item->key, item->klen);
+      offset += item->klen;
+      data[offset++] = '\0';
+
+      write_int(entry + 2 * INT_SIZE, offset);
+      write_int(entry + 3 * INT_SIZE, value->len);
+      memcpy(data + offset, value->data, value->len);
+      offset += value->len;
+      data[offset++] = '\0';
+    }
+
+  (*serialized)->len = size;
+  (*serialized)->data[size] = '\0';
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_proplist__is_binary(const void *data,
+                        apr_size_t len)
+{
+  return len >= HEADER_SIZE && memcmp(data, magic, sizeof(magic)) == 0;
+}
+
+/* Error to return for hash dumps that we can't parse. */
+static svn_error_t *
+hash_dump_malformed(void)
+{
+  return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                          _("Serialized hash malformed"));
+}
+
+/* Parse the line "<PREFIX> <number>\n" at *P, not exceeding END, and
+ * return the number in *NUMBER.  Advance *P behind the line.
+ */
+static svn_error_t *
+parse_length(apr_size_t *number,
+             const char **p,
+             const char *end,
+             char prefix)
+{
+  const char *s = *p;
+  apr_size_t value = 0;
+
+  if (end - s < 4 || s[0] != prefix || s[1] != ' ')
+    return hash_dump_malformed();
+
+  for (s += 2; s < end && *s >= '0' && *s <= '9'; ++s)
+    {
+      if (value > (APR_SIZE_MAX - 9) / 10)
+        return hash_dump_malformed();
+
+      value = value * 10 + (*s - '0');
+    }
+
+  if (s == *p + 2 || s == end || *s != '\n')
+    return hash_dump_malformed();
+
+  *number = value;
+  *p = s + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the hash dump entry string of length SIZE at *P, not exceeding
+ * END.  Return its start in *STRING and advance *P behind the string
+ * and its terminating newline.
+ */
+static svn_error_t *
+parse_string(const char **string,
+             const char **p,
+             const char *end,
+             apr_size_t size)
+{
+  if ((apr_size_t)(end - *p) <= size || (*p)[size] != '\n')
+    return hash_dump_malformed();
+
+  *string = *p;
+  *p += size + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_proplist__get for the hash dump of LEN bytes in DATA.
+ * Scan the entries without copying them until we find NAME.
+ */
+static svn_error_t *
+hash_dump_get(svn_string_t **value,
+              const char *data,
+              apr_size_t len,
+              const char *name,
+              apr_pool_t *result_pool)
+{
+  const char *p = data;
+  const char *end = data + len;
+  apr_size_t name_len = strlen(name);
+
+  *value = NULL;
+  while (end - p < 3 || memcmp(p, SVN_HASH_TERMINATOR, 3) != 0)
+    {
+      const char *key;
+      const char *val;
+      apr_size_t key_len;
+      apr_size_t val_len;
+
+      SVN_ERR(parse_length(&key_len, &p, end, 'K'));
+      SVN_ERR(parse_string(&key, &p, end, key_len));
+      SVN_ERR(parse_length(&val_len, &p, end, 'V'));
+      SVN_ERR(parse_string(&val, &p, end, val_len));
+
+      if (key_len == name_len && memcmp(key, name, name_len) == 0)
+        {
+          *value = svn_string_ncreate(val, val_len, result_pool);
+          break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_proplist__get(svn_string_t **value,
+                  const void *data,
+                  apr_size_t len,
+                  const char *name,
+                  apr_pool_t *result_pool)
+{
+  const unsigned char *bytes = data;
+  apr_size_t name_len = strlen(name);
+  apr_size_t lower = 0;
+  apr_size_t upper;
+
+  if (!svn_proplist__is_binary(data, len))
+    return svn_error_trace(hash_dump_get(value, data, len, name,
+                                         result_pool));
+
+  /* Binary search on the sorted table.
+   * Same order as svn_sort_compare_items_lexically. */
+  *value = NULL;
+  SVN_ERR(read_count(&upper, bytes, len));
+  while (lower < upper)
+    {
+      apr_size_t middle = lower + (upper - lower) / 2;
+      const unsigned char *entry = bytes + HEADER_SIZE + middle * ENTRY_SIZE;
+      const char *key;
+      apr_size_t key_len;
+      int diff;
+
+      SVN_ERR(read_string(&key, &key_len, bytes, len, entry));
+      diff = memcmp(key, name, MIN(key_len, name_len));
+      if (diff == 0)
+        diff = key_len < name_len ? -1 : key_len > name_len ? 1 : 0;
+
+      if (diff < 0)
+        {
+          lower = middle + 1;
+        }
+      else if (diff > 0)
+        {
+          upper = middle;
+        }
+      else
+        {
+          const char *val;
+          apr_size_t val_len;
+
+          SVN_ERR(read_string(&val, &val_len, bytes, len,
+                              entry + 2 * INT_SIZE));
+          *value = svn_string_ncreate(val, val_len, result_pool);
+          break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_proplist__parse(apr_hash_t **props,
+                    const void *data,
+                    apr_size_t len,
+                    apr_pool_t *pool)
+{
+  const unsigned char *bytes = data;
+  const unsigned char *entry;
+  svn_string_t *values;
+  apr_size_t count;
+  apr_size_t i;
+
+  if (!svn_proplist__is_binary(data, len))
+    {
+      svn_string_t content;
+      content.data = data;
+      content.len = len;
+
+      *props = apr_hash_make(pool);
+      return svn_error_trace(svn_hash_read2(*props,
+                                            svn_stream_from_string(&content,
+                                                                   pool),
+                                            SVN_HASH_TERMINATOR, pool));
+    }
+
+  /* Reference the names and values in DATA directly. */
+  SVN_ERR(read_count(&count, bytes, len));
+  values = apr_palloc(pool, count * sizeof(*values));
+  *props = svn_hash__make(pool);
+
+  for (i = 0, entry = bytes + HEADER_SIZE; i < count; ++i, entry += ENTRY_SIZE)
+    {
+      const char *key;
+      apr_size_t key_len;
+
+      SVN_ERR(read_string(&key, &key_len, bytes, len, entry));
+      SVN_ERR(read_string(&values[i].data, &values[i].len, bytes, len,
+                          entry + 2 * INT_SIZE));
+      apr_hash_set(*props, key, key_len, &values[i]);
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,436 @@
+/*
+ * sha1.c :  SHA-1 implementation using CPU extensions where available
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr.h>
+
+#include "sha1.h"
+
+/* Unlike SSE2, the SHA extensions are not part of any baseline ISA that
+ * we could assume.  On x86, we compile the accelerated code for them
+ * using function specific target options and check for CPU support at
+ * runtime.  On ARMv8, we only use them if the compiler may do so anyway.
+ * Define SVN_DISABLE_SIMD to always use the portable implementation.
+ */
+#if !defined(SVN_DISABLE_SIMD) && defined(__GNUC__) \
+    && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || __GNUC__ >= 5)
+#  define SVN_SHA1__X86_SHA 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#elif !defined(SVN_DISABLE_SIMD) && defined(__aarch64__) \
+    && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#  define SVN_SHA1__ARM_SHA 1
+#  include <arm_neon.h>
+#endif
+
+/* Process COUNT blocks of SVN_SHA1__BLOCK_SIZE bytes each from DATA and
+ * update the intermediate hash value in STATE.
+ */
+typedef void (*blocks_func_t)(apr_uint32_t state[5],
+                              const unsigned char *data,
+                              apr_size_t count);
+
+/* Initial hash value as defined in FIPS 180-4. */
+static const apr_uint32_t initial_state[5]
+  = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+/* Round constants as defined in FIPS 180-4. */
+#define K0 0x5a827999
+#define K1 0x6ed9eba1
+#define K2 0x8f1bbcdc
+#define K3 0xca62c1d6
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Return the big-endian 32 bit number at P. */
+static APR_INLINE apr_uint32_t
+load_be32(const unsigned char *p)
+{
+  return ((apr_uint32_t)p[0] << 24) | ((apr_uint32_t)p[1] << 16)
+       | ((apr_uint32_t)p[2] << 8) | (apr_uint32_t)p[3];
+}
+
+/* Write VALUE to P as big-endian 32 bit number. */
+static APR_INLINE void
+store_be32(unsigned char *p, apr_uint32_t value)
+{
+  p[0] = (unsigned char)(value >> 24);
+  p[1] = (unsigned char)(value >> 16);
+  p[2] = (unsigned char)(value >> 8);
+  p[3] = (unsigned char)value;
+}
+
+/* Round I of the portable implementation with F being the result of the
+ * round function plus the round constant.  W is the message schedule,
+ * used as a ring buffer of 16 words.
+ */
+#define ROUND(i, f)                                                     \
+  do                                                                    \
+    {                                                                   \
+      apr_uint32_t temp;                                                \
+      if ((i) >= 16)                                                    \
+        {                                                               \
+          temp = w[((i) + 13) & 15] ^ w[((i) + 8) & 15]                 \
+               ^ w[((i) + 2) & 15] ^ w[(i) & 15];                       \
+          w[(i) & 15] = ROTL32(temp, 1);                                \
+        }                                                               \
+                                                                        \
+      temp = ROTL32(a, 5) + (f) + e + w[(i) & 15];                      \
+      e = d;                                                            \
+      d = c;                                                            \
+      c = ROTL32(b, 30);                                                \
+      b = a;                                                            \
+      a = temp;                                                         \
+    }                                                                   \
+  while (0)
+
+/* Implements blocks_func_t in portable C. */
+static void
+blocks_portable(apr_uint32_t state[5],
+                const unsigned char *data,
+                apr_size_t count)
+{
+  for (; count > 0; --count, data += SVN_SHA1__BLOCK_SIZE)
+    {
+      apr_uint32_t w[16];
+      apr_uint32_t a = state[0];
+      apr_uint32_t b = state[1];
+      apr_uint32_t c = state[2];
+      apr_uint32_t d = state[3];
+      apr_uint32_t e = state[4];
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        w[i] = load_be32(data + 4 * i);
+
+      for (i = 0; i < 20; ++i)
+        ROUND(i, ((b & c) | (~b & d)) + K0);
+      for (; i < 40; ++i)
+        ROUND(i, (b ^ c ^ d) + K1);
+      for (; i < 60; ++i)
+        ROUND(i, ((b & c) | (b & d) | (c & d)) + K2);
+      for (; i < 80; ++i)
+        ROUND(i, (b ^ c ^ d) + K3);
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+    }
+}
+
+#undef ROUND
+
+#if SVN_SHA1__X86_SHA
+
+/* Rounds 4*I to 4*I+3 of a block using round function F.  W[I % 4] holds
+ * the message schedule for these rounds and gets replaced by the one for
+ * rounds 4*I+16 to 4*I+19.  E is the ABCD value before the previous group
+ * of rounds, except for the first group where it holds the initial E.
+ */
+#define X86_ROUNDS(i, f)                                                \
+  do                                                                    \
+    {                                                                   \
+      __m128i e_next = abcd;                                            \
+      e = (i) ? _mm_sha1nexte_epu32(e, w[(i) % 4])                      \
+              : _mm_add_epi32(e, w[0]);                                 \
+      abcd = _mm_sha1rnds4_epu32(abcd, e, f);                           \
+      e = e_next;                                                       \
+      if ((i) < 16)                                                     \
+        w[(i) % 4]                                                      \
+          = _mm_sha1msg2_epu32(                                         \
+              _mm_xor_si128(_mm_sha1msg1_epu32(w[(i) % 4],              \
+                                               w[((i) + 1) % 4]),       \
+                            w[((i) + 2) % 4]),                          \
+              w[((i) + 3) % 4]);                                        \
+    }                                                                   \
+  while (0)
+
+/* Implements blocks_func_t using the x86 SHA extensions. */
+__attribute__((target("sha,sse4.1")))
+static void
+blocks_x86_sha(apr_uint32_t state[5],
+               const unsigned char *data,
+               apr_size_t count)
+{
+  /* The SHA instructions expect A in the highest lane and the message
+     words in big-endian order. */
+  const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607ULL,
+                                           0x08090a0b0c0d0e0fULL);
+  __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state),
+                                   0x1b);
+  __m128i e_saved = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; count > 0; --count, data += SVN_SHA1__BLOCK_SIZE)
+    {
+      __m128i abcd_saved = abcd;
+      __m128i e = e_saved;
+      __m128i w[4];
+      int i;
+
+      for (i = 0; i < 4; ++i)
+        w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data + i),
+                                byte_swap);
+
+      X86_ROUNDS(0, 0);
+      X86_ROUNDS(1, 0);
+      X86_ROUNDS(2, 0);
+      X86_ROUNDS(3, 0);
+      X86_ROUNDS(4, 0);
+      X86_ROUNDS(5, 1);
+      X86_ROUNDS(6, 1);
+      X86_ROUNDS(7, 1);
+      X86_ROUNDS(8, 1);
+      X86_ROUNDS(9, 1);
+      X86_ROUNDS(10, 2);
+      X86_ROUNDS(11, 2);
+      X86_ROUNDS(12, 2);
+      X86_ROUNDS(13, 2);
+      X86_ROUNDS(14, 2);
+      X86_ROUNDS(15, 3);
+      X86_ROUNDS(16, 3);
+      X86_ROUNDS(17, 3);
+      X86_ROUNDS(18, 3);
+      X86_ROUNDS(19, 3);
+
+      e_saved = _mm_sha1nexte_epu32(e, e_saved);
+      abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e_saved, 3);
+}
+
+#undef X86_ROUNDS
+
+/* Return TRUE if the CPU supports the SHA extensions as well as the SSE
+ * versions that blocks_x86_sha() requires.
+ */
+static svn_boolean_t
+have_x86_sha(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return FALSE;
+
+  /* SSSE3 and SSE4.1 */
+  __cpuid(1, eax, ebx, ecx, edx);
+  if ((ecx & (1 << 9)) == 0 || (ecx & (1 << 19)) == 0)
+    return FALSE;
+
+  /* SHA */
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & (1 << 29)) != 0;
+}
+
+#endif /* SVN_SHA1__X86_SHA */
+
+#if SVN_SHA1__ARM_SHA
+
+/* Rounds 4*I to 4*I+3 of a block using round instruction OP.  W[I % 4]
+ * holds the message schedule for these rounds and gets replaced by the
+ * one for rounds 4*I+16 to 4*I+19.  E is the current value of E.
+ */
+#define ARM_ROUNDS(i, op, k)                                            \
+  do                                                                    \
+    {                                                                   \
+      uint32_t e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));            \
+      abcd = op(abcd, e, vaddq_u32(w[(i) % 4], vdupq_n_u32(k)));        \
+      e = e_next;                                                       \
+      if ((i) < 16)                                                     \
+        w[(i) % 4]                                                      \
+          = vsha1su1q_u32(vsha1su0q_u32(w[(i) % 4], w[((i) + 1) % 4],  \
+                                        w[((i) + 2) % 4]),              \
+                          w[((i) + 3) % 4]);                            \
+    }                                                                   \
+  while (0)
+
+/* Implements blocks_func_t using the ARMv8 SHA extensions. */
+static void
+blocks_arm_sha(apr_uint32_t state[5],
+               const unsigned char *data,
+               apr_size_t count)
+{
+  uint32x4_t abcd = vld1q_u32(state);
+  uint32_t e_saved = state[4];
+
+  for (; count > 0; --count, data += SVN_SHA1__BLOCK_SIZE)
+    {
+      uint32x4_t abcd_saved = abcd;
+      uint32_t e = e_saved;
+      uint32x4_t w[4];
+      int i;
+
+      for (i = 0; i < 4; ++i)
+        w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+
+      ARM_ROUNDS(0, vsha1cq_u32, K0);
+      ARM_ROUNDS(1, vsha1cq_u32, K0);
+      ARM_ROUNDS(2, vsha1cq_u32, K0);
+      ARM_ROUNDS(3, vsha1cq_u32, K0);
+      ARM_ROUNDS(4, vsha1cq_u32, K0);
+      ARM_ROUNDS(5, vsha1pq_u32, K1);
+      ARM_ROUNDS(6, vsha1pq_u32, K1);
+      ARM_ROUNDS(7, vsha1pq_u32, K1);
+      ARM_ROUNDS(8, vsha1pq_u32, K1);
+      ARM_ROUNDS(9, vsha1pq_u32, K1);
+      ARM_ROUNDS(10, vsha1mq_u32, K2);
+      ARM_ROUNDS(11, vsha1mq_u32, K2);
+      ARM_ROUNDS(12, vsha1mq_u32, K2);
+      ARM_ROUNDS(13, vsha1mq_u32, K2);
+      ARM_ROUNDS(14, vsha1mq_u32, K2);
+      ARM_ROUNDS(15, vsha1pq_u32, K3);
+      ARM_ROUNDS(16, vsha1pq_u32, K3);
+      ARM_ROUNDS(17, vsha1pq_u32, K3);
+      ARM_ROUNDS(18, vsha1pq_u32, K3);
+      ARM_ROUNDS(19, vsha1pq_u32, K3);
+
+      abcd = vaddq_u32(abcd, abcd_saved);
+      e_saved += e;
+    }
+
+  vst1q_u32(state, abcd);
+  state[4] = e_saved;
+}
+
+#undef ARM_ROUNDS
+
+#endif /* SVN_SHA1__ARM_SHA */
+
+/* Return the fastest implementation of blocks_func_t for this machine.
+ */
+static blocks_func_t
+get_blocks_func(void)
+{
+#if SVN_SHA1__X86_SHA
+
+  /* 0 = not checked yet, 1 = no SHA extensions, 2 = use them.
+     Concurrent initialization is harmless as all threads will come to
+     the same conclusion. */
+  static volatile int has_sha = 0;
+  if (has_sha == 0)
+    has_sha = have_x86_sha() ? 2 : 1;
+
+  if (has_sha == 2)
+    return blocks_x86_sha;
+
+#elif SVN_SHA1__ARM_SHA
+
+  return blocks_arm_sha;
+
+#endif
+
+  return blocks_portable;
+}
+
+void
+svn_sha1__init(svn_sha1__context_t *context)
+{
+  memcpy(context->state, initial_state, sizeof(initial_state));
+  context->length = 0;
+}
+
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len)
+{
+  const unsigned char *input = data;
+  apr_size_t buffered = (apr_size_t)(context->length % SVN_SHA1__BLOCK_SIZE);
+  blocks_func_t blocks_func;
+
+  if (len == 0)
+    return;
+
+  blocks_func = get_blocks_func();
+  context->length += len;
+
+  /* Complete the buffered block first. */
+  if (buffered)
+    {
+      apr_size_t to_copy = SVN_SHA1__BLOCK_SIZE - buffered;
+      if (to_copy > len)
+        to_copy = len;
+
+      memcpy(context->buffer + buffered, input, to_copy);
+      input += to_copy;
+      len -= to_copy;
+
+      if (buffered + to_copy < SVN_SHA1__BLOCK_SIZE)
+        return;
+
+      blocks_func(context->state, context->buffer, 1);
+    }
+
+  /* Process full blocks directly from the input. */
+  if (len >= SVN_SHA1__BLOCK_SIZE)
+    {
+      apr_size_t count = len / SVN_SHA1__BLOCK_SIZE;
+      blocks_func(context->state, input, count);
+      input += count * SVN_SHA1__BLOCK_SIZE;
+      len -= count * SVN_SHA1__BLOCK_SIZE;
+    }
+
+  /* Keep the rest for later. */
+  memcpy(context->buffer, input, len);
+}
+
+void
+svn_sha1__final(unsigned char *digest,
+                svn_sha1__context_t *context)
+{
+  apr_uint64_t bit_length = context->length * 8;
+  apr_size_t buffered = (apr_size_t)(context->length % SVN_SHA1__BLOCK_SIZE);
+  blocks_func_t blocks_func = get_blocks_func();
+  int i;
+
+  /* Append a single 1 bit and pad with zeros such that the 64 bit message
+     length will end the last block. */
+  context->buffer[buffered++] = 0x80;
+  if (buffered > SVN_SHA1__BLOCK_SIZE - 8)
+    {
+      memset(context->buffer + buffered, 0, SVN_SHA1__BLOCK_SIZE - buffered);
+      blocks_func(context->state, context->buffer, 1);
+      buffered = 0;
+    }
+
+  memset(context->buffer + buffered, 0,
+         SVN_SHA1__BLOCK_SIZE - 8 - buffered);
+  store_be32(context->buffer + SVN_SHA1__BLOCK_SIZE - 8,
+             (apr_uint32_t)(bit_length >> 32));
+  store_be32(context->buffer + SVN_SHA1__BLOCK_SIZE - 4,
+             (apr_uint32_t)bit_length);
+  blocks_func(context->state, context->buffer, 1);
+
+  for (i = 0; i < 5; ++i)
+    store_be32(digest + 4 * i, context->state[i]);
+}
+
+svn_boolean_t
+svn_sha1__is_accelerated(void)
+{
+  return get_blocks_func() != blocks_portable;
+}
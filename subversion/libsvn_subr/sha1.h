@@ -0,0 +1,83 @@
+/*
+ * sha1.h :  SHA-1 implementation using CPU extensions where available
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_SUBR_SHA1_H
+#define SVN_LIBSVN_SUBR_SHA1_H
+
+#include <apr.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Size of a SHA-1 input block in bytes. */
+#define SVN_SHA1__BLOCK_SIZE 64
+
+/* SHA-1 checksum creation context.  Its contents are private to sha1.c;
+ * the struct is only public so that contexts can live on the stack.
+ */
+typedef struct svn_sha1__context_t
+{
+  /* The five 32 bit words of the intermediate hash value. */
+  apr_uint32_t state[5];
+
+  /* Total number of bytes fed into the context so far. */
+  apr_uint64_t length;
+
+  /* Data of the current, incomplete block. Its size is LENGTH modulo
+   * SVN_SHA1__BLOCK_SIZE. */
+  unsigned char buffer[SVN_SHA1__BLOCK_SIZE];
+} svn_sha1__context_t;
+
+/* Initialize the SHA-1 checksum CONTEXT.
+ */
+void
+svn_sha1__init(svn_sha1__context_t *context);
+
+/* Feed LEN bytes from DATA into the SHA-1 checksum creation CONTEXT.
+ */
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len);
+
+/* Write the SHA-1 checksum over all data fed into CONTEXT to DIGEST,
+ * which must provide APR_SHA1_DIGESTSIZE bytes.  CONTEXT must be
+ * re-initialized before it can be used again.
+ */
+void
+svn_sha1__final(unsigned char *digest,
+                svn_sha1__context_t *context);
+
+/* Return TRUE if svn_sha1__update() uses SHA instructions of the CPU.
+ */
+svn_boolean_t
+svn_sha1__is_accelerated(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_SUBR_SHA1_H */
@@ -22,12 +22,37 @@
  */
 
 #include <apr_file_io.h>
+#include <apr_mmap.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_io.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
 
 #include "private/svn_subr_private.h"
 
+/* Asynchronous spilling needs a thread to write the data and memory
+   mapping to read it back without disturbing the writer.  */
+#if APR_HAS_THREADS && APR_HAS_MMAP
+#define SPILLBUF_ASYNC
+#endif
+
+/* Size of the blocks that asynchronous spill buffers hand over to their
+   writer thread.  */
+#define SPILL_BLOCK_SIZE 0x10000
+
+/* Maximum number of blocks queued for the writer thread.  Writes will
+   block when the writer falls behind by that much.  */
+#define MAX_QUEUED_BLOCKS 16
+
+/* Spill file contents will be mapped in windows of this size, aligned
+   to MAP_ALIGNMENT.  The latter covers all common page sizes.  */
+#define MAP_WINDOW_SIZE 0x400000
+#define MAP_ALIGNMENT 0x10000
+
 
 struct memblock_t {
   apr_size_t size;
@@ -37,6 +62,47 @@ struct memblock_t {
 };
 
 
+#ifdef SPILLBUF_ASYNC
+
+/* Background writer for the spill file of an asynchronous spill buffer.
+   All members except FILE and POOL are protected by MUTEX.  */
+typedef struct spill_writer_t {
+  /* The spill file.  Only the writer thread writes to it.  */
+  apr_file_t *file;
+
+  /* Blocks waiting to be written, in order, and their number.  */
+  struct memblock_t *first;
+  struct memblock_t *last;
+  int queued;
+
+  /* Blocks that have been written and may be reused.  */
+  struct memblock_t *free;
+
+  /* Number of bytes that have actually been written to FILE.  */
+  svn_filesize_t written;
+
+  /* First error reported by the writer thread.  Further blocks will be
+     discarded.  */
+  svn_error_t *error;
+
+  /* Set when the writer thread shall terminate.  */
+  svn_boolean_t shutdown;
+
+  /* Gets signaled whenever any of the above changes.  */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  apr_thread_t *thread;
+
+  /* Own root pool for the thread and its synchronization objects, and
+     a scratch pool exclusively used by the thread.  */
+  apr_pool_t *pool;
+  apr_pool_t *scratch_pool;
+} spill_writer_t;
+
+#endif
+
+
 struct svn_spillbuf_t {
   /* Pool for allocating blocks and the spill file.  */
   apr_pool_t *pool;
@@ -87,6 +153,43 @@ struct svn_spillbuf_t {
 
   /* The name of the temporary spill file. */
   const char *filename;
+
+  /* When true, spilled data will be written from a background thread
+     and read back through memory mapping. */
+  svn_boolean_t async;
+
+#ifdef SPILLBUF_ASYNC
+  /* The writer for the current SPILL file.  NULL if there is no spill
+     file or it is not written asynchronously.  */
+  spill_writer_t *writer;
+
+  /* Block collecting data that has not been handed to WRITER yet.  */
+  struct memblock_t *spill_block;
+
+  /* Total amount of data in the spill file, including data not written
+     yet.  */
+  svn_filesize_t spill_end;
+
+  /* Unbuffered read-only handle on the spill file.  SPILL itself is
+     buffered, which APR cannot map, and it belongs to the writer thread.
+     NULL until the first read from the spill file.  */
+  apr_file_t *map_file;
+
+  /* Set when mapping MAP_FILE failed.  Read from it instead.  */
+  svn_boolean_t map_unsupported;
+
+  /* Current mapping of the spill file, starting at MAP_OFFSET.  It may
+     outlive the spill file until the next read.  */
+  apr_mmap_t *map;
+  apr_off_t map_offset;
+
+  /* Describes the mapped data most recently passed out for reading.
+     This one is never put on the AVAIL list.  */
+  struct memblock_t map_block;
+#endif
+
+  /* Usage statistics. */
+  svn_spillbuf_stats_t stats;
 };
 
 
@@ -170,6 +273,26 @@ svn_spillbuf__create_extended(apr_size_t blocksize,
   return buf;
 }
 
+svn_spillbuf_t *
+svn_spillbuf__create_async(apr_size_t blocksize,
+                           apr_size_t maxsize,
+                           apr_pool_t *result_pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create(blocksize, maxsize,
+                                             result_pool);
+#ifdef SPILLBUF_ASYNC
+  buf->async = TRUE;
+#endif
+  return buf;
+}
+
+void
+svn_spillbuf__get_stats(svn_spillbuf_stats_t *stats,
+                        const svn_spillbuf_t *buf)
+{
+  *stats = buf->stats;
+}
+
 svn_filesize_t
 svn_spillbuf__get_size(const svn_spillbuf_t *buf)
 {
@@ -204,13 +327,17 @@ get_buffer(svn_spillbuf_t *buf)
   if (mem != NULL)
     {
       buf->out_for_reading = NULL;
-      return mem;
+#ifdef SPILLBUF_ASYNC
+      if (mem != &buf->map_block)
+#endif
+        return mem;
     }
 
   if (buf->avail == NULL)
     {
       mem = apr_palloc(buf->pool, sizeof(*mem));
       mem->data = apr_palloc(buf->pool, buf->blocksize);
+      ++buf->stats.blocks_allocated;
       return mem;
     }
 
@@ -225,11 +352,369 @@ static void
 return_buffer(svn_spillbuf_t *buf,
               struct memblock_t *mem)
 {
+#ifdef SPILLBUF_ASYNC
+  /* Mapped data is not ours to recycle.  */
+  if (mem == &buf->map_block)
+    return;
+#endif
+
   mem->next = buf->avail;
   buf->avail = mem;
 }
 
 
+#ifdef SPILLBUF_ASYNC
+
+/* Thread function writing the blocks queued in the spill_writer_t
+   given as DATA until told to shut down.  */
+static void * APR_THREAD_FUNC
+spill_writer_thread(apr_thread_t *thread,
+                    void *data)
+{
+  spill_writer_t *writer = data;
+
+  apr_thread_mutex_lock(writer->mutex);
+  while (TRUE)
+    {
+      struct memblock_t *mem;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      while (writer->first == NULL && !writer->shutdown)
+        apr_thread_cond_wait(writer->cond, writer->mutex);
+
+      if (writer->shutdown)
+        break;
+
+      mem = writer->first;
+      writer->first = mem->next;
+      if (writer->first == NULL)
+        writer->last = NULL;
+
+      if (writer->error == NULL)
+        {
+          apr_thread_mutex_unlock(writer->mutex);
+
+          /* Readers map the file, so the data must not linger in APR's
+             file buffer.  */
+          err = svn_io_file_write_full(writer->file, mem->data, mem->size,
+                                       NULL, writer->scratch_pool);
+          if (!err)
+            err = svn_io_file_flush(writer->file, writer->scratch_pool);
+          svn_pool_clear(writer->scratch_pool);
+
+          apr_thread_mutex_lock(writer->mutex);
+        }
+
+      if (err)
+        writer->error = err;
+      else
+        writer->written += mem->size;
+
+      mem->next = writer->free;
+      writer->free = mem;
+      --writer->queued;
+
+      apr_thread_cond_broadcast(writer->cond);
+    }
+  apr_thread_mutex_unlock(writer->mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Pool cleanup function terminating the spill_writer_t given as DATA.
+   Data that has not been written yet will be discarded.  */
+static apr_status_t
+cleanup_writer(void *data)
+{
+  spill_writer_t *writer = data;
+  apr_status_t retval;
+
+  apr_thread_mutex_lock(writer->mutex);
+  writer->shutdown = TRUE;
+  apr_thread_cond_broadcast(writer->cond);
+  apr_thread_mutex_unlock(writer->mutex);
+
+  apr_thread_join(&retval, writer->thread);
+
+  svn_error_clear(writer->error);
+  svn_pool_destroy(writer->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Start a writer for the spill file of BUF, which currently contains
+   BUF->SPILL_END bytes.  */
+static svn_error_t *
+start_writer(svn_spillbuf_t *buf)
+{
+  spill_writer_t *writer = apr_pcalloc(buf->pool, sizeof(*writer));
+  apr_status_t status;
+
+  /* Any mapping still around belongs to the previous spill file.  Writing
+     invalidates the data out for reading, so we may drop it now.  */
+  if (buf->map)
+    {
+      apr_mmap_delete(buf->map);
+      buf->map = NULL;
+    }
+
+  writer->file = buf->spill;
+  writer->written = buf->spill_end;
+
+  /* The thread may outlive BUF->POOL's allocator lock, so it gets a
+     root pool of its own.  */
+  writer->pool = svn_pool_create(NULL);
+  writer->scratch_pool = svn_pool_create(writer->pool);
+
+  status = apr_thread_mutex_create(&writer->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   writer->pool);
+  if (!status)
+    status = apr_thread_cond_create(&writer->cond, writer->pool);
+  if (!status)
+    status = apr_thread_create(&writer->thread, NULL, spill_writer_thread,
+                               writer, writer->pool);
+  if (status)
+    {
+      svn_pool_destroy(writer->pool);
+      return svn_error_wrap_apr(status, _("Can't start spill file writer"));
+    }
+
+  /* Registered after the spill file's cleanup, so this runs first.  */
+  apr_pool_cleanup_register(buf->pool, writer, cleanup_writer,
+                            apr_pool_cleanup_null);
+  buf->writer = writer;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait until the writer of BUF has written more than TARGET bytes or
+   failed.  Return the writer's error, if any.  */
+static svn_error_t *
+wait_for_writer(svn_spillbuf_t *buf,
+                svn_filesize_t target)
+{
+  spill_writer_t *writer = buf->writer;
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(writer->mutex);
+  while (writer->written <= target && writer->error == NULL)
+    apr_thread_cond_wait(writer->cond, writer->mutex);
+  err = svn_error_dup(writer->error);
+  apr_thread_mutex_unlock(writer->mutex);
+
+  return svn_error_trace(err);
+}
+
+/* Hand the partially or completely filled BUF->SPILL_BLOCK over to the
+   writer of BUF.  Block while the writer lags too far behind.  */
+static svn_error_t *
+queue_spill_block(svn_spillbuf_t *buf)
+{
+  spill_writer_t *writer = buf->writer;
+  struct memblock_t *mem = buf->spill_block;
+  svn_error_t *err;
+
+  buf->spill_block = NULL;
+  mem->next = NULL;
+
+  apr_thread_mutex_lock(writer->mutex);
+  if (writer->queued >= MAX_QUEUED_BLOCKS)
+    {
+      ++buf->stats.write_waits;
+      while (writer->queued >= MAX_QUEUED_BLOCKS && writer->error == NULL)
+        apr_thread_cond_wait(writer->cond, writer->mutex);
+    }
+
+  if (writer->last)
+    writer->last->next = mem;
+  else
+    writer->first = mem;
+  writer->last = mem;
+  ++writer->queued;
+
+  apr_thread_cond_broadcast(writer->cond);
+  err = svn_error_dup(writer->error);
+  apr_thread_mutex_unlock(writer->mutex);
+
+  return svn_error_trace(err);
+}
+
+/* Append LEN bytes of DATA to the spill file of BUF through its
+   writer.  */
+static svn_error_t *
+write_async(svn_spillbuf_t *buf,
+            const char *data,
+            apr_size_t len)
+{
+  while (len > 0)
+    {
+      struct memblock_t *mem = buf->spill_block;
+      apr_size_t amt;
+
+      if (mem == NULL)
+        {
+          spill_writer_t *writer = buf->writer;
+
+          apr_thread_mutex_lock(writer->mutex);
+          mem = writer->free;
+          if (mem)
+            writer->free = mem->next;
+          apr_thread_mutex_unlock(writer->mutex);
+
+          if (mem == NULL)
+            {
+              mem = apr_palloc(buf->pool, sizeof(*mem));
+              mem->data = apr_palloc(buf->pool, SPILL_BLOCK_SIZE);
+              ++buf->stats.blocks_allocated;
+            }
+
+          mem->size = 0;
+          buf->spill_block = mem;
+        }
+
+      amt = MIN(SPILL_BLOCK_SIZE - mem->size, len);
+      memcpy(mem->data + mem->size, data, amt);
+      mem->size += amt;
+      data += amt;
+      len -= amt;
+
+      buf->spill_size += amt;
+      buf->spill_end += amt;
+
+      if (mem->size == SPILL_BLOCK_SIZE)
+        SVN_ERR(queue_spill_block(buf));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Point *MEM to the next block of data from the spill file of BUF, which
+   must not be empty, using memory mapping.  If the file cannot be mapped,
+   read the data into a normal block instead.  */
+static svn_error_t *
+read_mapped(struct memblock_t **mem,
+            svn_spillbuf_t *buf,
+            apr_pool_t *scratch_pool)
+{
+  spill_writer_t *writer = buf->writer;
+  svn_filesize_t written;
+  apr_size_t len;
+  void *data;
+
+  apr_thread_mutex_lock(writer->mutex);
+  written = writer->written;
+  apr_thread_mutex_unlock(writer->mutex);
+
+  /* Wait only if none of the data that we need has been written yet. */
+  if (written <= buf->spill_start)
+    {
+      if (buf->spill_block)
+        SVN_ERR(queue_spill_block(buf));
+
+      SVN_ERR(wait_for_writer(buf, buf->spill_start));
+
+      apr_thread_mutex_lock(writer->mutex);
+      written = writer->written;
+      apr_thread_mutex_unlock(writer->mutex);
+    }
+
+  len = (apr_size_t)MIN(written - buf->spill_start, buf->blocksize);
+
+  if (buf->map_file == NULL)
+    SVN_ERR(svn_io_file_open(&buf->map_file, buf->filename, APR_READ,
+                             APR_OS_DEFAULT, buf->pool));
+
+  if (buf->map_unsupported)
+    {
+      apr_off_t offset = buf->spill_start;
+      svn_error_t *err;
+
+      *mem = get_buffer(buf);
+      (*mem)->size = len;
+      (*mem)->next = NULL;
+
+      err = svn_io_file_seek(buf->map_file, APR_SET, &offset, scratch_pool);
+      if (!err)
+        err = svn_io_file_read_full2(buf->map_file, (*mem)->data, len,
+                                     NULL, NULL, scratch_pool);
+      if (err)
+        {
+          return_buffer(buf, *mem);
+          return svn_error_trace(err);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  if (buf->map == NULL
+      || buf->spill_start < buf->map_offset
+      || buf->spill_start + len > buf->map_offset + buf->map->size)
+    {
+      apr_off_t offset = buf->spill_start & ~(apr_off_t)(MAP_ALIGNMENT - 1);
+      apr_size_t size = (apr_size_t)MIN(written - offset, MAP_WINDOW_SIZE);
+      apr_status_t status;
+
+      size = MAX(size, (apr_size_t)(buf->spill_start + len - offset));
+
+      if (buf->map)
+        apr_mmap_delete(buf->map);
+      buf->map = NULL;
+
+      status = apr_mmap_create(&buf->map, buf->map_file, offset, size,
+                               APR_MMAP_READ, buf->pool);
+      if (status)
+        {
+          /* Not all platforms and file systems support mapping.  */
+          buf->map = NULL;
+          buf->map_unsupported = TRUE;
+          return svn_error_trace(read_mapped(mem, buf, scratch_pool));
+        }
+
+      buf->map_offset = offset;
+    }
+
+  apr_mmap_offset(&data, buf->map, buf->spill_start - buf->map_offset);
+
+  *mem = &buf->map_block;
+  (*mem)->data = data;
+  (*mem)->size = len;
+  (*mem)->next = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* The spill file of BUF has been read completely.  Stop its writer and
+   close the read handle.  */
+static svn_error_t *
+stop_writer(svn_spillbuf_t *buf,
+            apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(buf->writer->mutex);
+  err = svn_error_dup(buf->writer->error);
+  apr_thread_mutex_unlock(buf->writer->mutex);
+
+  apr_pool_cleanup_run(buf->pool, buf->writer, cleanup_writer);
+  buf->writer = NULL;
+  buf->spill_end = 0;
+
+  /* An existing mapping remains valid without the handle.  */
+  if (buf->map_file)
+    {
+      err = svn_error_compose_create(err,
+                                     svn_io_file_close(buf->map_file,
+                                                       scratch_pool));
+      buf->map_file = NULL;
+    }
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+
 svn_error_t *
 svn_spillbuf__write(svn_spillbuf_t *buf,
                     const char *data,
@@ -271,8 +756,26 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
              data from the file. */
           buf->spill_start = buf->memory_size;
         }
+
+      ++buf->stats.spill_files;
+
+#ifdef SPILLBUF_ASYNC
+      if (buf->async)
+        {
+          buf->spill_end = buf->spill_all_contents ? buf->memory_size : 0;
+          SVN_ERR(start_writer(buf));
+        }
+#endif
     }
 
+#ifdef SPILLBUF_ASYNC
+  if (buf->writer != NULL)
+    {
+      buf->stats.spilled += len;
+      return svn_error_trace(write_async(buf, data, len));
+    }
+#endif
+
   /* Once a spill file has been constructed, then we need to put all
      arriving data into the file. We will no longer attempt to hold it
      in memory.  */
@@ -289,6 +792,7 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
       SVN_ERR(svn_io_file_write_full(buf->spill, data, len,
                                      NULL, scratch_pool));
       buf->spill_size += len;
+      buf->stats.spilled += len;
 
       return SVN_NO_ERROR;
     }
@@ -340,6 +844,9 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
         }
     }
 
+  if (buf->memory_size > buf->stats.memory_peak)
+    buf->stats.memory_peak = buf->memory_size;
+
   return SVN_NO_ERROR;
 }
 
@@ -355,6 +862,15 @@ read_data(struct memblock_t **mem,
 {
   svn_error_t *err;
 
+#ifdef SPILLBUF_ASYNC
+  /* A mapping left over from the last spill file is no longer needed.  */
+  if (buf->map != NULL && buf->spill == NULL)
+    {
+      apr_mmap_delete(buf->map);
+      buf->map = NULL;
+    }
+#endif
+
   /* If we have some in-memory blocks, then return one.  */
   if (buf->head != NULL)
     {
@@ -378,25 +894,35 @@ read_data(struct memblock_t **mem,
       return SVN_NO_ERROR;
     }
 
-  /* Assume that the caller has seeked the spill file to the correct pos.  */
+#ifdef SPILLBUF_ASYNC
+  if (buf->writer != NULL)
+    {
+      SVN_ERR(read_mapped(mem, buf, scratch_pool));
+    }
+  else
+#endif
+    {
+      /* Assume that the caller has seeked the spill file to the correct
+         pos.  */
 
-  /* Get a buffer that we can read content into.  */
-  *mem = get_buffer(buf);
-  /* NOTE: mem's size/next are uninitialized.  */
+      /* Get a buffer that we can read content into.  */
+      *mem = get_buffer(buf);
+      /* NOTE: mem's size/next are uninitialized.  */
 
-  if ((apr_uint64_t)buf->spill_size < (apr_uint64_t)buf->blocksize)
-    (*mem)->size = (apr_size_t)buf->spill_size;
-  else
-    (*mem)->size = buf->blocksize;  /* The size of (*mem)->data  */
-  (*mem)->next = NULL;
+      if ((apr_uint64_t)buf->spill_size < (apr_uint64_t)buf->blocksize)
+        (*mem)->size = (apr_size_t)buf->spill_size;
+      else
+        (*mem)->size = buf->blocksize;  /* The size of (*mem)->data  */
+      (*mem)->next = NULL;
 
-  /* Read some data from the spill file into the memblock.  */
-  err = svn_io_file_read(buf->spill, (*mem)->data, &(*mem)->size,
-                         scratch_pool);
-  if (err)
-    {
-      return_buffer(buf, *mem);
-      return svn_error_trace(err);
+      /* Read some data from the spill file into the memblock.  */
+      err = svn_io_file_read(buf->spill, (*mem)->data, &(*mem)->size,
+                             scratch_pool);
+      if (err)
+        {
+          return_buffer(buf, *mem);
+          return svn_error_trace(err);
+        }
     }
 
   /* Mark the data that we consumed from the spill file.  */
@@ -405,6 +931,11 @@ read_data(struct memblock_t **mem,
   /* Did we consume all the data from the spill file?  */
   if ((buf->spill_size -= (*mem)->size) == 0)
     {
+#ifdef SPILLBUF_ASYNC
+      if (buf->writer != NULL)
+        SVN_ERR(stop_writer(buf, scratch_pool));
+#endif
+
       /* Close and reset our spill file information.  */
       SVN_ERR(svn_io_file_close(buf->spill, scratch_pool));
       buf->spill = NULL;
@@ -423,7 +954,12 @@ maybe_seek(svn_boolean_t *seeked,
            const svn_spillbuf_t *buf,
            apr_pool_t *scratch_pool)
 {
-  if (buf->head == NULL && buf->spill != NULL)
+  if (buf->head == NULL && buf->spill != NULL
+#ifdef SPILLBUF_ASYNC
+      /* Asynchronous spill files are read through mappings.  */
+      && buf->writer == NULL
+#endif
+      )
     {
       apr_off_t output_unused;
 
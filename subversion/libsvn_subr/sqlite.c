@@ -20,7 +20,12 @@
  * ====================================================================
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include "svn_types.h"
 #include "svn_error.h"
@@ -30,6 +35,7 @@
 #include "svn_checksum.h"
 
 #include "internal_statements.h"
+#include "profile.h"
 
 #include "private/svn_sqlite.h"
 #include "svn_private_config.h"
@@ -134,6 +140,26 @@ svn_sqlite__dbg_enable_errorlog(void)
 }
 
 
+/* Profiling data of a single statement. */
+typedef struct stmt_stats_t
+{
+  /* Number of times the statement has been executed. */
+  apr_uint64_t executions;
+
+  /* Number of sqlite3_step() calls and result rows returned by them. */
+  apr_uint64_t steps;
+  apr_uint64_t rows;
+
+  /* Number of full table scan steps and sort operations as reported by
+     sqlite3_stmt_status(). */
+  apr_uint64_t fullscan_steps;
+  apr_uint64_t sorts;
+
+  /* Total execution time and the longest single execution in ns. */
+  apr_uint64_t time_total;
+  apr_uint64_t time_max;
+} stmt_stats_t;
+
 struct svn_sqlite__db_t
 {
   sqlite3 *db3;
@@ -142,6 +168,12 @@ struct svn_sqlite__db_t
   svn_sqlite__stmt_t **prepared_stmts;
   apr_pool_t *state_pool;
 
+  /* If statement profiling is enabled, the file name of the database and
+     statistics for all NBR_STATEMENTS + STMT_INTERNAL_LAST statements.
+     STATS is NULL otherwise. */
+  const char *name;
+  stmt_stats_t *stats;
+
 #ifdef SVN_UNICODE_NORMALIZATION_FIXES
   /* Buffers for SQLite extensoins. */
   svn_membuf_t sqlext_buf1;
@@ -155,6 +187,12 @@ struct svn_sqlite__stmt_t
   sqlite3_stmt *s3stmt;
   svn_sqlite__db_t *db;
   svn_boolean_t needs_reset;
+
+  /* Where to accumulate the profiling data for this statement.  NULL if
+     profiling is disabled.  EXEC_TIME is the time spent in the current
+     execution so far. */
+  stmt_stats_t *stats;
+  apr_uint64_t exec_time;
 };
 
 struct svn_sqlite__context_t
@@ -218,6 +256,272 @@ struct svn_sqlite__value_t
 #define BUSY_TIMEOUT 10000
 
 
+/*** Statement profiling. ***/
+
+/* Accumulated statistics of all closed connections to databases named
+   NAME that used the same STATEMENTS array.  Allocated with malloc(),
+   since they outlive all pools. */
+typedef struct profile_set_t
+{
+  const char * const *statements;
+  char *name;
+  int nbr_statements;
+  stmt_stats_t *stats;
+  struct profile_set_t *next;
+} profile_set_t;
+
+/* State of the statement profiler.  Its lock serializes access to
+   PROFILE_SETS. */
+static svn_profile__t profile
+  = { FALSE, NULL, NULL, svn_sqlite__profile_report };
+
+/* All profile sets collected so far. */
+static profile_set_t *profile_sets = NULL;
+
+/* Return a monotonic timestamp in ns. */
+static apr_uint64_t
+profile_now(void)
+{
+#if defined(CLOCK_MONOTONIC) && !defined(WIN32)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+    return (apr_uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+
+  return (apr_uint64_t)apr_time_now() * 1000;
+}
+
+/* Conclude the current execution of STMT and fetch the counters that
+   SQLite maintains for it. */
+static void
+profile_flush(svn_sqlite__stmt_t *stmt)
+{
+  stmt_stats_t *stats = stmt->stats;
+
+  stats->fullscan_steps
+    += sqlite3_stmt_status(stmt->s3stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+  stats->sorts
+    += sqlite3_stmt_status(stmt->s3stmt, SQLITE_STMTSTATUS_SORT, 1);
+
+  if (stats->time_max < stmt->exec_time)
+    stats->time_max = stmt->exec_time;
+  stmt->exec_time = 0;
+}
+
+/* Add the statistics collected by the connection DB to the global
+   profile. */
+static void
+profile_merge(svn_sqlite__db_t *db)
+{
+  int count = db->nbr_statements + STMT_INTERNAL_LAST;
+  profile_set_t *set;
+  int i;
+
+  svn_profile__lock(&profile);
+
+  for (set = profile_sets; set; set = set->next)
+    if (set->statements == db->statement_strings
+        && strcmp(set->name, db->name) == 0)
+      break;
+
+  if (set == NULL)
+    {
+      set = calloc(1, sizeof(*set));
+      if (set)
+        {
+          set->name = malloc(strlen(db->name) + 1);
+          set->stats = calloc(count, sizeof(*set->stats));
+          if (set->name == NULL || set->stats == NULL)
+            {
+              free(set->name);
+              free(set->stats);
+              free(set);
+              set = NULL;
+            }
+        }
+
+      if (set)
+        {
+          strcpy(set->name, db->name);
+          set->statements = db->statement_strings;
+          set->nbr_statements = db->nbr_statements;
+          set->next = profile_sets;
+          profile_sets = set;
+        }
+    }
+
+  for (i = 0; set && i < count; ++i)
+    {
+      stmt_stats_t *total = &set->stats[i];
+      const stmt_stats_t *stats = &db->stats[i];
+
+      total->executions += stats->executions;
+      total->steps += stats->steps;
+      total->rows += stats->rows;
+      total->fullscan_steps += stats->fullscan_steps;
+      total->sorts += stats->sorts;
+      total->time_total += stats->time_total;
+      if (total->time_max < stats->time_max)
+        total->time_max = stats->time_max;
+    }
+
+  svn_profile__unlock(&profile);
+}
+
+/* A single line of the profile report. */
+typedef struct report_line_t
+{
+  const profile_set_t *set;
+  int stmt_idx;
+  stmt_stats_t stats;
+} report_line_t;
+
+/* qsort comparison function putting the statements with the largest
+   total execution time first. */
+static int
+compare_report_lines(const void *lhs,
+                     const void *rhs)
+{
+  const report_line_t *left = lhs;
+  const report_line_t *right = rhs;
+
+  if (left->stats.time_total != right->stats.time_total)
+    return left->stats.time_total > right->stats.time_total ? -1 : 1;
+  if (left->stats.executions != right->stats.executions)
+    return left->stats.executions > right->stats.executions ? -1 : 1;
+
+  return left->stmt_idx - right->stmt_idx;
+}
+
+/* Write the first few characters of the statement text SQL to STREAM,
+   collapsing all whitespace into single spaces. */
+static void
+print_sql(FILE *stream,
+          const char *sql)
+{
+  int written = 0;
+  svn_boolean_t space = FALSE;
+
+  for (; *sql && written < 60; ++sql)
+    {
+      if (*sql == ' ' || *sql == '\t' || *sql == '\r' || *sql == '\n')
+        {
+          space = written > 0;
+          continue;
+        }
+
+      if (space)
+        {
+          fputc(' ', stream);
+          ++written;
+          space = FALSE;
+        }
+
+      fputc(*sql, stream);
+      ++written;
+    }
+
+  if (*sql)
+    fputs("...", stream);
+}
+
+void
+svn_sqlite__profile_report(FILE *stream)
+{
+  report_line_t *lines;
+  profile_set_t *set;
+  apr_size_t count = 0;
+  apr_size_t i;
+  int j;
+
+  if (!profile.active)
+    return;
+
+  /* Take a snapshot, so we don't block other threads while printing. */
+  svn_profile__lock(&profile);
+
+  for (set = profile_sets; set; set = set->next)
+    for (j = 0; j < set->nbr_statements + STMT_INTERNAL_LAST; ++j)
+      if (set->stats[j].executions)
+        ++count;
+
+  lines = malloc(count * sizeof(*lines) + 1);
+  if (lines != NULL)
+    {
+      count = 0;
+      for (set = profile_sets; set; set = set->next)
+        for (j = 0; j < set->nbr_statements + STMT_INTERNAL_LAST; ++j)
+          if (set->stats[j].executions)
+            {
+              lines[count].set = set;
+              lines[count].stmt_idx = j;
+              lines[count].stats = set->stats[j];
+              ++count;
+            }
+    }
+
+  svn_profile__unlock(&profile);
+
+  if (lines == NULL)
+    return;
+
+  qsort(lines, count, sizeof(*lines), compare_report_lines);
+
+  fprintf(stream, "SQLite statement profile of %s:\n",
+          profile.progname ? profile.progname : "<unknown>");
+  fprintf(stream, "%-16s %5s %10s %12s %12s %12s %8s %12s %10s  %s\n",
+          "database", "stmt", "executions", "steps", "rows", "scan steps",
+          "sorts", "total ms", "max ms", "statement");
+
+  for (i = 0; i < count; ++i)
+    {
+      const report_line_t *line = &lines[i];
+      const stmt_stats_t *stats = &line->stats;
+      const char *sql;
+      char stmt_name[16];
+
+      /* Internal statements are stored behind the registered ones. */
+      if (line->stmt_idx < line->set->nbr_statements)
+        {
+          sql = line->set->statements[line->stmt_idx];
+          sprintf(stmt_name, "%d", line->stmt_idx);
+        }
+      else
+        {
+          int internal_idx = line->stmt_idx - line->set->nbr_statements;
+          sql = internal_statements[internal_idx];
+          sprintf(stmt_name, "i%d", internal_idx);
+        }
+
+      fprintf(stream,
+              "%-16s %5s %10" APR_UINT64_T_FMT " %12" APR_UINT64_T_FMT
+              " %12" APR_UINT64_T_FMT " %12" APR_UINT64_T_FMT
+              " %8" APR_UINT64_T_FMT " %12.3f %10.3f  ",
+              line->set->name, stmt_name, stats->executions, stats->steps,
+              stats->rows, stats->fullscan_steps, stats->sorts,
+              stats->time_total / 1e6, stats->time_max / 1e6);
+      print_sql(stream, sql);
+      fputc('\n', stream);
+    }
+
+  fflush(stream);
+  free(lines);
+}
+
+void
+svn_sqlite__profile_start(void)
+{
+  svn_profile__start(&profile);
+}
+
+void
+svn_sqlite__profile_init(const char *progname)
+{
+  svn_profile__init(&profile, SVN_SQLITE__PROFILE_ENV, progname);
+}
+
+
+
 /* Convenience wrapper around exec_sql2(). */
 #define exec_sql(db, sql) exec_sql2((db), (sql), SQLITE_OK)
 
@@ -250,6 +554,8 @@ prepare_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
   *stmt = apr_palloc(result_pool, sizeof(**stmt));
   (*stmt)->db = db;
   (*stmt)->needs_reset = FALSE;
+  (*stmt)->stats = NULL;
+  (*stmt)->exec_time = 0;
 
   SQLITE_ERR(sqlite3_prepare_v2(db->db3, text, -1, &(*stmt)->s3stmt, NULL), db);
 
@@ -260,9 +566,24 @@ prepare_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
 svn_error_t *
 svn_sqlite__exec_statements(svn_sqlite__db_t *db, int stmt_idx)
 {
+  svn_error_t *err;
+  apr_uint64_t start;
+
   SVN_ERR_ASSERT(stmt_idx < db->nbr_statements);
 
-  return svn_error_trace(exec_sql(db, db->statement_strings[stmt_idx]));
+  if (!db->stats)
+    return svn_error_trace(exec_sql(db, db->statement_strings[stmt_idx]));
+
+  start = profile_now();
+  err = exec_sql(db, db->statement_strings[stmt_idx]);
+  start = profile_now() - start;
+
+  db->stats[stmt_idx].executions++;
+  db->stats[stmt_idx].time_total += start;
+  if (db->stats[stmt_idx].time_max < start)
+    db->stats[stmt_idx].time_max = start;
+
+  return svn_error_trace(err);
 }
 
 
@@ -273,9 +594,13 @@ svn_sqlite__get_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
   SVN_ERR_ASSERT(stmt_idx < db->nbr_statements);
 
   if (db->prepared_stmts[stmt_idx] == NULL)
-    SVN_ERR(prepare_statement(&db->prepared_stmts[stmt_idx], db,
-                              db->statement_strings[stmt_idx],
-                              db->state_pool));
+    {
+      SVN_ERR(prepare_statement(&db->prepared_stmts[stmt_idx], db,
+                                db->statement_strings[stmt_idx],
+                                db->state_pool));
+      if (db->stats)
+        db->prepared_stmts[stmt_idx]->stats = &db->stats[stmt_idx];
+    }
 
   *stmt = db->prepared_stmts[stmt_idx];
 
@@ -298,9 +623,13 @@ get_internal_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
   SVN_ERR_ASSERT(stmt_idx < STMT_INTERNAL_LAST);
 
   if (db->prepared_stmts[prep_idx] == NULL)
-    SVN_ERR(prepare_statement(&db->prepared_stmts[prep_idx], db,
-                              internal_statements[stmt_idx],
-                              db->state_pool));
+    {
+      SVN_ERR(prepare_statement(&db->prepared_stmts[prep_idx], db,
+                                internal_statements[stmt_idx],
+                                db->state_pool));
+      if (db->stats)
+        db->prepared_stmts[prep_idx]->stats = &db->stats[prep_idx];
+    }
 
   *stmt = db->prepared_stmts[prep_idx];
 
@@ -344,8 +673,23 @@ svn_sqlite__step_row(svn_sqlite__stmt_t *stmt)
 svn_error_t *
 svn_sqlite__step(svn_boolean_t *got_row, svn_sqlite__stmt_t *stmt)
 {
+  apr_uint64_t start = stmt->stats ? profile_now() : 0;
   int sqlite_result = sqlite3_step(stmt->s3stmt);
 
+  if (stmt->stats)
+    {
+      apr_uint64_t duration = profile_now() - start;
+
+      /* The first step after a reset starts a new execution. */
+      if (!stmt->needs_reset)
+        stmt->stats->executions++;
+      stmt->stats->steps++;
+      if (sqlite_result == SQLITE_ROW)
+        stmt->stats->rows++;
+      stmt->stats->time_total += duration;
+      stmt->exec_time += duration;
+    }
+
   if (sqlite_result != SQLITE_DONE && sqlite_result != SQLITE_ROW)
     {
       svn_error_t *err1, *err2;
@@ -750,6 +1094,9 @@ svn_sqlite__reset(svn_sqlite__stmt_t *stmt)
   /* No need to reset again after a first attempt */
   stmt->needs_reset = FALSE;
 
+  if (stmt->stats)
+    profile_flush(stmt);
+
   /* Clear bindings first, as there are no documented reasons
      why this would ever fail, but keeping variable bindings
      when reset is not what we expect. */
@@ -951,12 +1298,17 @@ close_apr(void *data)
                             svn_sqlite__reset(db->prepared_stmts[i]));
 #endif
                 }
+              if (db->prepared_stmts[i]->stats)
+                profile_flush(db->prepared_stmts[i]);
               err = svn_error_compose_create(
                         svn_sqlite__finalize(db->prepared_stmts[i]), err);
             }
         }
     }
 
+  if (db->stats)
+    profile_merge(db);
+
   result = sqlite3_close(db->db3);
 
   /* If there's a pre-existing error, return it. */
@@ -1074,6 +1426,7 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  svn_sqlite__mode_t mode, const char * const statements[],
                  int unused1, const char * const *unused2,
                  apr_int32_t timeout,
+                 const svn_sqlite__tuning_t *tuning,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_atomic__init_once(&sqlite_init_state,
@@ -1164,11 +1517,40 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* Testing shows TRUNCATE is faster than DELETE on Windows.
+
+     Changing the journal mode from or to WAL requires exclusive access to
+     the database.  If other connections are active, simply continue with
+     the mode that they use.  Failure to enable WAL mode, e.g. because the
+     VFS does not support shared memory, is not fatal either. */
+  if (tuning && tuning->wal && mode != svn_sqlite__mode_readonly)
+    svn_error_clear(exec_sql(*db, "PRAGMA journal_mode = WAL;"));
+  else
+    SVN_SQLITE__ERR_CLOSE(exec_sql2(*db, "PRAGMA journal_mode = TRUNCATE;",
+                                    SQLITE_BUSY),
+                          *db);
+
+  if (tuning && tuning->mmap_size > 0)
+    SVN_SQLITE__ERR_CLOSE(exec_sql(*db,
+                                   apr_psprintf(scratch_pool,
+                                                "PRAGMA mmap_size = %"
+                                                APR_INT64_T_FMT ";",
+                                                tuning->mmap_size)),
+                          *db);
+
+  /* Negative values specify the cache size in KiB instead of pages. */
+  if (tuning && tuning->cache_size > 0)
+    SVN_SQLITE__ERR_CLOSE(exec_sql(*db,
+                                   apr_psprintf(scratch_pool,
+                                                "PRAGMA cache_size = -%"
+                                                APR_INT64_T_FMT ";",
+                                                (tuning->cache_size + 1023)
+                                                  / 1024)),
+                          *db);
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
@@ -1215,6 +1597,14 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                                                 * sizeof(svn_sqlite__stmt_t *));
     }
 
+  if (profile.active)
+    {
+      (*db)->name = svn_dirent_basename(path, result_pool);
+      (*db)->stats = apr_pcalloc(result_pool,
+                                 ((*db)->nbr_statements + STMT_INTERNAL_LAST)
+                                   * sizeof(*(*db)->stats));
+    }
+
   (*db)->state_pool = result_pool;
   apr_pool_cleanup_register(result_pool, *db, close_apr, apr_pool_cleanup_null);
 
@@ -1466,7 +1856,7 @@ svn_sqlite__hotcopy(const char *src_path,
   svn_sqlite__db_t *src_db;
 
   SVN_ERR(svn_sqlite__open(&src_db, src_path, svn_sqlite__mode_readonly,
-                           NULL, 0, NULL, 0,
+                           NULL, 0, NULL, 0, NULL,
                            scratch_pool, scratch_pool));
 
   {
@@ -1475,7 +1865,7 @@ svn_sqlite__hotcopy(const char *src_path,
     int rc1, rc2;
 
     SVN_ERR(svn_sqlite__open(&dst_db, dst_path, svn_sqlite__mode_rwcreate,
-                             NULL, 0, NULL, 0, scratch_pool, scratch_pool));
+                             NULL, 0, NULL, 0, NULL, scratch_pool, scratch_pool));
     backup = sqlite3_backup_init(dst_db->db3, "main", src_db->db3, "main");
     if (!backup)
       return svn_error_createf(SVN_ERR_SQLITE_ERROR, NULL,
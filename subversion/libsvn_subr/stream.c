@@ -71,6 +71,12 @@ struct svn_stream_t {
 static svn_error_t *
 skip_default_handler(void *baton, apr_size_t len, svn_read_fn_t read_full_fn);
 
+static svn_error_t *
+read_full_handler_apr(void *baton, char *buffer, apr_size_t *len);
+
+static svn_error_t *
+write_handler_apr(void *baton, const char *data, apr_size_t *len);
+
 
 /*** Generic streams. ***/
 
@@ -402,14 +408,25 @@ svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
                               void *cancel_baton,
                               apr_pool_t *scratch_pool)
 {
-  char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
-  svn_error_t *err;
+  char *buf = NULL;
+  svn_boolean_t copied = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
   svn_error_t *err2;
 
+  /* If both ends are plain files, let the kernel copy the data. */
+  if (from->file && from->read_full_fn == read_full_handler_apr
+      && to->file && to->write_fn == write_handler_apr)
+    err = svn_io__file_copy_in_kernel(&copied, from->file, to->file,
+                                      cancel_func, cancel_baton,
+                                      scratch_pool);
+
+  if (!err && !copied)
+    buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+
   /* Read and write chunks until we get a short read, indicating the
      end of the stream.  (We can't get a short write without an
      associated error.) */
-  while (1)
+  while (!err && !copied)
     {
       apr_size_t len = SVN__STREAM_CHUNK_SIZE;
 
@@ -1363,9 +1380,16 @@ svn_stream_compressed(svn_stream_t *stream, apr_pool_t *pool)
 
 struct checksum_stream_baton
 {
+  /* May be NULL if no checksums of the respective direction are wanted. */
   svn_checksum_ctx_t *read_ctx, *write_ctx;
-  svn_checksum_t **read_checksum;  /* Output value. */
-  svn_checksum_t **write_checksum;  /* Output value. */
+
+  /* Checksum kinds and the respective output values, COUNT elements each.
+     Output values are NULL for checksums that are not being calculated. */
+  svn_checksum_kind_t *kinds;
+  svn_checksum_t ***read_checksums;
+  svn_checksum_t ***write_checksums;
+  int count;
+
   svn_stream_t *proxy;
 
   /* True if more data should be read when closing the stream. */
@@ -1382,7 +1406,7 @@ read_handler_checksum(void *baton, char *buffer, apr_size_t *len)
 
   SVN_ERR(svn_stream_read2(btn->proxy, buffer, len));
 
-  if (btn->read_checksum)
+  if (btn->read_ctx)
     SVN_ERR(svn_checksum_update(btn->read_ctx, buffer, *len));
 
   return SVN_NO_ERROR;
@@ -1396,7 +1420,7 @@ read_full_handler_checksum(void *baton, char *buffer, apr_size_t *len)
 
   SVN_ERR(svn_stream_read_full(btn->proxy, buffer, len));
 
-  if (btn->read_checksum)
+  if (btn->read_ctx)
     SVN_ERR(svn_checksum_update(btn->read_ctx, buffer, *len));
 
   if (saved_len != *len)
@@ -1411,7 +1435,7 @@ write_handler_checksum(void *baton, const char *buffer, apr_size_t *len)
 {
   struct checksum_stream_baton *btn = baton;
 
-  if (btn->write_checksum && *len > 0)
+  if (btn->write_ctx && *len > 0)
     SVN_ERR(svn_checksum_update(btn->write_ctx, buffer, *len));
 
   return svn_error_trace(svn_stream_write(btn->proxy, buffer, len));
@@ -1430,6 +1454,7 @@ static svn_error_t *
 close_handler_checksum(void *baton)
 {
   struct checksum_stream_baton *btn = baton;
+  int i;
 
   /* If we're supposed to drain the stream, do so before finalizing the
      checksum. */
@@ -1445,11 +1470,18 @@ close_handler_checksum(void *baton)
       while (btn->read_more);
     }
 
-  if (btn->read_ctx)
-    SVN_ERR(svn_checksum_final(btn->read_checksum, btn->read_ctx, btn->pool));
-
-  if (btn->write_ctx)
-    SVN_ERR(svn_checksum_final(btn->write_checksum, btn->write_ctx, btn->pool));
+  for (i = 0; i < btn->count; ++i)
+    {
+      if (btn->read_checksums[i])
+        SVN_ERR(svn_checksum__final_kind(btn->read_checksums[i],
+                                         btn->read_ctx, btn->kinds[i],
+                                         btn->pool));
+
+      if (btn->write_checksums[i])
+        SVN_ERR(svn_checksum__final_kind(btn->write_checksums[i],
+                                         btn->write_ctx, btn->kinds[i],
+                                         btn->pool));
+    }
 
   return svn_error_trace(svn_stream_close(btn->proxy));
 }
@@ -1480,33 +1512,62 @@ seek_handler_checksum(void *baton, const svn_stream_mark_t *mark)
 }
 
 
+/* Set *COPY to a copy of the COUNT output values in CHECKSUMS, which may
+ * be NULL.  Return a context calculating the checksums of those KINDS for
+ * which there are output values, or NULL if there are none.  Allocate
+ * everything in POOL.
+ */
+static svn_checksum_ctx_t *
+create_stream_checksum_ctx(svn_checksum_t ****copy,
+                           svn_checksum_t **checksums[],
+                           const svn_checksum_kind_t *kinds,
+                           int count,
+                           apr_pool_t *pool)
+{
+  svn_checksum_kind_t *wanted = apr_palloc(pool, count * sizeof(*wanted));
+  int i, wanted_count = 0;
+
+  *copy = apr_pcalloc(pool, count * sizeof(**copy));
+  if (checksums == NULL)
+    return NULL;
+
+  for (i = 0; i < count; ++i)
+    if (checksums[i])
+      {
+        (*copy)[i] = checksums[i];
+        wanted[wanted_count++] = kinds[i];
+      }
+
+  return wanted_count
+       ? svn_checksum__ctx_create_multi(wanted, wanted_count, pool)
+       : NULL;
+}
+
 svn_stream_t *
-svn_stream_checksummed2(svn_stream_t *stream,
-                        svn_checksum_t **read_checksum,
-                        svn_checksum_t **write_checksum,
-                        svn_checksum_kind_t checksum_kind,
-                        svn_boolean_t read_all,
-                        apr_pool_t *pool)
+svn_stream__checksummed_multi(svn_stream_t *stream,
+                              svn_checksum_t **read_checksums[],
+                              svn_checksum_t **write_checksums[],
+                              const svn_checksum_kind_t *kinds,
+                              int count,
+                              svn_boolean_t read_all,
+                              apr_pool_t *pool)
 {
   svn_stream_t *s;
   struct checksum_stream_baton *baton;
 
-  if (read_checksum == NULL && write_checksum == NULL)
-    return stream;
-
   baton = apr_palloc(pool, sizeof(*baton));
-  if (read_checksum)
-    baton->read_ctx = svn_checksum_ctx_create(checksum_kind, pool);
-  else
-    baton->read_ctx = NULL;
-
-  if (write_checksum)
-    baton->write_ctx = svn_checksum_ctx_create(checksum_kind, pool);
-  else
-    baton->write_ctx = NULL;
+  baton->read_ctx = create_stream_checksum_ctx(&baton->read_checksums,
+                                               read_checksums, kinds, count,
+                                               pool);
+  baton->write_ctx = create_stream_checksum_ctx(&baton->write_checksums,
+                                                write_checksums, kinds,
+                                                count, pool);
+
+  if (baton->read_ctx == NULL && baton->write_ctx == NULL)
+    return stream;
 
-  baton->read_checksum = read_checksum;
-  baton->write_checksum = write_checksum;
+  baton->kinds = apr_pmemdup(pool, kinds, count * sizeof(*kinds));
+  baton->count = count;
   baton->proxy = stream;
   baton->read_more = read_all;
   baton->pool = pool;
@@ -1521,6 +1582,19 @@ svn_stream_checksummed2(svn_stream_t *stream,
   return s;
 }
 
+svn_stream_t *
+svn_stream_checksummed2(svn_stream_t *stream,
+                        svn_checksum_t **read_checksum,
+                        svn_checksum_t **write_checksum,
+                        svn_checksum_kind_t checksum_kind,
+                        svn_boolean_t read_all,
+                        apr_pool_t *pool)
+{
+  return svn_stream__checksummed_multi(stream, &read_checksum,
+                                       &write_checksum, &checksum_kind, 1,
+                                       read_all, pool);
+}
+
 /* Helper for svn_stream_contents_checksum() to compute checksum of
  * KIND of STREAM. This function doesn't close source stream. */
 static svn_error_t *
@@ -0,0 +1,656 @@
+/*
+ * stream_async.c:   streams that move their I/O to a separate thread
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
+
+#include "private/svn_io_private.h"
+
+/* Size of the blocks handed over between the threads.  */
+#define BLOCK_SIZE 0x10000
+
+/* Default for the maximum number of bytes queued between the threads.  */
+#define DEFAULT_MAX_QUEUED 0x400000
+
+#if APR_HAS_THREADS
+
+/* A block of stream data.  */
+typedef struct block_t
+{
+  apr_size_t size;
+  char *data;
+
+  struct block_t *next;
+} block_t;
+
+/* A bounded queue of blocks, passed from a producer thread to a consumer
+   thread.  One side is the caller using the stream, the other side the
+   thread that we started.  All members except POOL and STREAM are
+   protected by MUTEX.  */
+typedef struct block_queue_t
+{
+  /* Blocks waiting to be consumed, in order, and their number.  */
+  block_t *first;
+  block_t *last;
+  int queued;
+
+  /* Upper limit for QUEUED.  */
+  int max_queued;
+
+  /* Blocks that have been consumed and may be reused.  */
+  block_t *free;
+
+  /* Set when the producer will not queue any further blocks.  */
+  svn_boolean_t eof;
+
+  /* Set when the thread shall terminate ASAP and when it did so.  */
+  svn_boolean_t shutdown;
+  svn_boolean_t finished;
+
+  /* First error reported by the thread.  */
+  svn_error_t *error;
+
+  /* Gets signaled whenever any of the above changes.  */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  apr_thread_t *thread;
+
+  /* The stream that the thread reads from or writes to.  */
+  svn_stream_t *stream;
+
+  /* Own root pool for the thread, the blocks and the synchronization
+     objects.  */
+  apr_pool_t *pool;
+} block_queue_t;
+
+/* Return an unused block from QUEUE.  MUTEX must be held.  */
+static block_t *
+get_free_block(block_queue_t *queue)
+{
+  block_t *block = queue->free;
+
+  if (block)
+    {
+      queue->free = block->next;
+    }
+  else
+    {
+      block = apr_palloc(queue->pool, sizeof(*block));
+      block->data = apr_palloc(queue->pool, BLOCK_SIZE);
+    }
+
+  block->size = 0;
+  block->next = NULL;
+
+  return block;
+}
+
+/* Append BLOCK to QUEUE and signal the consumer.  MUTEX must be held.  */
+static void
+put_block(block_queue_t *queue,
+          block_t *block)
+{
+  if (queue->last)
+    queue->last->next = block;
+  else
+    queue->first = block;
+
+  queue->last = block;
+  ++queue->queued;
+
+  apr_thread_cond_broadcast(queue->cond);
+}
+
+/* Remove the first block from QUEUE and return it.  MUTEX must be held
+   and the queue must not be empty.  */
+static block_t *
+take_block(block_queue_t *queue)
+{
+  block_t *block = queue->first;
+
+  queue->first = block->next;
+  if (queue->first == NULL)
+    queue->last = NULL;
+
+  --queue->queued;
+  apr_thread_cond_broadcast(queue->cond);
+
+  return block;
+}
+
+/* Return BLOCK to the unused blocks of QUEUE.  MUTEX must be held.  */
+static void
+release_block(block_queue_t *queue,
+              block_t *block)
+{
+  block->next = queue->free;
+  queue->free = block;
+}
+
+/* Pool cleanup function terminating the thread of the block_queue_t given
+   as DATA.  Data that has not been processed yet will be discarded.  */
+static apr_status_t
+cleanup_queue(void *data)
+{
+  block_queue_t *queue = data;
+  apr_status_t retval;
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->shutdown = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_thread_join(&retval, queue->thread);
+
+  svn_error_clear(queue->error);
+  svn_pool_destroy(queue->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Create a block queue for STREAM in *QUEUE and start THREAD_FUNC on it.
+   Limit the queue to MAX_QUEUED bytes.  The thread gets terminated when
+   RESULT_POOL gets cleaned up.  */
+static svn_error_t *
+start_queue(block_queue_t **queue,
+            svn_stream_t *stream,
+            apr_size_t max_queued,
+            apr_thread_start_t thread_func,
+            apr_pool_t *result_pool)
+{
+  block_queue_t *result;
+  apr_pool_t *pool;
+  apr_status_t status;
+
+  /* The thread may outlive RESULT_POOL's allocator lock, so it gets a
+     root pool of its own.  */
+  pool = svn_pool_create(NULL);
+  result = apr_pcalloc(pool, sizeof(*result));
+  result->pool = pool;
+  result->stream = stream;
+
+  if (max_queued == 0)
+    max_queued = DEFAULT_MAX_QUEUED;
+  result->max_queued = (int)MAX(1, max_queued / BLOCK_SIZE);
+
+  status = apr_thread_mutex_create(&result->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&result->cond, pool);
+  if (!status)
+    status = apr_thread_create(&result->thread, NULL, thread_func, result,
+                               pool);
+  if (status)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_wrap_apr(status, _("Can't start stream thread"));
+    }
+
+  apr_pool_cleanup_register(result_pool, result, cleanup_queue,
+                            apr_pool_cleanup_null);
+  *queue = result;
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Read-ahead streams ***/
+
+/* Baton of a read-ahead stream.  */
+typedef struct read_ahead_baton_t
+{
+  block_queue_t *queue;
+
+  /* The block currently being read by the caller and the read position
+     within it.  Private to the caller's thread.  */
+  block_t *current;
+  apr_size_t offset;
+
+  /* The pool that QUEUE's cleanup is registered with.  */
+  apr_pool_t *pool;
+} read_ahead_baton_t;
+
+/* Thread function reading the source stream of the block_queue_t given
+   as DATA until EOF, an error or shutdown.  */
+static void * APR_THREAD_FUNC
+read_ahead_thread(apr_thread_t *thread,
+                  void *data)
+{
+  block_queue_t *queue = data;
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (!queue->eof)
+    {
+      block_t *block;
+      svn_error_t *err;
+
+      while (queue->queued >= queue->max_queued && !queue->shutdown)
+        apr_thread_cond_wait(queue->cond, queue->mutex);
+
+      if (queue->shutdown)
+        break;
+
+      block = get_free_block(queue);
+      apr_thread_mutex_unlock(queue->mutex);
+
+      block->size = BLOCK_SIZE;
+      err = svn_stream_read_full(queue->stream, block->data, &block->size);
+
+      apr_thread_mutex_lock(queue->mutex);
+      if (err)
+        {
+          queue->error = err;
+          queue->eof = TRUE;
+          release_block(queue, block);
+          apr_thread_cond_broadcast(queue->cond);
+        }
+      else
+        {
+          /* A short read indicates the end of the stream. */
+          if (block->size < BLOCK_SIZE)
+            queue->eof = TRUE;
+          put_block(queue, block);
+        }
+    }
+
+  queue->finished = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Make sure that BATON->CURRENT contains unread data.  Set it to NULL if
+   we reached the end of the stream.  */
+static svn_error_t *
+next_block(read_ahead_baton_t *baton)
+{
+  block_queue_t *queue = baton->queue;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (baton->current && baton->offset < baton->current->size)
+    return SVN_NO_ERROR;
+
+  apr_thread_mutex_lock(queue->mutex);
+
+  if (baton->current)
+    release_block(queue, baton->current);
+  baton->current = NULL;
+  baton->offset = 0;
+
+  while (queue->first == NULL && !queue->eof)
+    apr_thread_cond_wait(queue->cond, queue->mutex);
+
+  /* Skip empty blocks, e.g. the last one of a stream whose length is a
+     multiple of BLOCK_SIZE. */
+  while (queue->first && baton->current == NULL)
+    {
+      block_t *block = take_block(queue);
+      if (block->size)
+        baton->current = block;
+      else
+        release_block(queue, block);
+    }
+
+  /* Report errors only after all data read before them. */
+  if (baton->current == NULL)
+    err = svn_error_dup(queue->error);
+
+  apr_thread_mutex_unlock(queue->mutex);
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_read_fn_t.  Return data from the current block only. */
+static svn_error_t *
+read_ahead_read(void *baton,
+                char *buffer,
+                apr_size_t *len)
+{
+  read_ahead_baton_t *btn = baton;
+  apr_size_t to_copy;
+
+  SVN_ERR(next_block(btn));
+  if (btn->current == NULL)
+    {
+      *len = 0;
+      return SVN_NO_ERROR;
+    }
+
+  to_copy = MIN(*len, btn->current->size - btn->offset);
+  memcpy(buffer, btn->current->data + btn->offset, to_copy);
+  btn->offset += to_copy;
+  *len = to_copy;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t.  Fill BUFFER completely unless we hit EOF. */
+static svn_error_t *
+read_ahead_read_full(void *baton,
+                     char *buffer,
+                     apr_size_t *len)
+{
+  apr_size_t total = 0;
+
+  while (total < *len)
+    {
+      apr_size_t chunk = *len - total;
+
+      SVN_ERR(read_ahead_read(baton, buffer + total, &chunk));
+      if (chunk == 0)
+        break;
+
+      total += chunk;
+    }
+
+  *len = total;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_readline_fn_t.  Same semantics as the default
+   implementation, but scan the buffered blocks directly.  */
+static svn_error_t *
+read_ahead_readline(void *baton,
+                    svn_stringbuf_t **stringbuf,
+                    const char *eol,
+                    svn_boolean_t *eof,
+                    apr_pool_t *pool)
+{
+  read_ahead_baton_t *btn = baton;
+  svn_stringbuf_t *str = svn_stringbuf_create_ensure(SVN__LINE_CHUNK_SIZE,
+                                                     pool);
+  const char *match = eol;
+
+  while (*match)
+    {
+      const char *data;
+      apr_size_t start;
+      apr_size_t end;
+
+      SVN_ERR(next_block(btn));
+      if (btn->current == NULL)
+        {
+          *eof = TRUE;
+          *stringbuf = str;
+          return SVN_NO_ERROR;
+        }
+
+      data = btn->current->data;
+      start = btn->offset;
+      end = btn->current->size;
+
+      for (; btn->offset < end && *match; ++btn->offset)
+        {
+          if (data[btn->offset] == *match)
+            match++;
+          else
+            match = eol;
+        }
+
+      svn_stringbuf_appendbytes(str, data + start, btn->offset - start);
+    }
+
+  *eof = FALSE;
+  svn_stringbuf_chop(str, match - eol);
+  *stringbuf = str;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t.  Stop the thread and close the source. */
+static svn_error_t *
+read_ahead_close(void *baton)
+{
+  read_ahead_baton_t *btn = baton;
+  svn_stream_t *source = btn->queue->stream;
+
+  apr_pool_cleanup_run(btn->pool, btn->queue, cleanup_queue);
+
+  return svn_error_trace(svn_stream_close(source));
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_stream__create_read_ahead(svn_stream_t **stream,
+                              svn_stream_t *source,
+                              apr_size_t max_buffered,
+                              apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  read_ahead_baton_t *baton = apr_pcalloc(result_pool, sizeof(*baton));
+
+  SVN_ERR(start_queue(&baton->queue, source, max_buffered,
+                      read_ahead_thread, result_pool));
+  baton->pool = result_pool;
+
+  *stream = svn_stream_create(baton, result_pool);
+  svn_stream_set_read2(*stream, read_ahead_read, read_ahead_read_full);
+  svn_stream_set_readline(*stream, read_ahead_readline);
+  svn_stream_set_close(*stream, read_ahead_close);
+#else
+  *stream = source;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
+#if APR_HAS_THREADS
+
+/*** Asynchronous writers ***/
+
+/* Baton of an asynchronous writer stream.  */
+typedef struct async_writer_baton_t
+{
+  block_queue_t *queue;
+
+  /* The block currently being filled by the caller.  Private to the
+     caller's thread.  */
+  block_t *current;
+
+  /* The pool that QUEUE's cleanup is registered with.  */
+  apr_pool_t *pool;
+} async_writer_baton_t;
+
+/* Thread function writing the blocks of the block_queue_t given as DATA
+   to its target stream and closing the target at EOF.  */
+static void * APR_THREAD_FUNC
+async_writer_thread(apr_thread_t *thread,
+                    void *data)
+{
+  block_queue_t *queue = data;
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (TRUE)
+    {
+      block_t *block;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      while (queue->first == NULL && !queue->eof && !queue->shutdown)
+        apr_thread_cond_wait(queue->cond, queue->mutex);
+
+      if (queue->shutdown)
+        break;
+
+      if (queue->first == NULL)
+        {
+          /* EOF and all data written. */
+          if (queue->error == NULL)
+            {
+              apr_thread_mutex_unlock(queue->mutex);
+              err = svn_stream_close(queue->stream);
+              apr_thread_mutex_lock(queue->mutex);
+              queue->error = err;
+            }
+
+          break;
+        }
+
+      block = take_block(queue);
+
+      /* After an error, we only discard the remaining data. */
+      if (queue->error == NULL)
+        {
+          apr_size_t len = block->size;
+
+          apr_thread_mutex_unlock(queue->mutex);
+          err = svn_stream_write(queue->stream, block->data, &len);
+          apr_thread_mutex_lock(queue->mutex);
+          queue->error = err;
+        }
+
+      release_block(queue, block);
+    }
+
+  queue->finished = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Hand BATON->CURRENT over to the writer thread.  If LAST is set, signal
+   EOF to the writer as well.  Block while the writer lags too far behind.
+   Return any error reported by the writer.  */
+static svn_error_t *
+flush_block(async_writer_baton_t *baton,
+            svn_boolean_t last)
+{
+  block_queue_t *queue = baton->queue;
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (queue->queued >= queue->max_queued && queue->error == NULL)
+    apr_thread_cond_wait(queue->cond, queue->mutex);
+
+  if (baton->current)
+    put_block(queue, baton->current);
+  baton->current = NULL;
+
+  if (last)
+    {
+      queue->eof = TRUE;
+      apr_thread_cond_broadcast(queue->cond);
+    }
+
+  err = svn_error_dup(queue->error);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_write_fn_t.  Queue the data for the writer thread. */
+static svn_error_t *
+async_writer_write(void *baton,
+                   const char *data,
+                   apr_size_t *len)
+{
+  async_writer_baton_t *btn = baton;
+  apr_size_t remaining = *len;
+
+  while (remaining)
+    {
+      apr_size_t to_copy;
+
+      if (btn->current == NULL)
+        {
+          apr_thread_mutex_lock(btn->queue->mutex);
+          btn->current = get_free_block(btn->queue);
+          apr_thread_mutex_unlock(btn->queue->mutex);
+        }
+
+      to_copy = MIN(remaining, BLOCK_SIZE - btn->current->size);
+      memcpy(btn->current->data + btn->current->size, data, to_copy);
+      btn->current->size += to_copy;
+      data += to_copy;
+      remaining -= to_copy;
+
+      if (btn->current->size == BLOCK_SIZE)
+        SVN_ERR(flush_block(btn, FALSE));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t.  Wait for the writer to write all data and
+   to close the target.  */
+static svn_error_t *
+async_writer_close(void *baton)
+{
+  async_writer_baton_t *btn = baton;
+  block_queue_t *queue = btn->queue;
+  svn_error_t *err = flush_block(btn, TRUE);
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (!queue->finished)
+    apr_thread_cond_wait(queue->cond, queue->mutex);
+
+  svn_error_clear(err);
+  err = queue->error;
+  queue->error = NULL;
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_pool_cleanup_run(btn->pool, queue, cleanup_queue);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_stream__create_async_writer(svn_stream_t **stream,
+                                svn_stream_t *target,
+                                apr_size_t max_buffered,
+                                apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  async_writer_baton_t *baton = apr_pcalloc(result_pool, sizeof(*baton));
+
+  SVN_ERR(start_queue(&baton->queue, target, max_buffered,
+                      async_writer_thread, result_pool));
+  baton->pool = result_pool;
+
+  *stream = svn_stream_create(baton, result_pool);
+  svn_stream_set_write(*stream, async_writer_write);
+  svn_stream_set_close(*stream, async_writer_close);
+#else
+  *stream = target;
+#endif
+
+  return SVN_NO_ERROR;
+}
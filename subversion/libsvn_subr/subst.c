@@ -51,6 +51,7 @@
 
 #include "private/svn_string_private.h"
 #include "private/svn_eol_private.h"
+#include "private/svn_simd_private.h"
 
 /**
  * The textual elements of a detranslated special file.  One of these
@@ -980,6 +981,138 @@ eol_unchanged(struct translation_baton *b,
   return !b->interesting[(unsigned char)buf[1]] || buf[0] == buf[1];
 }
 
+/* Return the first char in the range START to END that B considers
+ * interesting, or END if there is none.
+ */
+static APR_INLINE const char *
+find_interesting(const struct translation_baton *b,
+                 const char *start,
+                 const char *end)
+{
+  const char *interesting = b->interesting;
+
+#if SVN__HAVE_SSE2
+
+  /* The only interesting chars are '$' and the EOL chars.  Compare 16
+     bytes at a time against all of them and mask out those that are not
+     interesting for this translation. */
+  const __m128i dollar = _mm_set1_epi8('$');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i use_dollar = _mm_set1_epi8(interesting['$'] ? -1 : 0);
+  const __m128i use_eol = _mm_set1_epi8(interesting['\n'] ? -1 : 0);
+
+  for (; end - start >= (apr_ssize_t)sizeof(__m128i);
+       start += sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)start);
+      __m128i eols = _mm_or_si128(_mm_cmpeq_epi8(chunk, cr),
+                                  _mm_cmpeq_epi8(chunk, lf));
+      __m128i found
+        = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(chunk, dollar),
+                                     use_dollar),
+                       _mm_and_si128(eols, use_eol));
+      int mask = _mm_movemask_epi8(found);
+      if (mask)
+        return start + svn__lowest_bit_index(mask);
+    }
+
+#else
+
+  /* Check 4 bytes at once to allow for efficient pipelining
+     and to reduce loop condition overhead. */
+  for (; end - start >= 4; start += 4)
+    if (interesting[(unsigned char)start[0]]
+        || interesting[(unsigned char)start[1]]
+        || interesting[(unsigned char)start[2]]
+        || interesting[(unsigned char)start[3]])
+      break;
+
+#endif
+
+  /* Find the exact position of the interesting char, if any. */
+  while (start < end && !interesting[(unsigned char)*start])
+    ++start;
+
+  return start;
+}
+
+/* Assuming that B->NL_TRANSLATION_SKIPPABLE is TRUE, i.e. EOLs that are
+ * already in B->EOL_STR format can be copied as they are, return the
+ * position in the range START to END up to which the data contains only
+ * such EOLs and no other interesting chars.
+ *
+ * The result is conservative: it may be START, it will not be within the
+ * last two bytes before END (see the EOF check in translate_chunk) and it
+ * will never point behind a CR, so the caller can continue with its own
+ * scan from there.
+ */
+static const char *
+skip_unchanged_eols(const struct translation_baton *b,
+                    const char *start,
+                    const char *end)
+{
+#if SVN__HAVE_SSE2
+
+  const __m128i dollar = _mm_set1_epi8('$');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const char *p = start;
+  int carry = 0;
+  char eol_char;
+
+  /* We only handle the standard EOL styles here. */
+  if (b->eol_str_len == 2 && b->eol_str[0] == '\r' && b->eol_str[1] == '\n')
+    eol_char = 0;
+  else if (b->eol_str_len == 1 && (*b->eol_str == '\r' || *b->eol_str == '\n'))
+    eol_char = *b->eol_str;
+  else
+    return start;
+
+  /* Stop at the first block that contains anything else than unchanged
+     EOLs.  For CRLF, a CR at the end of a block must be followed by a LF
+     at the start of the next one, tracked by CARRY. */
+  for (; end - p >= (apr_ssize_t)sizeof(__m128i) + 2; p += sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+      int cr_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, cr));
+      int lf_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf));
+
+      if (b->keywords && _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, dollar)))
+        break;
+
+      if (eol_char == '\n')
+        {
+          if (cr_mask)
+            break;
+        }
+      else if (eol_char == '\r')
+        {
+          if (lf_mask)
+            break;
+        }
+      else
+        {
+          if (lf_mask != (((cr_mask << 1) | carry) & 0xffff))
+            break;
+          carry = cr_mask >> 15;
+        }
+    }
+
+  /* Let the caller decide upon any CR that we might have skipped, e.g. a
+     CRLF or a lone CR spanning the block boundary. */
+  if (p > start && p[-1] == '\r')
+    --p;
+
+  return p;
+
+#else
+
+  return start;
+
+#endif
+}
+
 
 /* Translate eols and keywords of a 'chunk' of characters BUF of size BUFLEN
  * according to the settings and state stored in baton B.
@@ -1008,7 +1141,6 @@ translate_chunk(svn_stream_t *dst,
     {
       /* precalculate some oft-used values */
       const char *end = buf + buflen;
-      const char *interesting = b->interesting;
       apr_size_t next_sign_off = 0;
 
       /* At the beginning of this loop, assume that we might be in an
@@ -1115,6 +1247,10 @@ translate_chunk(svn_stream_t *dst,
            */
           len = 0 - b->eol_str_len;
 
+          /* Skip large runs of EOLs that don't need translation in bulk. */
+          if (b->nl_translation_skippable == svn_tristate_true)
+            len += skip_unchanged_eols(b, p, end) - p;
+
           /* Look for the next EOL (or $) that actually needs translation.
              Stop there or at EOF, whichever is encountered first.
            */
@@ -1125,24 +1261,8 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
+                  /* find the next EOL or '$' */
+                  len = find_interesting(b, p + len, end) - p;
                 }
               else
                 {
@@ -1160,8 +1280,7 @@ translate_chunk(svn_stream_t *dst,
                  (end - p) > (len + 2) &&     /* not too close to EOF */
                  eol_unchanged(b, p + len));  /* EOL format already ok */
 
-          while ((p + len) < end && !interesting[(unsigned char)p[len]])
-            len++;
+          len = find_interesting(b, p + len, end) - p;
 
           if (len)
             {
@@ -0,0 +1,463 @@
+/* task.c : ordered task queue with concurrent processing
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
+
+#include "private/svn_task.h"
+
+/* Default number of in-flight tasks per worker thread. */
+#define PENDING_PER_THREAD 2
+
+/* Upper limit to the number of worker threads per queue. */
+#define MAX_THREADS 64
+
+/* A single entry in the task queue.  It is allocated in its own POOL. */
+typedef struct task_t
+{
+  /* Next task in submission order or NULL. */
+  struct task_t *next;
+
+  /* Callbacks and their baton as passed to svn_task__queue_add(). */
+  svn_task__process_func_t process_func;
+  svn_task__output_func_t output_func;
+  void *baton;
+
+  /* Result of the process step. */
+  void *result;
+  svn_error_t *error;
+
+  /* Set once the process step has completed. */
+  svn_boolean_t done;
+
+  /* Pool containing this struct and everything that belongs to the task. */
+  apr_pool_t *pool;
+} task_t;
+
+struct svn_task__queue_t
+{
+  /* List of all tasks that have not been output yet, in submission order.
+   * LAST is NULL if the list is empty. */
+  task_t *first;
+  task_t *last;
+
+  /* First task in the list that has not been picked up by a worker yet.
+   * NULL, if there is none. */
+  task_t *next_todo;
+
+  /* Number of entries in the list and the limit to that. */
+  int pending;
+  int max_pending;
+
+  /* Number of process steps completed so far and the value of that
+   * counter seen by the last svn_task__queue_wait() call. */
+  apr_uint64_t processed;
+  apr_uint64_t processed_seen;
+
+  /* Number of worker threads.  0, if tasks are run synchronously. */
+  int thread_count;
+
+#if APR_HAS_THREADS
+  /* The worker threads. */
+  apr_thread_t **threads;
+
+  /* Set when the workers shall terminate. */
+  svn_boolean_t shutdown;
+
+  /* Protects all of the above.  WORK_COND gets signaled when there is a
+   * new task to process or SHUTDOWN got set.  DONE_COND gets signaled
+   * whenever a worker completed a task. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *work_cond;
+  apr_thread_cond_t *done_cond;
+
+  /* Thread-safe pool that the threads and synchronization objects live
+   * in.  Owned by the queue. */
+  apr_pool_t *thread_pool;
+#endif
+};
+
+/* Execute the process step of TASK. */
+static void
+process_task(task_t *task)
+{
+  apr_pool_t *scratch_pool;
+
+  if (task->process_func == NULL)
+    return;
+
+  scratch_pool = svn_pool_create(task->pool);
+  task->error = task->process_func(&task->result, task->baton,
+                                   task->pool, scratch_pool);
+  svn_pool_destroy(scratch_pool);
+}
+
+/* Execute the output step of TASK and release it.  Return any error
+ * produced by either step.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+output_task(task_t *task,
+            apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = task->error;
+
+  if (!err && task->output_func)
+    err = task->output_func(task->result, task->baton, scratch_pool);
+
+  svn_pool_destroy(task->pool);
+
+  return svn_error_trace(err);
+}
+
+#if APR_HAS_THREADS
+
+/* Handy macro to check APR function results and turning them into
+ * svn_error_t upon failure. */
+#define WRAP_APR_ERR(x,msg)                     \
+  {                                             \
+    apr_status_t status_ = (x);                 \
+    if (status_)                                \
+      return svn_error_wrap_apr(status_, msg);  \
+  }
+
+/* Worker thread function.  DATA is the svn_task__queue_t. */
+static void * APR_THREAD_FUNC
+worker(apr_thread_t *thread,
+       void *data)
+{
+  svn_task__queue_t *queue = data;
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (TRUE)
+    {
+      task_t *task;
+
+      while (!queue->shutdown && queue->next_todo == NULL)
+        apr_thread_cond_wait(queue->work_cond, queue->mutex);
+
+      if (queue->shutdown)
+        break;
+
+      task = queue->next_todo;
+      queue->next_todo = task->next;
+      apr_thread_mutex_unlock(queue->mutex);
+
+      process_task(task);
+
+      apr_thread_mutex_lock(queue->mutex);
+      task->done = TRUE;
+      ++queue->processed;
+      apr_thread_cond_broadcast(queue->done_cond);
+    }
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Terminate all worker threads of QUEUE and wait for them to finish.
+ * Tasks that are currently being processed will be completed first. */
+static void
+stop_workers(svn_task__queue_t *queue)
+{
+  int i;
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->shutdown = TRUE;
+  apr_thread_cond_broadcast(queue->work_cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  for (i = 0; i < queue->thread_count; ++i)
+    if (queue->threads[i])
+      {
+        apr_status_t retval;
+        apr_thread_join(&retval, queue->threads[i]);
+        queue->threads[i] = NULL;
+      }
+}
+
+#endif
+
+/* Pool cleanup function for svn_task__queue_t given by DATA.  Stop all
+ * workers and discard all tasks that have not been output yet. */
+static apr_status_t
+queue_cleanup(void *data)
+{
+  svn_task__queue_t *queue = data;
+
+#if APR_HAS_THREADS
+  if (queue->mutex)
+    stop_workers(queue);
+#endif
+
+  while (queue->first)
+    {
+      task_t *task = queue->first;
+      queue->first = task->next;
+      svn_error_clear(task->error);
+      svn_pool_destroy(task->pool);
+    }
+
+  queue->last = NULL;
+  queue->next_todo = NULL;
+  queue->pending = 0;
+
+#if APR_HAS_THREADS
+  if (queue->thread_pool)
+    {
+      svn_pool_destroy(queue->thread_pool);
+      queue->thread_pool = NULL;
+      queue->mutex = NULL;
+    }
+#endif
+
+  return APR_SUCCESS;
+}
+
+/* Output tasks from the head of QUEUE that have already been processed.
+ * If there are more than KEEP tasks pending, wait for the head to get
+ * processed until that limit is met.  Return the first error reported
+ * by an output task.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+output_completed(svn_task__queue_t *queue,
+                 int keep,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (queue->first)
+    {
+      task_t *task;
+      svn_boolean_t done;
+
+#if APR_HAS_THREADS
+      WRAP_APR_ERR(apr_thread_mutex_lock(queue->mutex),
+                   _("Can't lock task queue mutex"));
+
+      task = queue->first;
+      while (!task->done && queue->pending > keep)
+        {
+          apr_status_t status = apr_thread_cond_wait(queue->done_cond,
+                                                     queue->mutex);
+          if (status)
+            {
+              apr_thread_mutex_unlock(queue->mutex);
+              return svn_error_wrap_apr(status,
+                                        _("Can't wait for task completion"));
+            }
+        }
+
+      done = task->done;
+      if (done)
+        {
+          queue->first = task->next;
+          if (queue->first == NULL)
+            queue->last = NULL;
+          --queue->pending;
+        }
+
+      WRAP_APR_ERR(apr_thread_mutex_unlock(queue->mutex),
+                   _("Can't unlock task queue mutex"));
+#else
+      /* Without threads, all tasks get processed synchronously. */
+      task = queue->first;
+      done = TRUE;
+      queue->first = task->next;
+      if (queue->first == NULL)
+        queue->last = NULL;
+      --queue->pending;
+#endif
+
+      if (!done)
+        break;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(output_task(task, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_task__queue_create(svn_task__queue_t **queue,
+                       int thread_count,
+                       int max_pending,
+                       apr_pool_t *result_pool)
+{
+  svn_task__queue_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+#if APR_HAS_THREADS
+  if (thread_count > MAX_THREADS)
+    thread_count = MAX_THREADS;
+
+  /* A single worker would only add overhead to the sequential case. */
+  result->thread_count = thread_count > 1 ? thread_count : 0;
+#endif
+
+  if (max_pending <= 0)
+    max_pending = PENDING_PER_THREAD * MAX(result->thread_count, 1);
+  result->max_pending = max_pending;
+
+  apr_pool_cleanup_register(result_pool, result, queue_cleanup,
+                            apr_pool_cleanup_null);
+
+#if APR_HAS_THREADS
+  if (result->thread_count)
+    {
+      int i;
+
+      /* The threads will release their resources asynchronously, hence
+       * they need a thread-safe pool to live in. */
+      result->thread_pool = svn_pool_create(NULL);
+      result->threads = apr_pcalloc(result->thread_pool,
+                                    result->thread_count
+                                      * sizeof(*result->threads));
+
+      WRAP_APR_ERR(apr_thread_mutex_create(&result->mutex,
+                                           APR_THREAD_MUTEX_DEFAULT,
+                                           result->thread_pool),
+                   _("Can't create task queue mutex"));
+      WRAP_APR_ERR(apr_thread_cond_create(&result->work_cond,
+                                          result->thread_pool),
+                   _("Can't create condition variable"));
+      WRAP_APR_ERR(apr_thread_cond_create(&result->done_cond,
+                                          result->thread_pool),
+                   _("Can't create condition variable"));
+
+      for (i = 0; i < result->thread_count; ++i)
+        WRAP_APR_ERR(apr_thread_create(&result->threads[i], NULL, worker,
+                                       result, result->thread_pool),
+                     _("Can't create task queue worker thread"));
+    }
+#endif
+
+  *queue = result;
+
+  return SVN_NO_ERROR;
+}
+
+int
+svn_task__queue_thread_count(svn_task__queue_t *queue)
+{
+  return queue->thread_count;
+}
+
+svn_error_t *
+svn_task__queue_add(svn_task__queue_t *queue,
+                    svn_task__process_func_t process_func,
+                    svn_task__output_func_t output_func,
+                    void *task_baton,
+                    apr_pool_t *task_pool,
+                    apr_pool_t *scratch_pool)
+{
+  task_t *task = apr_pcalloc(task_pool, sizeof(*task));
+  svn_error_t *err;
+
+  task->process_func = process_func;
+  task->output_func = output_func;
+  task->baton = task_baton;
+  task->pool = task_pool;
+
+  /* Sequential execution.  Nothing can be pending in that case. */
+  if (queue->thread_count == 0)
+    {
+      process_task(task);
+      return svn_error_trace(output_task(task, scratch_pool));
+    }
+
+  /* Make room for the new task. */
+  err = output_completed(queue, queue->max_pending - 1, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(task_pool);
+      return svn_error_trace(err);
+    }
+
+#if APR_HAS_THREADS
+  WRAP_APR_ERR(apr_thread_mutex_lock(queue->mutex),
+               _("Can't lock task queue mutex"));
+
+  if (queue->last)
+    queue->last->next = task;
+  else
+    queue->first = task;
+  queue->last = task;
+
+  if (queue->next_todo == NULL)
+    queue->next_todo = task;
+  ++queue->pending;
+
+  apr_thread_cond_signal(queue->work_cond);
+
+  WRAP_APR_ERR(apr_thread_mutex_unlock(queue->mutex),
+               _("Can't unlock task queue mutex"));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_task__queue_wait(svn_task__queue_t *queue,
+                     apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  if (queue->thread_count)
+    {
+      WRAP_APR_ERR(apr_thread_mutex_lock(queue->mutex),
+                   _("Can't lock task queue mutex"));
+
+      while (queue->pending && queue->processed == queue->processed_seen)
+        {
+          apr_status_t status = apr_thread_cond_wait(queue->done_cond,
+                                                     queue->mutex);
+          if (status)
+            {
+              apr_thread_mutex_unlock(queue->mutex);
+              return svn_error_wrap_apr(status,
+                                        _("Can't wait for task completion"));
+            }
+        }
+      queue->processed_seen = queue->processed;
+
+      WRAP_APR_ERR(apr_thread_mutex_unlock(queue->mutex),
+                   _("Can't unlock task queue mutex"));
+    }
+#endif
+
+  /* Output whatever is ready without waiting for the remaining tasks. */
+  return svn_error_trace(output_completed(queue, queue->max_pending,
+                                          scratch_pool));
+}
+
+svn_error_t *
+svn_task__queue_drain(svn_task__queue_t *queue,
+                      apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(output_completed(queue, 0, scratch_pool));
+}
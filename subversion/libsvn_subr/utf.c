@@ -45,6 +45,7 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_string_private.h"
 #include "private/svn_mutex.h"
+#include "private/svn_simd_private.h"
 
 
 
@@ -566,6 +567,34 @@ convert_to_stringbuf(xlate_handle_node_t *node,
 }
 
 
+/* Return the length of a prefix of the LEN bytes at DATA that only consists
+   of seven-bit, non-control (except for whitespace) ASCII characters.  This
+   is a quick estimate; the actual prefix may be longer. */
+static apr_size_t
+safe_ascii_prefix_len(const char *data, apr_size_t len)
+{
+  apr_size_t i = 0;
+
+#if SVN__HAVE_SSE2
+  /* Check 16 bytes at a time for 0x20-0x7e and the whitespace 0x09-0x0d. */
+  for (; len - i >= 16; i += 16)
+    {
+      __m128i in = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i printable
+        = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(0x1f)),
+                        _mm_cmplt_epi8(in, _mm_set1_epi8(0x7f)));
+      __m128i space
+        = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(0x08)),
+                        _mm_cmplt_epi8(in, _mm_set1_epi8(0x0e)));
+
+      if (_mm_movemask_epi8(_mm_or_si128(printable, space)) != 0xffff)
+        break;
+    }
+#endif
+
+  return i;
+}
+
 /* Return APR_EINVAL if the first LEN bytes of DATA contain anything
    other than seven-bit, non-control (except for whitespace) ASCII
    characters, finding the error pool from POOL.  Otherwise, return
@@ -574,8 +603,9 @@ static svn_error_t *
 check_non_ascii(const char *data, apr_size_t len, apr_pool_t *pool)
 {
   const char *data_start = data;
+  apr_size_t safe_len = safe_ascii_prefix_len(data, len);
 
-  for (; len > 0; --len, data++)
+  for (data += safe_len, len -= safe_len; len > 0; --len, data++)
     {
       if ((! svn_ctype_isascii(*data))
           || ((! svn_ctype_isspace(*data))
@@ -741,6 +771,47 @@ svn_utf_string_to_utf8(const svn_string_t **dest,
 }
 
 
+/* Return TRUE if the LEN bytes at DATA only contain characters that are
+   encoded the same way in UTF-8 and in any ASCII compatible native
+   encoding, i.e. that never need to be converted.  This excludes all
+   control characters except TAB, LF and CR, as well as backslash and
+   tilde, which some Japanese encodings use for other characters. */
+static svn_boolean_t
+is_invariant_ascii(const char *data, apr_size_t len)
+{
+  apr_size_t i = 0;
+
+#if SVN__HAVE_SSE2
+  for (; len - i >= 16; i += 16)
+    {
+      __m128i in = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i ok
+        = _mm_andnot_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('\\')),
+                           _mm_and_si128(_mm_cmpgt_epi8(in,
+                                                        _mm_set1_epi8(0x1f)),
+                                         _mm_cmplt_epi8(in,
+                                                        _mm_set1_epi8('~'))));
+
+      ok = _mm_or_si128(ok, _mm_cmpeq_epi8(in, _mm_set1_epi8('\t')));
+      ok = _mm_or_si128(ok, _mm_cmpeq_epi8(in, _mm_set1_epi8('\n')));
+      ok = _mm_or_si128(ok, _mm_cmpeq_epi8(in, _mm_set1_epi8('\r')));
+
+      if (_mm_movemask_epi8(ok) != 0xffff)
+        return FALSE;
+    }
+#endif
+
+  for (; i < len; ++i)
+    {
+      char c = data[i];
+      if (!(c >= 0x20 && c < '~' && c != '\\')
+          && c != '\t' && c != '\n' && c != '\r')
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /* Common implementation for svn_utf_cstring_to_utf8,
    svn_utf_cstring_to_utf8_ex, svn_utf_cstring_from_utf8 and
    svn_utf_cstring_from_utf8_ex. Convert SRC to DEST using NODE->handle as
@@ -775,6 +846,15 @@ svn_utf_cstring_to_utf8(const char **dest,
 {
   xlate_handle_node_t *node;
   svn_error_t *err;
+  apr_size_t len = strlen(src);
+
+  /* Most strings are plain ASCII.  Don't bother looking up a converter
+     for them. */
+  if (is_invariant_ascii(src, len))
+    {
+      *dest = apr_pstrmemdup(pool, src, len);
+      return SVN_NO_ERROR;
+    }
 
   SVN_ERR(get_ntou_xlate_handle_node(&node, pool));
   err = convert_cstring(dest, src, node, pool);
@@ -899,6 +979,14 @@ svn_utf_cstring_from_utf8(const char **dest,
 {
   xlate_handle_node_t *node;
   svn_error_t *err;
+  apr_size_t len = strlen(src);
+
+  /* Plain ASCII is valid UTF-8 and needs no conversion. */
+  if (is_invariant_ascii(src, len))
+    {
+      *dest = apr_pstrmemdup(pool, src, len);
+      return SVN_NO_ERROR;
+    }
 
   SVN_ERR(check_cstring_utf8(src, pool));
 
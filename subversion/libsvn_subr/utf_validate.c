@@ -59,6 +59,7 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_simd_private.h"
 
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
@@ -276,10 +277,123 @@ first_non_fsm_start_char(const char *data, apr_size_t max_len)
   return data;
 }
 
+#if SVN__HAVE_SSE2
+
+/* Return a mask of all bytes that are >= C in the vector X. */
+static APR_INLINE __m128i
+bytes_at_least(__m128i x, unsigned char c)
+{
+  return _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8((char)c)), x);
+}
+
+/* Return a vector that has the bytes of IN shifted up by N positions,
+ * filled with the last N bytes of PREV.  I.e. byte I of the result is
+ * the byte N positions before byte I of IN in the input string. */
+#define PRECEDING_BYTES(in, prev, n) \
+  _mm_or_si128(_mm_slli_si128(in, n), _mm_srli_si128(prev, 16 - n))
+
+/* Return a mask of the bytes in the 16 byte block IN that violate the
+ * rules in the table at the top of this file.  PREV is the block preceding
+ * IN in the string, i.e. the check covers multi-byte characters that
+ * straddle the block boundary.  Characters extending beyond IN are not
+ * reported as invalid; they will be checked together with the next block.
+ *
+ * Instead of running the state machine, determine for each byte whether
+ * it has to be a continuation byte, based on the lead bytes in up to three
+ * preceding positions, and compare that with what the bytes actually are.
+ * The range restrictions for the second byte of some sequences as well as
+ * the octets that may never occur are checked separately.
+ */
+static APR_INLINE __m128i
+block_errors(__m128i in, __m128i prev)
+{
+  __m128i prev1 = PRECEDING_BYTES(in, prev, 1);
+  __m128i prev2 = PRECEDING_BYTES(in, prev, 2);
+  __m128i prev3 = PRECEDING_BYTES(in, prev, 3);
+
+  __m128i is_tail = _mm_cmpeq_epi8(_mm_and_si128(in, _mm_set1_epi8(-0x40)),
+                                   _mm_set1_epi8(-0x80));
+  __m128i must_be_tail = _mm_or_si128(_mm_or_si128(bytes_at_least(prev1, 0xc0),
+                                                   bytes_at_least(prev2, 0xe0)),
+                                      bytes_at_least(prev3, 0xf0));
+  __m128i errors = _mm_xor_si128(is_tail, must_be_tail);
+
+  /* 0xc0, 0xc1 and 0xf5-0xff */
+  errors = _mm_or_si128(errors, bytes_at_least(in, 0xf5));
+  errors = _mm_or_si128(errors,
+                        _mm_cmpeq_epi8(_mm_and_si128(in, _mm_set1_epi8(-2)),
+                                       _mm_set1_epi8(-0x40)));
+
+  /* 0xe0 %xA0-BF, 0xed %x80-9F, 0xf0 %x90-BF and 0xf4 %x80-8F */
+  errors = _mm_or_si128(errors,
+             _mm_andnot_si128(bytes_at_least(in, 0xa0),
+                              _mm_cmpeq_epi8(prev1, _mm_set1_epi8(-0x20))));
+  errors = _mm_or_si128(errors,
+             _mm_and_si128(bytes_at_least(in, 0xa0),
+                           _mm_cmpeq_epi8(prev1, _mm_set1_epi8(-0x13))));
+  errors = _mm_or_si128(errors,
+             _mm_andnot_si128(bytes_at_least(in, 0x90),
+                              _mm_cmpeq_epi8(prev1, _mm_set1_epi8(-0x10))));
+  errors = _mm_or_si128(errors,
+             _mm_and_si128(bytes_at_least(in, 0x90),
+                           _mm_cmpeq_epi8(prev1, _mm_set1_epi8(-0x0c))));
+
+  return errors;
+}
+
+#endif
+
+/* Return the position in DATA, which is LEN bytes long, up to which
+ * the string has been found to be valid UTF-8.  It is always the start of
+ * a character, i.e. the state machine may continue in FSM_START there.
+ * The remainder of the string will still need to be checked.
+ */
+static const char *
+skip_valid_chars(const char *data, apr_size_t len)
+{
+#if SVN__HAVE_SSE2
+  const char *start = data;
+  const char *end = data + len;
+  __m128i prev = _mm_setzero_si128();
+
+  for (; end - data >= 16; data += 16)
+    {
+      __m128i in = _mm_loadu_si128((const __m128i *)data);
+
+      /* Fast path for plain ASCII. */
+      if ((_mm_movemask_epi8(in) | _mm_movemask_epi8(prev)) == 0)
+        continue;
+
+      if (_mm_movemask_epi8(block_errors(in, prev)))
+        break;
+
+      prev = in;
+    }
+
+  /* Everything before DATA is valid, except that the character at DATA-1
+   * may be incomplete.  Go back to its first byte. */
+  if (data > start)
+    {
+      int i;
+
+      --data;
+      for (i = 0; i < 3 && data > start; ++i)
+        if (((unsigned char)*data & 0xc0) == 0x80)
+          --data;
+        else
+          break;
+    }
+
+  return data;
+#else
+  return first_non_fsm_start_char(data, len);
+#endif
+}
+
 const char *
 svn_utf__last_valid(const char *data, apr_size_t len)
 {
-  const char *start = first_non_fsm_start_char(data, len);
+  const char *start = skip_valid_chars(data, len);
   const char *end = data + len;
   int state = FSM_START;
 
@@ -313,7 +427,7 @@ svn_utf__is_valid(const char *data, apr_size_t len)
   if (!data)
     return FALSE;
 
-  data = first_non_fsm_start_char(data, len);
+  data = skip_valid_chars(data, len);
 
   while (data < end)
     {
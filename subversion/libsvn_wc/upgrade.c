@@ -42,6 +42,7 @@
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
 #include "private/svn_token.h"
 
 /* WC-1.0 administrative area extensions */
@@ -1044,6 +1045,9 @@ migrate_text_bases(apr_hash_t **text_bases_info,
         apr_finfo_t finfo;
         svn_stream_t *read_stream;
         svn_stream_t *result_stream;
+        svn_checksum_t **checksums[2];
+        static const svn_checksum_kind_t checksum_kinds[2]
+          = { svn_checksum_md5, svn_checksum_sha1 };
 
         text_base_path = svn_dirent_join(text_base_dir, text_base_basename,
                                          iterpool);
@@ -1057,13 +1061,11 @@ migrate_text_bases(apr_hash_t **text_bases_info,
         SVN_ERR(svn_stream_open_readonly(&read_stream, text_base_path,
                                            iterpool, iterpool));
 
-        read_stream = svn_stream_checksummed2(read_stream, &md5_checksum,
-                                              NULL, svn_checksum_md5,
-                                              TRUE, iterpool);
-
-        read_stream = svn_stream_checksummed2(read_stream, &sha1_checksum,
-                                              NULL, svn_checksum_sha1,
-                                              TRUE, iterpool);
+        checksums[0] = &md5_checksum;
+        checksums[1] = &sha1_checksum;
+        read_stream = svn_stream__checksummed_multi(read_stream, checksums,
+                                                    NULL, checksum_kinds, 2,
+                                                    TRUE, iterpool);
 
         /* This calculates the hash, creates a copy and closes the stream */
         SVN_ERR(svn_stream_copy3(read_stream, result_stream,
@@ -1432,12 +1432,13 @@ create_db(svn_sqlite__db_t **sdb,
           svn_depth_t root_node_depth,
           svn_boolean_t exclusive,
           apr_int32_t timeout,
+          const svn_sqlite__tuning_t *tuning,
           apr_pool_t *result_pool,
           apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_wc__db_util_open_db(sdb, dir_abspath, sdb_fname,
                                   svn_sqlite__mode_rwcreate, exclusive,
-                                  timeout,
+                                  timeout, tuning,
                                   NULL /* my_statements */,
                                   result_pool, scratch_pool));
 
@@ -1487,7 +1488,7 @@ svn_wc__db_init(svn_wc__db_t *db,
   SVN_ERR(create_db(&sdb, &repos_id, &wc_id, local_abspath, repos_root_url,
                     repos_uuid, SDB_FILE,
                     repos_relpath, initial_rev, depth, sqlite_exclusive,
-                    sqlite_timeout,
+                    sqlite_timeout, &db->tuning,
                     db->state_pool, scratch_pool));
 
   /* Create the WCROOT for this directory.  */
@@ -13334,6 +13335,7 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
                     NULL, SVN_INVALID_REVNUM, svn_depth_unknown,
                     TRUE /* exclusive */,
                     0 /* timeout */,
+                    NULL /* tuning */,
                     wc_db->state_pool, scratch_pool));
 
   SVN_ERR(svn_wc__db_pdh_create_wcroot(&wcroot,
@@ -16016,6 +16018,7 @@ svn_wc__db_bump_format(int *result_format,
                                 svn_sqlite__mode_readwrite,
                                 TRUE, /* exclusive */
                                 0, /* default timeout */
+                                NULL, /* default tuning */
                                 NULL, /* my statements */
                                 scratch_pool, scratch_pool);
   if (err)
@@ -30,6 +30,7 @@
 #include "svn_dirent_uri.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -369,6 +370,9 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   const char *temp_dir_abspath;
+  svn_checksum_t **checksums[2];
+  static const svn_checksum_kind_t checksum_kinds[2]
+    = { svn_checksum_md5, svn_checksum_sha1 };
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
@@ -388,12 +392,12 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   (*install_data)->inner_stream = *stream;
 
-  if (md5_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
-                                      svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
-                                      svn_checksum_sha1, FALSE, result_pool);
+  /* Calculate both checksums in a single pass. */
+  checksums[0] = md5_checksum;
+  checksums[1] = sha1_checksum;
+  *stream = svn_stream__checksummed_multi(*stream, NULL, checksums,
+                                          checksum_kinds, 2, FALSE,
+                                          result_pool);
 
   return SVN_NO_ERROR;
 }
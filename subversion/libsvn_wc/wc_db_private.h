@@ -52,6 +52,9 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* SQLite connection tuning options from the config. */
+  svn_sqlite__tuning_t tuning;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -198,7 +201,7 @@ svn_wc__db_util_fetch_wc_id(apr_int64_t *wc_id,
 /* Open a connection in *SDB to the WC database found in the WC metadata
  * directory inside DIR_ABSPATH, having the filename SDB_FNAME.
  *
- * SMODE, EXCLUSIVE and TIMEOUT are passed to svn_sqlite__open().
+ * SMODE, EXCLUSIVE, TIMEOUT and TUNING are passed to svn_sqlite__open().
  *
  * Register MY_STATEMENTS, or if that is null, the default set of WC DB
  * statements, as the set of statements to be prepared now and executed
@@ -212,6 +215,7 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         svn_sqlite__mode_t smode,
                         svn_boolean_t exclusive,
                         apr_int32_t timeout,
+                        const svn_sqlite__tuning_t *tuning,
                         const char *const *my_statements,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
@@ -241,6 +241,7 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      apr_int64_t size;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,6 +262,35 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_bool(config, &(*db)->tuning.wal,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_SQLITE_WAL,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->tuning.wal = FALSE;
+        }
+
+      /* Both sizes are given in MB. */
+      err = svn_config_get_int64(config, &size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE,
+                                 0);
+      if (err || size < 0 || size > APR_INT64_MAX / (1024 * 1024))
+        svn_error_clear(err);
+      else
+        (*db)->tuning.mmap_size = size * 1024 * 1024;
+
+      err = svn_config_get_int64(config, &size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE,
+                                 0);
+      if (err || size < 0 || size > APR_INT64_MAX / (1024 * 1024))
+        svn_error_clear(err);
+      else
+        (*db)->tuning.cache_size = size * 1024 * 1024;
     }
 
   return SVN_NO_ERROR;
@@ -641,7 +671,8 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
              as the filesystem allows. */
           err = svn_wc__db_util_open_db(&sdb, local_abspath, SDB_FILE,
                                         svn_sqlite__mode_readwrite,
-                                        db->exclusive, db->timeout, NULL,
+                                        db->exclusive, db->timeout,
+                                        &db->tuning, NULL,
                                         db->state_pool, scratch_pool);
           if (err == NULL)
             {
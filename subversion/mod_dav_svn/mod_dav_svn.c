@@ -624,6 +624,19 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNAuthzImageDir_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  const char *dir = svn_dirent_internal_style(arg1, cmd->pool);
+
+  if (!svn_dirent_is_absolute(dir))
+    return "SVNAuthzImageDir must be an absolute path.";
+
+  svn_repos_authz_set_image_dir(dir, cmd->pool);
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -1389,6 +1402,12 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_TAKE1("SVNAuthzImageDir", SVNAuthzImageDir_cmd, NULL,
+                RSRC_CONF,
+                "specifies a directory, only writable by the server, in "
+                "which compiled authz rules get shared between processes "
+                "(default is not to share them)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
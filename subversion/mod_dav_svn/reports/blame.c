@@ -0,0 +1,293 @@
+/*
+ * blame.c: mod_dav_svn REPORT handler for server-side line annotation
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h> /* for strcmp() */
+
+#include "svn_types.h"
+#include "svn_xml.h"
+#include "svn_pools.h"
+#include "svn_base64.h"
+#include "svn_diff.h"
+#include "svn_dav.h"
+
+#include "private/svn_log.h"
+#include "private/svn_fspath.h"
+
+#include "../dav_svn.h"
+
+/* Baton type to be used with blame_receiver. */
+typedef struct blame_receiver_baton_t
+{
+  /* this buffers the output for a bit and is automatically flushed,
+     at appropriate times, by the Apache filter system. */
+  apr_bucket_brigade *bb;
+
+  /* where to deliver the output */
+  dav_svn__output *output;
+
+  /* Whether we've written the <S:blame-report> header.  Allows for lazy
+     writes to support mod_dav-based error handling. */
+  svn_boolean_t needs_header;
+
+  /* Revisions whose properties have already been sent, as a set of
+     svn_revnum_t. */
+  apr_hash_t *sent_revs;
+} blame_receiver_baton_t;
+
+
+/* If BRB->needs_header is true, send the "<S:blame-report>" start
+   element and set BRB->needs_header to zero.  Else do nothing. */
+static svn_error_t *
+maybe_send_header(blame_receiver_baton_t *brb)
+{
+  if (brb->needs_header)
+    {
+      SVN_ERR(dav_svn__brigade_puts(brb->bb, brb->output,
+                                    DAV_XML_HEADER DEBUG_CR
+                                    "<S:blame-report xmlns:S=\""
+                                    SVN_XML_NAMESPACE "\" "
+                                    "xmlns:D=\"DAV:\">" DEBUG_CR));
+      brb->needs_header = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Return the attribute string for sending VAL as element contents and
+   set *VAL to the (possibly encoded) contents to send.  Values that are
+   not XML-safe get base64-encoded. */
+static const char *
+encode_value(const svn_string_t **val,
+             apr_pool_t *pool)
+{
+  if (svn_xml_is_xml_safe((*val)->data, (*val)->len))
+    {
+      svn_stringbuf_t *tmp = NULL;
+      svn_xml_escape_cdata_string(&tmp, *val, pool);
+      *val = svn_string_create(tmp ? tmp->data : "", pool);
+      return "";
+    }
+
+  *val = svn_base64_encode_string2(*val, FALSE, pool);
+  return " encoding=\"base64\"";
+}
+
+
+/* Implements svn_repos_blame_receiver_t, sending one line of blame
+ * information to the client.  The properties of each revision are only
+ * sent before the first line attributed to it.  BATON must be a
+ * blame_receiver_baton_t. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t line_no,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               const svn_string_t *line,
+               apr_pool_t *pool)
+{
+  blame_receiver_baton_t *brb = baton;
+  const char *encoding;
+
+  SVN_ERR(maybe_send_header(brb));
+
+  if (!SVN_IS_VALID_REVNUM(revision))
+    {
+      encoding = encode_value(&line, pool);
+      return svn_error_trace(dav_svn__brigade_printf(brb->bb, brb->output,
+                                                     "<S:line%s>%s</S:line>"
+                                                     DEBUG_CR,
+                                                     encoding, line->data));
+    }
+
+  if (!apr_hash_get(brb->sent_revs, &revision, sizeof(revision)))
+    {
+      apr_pool_t *hash_pool = apr_hash_pool_get(brb->sent_revs);
+      svn_revnum_t *key = apr_pmemdup(hash_pool, &revision,
+                                      sizeof(revision));
+      apr_hash_index_t *hi;
+
+      apr_hash_set(brb->sent_revs, key, sizeof(*key), key);
+
+      SVN_ERR(dav_svn__brigade_printf(brb->bb, brb->output,
+                                      "<S:rev-props rev=\"%ld\">" DEBUG_CR,
+                                      revision));
+      for (hi = apr_hash_first(pool, rev_props); hi; hi = apr_hash_next(hi))
+        {
+          const char *name = apr_hash_this_key(hi);
+          const svn_string_t *value = apr_hash_this_val(hi);
+
+          encoding = encode_value(&value, pool);
+          SVN_ERR(dav_svn__brigade_printf(brb->bb, brb->output,
+                                          "<S:rev-prop name=\"%s\"%s>"
+                                          "%s</S:rev-prop>" DEBUG_CR,
+                                          apr_xml_quote_string(pool, name,
+                                                               1),
+                                          encoding, value->data));
+        }
+      SVN_ERR(dav_svn__brigade_puts(brb->bb, brb->output,
+                                    "</S:rev-props>" DEBUG_CR));
+    }
+
+  encoding = encode_value(&line, pool);
+  return svn_error_trace(dav_svn__brigade_printf(brb->bb, brb->output,
+                                                 "<S:line rev=\"%ld\"%s>"
+                                                 "%s</S:line>" DEBUG_CR,
+                                                 revision, encoding,
+                                                 line->data));
+}
+
+
+/* Respond to a client request for a REPORT of type blame-report for the
+   RESOURCE.  Get request body from DOC and send result to OUTPUT. */
+dav_error *
+dav_svn__blame_report(const dav_resource *resource,
+                      const apr_xml_doc *doc,
+                      dav_svn__output *output)
+{
+  svn_error_t *serr;
+  dav_error *derr = NULL;
+  apr_xml_elem *child;
+  int ns;
+  blame_receiver_baton_t brb;
+  dav_svn__authz_read_baton arb;
+  const char *abs_path = NULL;
+  svn_diff_file_options_t *diff_options;
+
+  /* These get determined from the request document. */
+  svn_revnum_t start = SVN_INVALID_REVNUM;
+  svn_revnum_t end = SVN_INVALID_REVNUM;
+
+  /* Construct the authz read check baton. */
+  arb.r = resource->info->r;
+  arb.repos = resource->info->repos;
+
+  /* Sanity check. */
+  if (!resource->info->repos_path)
+    return dav_svn__new_error(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                              "The request does not specify a repository path");
+  ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
+  if (ns == -1)
+    {
+      return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                                    "The request does not contain the 'svn:' "
+                                    "namespace, so it is not going to have "
+                                    "certain required elements");
+    }
+
+  /* Get request information. */
+  diff_options = svn_diff_file_options_create(resource->pool);
+  for (child = doc->root->first_child; child != NULL; child = child->next)
+    {
+      /* if this element isn't one of ours, then skip it */
+      if (child->ns != ns)
+        continue;
+
+      if (strcmp(child->name, "start-revision") == 0)
+        start = SVN_STR_TO_REV(dav_xml_get_cdata(child, resource->pool, 1));
+      else if (strcmp(child->name, "end-revision") == 0)
+        end = SVN_STR_TO_REV(dav_xml_get_cdata(child, resource->pool, 1));
+      else if (strcmp(child->name, "ignore-space") == 0)
+        {
+          const char *value = dav_xml_get_cdata(child, resource->pool, 1);
+          if (strcmp(value, "change") == 0)
+            diff_options->ignore_space = svn_diff_file_ignore_space_change;
+          else if (strcmp(value, "all") == 0)
+            diff_options->ignore_space = svn_diff_file_ignore_space_all;
+        }
+      else if (strcmp(child->name, "ignore-eol-style") == 0)
+        diff_options->ignore_eol_style = TRUE; /* presence indicates
+                                                  positivity */
+      else if (strcmp(child->name, "path") == 0)
+        {
+          const char *rel_path = dav_xml_get_cdata(child, resource->pool, 0);
+          if ((derr = dav_svn__test_canonical(rel_path, resource->pool)))
+            return derr;
+
+          /* Force REL_PATH to be a relative path, not an fspath. */
+          rel_path = svn_relpath_canonicalize(rel_path, resource->pool);
+
+          /* Append the REL_PATH to the base FS path to get an
+             absolute repository path. */
+          abs_path = svn_fspath__join(resource->info->repos_path, rel_path,
+                                      resource->pool);
+        }
+      /* else unknown element; skip it */
+    }
+
+  /* Check that all parameters are present and valid. */
+  if (! abs_path)
+    return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                                  "Not all parameters passed");
+
+  brb.bb = apr_brigade_create(resource->pool,
+                              dav_svn__output_get_bucket_alloc(output));
+  brb.output = output;
+  brb.needs_header = TRUE;
+  brb.sent_revs = apr_hash_make(resource->pool);
+
+  /* blame_receiver will send header first time it is called. */
+
+  /* Annotate the file and send the lines. */
+  serr = svn_repos_get_blame(resource->info->repos->repos, abs_path,
+                             start, end, diff_options,
+                             dav_svn__authz_read_func(&arb), &arb,
+                             blame_receiver, &brb, NULL, NULL,
+                             resource->pool);
+
+  if (serr)
+    {
+      /* See dav_svn__file_revs_report() for why we don't 'goto cleanup'
+         here. */
+      return (dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                   NULL, resource->pool));
+    }
+
+  if ((serr = maybe_send_header(&brb)))
+    {
+      derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "Error beginning REPORT response",
+                                  resource->pool);
+      goto cleanup;
+    }
+
+  if ((serr = dav_svn__brigade_puts(brb.bb, brb.output,
+                                    "</S:blame-report>" DEBUG_CR)))
+    {
+      derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "Error ending REPORT response",
+                                  resource->pool);
+      goto cleanup;
+    }
+
+ cleanup:
+
+  /* We've detected a 'high level' svn action to log. */
+  dav_svn__operational_log(resource->info,
+                           svn_log__get_blame(abs_path, start, end,
+                                              resource->pool));
+
+  return dav_svn__final_flush_or_error(resource->info->r, brb.bb, output,
+                                       derr, resource->pool);
+}
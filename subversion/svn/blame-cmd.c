@@ -300,10 +300,12 @@ svn_cl__blame(apr_getopt_t *os,
 
   subpool = svn_pool_create(pool);
 
-  if (opt_state->extensions)
+  if (opt_state->extensions || opt_state->diff.diff_algorithm)
     {
       apr_array_header_t *opts;
-      opts = svn_cstring_split(opt_state->extensions, " \t\n\r", TRUE, pool);
+      opts = svn_cstring_split(svn_cl__get_diff_extensions(opt_state, NULL,
+                                                           pool),
+                               " \t\n\r", TRUE, pool);
       SVN_ERR(svn_diff_file_options_parse(diff_options, opts, pool));
     }
 
@@ -189,6 +189,7 @@ typedef struct svn_cl__opt_state_t
   const char *diff_cmd;              /* the external diff command to use
                                         (not converted to UTF-8) */
   svn_boolean_t internal_diff;       /* override diff_cmd in config file */
+  const char *diff_algorithm;        /* algorithm used by the internal diff */
   svn_boolean_t no_diff_added;       /* do not show diffs for deleted files */
   svn_boolean_t no_diff_deleted;     /* do not show diffs for deleted files */
   svn_boolean_t show_copies_as_adds; /* do not diff copies with their source */
@@ -851,6 +852,17 @@ svn_cl__check_targets_are_local_paths(const apr_array_header_t *targets);
 svn_error_t *
 svn_cl__check_target_is_local_path(const char *target);
 
+/* Return the options for the internal diff given by the 'extensions' and
+ * 'diff_algorithm' fields of OPT_STATE as a whitespace separated string,
+ * or NULL if neither has been set.  The diff algorithm gets appended to
+ * the extensions.  If only a diff algorithm has been given and CFG is not
+ * NULL, append it to the diff-extensions configured in CFG instead, so
+ * that they still apply.  Allocate the result in POOL. */
+const char *
+svn_cl__get_diff_extensions(const svn_cl__opt_state_t *opt_state,
+                            svn_config_t *cfg,
+                            apr_pool_t *pool);
+
 /* Return a copy of PATH, converted to the local path style, skipping
  * PARENT_PATH if it is non-null and is a parent of or equal to PATH.
  *
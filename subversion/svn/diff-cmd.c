@@ -209,6 +209,7 @@ svn_cl__diff(apr_getopt_t *os,
   svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
   svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
   apr_array_header_t *options;
+  const char *extensions;
   apr_array_header_t *targets;
   svn_stream_t *outstream;
   svn_stream_t *errstream;
@@ -222,8 +223,15 @@ svn_cl__diff(apr_getopt_t *os,
     opt_state->diff.patch_compatible || opt_state->diff.ignore_properties;
   int i;
 
-  if (opt_state->extensions)
-    options = svn_cstring_split(opt_state->extensions, " \t\n\r", TRUE, pool);
+  /* Without -x, the diff-extensions from the config apply. */
+  extensions = svn_cl__get_diff_extensions(
+                 opt_state,
+                 ctx->config ? svn_hash_gets(ctx->config,
+                                             SVN_CONFIG_CATEGORY_CONFIG)
+                             : NULL,
+                 pool);
+  if (extensions)
+    options = svn_cstring_split(extensions, " \t\n\r", TRUE, pool);
   else
     options = NULL;
 
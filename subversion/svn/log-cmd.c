@@ -749,6 +749,10 @@ svn_cl__log(apr_getopt_t *os,
     return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
                             _("'extensions' option requires 'diff' "
                               "option"));
+  if (opt_state->diff.diff_algorithm && (! opt_state->show_diff))
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("'diff-algorithm' option requires 'diff' "
+                              "option"));
 
   if (opt_state->depth != svn_depth_unknown && (! opt_state->show_diff))
     return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
@@ -812,7 +816,12 @@ svn_cl__log(apr_getopt_t *os,
   lb.show_diff = opt_state->show_diff;
   lb.depth = opt_state->depth == svn_depth_unknown ? svn_depth_infinity
                                                    : opt_state->depth;
-  lb.diff_extensions = opt_state->extensions;
+  lb.diff_extensions = svn_cl__get_diff_extensions(
+                         opt_state,
+                         ctx->config ? svn_hash_gets(ctx->config,
+                                                     SVN_CONFIG_CATEGORY_CONFIG)
+                                     : NULL,
+                         pool);
   lb.merge_stack = NULL;
   lb.search_patterns = opt_state->search_patterns;
   svn_membuf__create(&lb.buffer, 0, pool);
@@ -246,6 +246,7 @@ svn_cl__merge(apr_getopt_t *os,
   svn_opt_revision_t first_range_start, first_range_end, peg_revision1,
     peg_revision2;
   apr_array_header_t *options, *ranges_to_merge = opt_state->revision_ranges;
+  const char *extensions;
   apr_array_header_t *conflicted_paths;
   svn_boolean_t has_explicit_target = FALSE;
 
@@ -476,8 +477,9 @@ svn_cl__merge(apr_getopt_t *os,
         }
     }
 
-  if (opt_state->extensions)
-    options = svn_cstring_split(opt_state->extensions, " \t\n\r", TRUE, pool);
+  extensions = svn_cl__get_diff_extensions(opt_state, NULL, pool);
+  if (extensions)
+    options = svn_cstring_split(extensions, " \t\n\r", TRUE, pool);
   else
     options = NULL;
 
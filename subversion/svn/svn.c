@@ -148,6 +148,7 @@ typedef enum svn_cl__longopt_t {
   opt_vacuum_pristines,
   opt_drop,
   opt_viewspec,
+  opt_diff_algorithm,
 } svn_cl__longopt_t;
 
 
@@ -225,7 +226,21 @@ const apr_getopt_option_t svn_cl__options[] =
                        "                             "
                        "  -U ARG, --context ARG: Show ARG lines of context\n"
                        "                             "
-                       "  -p, --show-c-function: Show C function name")},
+                       "  -p, --show-c-function: Show C function name\n"
+                       "                             "
+                       "  --diff-algorithm ARG: 'myers' (default) or\n"
+                       "                             "
+                       "    'patience'\n"
+                       "                             "
+                       "  --git-binary-deltas: Allow binary deltas in\n"
+                       "                             "
+                       "    git diffs of binary files")},
+  {"diff-algorithm", opt_diff_algorithm, 1,
+                    N_("use diff algorithm ARG ('myers' or 'patience')\n"
+                       "                             "
+                       "for internal diff, merge and blame; the same as\n"
+                       "                             "
+                       "-x '--diff-algorithm ARG'")},
   {"targets",       opt_targets, 1,
                     N_("pass contents of file ARG as additional args")},
   {"depth",         opt_depth, 1,
@@ -591,7 +606,8 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
      "\n"), N_(
      "  Write the annotated result to standard output.\n"
     )},
-    {'r', 'v', 'g', opt_incremental, opt_xml, 'x', opt_force} },
+    {'r', 'v', 'g', opt_incremental, opt_xml, 'x', opt_diff_algorithm,
+     opt_force} },
 
   { "cat", svn_cl__cat, {0}, {N_(
      "Output the content of specified files or URLs.\n"
@@ -763,7 +779,8 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
      "  6. Shorthand for 'svn diff --old=OLD-PATH[@OLDREV] --new=NEW-URL[@NEWREV]'\n"
     )},
     {'r', 'c', opt_old_cmd, opt_new_cmd, 'N', opt_depth, opt_diff_cmd,
-     opt_internal_diff, 'x', opt_no_diff_added, opt_no_diff_deleted,
+     opt_internal_diff, 'x', opt_diff_algorithm, opt_no_diff_added,
+     opt_no_diff_deleted,
      opt_ignore_properties, opt_properties_only,
      opt_show_copies_as_adds, opt_notice_ancestry, opt_summarize, opt_changelist,
      opt_force, opt_xml, opt_use_git_diff_format, opt_patch_compatible} },
@@ -1000,7 +1017,8 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     {'r', 'c', 'q', 'v', 'g', opt_targets, opt_stop_on_copy, opt_incremental,
      opt_xml, 'l', opt_with_all_revprops, opt_with_no_revprops,
      opt_with_revprop, opt_depth, opt_diff, opt_diff_cmd,
-     opt_internal_diff, 'x', opt_search, opt_search_and },
+     opt_internal_diff, 'x', opt_diff_algorithm, opt_search,
+     opt_search_and },
     {{opt_with_revprop, N_("retrieve revision property ARG")},
      {'c', N_("the change made in revision ARG")},
      {'v', N_("also print all affected paths")},
@@ -1339,7 +1357,8 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
 "  repositories.\n"
     )},
     {'r', 'c', 'N', opt_depth, 'q', opt_force, opt_dry_run, opt_merge_cmd,
-     opt_record_only, 'x', opt_ignore_ancestry, opt_accept, opt_reintegrate,
+     opt_record_only, 'x', opt_diff_algorithm, opt_ignore_ancestry,
+     opt_accept, opt_reintegrate,
      opt_allow_mixed_revisions, 'v'},
     { { opt_force, N_("force deletions even if deleted contents don't match") } }
   },
@@ -2576,6 +2595,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case opt_diff_cmd:
         opt_state.diff.diff_cmd = apr_pstrdup(pool, opt_arg);
         break;
+      case opt_diff_algorithm:
+        if (strcmp(opt_arg, "myers") != 0 && strcmp(opt_arg, "patience") != 0)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("'%s' is not a valid diff algorithm; "
+                                     "try 'myers' or 'patience'"),
+                                   opt_arg);
+        opt_state.diff.diff_algorithm = opt_arg;
+        break;
       case opt_merge_cmd:
         opt_state.merge_cmd = apr_pstrdup(pool, opt_arg);
         break;
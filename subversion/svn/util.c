@@ -1005,6 +1005,28 @@ svn_cl__check_targets_are_local_paths(const apr_array_header_t *targets)
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_cl__get_diff_extensions(const svn_cl__opt_state_t *opt_state,
+                            svn_config_t *cfg,
+                            apr_pool_t *pool)
+{
+  const char *extensions = opt_state->extensions;
+
+  if (!opt_state->diff.diff_algorithm)
+    return extensions;
+
+  if (!extensions && cfg)
+    svn_config_get(cfg, &extensions, SVN_CONFIG_SECTION_HELPERS,
+                   SVN_CONFIG_OPTION_DIFF_EXTENSIONS, NULL);
+
+  if (extensions)
+    return apr_psprintf(pool, "%s --diff-algorithm %s", extensions,
+                        opt_state->diff.diff_algorithm);
+  else
+    return apr_psprintf(pool, "--diff-algorithm %s",
+                        opt_state->diff.diff_algorithm);
+}
+
 const char *
 svn_cl__local_style_skip_ancestor(const char *parent_path,
                                   const char *path,
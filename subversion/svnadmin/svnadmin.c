@@ -49,6 +49,8 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_io_private.h"
+#include "private/svn_repos_private.h"
 
 #include "svn_private_config.h"
 
@@ -103,6 +105,7 @@ static svn_opt_subcommand_t
   subcommand_dump_revprops,
   subcommand_freeze,
   subcommand_help,
+  subcommand_hook_queue,
   subcommand_hotcopy,
   subcommand_info,
   subcommand_load,
@@ -113,6 +116,7 @@ static svn_opt_subcommand_t
   subcommand_lslocks,
   subcommand_lstxns,
   subcommand_pack,
+  subcommand_rebuild_date_index,
   subcommand_recover,
   subcommand_rmlocks,
   subcommand_rmtxns,
@@ -155,7 +159,12 @@ enum svnadmin__cmdline_options_t
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__jobs,
+    svnadmin__pipeline,
+    svnadmin__compress,
+    svnadmin__since_last_verify,
+    svnadmin__follow
   };
 
 /* Option codes and descriptions.
@@ -294,6 +303,23 @@ static const apr_getopt_option_t options_table[] =
         "                             Character '/' is not treated specially, so\n"
         "                             pattern /*/foo matches paths /a/foo and /a/b/foo.") },
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("use up to ARG threads to process revisions")},
+
+    {"pipeline", svnadmin__pipeline, 0,
+     N_("read the dumpstream and store file contents in\n"
+        "                             separate threads")},
+
+    {"compress", svnadmin__compress, 0,
+     N_("write a block-compressed dumpfile")},
+
+    {"since-last-verify", svnadmin__since_last_verify, 0,
+     N_("skip revisions that did not change since they\n"
+        "                             were last verified with this option")},
+
+    {"follow", svnadmin__follow, 0,
+     N_("keep waiting for new events")},
+
     {NULL}
   };
 
@@ -367,9 +393,18 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Using --exclude or --include gives results equivalent to authz-based\n"
     "path exclusions. In particular, when the source of a copy is\n"
     "excluded, the copy is transformed into an add (unlike in 'svndumpfilter').\n"
+    "\n"
+    "Using --jobs dumps several revisions concurrently.  The output is the\n"
+    "same as without that option.\n"
+    "\n"
+    "Using --compress compresses and checksums the dumpfile in independent\n"
+    "blocks.  'svnadmin load', 'svnrdump load' and 'svndumpfilter' accept\n"
+    "such dumpfiles directly and verify them while reading.  'svnadmin load'\n"
+    "with -r will skip most of the data before LOWER.\n"
    )},
   {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
-   svnadmin__exclude, svnadmin__include, svnadmin__glob },
+   svnadmin__exclude, svnadmin__include, svnadmin__glob, svnadmin__jobs,
+   svnadmin__compress },
   {{'F', N_("write to file ARG instead of stdout")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, {N_(
@@ -408,6 +443,28 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {0} },
 
+  {"hook-queue", subcommand_hook_queue, {0}, {N_(
+    "usage: svnadmin hook-queue REPOS_PATH ACTION\n"
+    "\n"), N_(
+    "Manage the queue of asynchronously run hooks of the repository at\n"
+    "REPOS_PATH.  While the queue is enabled, the post-commit and\n"
+    "post-revprop-change hooks are queued instead of being run when the\n"
+    "respective operation completes.  ACTION is one of:\n"
+    "\n"
+    "  enable   - queue hooks from now on\n"
+    "  disable  - run hooks synchronously again; the queue must be empty\n"
+    "  status   - show whether the queue is enabled and list its events\n"
+    "  run      - run the queued hooks, retrying failed hooks a few times;\n"
+    "             with --follow, keep running until cancelled\n"
+    "  retry    - make hooks that failed permanently run again\n"
+    "  discard  - remove hooks that failed permanently from the queue\n"
+    "\n"), N_(
+    "Hooks for the same revision are run in the order they were queued.\n"
+    "Hooks for different revisions are run concurrently by up to --jobs\n"
+    "runners.\n"
+   )},
+   {svnadmin__jobs, svnadmin__follow, 'q'} },
+
   {"hotcopy", subcommand_hotcopy, {0}, {N_(
     "usage: svnadmin hotcopy REPOS_PATH NEW_REPOS_PATH\n"
     "\n"), N_(
@@ -450,13 +507,15 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "one specified in the stream.  Progress feedback is sent to stdout.\n"
     "If --revision is specified, limit the loaded revisions to only those\n"
     "in the dump stream whose revision numbers match the specified range.\n"
+    "Using --pipeline overlaps reading the stream and storing large file\n"
+    "contents with parsing; the result is the same as without it.\n"
    )},
    {'q', 'r', svnadmin__ignore_uuid, svnadmin__force_uuid,
     svnadmin__ignore_dates,
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__normalize_props,
     svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, 'F', svnadmin__pipeline},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, {N_(
@@ -508,6 +567,16 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {'q', 'M'} },
 
+  {"rebuild-date-index", subcommand_rebuild_date_index, {0}, {N_(
+    "usage: svnadmin rebuild-date-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create or rebuild the index that maps dates to revisions in the\n"
+    "repository located at REPOS_PATH.  The index speeds up resolving\n"
+    "'-r {DATE}' revision arguments and is kept up to date by subsequent\n"
+    "commits and svn:date changes.\n"
+   )},
+   {0} },
+
   {"recover", subcommand_recover, {0}, {N_(
     "usage: svnadmin recover REPOS_PATH\n"
     "\n"), N_(
@@ -603,9 +672,15 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "usage: svnadmin verify REPOS_PATH\n"
     "\n"), N_(
     "Verify the data stored in the repository.\n"
+    "\n"
+    "Using --since-last-verify records the revisions that passed\n"
+    "verification and skips them in later runs with that option unless\n"
+    "their revision properties changed.  Corruption of such revisions on\n"
+    "disk will not be detected then.\n"
    )},
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__since_last_verify} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -648,6 +723,11 @@ struct svnadmin_opt_state
   apr_array_header_t *exclude;                      /* --exclude */
   apr_array_header_t *include;                      /* --include */
   svn_boolean_t glob;                               /* --pattern */
+  int jobs;                                         /* --jobs */
+  svn_boolean_t pipeline;                           /* --pipeline */
+  svn_boolean_t compress;                           /* --compress */
+  svn_boolean_t since_last_verify;                  /* --since-last-verify */
+  svn_boolean_t follow;                             /* --follow */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
@@ -990,7 +1070,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -1061,6 +1141,26 @@ repos_notify_handler(void *baton,
                                         notify->revision));
       return;
 
+    case svn_repos_notify_verify_rev_skipped:
+      svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                                        _("* Skipped unchanged revision %ld.\n"),
+                                        notify->revision));
+      return;
+
+    case svn_repos_notify_hook_run:
+      svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                                        _("* Ran %s hook for revision %ld.\n"),
+                                        notify->path, notify->revision));
+      return;
+
+    case svn_repos_notify_hook_failed:
+      svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                                        _("* %s hook for revision %ld "
+                                          "failed: %s\n"),
+                                        notify->path, notify->revision,
+                                        notify->warning_str));
+      return;
+
     case svn_repos_notify_verify_rev_structure:
       if (notify->revision == SVN_INVALID_REVNUM)
         svn_error_clear(svn_stream_puts(feedback_stream,
@@ -1427,6 +1527,14 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   else
     SVN_ERR(svn_stream_for_stdout(&out_stream, pool));
 
+  /* Compress in a separate thread while we are busy dumping. */
+  if (opt_state->compress)
+    {
+      SVN_ERR(svn_repos__dump_compress(&out_stream, out_stream, pool));
+      SVN_ERR(svn_stream__create_async_writer(&out_stream, out_stream, 0,
+                                              pool));
+    }
+
   /* Progress feedback goes to STDERR, unless they asked to suppress it. */
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stderr, pool);
@@ -1451,15 +1559,19 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                                  "cannot be used simultaneously"));
     }
 
-  SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
+  SVN_ERR(svn_repos_dump_fs5(repos, out_stream, lower, upper,
                              opt_state->incremental, opt_state->use_deltas,
-                             TRUE, TRUE,
+                             TRUE, TRUE, opt_state->jobs,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream,
                              filter_baton.prefixes ? dump_filter_func : NULL,
                              &filter_baton,
                              check_cancel, NULL, pool));
 
+  /* Write the final block. */
+  if (opt_state->compress)
+    SVN_ERR(svn_stream_close(out_stream));
+
   return SVN_NO_ERROR;
 }
 
@@ -1497,8 +1609,8 @@ subcommand_dump_revprops(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stderr, pool);
 
-  SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
-                             FALSE, FALSE, TRUE, FALSE,
+  SVN_ERR(svn_repos_dump_fs5(repos, out_stream, lower, upper,
+                             FALSE, FALSE, TRUE, FALSE, 1,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream, NULL, NULL,
                              check_cancel, NULL, pool));
@@ -1618,6 +1730,99 @@ subcommand_help(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 }
 
 
+/* How often 'svnadmin hook-queue run' tries to run a hook before
+   giving up on it. */
+#define HOOK_QUEUE_MAX_ATTEMPTS 5
+
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_hook_queue(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_stream_t *feedback_stream = NULL;
+  apr_array_header_t *args;
+  const char *action;
+  svn_repos_t *repos;
+
+  /* Expect one more argument: ACTION */
+  SVN_ERR(parse_args(&args, os, 1, 1, pool));
+  action = APR_ARRAY_IDX(args, 0, const char *);
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+
+  if (strcmp(action, "enable") == 0 || strcmp(action, "disable") == 0)
+    {
+      SVN_ERR(svn_repos_hook_queue_enable(repos, action[0] == 'e', pool));
+    }
+  else if (strcmp(action, "status") == 0)
+    {
+      apr_array_header_t *events;
+      svn_boolean_t enabled;
+      int i;
+
+      SVN_ERR(svn_repos_hook_queue_status(&enabled, &events, repos,
+                                          pool, pool));
+      SVN_ERR(svn_cmdline_printf(pool, enabled
+                                       ? _("Hook queue: enabled\n")
+                                       : _("Hook queue: disabled\n")));
+      for (i = 0; i < events->nelts; ++i)
+        {
+          const svn_repos_hook_event_t *event
+            = APR_ARRAY_IDX(events, i, const svn_repos_hook_event_t *);
+
+          SVN_ERR(check_cancel(NULL));
+          if (event->failed)
+            SVN_ERR(svn_cmdline_printf(pool,
+                                       _("%" APR_UINT64_T_FMT ": %s r%ld "
+                                         "failed after %d attempts: %s\n"),
+                                       event->id, event->hook,
+                                       event->revision, event->attempts,
+                                       event->last_error));
+          else if (event->attempts)
+            SVN_ERR(svn_cmdline_printf(pool,
+                                       _("%" APR_UINT64_T_FMT ": %s r%ld "
+                                         "retrying after %d attempts: %s\n"),
+                                       event->id, event->hook,
+                                       event->revision, event->attempts,
+                                       event->last_error));
+          else
+            SVN_ERR(svn_cmdline_printf(pool,
+                                       _("%" APR_UINT64_T_FMT ": %s r%ld "
+                                         "pending\n"),
+                                       event->id, event->hook,
+                                       event->revision));
+        }
+    }
+  else if (strcmp(action, "run") == 0)
+    {
+      /* Progress feedback goes to STDOUT, unless they asked to suppress
+         it. */
+      if (! opt_state->quiet)
+        feedback_stream = recode_stream_create(stdout, pool);
+
+      SVN_ERR(svn_repos_hook_queue_run(repos, opt_state->jobs,
+                                       HOOK_QUEUE_MAX_ATTEMPTS,
+                                       opt_state->follow,
+                                       !opt_state->quiet
+                                         ? repos_notify_handler : NULL,
+                                       feedback_stream, check_cancel, NULL,
+                                       pool));
+    }
+  else if (strcmp(action, "retry") == 0 || strcmp(action, "discard") == 0)
+    {
+      SVN_ERR(svn_repos_hook_queue_clear_failed(repos, action[0] == 'r',
+                                                pool));
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                               _("Unknown hook queue action '%s'"), action);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Set *REVNUM to the revision number of a numeric REV, or to
    SVN_INVALID_REVNUM if REV is unspecified. */
 static svn_error_t *
@@ -1707,13 +1912,14 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  err = svn_repos_load_fs6(repos, in_stream, lower, upper,
+  err = svn_repos_load_fs7(repos, in_stream, lower, upper,
                            opt_state->uuid_action, opt_state->parent_dir,
                            opt_state->use_pre_commit_hook,
                            opt_state->use_post_commit_hook,
                            !opt_state->bypass_prop_validation,
                            opt_state->ignore_dates,
                            opt_state->normalize_props,
+                           opt_state->pipeline,
                            opt_state->quiet ? NULL : repos_notify_handler,
                            feedback_stream, check_cancel, NULL, pool);
 
@@ -1847,6 +2053,22 @@ subcommand_lstxns(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 }
 
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_rebuild_date_index(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+
+  return svn_error_trace(svn_repos_rebuild_date_index(repos, check_cancel,
+                                                      NULL, pool));
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_recover(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2247,9 +2469,10 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
+  SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
                                opt_state->check_normalization,
                                opt_state->metadata_only,
+                               opt_state->since_last_verify,
                                !opt_state->quiet
                                  ? repos_notify_handler : NULL,
                                feedback_stream,
@@ -3032,6 +3255,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__metadata_only:
         opt_state.metadata_only = TRUE;
         break;
+      case svnadmin__since_last_verify:
+        opt_state.since_last_verify = TRUE;
+        break;
+      case svnadmin__follow:
+        opt_state.follow = TRUE;
+        break;
       case svnadmin__fs_type:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool));
         break;
@@ -3102,6 +3331,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__glob:
         opt_state.glob = TRUE;
         break;
+      case svnadmin__pipeline:
+        opt_state.pipeline = TRUE;
+        break;
+      case svnadmin__compress:
+        opt_state.compress = TRUE;
+        break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                  _("Argument to --jobs must be positive"));
+        break;
       default:
         {
           SVN_ERR(subcommand_help(NULL, NULL, pool));
@@ -3229,7 +3470,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    /* Concurrent dumps access the caches from several threads. */
+    settings.single_threaded = (opt_state.jobs <= 1);
 
     svn_cache_config_set(&settings);
   }
@@ -54,6 +54,7 @@
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_fspath.h"
 
 #ifdef HAVE_UNISTD_H
@@ -103,6 +104,9 @@ typedef struct fs_warning_baton_t {
 } fs_warning_baton_t;
 
 typedef struct authz_baton_t {
+  /* Must be the first member, so that svn_repos__authz_read_func() can
+     use a pointer to this structure as its baton. */
+  svn_repos__authz_read_baton_t read;
   server_baton_t *server;
   svn_ra_svn_conn_t *conn;
 } authz_baton_t;
@@ -416,6 +420,29 @@ static void convert_case(char *text, svn_boolean_t to_uppercase)
     }
 }
 
+/* Return the user name in B to be used for authz purposes.  If we have a
+   username, and we've not yet used it + any username case normalization
+   that might be requested to determine "the username we used for authz
+   purposes", do so now. */
+static const char *
+get_authz_user(server_baton_t *b)
+{
+  client_info_t *client_info = b->client_info;
+
+  if (client_info->user && (! client_info->authz_user))
+    {
+      char *authz_user = apr_pstrdup(b->pool, client_info->user);
+      if (b->repository->username_case == CASE_FORCE_UPPER)
+        convert_case(authz_user, TRUE);
+      else if (b->repository->username_case == CASE_FORCE_LOWER)
+        convert_case(authz_user, FALSE);
+
+      client_info->authz_user = authz_user;
+    }
+
+  return client_info->authz_user;
+}
+
 /* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
    the user described in BATON according to the authz rules in BATON.
    Use POOL for temporary allocations only.  If no authz rules are
@@ -427,7 +454,6 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
                                        apr_pool_t *pool)
 {
   repository_t *repository = b->repository;
-  client_info_t *client_info = b->client_info;
 
   /* If authz cannot be performed, grant access.  This is NOT the same
      as the default policy when authz is performed on a path with no
@@ -448,23 +474,9 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   if (path && *path != '/')
     path = svn_fspath__canonicalize(path, pool);
 
-  /* If we have a username, and we've not yet used it + any username
-     case normalization that might be requested to determine "the
-     username we used for authz purposes", do so now. */
-  if (client_info->user && (! client_info->authz_user))
-    {
-      char *authz_user = apr_pstrdup(b->pool, client_info->user);
-      if (repository->username_case == CASE_FORCE_UPPER)
-        convert_case(authz_user, TRUE);
-      else if (repository->username_case == CASE_FORCE_LOWER)
-        convert_case(authz_user, FALSE);
-
-      client_info->authz_user = authz_user;
-    }
-
   SVN_ERR(svn_repos_authz_check_access(repository->authzdb,
                                        repository->authz_repos_name,
-                                       path, client_info->authz_user,
+                                       path, get_authz_user(b),
                                        required, allowed, pool));
   if (!*allowed)
     SVN_ERR(log_authz_denied(path, required, b, pool));
@@ -472,29 +484,37 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   return SVN_NO_ERROR;
 }
 
-/* Set *ALLOWED to TRUE if PATH is readable by the user described in
- * BATON.  Use POOL for temporary allocations only.  ROOT is not used.
- * Implements the svn_repos_authz_func_t interface.
- */
-static svn_error_t *authz_check_access_cb(svn_boolean_t *allowed,
-                                          svn_fs_root_t *root,
-                                          const char *path,
-                                          void *baton,
-                                          apr_pool_t *pool)
+/* Log the denied read access to PATH for the authz_baton_t BATON.
+ * Implements the denied_func of svn_repos__authz_read_baton_t. */
+static svn_error_t *authz_read_denied_cb(const char *path,
+                                         void *baton,
+                                         apr_pool_t *scratch_pool)
 {
   authz_baton_t *sb = baton;
 
-  return authz_check_access(allowed, path, svn_authz_read,
-                            sb->server, pool);
+  return log_authz_denied(path, svn_authz_read, sb->server, scratch_pool);
 }
 
-/* If authz is enabled in the specified BATON, return a read authorization
-   function. Otherwise, return NULL. */
-static svn_repos_authz_func_t authz_check_access_cb_func(server_baton_t *baton)
+/* If authz is enabled for the server in the specified BATON, prepare
+   BATON for read authorization checks and return a read authorization
+   function to be used with it.  Otherwise, return NULL.
+
+   The function returned is svn_repos__authz_read_func(), which allows
+   the repository layer to check whole directories at once. */
+static svn_repos_authz_func_t authz_check_access_cb_func(authz_baton_t *baton)
 {
-  if (baton->repository->authzdb)
-     return authz_check_access_cb;
-  return NULL;
+  server_baton_t *b = baton->server;
+
+  if (!b->repository->authzdb)
+    return NULL;
+
+  baton->read.authz = b->repository->authzdb;
+  baton->read.repos_name = b->repository->authz_repos_name;
+  baton->read.user = get_authz_user(b);
+  baton->read.denied_func = authz_read_denied_cb;
+  baton->read.denied_baton = baton;
+
+  return svn_repos__authz_read_func;
 }
 
 /* Set *ALLOWED to TRUE if the REQUIRED access to PATH is granted,
@@ -985,7 +1005,7 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       tgt_path, text_deltas, depth,
                                       ignore_ancestry, send_copyfrom_args,
                                       editor, edit_baton,
-                                      authz_check_access_cb_func(b),
+                                      authz_check_access_cb_func(&ab),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
 
@@ -1097,7 +1117,7 @@ get_props(apr_hash_t **props,
     {
       SVN_ERR(svn_repos_fs_get_inherited_props(
                 iprops, root, path, NULL,
-                authz_check_access_cb_func(b->server),
+                authz_check_access_cb_func(b),
                 b, pool, pool));
     }
 
@@ -1186,7 +1206,7 @@ static svn_error_t *do_change_rev_prop(svn_ra_svn_conn_t *conn,
                                             b->client_info->user,
                                             name, old_value_p, value,
                                             TRUE, TRUE,
-                                            authz_check_access_cb_func(b), &ab,
+                                            authz_check_access_cb_func(&ab), &ab,
                                             pool));
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
 
@@ -1273,7 +1293,7 @@ rev_proplist(svn_ra_svn_conn_t *conn,
   SVN_ERR(trivial_auth_request(conn, pool, b));
   SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props, b->repository->repos,
                                              rev,
-                                             authz_check_access_cb_func(b),
+                                             authz_check_access_cb_func(&ab),
                                              &ab, pool));
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "success"));
   SVN_ERR(svn_ra_svn__write_proplist(conn, pool, props));
@@ -1302,7 +1322,7 @@ rev_prop(svn_ra_svn_conn_t *conn,
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
   SVN_CMD_ERR(svn_repos_fs_revision_prop(&value, b->repository->repos, rev,
-                                         name, authz_check_access_cb_func(b),
+                                         name, authz_check_access_cb_func(&ab),
                                          &ab, pool));
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, "(?s)", value));
   return SVN_NO_ERROR;
@@ -2237,7 +2257,7 @@ get_mergeinfo(svn_ra_svn_conn_t *conn,
                                           canonical_paths, rev,
                                           inherit,
                                           include_descendants,
-                                          authz_check_access_cb_func(b), &ab,
+                                          authz_check_access_cb_func(&ab), &ab,
                                           mergeinfo_receiver,
                                           &mergeinfo_baton,
                                           pool));
@@ -2469,7 +2489,7 @@ log_cmd(svn_ra_svn_conn_t *conn,
   err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
                             end_rev, (int) limit,
                             strict_node, include_merged_revisions,
-                            revprops, authz_check_access_cb_func(b), &ab,
+                            revprops, authz_check_access_cb_func(&ab), &ab,
                             send_changed_paths ? path_change_receiver : NULL,
                             send_changed_paths ? &lb : NULL,
                             revision_receiver, &lb, pool);
@@ -2625,7 +2645,7 @@ get_locations(svn_ra_svn_conn_t *conn,
   err = svn_repos_trace_node_locations(b->repository->fs, &fs_locations,
                                        abs_path, peg_revision,
                                        location_revisions,
-                                       authz_check_access_cb_func(b), &ab,
+                                       authz_check_access_cb_func(&ab), &ab,
                                        pool);
 
   /* Now, write the results to the connection. */
@@ -2755,7 +2775,7 @@ get_location_segments(svn_ra_svn_conn_t *conn,
   err = svn_repos_node_location_segments(b->repository->repos, abs_path,
                                          peg_revision, start_rev, end_rev,
                                          gls_receiver, (void *)conn,
-                                         authz_check_access_cb_func(b), &ab,
+                                         authz_check_access_cb_func(&ab), &ab,
                                          pool);
   write_err = svn_ra_svn__write_word(conn, pool, "done");
   if (write_err)
@@ -2873,7 +2893,7 @@ get_file_revs(svn_ra_svn_conn_t *conn,
 
   err = svn_repos_get_file_revs2(b->repository->repos, full_path, start_rev,
                                  end_rev, include_merged_revisions,
-                                 authz_check_access_cb_func(b), &ab,
+                                 authz_check_access_cb_func(&ab), &ab,
                                  file_rev_handler, &frb, pool);
   write_err = svn_ra_svn__write_word(conn, pool, "done");
   if (write_err)
@@ -2887,6 +2907,109 @@ get_file_revs(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Baton type to be used with blame_receiver. */
+typedef struct blame_receiver_baton_t
+{
+  /* Send the data through this connection. */
+  svn_ra_svn_conn_t *conn;
+
+  /* Revisions whose properties have already been sent, as a set of
+   * svn_revnum_t. */
+  apr_hash_t *sent_revs;
+} blame_receiver_baton_t;
+
+/* Implements svn_repos_blame_receiver_t, sending one line of blame
+ * information to the client.  The properties of each revision are only
+ * sent along with the first line attributed to it.  BATON must be a
+ * blame_receiver_baton_t. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t line_no,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               const svn_string_t *line,
+               apr_pool_t *pool)
+{
+  blame_receiver_baton_t *b = baton;
+
+  if (SVN_IS_VALID_REVNUM(revision)
+      && !apr_hash_get(b->sent_revs, &revision, sizeof(revision)))
+    {
+      apr_pool_t *hash_pool = apr_hash_pool_get(b->sent_revs);
+      svn_revnum_t *key = apr_pmemdup(hash_pool, &revision,
+                                      sizeof(revision));
+      apr_hash_set(b->sent_revs, key, sizeof(*key), key);
+
+      SVN_ERR(svn_ra_svn__write_tuple(b->conn, pool, "(?r)((!", revision));
+      SVN_ERR(svn_ra_svn__write_proplist(b->conn, pool, rev_props));
+      return svn_error_trace(svn_ra_svn__write_tuple(b->conn, pool, "!))s",
+                                                     line));
+    }
+
+  return svn_error_trace(svn_ra_svn__write_tuple(b->conn, pool, "(?r)()s",
+                                                 revision, line));
+}
+
+static svn_error_t *
+get_blame(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+  svn_error_t *err, *write_err;
+  blame_receiver_baton_t rb;
+  svn_revnum_t start_rev, end_rev;
+  const char *path;
+  const char *full_path;
+  const char *ignore_space;
+  svn_boolean_t ignore_eol_style;
+  svn_diff_file_options_t *diff_options;
+  authz_baton_t ab;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Parse arguments. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)(?r)wb",
+                                  &path, &start_rev, &end_rev,
+                                  &ignore_space, &ignore_eol_style));
+  path = svn_relpath_canonicalize(path, pool);
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  full_path = svn_fspath__join(b->repository->fs_path->data, path, pool);
+
+  diff_options = svn_diff_file_options_create(pool);
+  diff_options->ignore_eol_style = ignore_eol_style;
+  if (strcmp(ignore_space, "change") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_change;
+  else if (strcmp(ignore_space, "all") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_all;
+  else
+    diff_options->ignore_space = svn_diff_file_ignore_space_none;
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_blame(full_path, start_rev, end_rev,
+                                         pool)));
+
+  rb.conn = conn;
+  rb.sent_revs = apr_hash_make(pool);
+
+  err = svn_repos_get_blame(b->repository->repos, full_path, start_rev,
+                            end_rev, diff_options,
+                            authz_check_access_cb_func(&ab), &ab,
+                            blame_receiver, &rb, NULL, NULL, pool);
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 lock(svn_ra_svn_conn_t *conn,
      apr_pool_t *pool,
@@ -3365,7 +3488,7 @@ get_locks(svn_ra_svn_conn_t *conn,
                       svn_path_uri_encode(full_path, pool)));
   SVN_CMD_ERR(svn_repos_fs_get_locks2(&locks, b->repository->repos,
                                       full_path, depth,
-                                      authz_check_access_cb_func(b), &ab,
+                                      authz_check_access_cb_func(&ab), &ab,
                                       pool));
 
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "success"));
@@ -3407,7 +3530,7 @@ static svn_error_t *replay_one_revision(svn_ra_svn_conn_t *conn,
   if (! err)
     err = svn_repos_replay2(root, b->repository->fs_path->data,
                             low_water_mark, send_deltas, editor, edit_baton,
-                            authz_check_access_cb_func(b), &ab, pool);
+                            authz_check_access_cb_func(&ab), &ab, pool);
 
   if (err)
     svn_error_clear(editor->abort_edit(edit_baton, pool));
@@ -3469,7 +3592,7 @@ replay_range(svn_ra_svn_conn_t *conn,
 
       SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props,
                                                  b->repository->repos, rev,
-                                                 authz_check_access_cb_func(b),
+                                                 authz_check_access_cb_func(&ab),
                                                  &ab,
                                                  iterpool));
       SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w(!", "revprops"));
@@ -3670,7 +3793,7 @@ list(svn_ra_svn_conn_t *conn,
   /* Fetch the directory entries if requested and send them immediately. */
   path_info_only = (rb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
   err = svn_repos_list(root, full_path, patterns, depth, path_info_only,
-                       authz_check_access_cb_func(b), &ab, list_receiver,
+                       authz_check_access_cb_func(&ab), &ab, list_receiver,
                        &rb, NULL, NULL, pool);
 
 
@@ -3708,6 +3831,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-locations",   get_locations },
   { "get-location-segments",   get_location_segments },
   { "get-file-revs",   get_file_revs },
+  { "get-blame",       get_blame },
   { "lock",            lock },
   { "lock-many",       lock_many },
   { "unlock",          unlock },
@@ -4129,7 +4253,7 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4143,11 +4267,12 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4159,7 +4284,8 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
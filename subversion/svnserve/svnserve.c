@@ -222,6 +222,7 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_AUTHZ_IMAGE_DIR 277
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -325,6 +326,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"authz-image-dir", SVNSERVE_OPT_AUTHZ_IMAGE_DIR, 1,
+     N_("share compiled authz rules between server processes\n"
+        "                             "
+        "through directory ARG.  It must not be writable\n"
+        "                             "
+        "by other users.")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -929,6 +936,16 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_AUTHZ_IMAGE_DIR:
+          {
+            const char *image_dir;
+            SVN_ERR(svn_utf_cstring_to_utf8(&image_dir, arg, pool));
+            image_dir = svn_dirent_internal_style(image_dir, pool);
+            SVN_ERR(svn_dirent_get_absolute(&image_dir, image_dir, pool));
+            svn_repos_authz_set_image_dir(image_dir, pool);
+          }
+          break;
+
         case SVNSERVE_OPT_CLIENT_SPEED:
           {
             apr_size_t bandwidth = (apr_size_t)apr_strtoi64(arg, NULL, 0);
@@ -5253,6 +5253,53 @@ def diff_git_format_copy(sbox):
   svntest.actions.run_and_verify_svn(expected_output, [], 'diff',
                                      '--git', '.')
 
+# File diffs may be calculated concurrently ([miscellany] diff-jobs).
+# The output must not depend on that, in particular the git labels.
+def diff_git_format_concurrent(sbox):
+  "diff git format with concurrent file diffs"
+  sbox.build(read_only=True)
+  wc_dir = sbox.wc_dir
+
+  for path in ['iota', 'A/mu', 'A/B/lambda', 'A/B/E/alpha', 'A/B/E/beta',
+               'A/D/gamma', 'A/D/G/pi', 'A/D/G/rho', 'A/D/G/tau',
+               'A/D/H/chi', 'A/D/H/omega', 'A/D/H/psi']:
+    sbox.simple_append(path, "appended to '%s'\n" % path)
+
+  exit_code, serial_output, err = svntest.actions.run_and_verify_svn(
+    None, [], 'diff', '--git',
+    '--config-option=config:miscellany:diff-jobs=1', wc_dir)
+  exit_code, concurrent_output, err = svntest.actions.run_and_verify_svn(
+    None, [], 'diff', '--git',
+    '--config-option=config:miscellany:diff-jobs=4', wc_dir)
+
+  if "--- a/A/mu\t(revision 1)\n" not in concurrent_output:
+    raise svntest.Failure("Missing git label for 'A/mu'")
+
+  svntest.verify.verify_outputs(None, concurrent_output, None,
+                                serial_output, None)
+
+def diff_algorithm_keeps_config_extensions(sbox):
+  "diff --diff-algorithm keeps config extensions"
+  sbox.build(read_only=True)
+  wc_dir = sbox.wc_dir
+
+  # Only whitespace changes, which the configured extensions ignore.
+  iota_path = sbox.ospath('iota')
+  svntest.main.file_write(iota_path, "  This is the file 'iota'.  \n")
+
+  svntest.actions.run_and_verify_svn([], [],
+                                     'diff', '--diff-algorithm', 'patience',
+                                     '--config-option',
+                                     'config:helpers:diff-extensions=-w',
+                                     iota_path)
+
+  # Explicit -x options still replace the configured ones.
+  exit_code, output, err = svntest.actions.run_and_verify_svn(
+    None, [], 'diff', '--diff-algorithm', 'patience', '-x', '-u',
+    '--config-option', 'config:helpers:diff-extensions=-w', iota_path)
+  if "+  This is the file 'iota'.  \n" not in output:
+    raise svntest.Failure("Whitespace change not shown")
+
 ########################################################################
 #Run the tests
 
@@ -5353,6 +5400,8 @@ test_list = [ None,
               diff_summary_repo_wc_local_copy_unmodified,
               diff_file_replaced_by_symlink,
               diff_git_format_copy,
+              diff_git_format_concurrent,
+              diff_algorithm_keeps_config_extensions,
               ]
 
 if __name__ == '__main__':
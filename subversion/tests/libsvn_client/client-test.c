@@ -1408,6 +1408,99 @@ test_copy_pin_externals_select_subtree(const svn_test_opts_t *opts, apr_pool_t *
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_client_blame_receiver3_t, appending a line of the form
+   "LINE_NO REVISION LINE" to the svn_stringbuf_t BATON. */
+static svn_error_t *
+blame_to_stringbuf(void *baton,
+                   svn_revnum_t start_revnum,
+                   svn_revnum_t end_revnum,
+                   apr_int64_t line_no,
+                   svn_revnum_t revision,
+                   apr_hash_t *rev_props,
+                   svn_revnum_t merged_revision,
+                   apr_hash_t *merged_rev_props,
+                   const char *merged_path,
+                   const char *line,
+                   svn_boolean_t local_change,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = baton;
+
+  svn_stringbuf_appendcstr(result,
+                           apr_psprintf(pool, "%" APR_INT64_T_FMT " %ld %s|\n",
+                                        line_no, revision, line));
+
+  return SVN_NO_ERROR;
+}
+
+/* Server-side blame must report the same lines and revisions as the
+   client-side implementation, even for files with mixed line endings. */
+static svn_error_t *
+test_blame_mixed_eol(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  static const char *const texts[] = {
+    "one\r\ntwo\rthree\nfour\r\n",
+    "one\r\nTWO\rthree\nfour\r\nfive",
+    "zero\none\r\nTWO\rthree\r\n\r\nfour\r\nfive\n",
+    NULL
+  };
+  const char *repos_url;
+  svn_repos_t *repos;
+  svn_client_ctx_t *ctx;
+  svn_opt_revision_t head_rev = { svn_opt_revision_head, { 0 } };
+  svn_opt_revision_t one_rev = { svn_opt_revision_number, { 0 } };
+  svn_diff_file_options_t *diff_options = svn_diff_file_options_create(pool);
+  svn_stringbuf_t *server_blame = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *client_blame = svn_stringbuf_create_empty(pool);
+  const char *url;
+  int i;
+
+  SVN_ERR(create_greek_repos(&repos_url, "test-blame-mixed-eol", opts,
+                             pool));
+  SVN_ERR(svn_repos_open3(&repos,
+                          svn_test_data_path("test-blame-mixed-eol", pool),
+                          NULL, pool, pool));
+
+  for (i = 0; texts[i]; i++)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *txn_root;
+      svn_revnum_t youngest_rev;
+
+      SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos),
+                                  pool));
+      SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), youngest_rev,
+                                0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota", texts[i],
+                                          pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+    }
+
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+  url = svn_path_url_add_component2(repos_url, "iota", pool);
+  one_rev.value.number = 1;
+
+  /* ra_local annotates the file on the "server" ... */
+  SVN_ERR(svn_client_blame5(url, &head_rev, &one_rev, &head_rev,
+                            diff_options, FALSE, FALSE,
+                            blame_to_stringbuf, server_blame, ctx, pool));
+
+  /* ... unless we ask for merged revisions as well. */
+  SVN_ERR(svn_client_blame5(url, &head_rev, &one_rev, &head_rev,
+                            diff_options, FALSE, TRUE,
+                            blame_to_stringbuf, client_blame, ctx, pool));
+
+  SVN_TEST_STRING_ASSERT(server_blame->data, client_blame->data);
+
+  /* The CR of CRLF belongs to the line, like in the client. */
+  SVN_TEST_ASSERT(strstr(server_blame->data, "0 4 zero|\n1 2 one\r|\n"));
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1436,6 +1529,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_client_copy7 with externals_to_pin"),
     SVN_TEST_OPTS_PASS(test_copy_pin_externals_select_subtree,
                        "pin externals on selected subtrees only"),
+    SVN_TEST_OPTS_PASS(test_blame_mixed_eol,
+                       "server- and client-side blame of mixed EOLs"),
     SVN_TEST_NULL
   };
 
@@ -2693,6 +2693,73 @@ test_token_compare(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Append line number I of the contents used by test_mixed_eol_prefix_suffix
+   to BUF.  Line lengths and EOL styles vary, so that CR/LF pairs end up
+   at any offset relative to the blocks scanned for identical prefix and
+   suffix. */
+static void
+append_mixed_eol_line(svn_stringbuf_t *buf,
+                      int i)
+{
+  static const char * const eols[] = { "\r\n", "\r", "\n" };
+  int k;
+
+  for (k = 0; k <= i % 5; k++)
+    svn_stringbuf_appendbyte(buf, (char)('a' + i % 26));
+  svn_stringbuf_appendcstr(buf, eols[i % 3]);
+}
+
+/* The identical prefix and suffix span several chunks and contain all
+   kinds of EOLs.  The line numbers in the hunk header show whether they
+   have been counted correctly. */
+static svn_error_t *
+test_mixed_eol_prefix_suffix(apr_pool_t *pool)
+{
+  const int line_count = 40000;
+  const int changed_line = 20011;
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < line_count; i++)
+    {
+      append_mixed_eol_line(original, i);
+      if (i == changed_line)
+        svn_stringbuf_appendcstr(modified, "CHANGED\n");
+      else
+        append_mixed_eol_line(modified, i);
+    }
+
+  svn_stringbuf_appendcstr(expected,
+                           "--- mixed-eol-original" NL
+                           "+++ mixed-eol-modified" NL);
+  svn_stringbuf_appendcstr(expected,
+                           apr_psprintf(pool, "@@ -%d,7 +%d,7 @@" NL,
+                                        changed_line - 2,
+                                        changed_line - 2));
+  for (i = changed_line - 3; i <= changed_line + 3; i++)
+    {
+      if (i == changed_line)
+        {
+          svn_stringbuf_appendbyte(expected, '-');
+          append_mixed_eol_line(expected, i);
+          svn_stringbuf_appendcstr(expected, "+CHANGED\n");
+        }
+      else
+        {
+          svn_stringbuf_appendbyte(expected, ' ');
+          append_mixed_eol_line(expected, i);
+        }
+    }
+
+  SVN_ERR(two_way_diff("mixed-eol-original", "mixed-eol-modified",
+                       original->data, modified->data, expected->data,
+                       NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 two_way_issue_3362_v1(apr_pool_t *pool)
 {
@@ -3065,6 +3132,178 @@ three_way_double_add(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Patience diff anchors on the lines that are unique in both files, so
+   the inserted block is kept in one piece instead of being interleaved
+   with the braces of the surrounding blocks. */
+static svn_error_t *
+test_patience_diff(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 0, sizeof(const char *));
+
+  APR_ARRAY_PUSH(args, const char *) = "--patience";
+  SVN_ERR(svn_diff_file_options_parse(diff_opts, args, pool));
+  SVN_TEST_ASSERT(diff_opts->algorithm == svn_diff_algorithm_patience);
+
+  SVN_ERR(two_way_diff("patience1", "patience2",
+                       "a" NL
+                       "{" NL
+                       "}" NL
+                       "b" NL
+                       "{" NL
+                       "}" NL,
+
+                       "a" NL
+                       "{" NL
+                       "}" NL
+                       "c" NL
+                       "{" NL
+                       "}" NL
+                       "b" NL
+                       "{" NL
+                       "}" NL,
+
+                       "--- patience1" NL
+                       "+++ patience2" NL
+                       "@@ -1,6 +1,9 @@" NL
+                       " a" NL
+                       " {" NL
+                       " }" NL
+                       "+c" NL
+                       "+{" NL
+                       "+}" NL
+                       " b" NL
+                       " {" NL
+                       " }" NL,
+                       diff_opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Reordering many blocks of a large file is the worst case of the O(NP)
+   algorithm, but patience diff only has to compare the block boundaries.
+   Verify that diff and merge results are still correct. */
+static svn_error_t *
+test_patience_reordered_blocks(apr_pool_t *pool)
+{
+  int num_blocks = 500;
+  int block_lines = 20;
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified = svn_stringbuf_create_empty(pool);
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  svn_diff_t *diff;
+  int i, j;
+
+  diff_opts->algorithm = svn_diff_algorithm_patience;
+
+  for (i = 0; i < num_blocks; i++)
+    for (j = 0; j < block_lines; j++)
+      {
+        svn_stringbuf_appendcstr(original,
+                                 apr_psprintf(pool, "line %d.%d" NL, i, j));
+        svn_stringbuf_appendcstr(modified,
+                                 apr_psprintf(pool, "line %d.%d" NL,
+                                              num_blocks - i - 1, j));
+      }
+
+  SVN_ERR(svn_diff_mem_string_diff(&diff,
+                                   svn_string_create(original->data, pool),
+                                   svn_string_create(modified->data, pool),
+                                   diff_opts, pool));
+  SVN_TEST_ASSERT(svn_diff_contains_diffs(diff));
+
+  /* Merging the change into the unmodified file must reproduce it. */
+  SVN_ERR(three_way_merge("patience-orig", "patience-mod", "patience-orig",
+                          original->data, modified->data, original->data,
+                          modified->data, diff_opts,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t.output_common, summing up the number
+   of common lines in the apr_off_t at BATON. */
+static svn_error_t *
+count_common_lines(void *baton,
+                   apr_off_t original_start,
+                   apr_off_t original_length,
+                   apr_off_t modified_start,
+                   apr_off_t modified_length,
+                   apr_off_t latest_start,
+                   apr_off_t latest_length)
+{
+  *(apr_off_t *)baton += original_length;
+  return SVN_NO_ERROR;
+}
+
+/* Patience diff must neither miss the matches in files without any unique
+   lines nor spend unbounded time on them.  The second case used to run
+   the O(NP) algorithm on the whole file, taking minutes. */
+static svn_error_t *
+test_patience_repetitive(apr_pool_t *pool)
+{
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified = svn_stringbuf_create_empty(pool);
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  svn_diff_output_fns_t output_fns = { NULL };
+  apr_off_t common = 0;
+  svn_diff_t *diff;
+  int i;
+
+  diff_opts->algorithm = svn_diff_algorithm_patience;
+  output_fns.output_common = count_common_lines;
+
+  /* Every line appears twice, so there is nothing unique to anchor on.
+     All unchanged lines must still be found. */
+  for (i = 0; i < 1000; i++)
+    {
+      const char *line = apr_psprintf(pool, "line %d" NL, i);
+
+      svn_stringbuf_appendcstr(original, line);
+      svn_stringbuf_appendcstr(original, line);
+
+      if (i % 10 != 3)
+        {
+          svn_stringbuf_appendcstr(modified, line);
+          svn_stringbuf_appendcstr(modified, line);
+        }
+      if (i % 10 == 7)
+        {
+          line = apr_psprintf(pool, "new %d" NL, i);
+          svn_stringbuf_appendcstr(modified, line);
+          svn_stringbuf_appendcstr(modified, line);
+        }
+    }
+
+  SVN_ERR(svn_diff_mem_string_diff(&diff,
+                                   svn_string_create(original->data, pool),
+                                   svn_string_create(modified->data, pool),
+                                   diff_opts, pool));
+  SVN_ERR(svn_diff_output2(diff, &common, &output_fns, NULL, NULL));
+  SVN_TEST_INT_ASSERT(common, 1800);
+
+  /* Long random sequences of very few distinct lines. */
+  svn_stringbuf_setempty(original);
+  svn_stringbuf_setempty(modified);
+  for (i = 0; i < 100000; i++)
+    {
+      static const char *const lines[] = { "a" NL, "b" NL, "c" NL };
+
+      svn_stringbuf_appendcstr(original, lines[range_rand(0, 2)]);
+      svn_stringbuf_appendcstr(modified, lines[range_rand(0, 2)]);
+    }
+
+  SVN_ERR(three_way_merge("patience-rep-orig", "patience-rep-mod",
+                          "patience-rep-orig",
+                          original->data, modified->data, original->data,
+                          modified->data, diff_opts,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -3103,12 +3342,20 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "identical suffix starts at the boundary of a chunk"),
     SVN_TEST_PASS2(test_token_compare,
                    "compare tokens at the chunk boundary"),
+    SVN_TEST_PASS2(test_mixed_eol_prefix_suffix,
+                   "identical prefix and suffix with mixed EOLs"),
     SVN_TEST_PASS2(two_way_issue_3362_v1,
                    "2-way issue #3362 test v1"),
     SVN_TEST_PASS2(two_way_issue_3362_v2,
                    "2-way issue #3362 test v2"),
     SVN_TEST_XFAIL2(three_way_double_add,
                    "3-way merge, double add"),
+    SVN_TEST_PASS2(test_patience_diff,
+                   "2-way patience diff"),
+    SVN_TEST_PASS2(test_patience_reordered_blocks,
+                   "patience diff of many reordered blocks"),
+    SVN_TEST_PASS2(test_patience_repetitive,
+                   "patience diff without unique lines"),
     SVN_TEST_NULL
   };
 
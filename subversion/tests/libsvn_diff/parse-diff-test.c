@@ -1104,6 +1104,84 @@ test_parse_unidiff_with_mergeinfo(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return SIZE bytes of pseudo-random data, generated from SEED, that do
+   not compress well.  Allocate the result in POOL. */
+static svn_stringbuf_t *
+make_binary_data(apr_size_t size,
+                 apr_uint32_t seed,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_ensure(size, pool);
+  apr_size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      data->data[i] = (char)(seed >> 16);
+    }
+
+  data->len = size;
+  data->data[size] = '\0';
+
+  return data;
+}
+
+static svn_error_t *
+test_binary_diff_roundtrip(apr_pool_t *pool)
+{
+  /* Large enough to let the base85 encoding work in multiple blocks. */
+  svn_stringbuf_t *original = make_binary_data(300000, 1, pool);
+  svn_stringbuf_t *latest = svn_stringbuf_dup(original, pool);
+  svn_stringbuf_t *diff;
+  svn_stringbuf_t *delta_diff;
+  svn_stringbuf_t *contents;
+  svn_patch_file_t *patch_file;
+  svn_patch_t *patch;
+
+  memcpy(latest->data + 150000, "changed", 7);
+
+  diff = svn_stringbuf_create("diff --git a/bin b/bin" NL, pool);
+  SVN_ERR(svn_diff_output_binary2(svn_stream_from_stringbuf(diff, pool),
+                                  svn_stream_from_stringbuf(original, pool),
+                                  svn_stream_from_stringbuf(latest, pool),
+                                  FALSE, NULL, NULL, pool));
+
+  /* The literal data must survive the round trip. */
+  SVN_ERR(create_patch_file(&patch_file, diff->data, pool));
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file, FALSE, FALSE,
+                                    pool, pool));
+  SVN_TEST_ASSERT(patch);
+  SVN_TEST_ASSERT(patch->binary_patch);
+
+  SVN_ERR(svn_stringbuf_from_stream(&contents,
+            svn_diff_get_binary_diff_original_stream(patch->binary_patch,
+                                                     pool),
+            0, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(contents, original));
+
+  SVN_ERR(svn_stringbuf_from_stream(&contents,
+            svn_diff_get_binary_diff_result_stream(patch->binary_patch,
+                                                   pool),
+            0, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(contents, latest));
+  SVN_ERR(svn_diff_close_patch_file(patch_file, pool));
+
+  /* With deltas allowed, both hunks become deltas, as the data does
+     not compress but is almost identical. */
+  delta_diff = svn_stringbuf_create("diff --git a/bin b/bin" NL, pool);
+  SVN_ERR(svn_diff_output_binary2(svn_stream_from_stringbuf(delta_diff, pool),
+                                  svn_stream_from_stringbuf(original, pool),
+                                  svn_stream_from_stringbuf(latest, pool),
+                                  TRUE, NULL, NULL, pool));
+
+  SVN_TEST_ASSERT(strstr(delta_diff->data, NL "literal ") == NULL);
+  SVN_TEST_ASSERT(strstr(delta_diff->data, "GIT binary patch" NL "delta "));
+  SVN_TEST_ASSERT(strstr(delta_diff->data, NL NL "delta "));
+  SVN_TEST_ASSERT(delta_diff->len < diff->len / 10);
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1132,6 +1210,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test parsing unidiffs lacking trailing eol"),
     SVN_TEST_PASS2(test_parse_unidiff_with_mergeinfo,
                    "test parsing unidiffs with mergeinfo"),
+    SVN_TEST_PASS2(test_binary_diff_roundtrip,
+                   "test git binary diff output"),
     SVN_TEST_NULL
   };
 
@@ -7161,7 +7161,7 @@ commit_with_locked_rep_cache(const svn_test_opts_t *opts,
   SVN_ERR(svn_sqlite__open(&sdb,
                            svn_dirent_join(fs_path, "rep-cache.db", pool),
                            svn_sqlite__mode_readonly, statements, 0, NULL,
-                           0, pool, pool));
+                           0, NULL, pool, pool));
   SVN_ERR(svn_sqlite__begin_transaction(sdb));
   SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
 
@@ -511,6 +511,118 @@ reposful_reposless_stanzas_inherit(apr_pool_t *pool)
    return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_authz_image(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const char *srcdir;
+  svn_stream_t *rules;
+  svn_stream_t *groups;
+  authz_full_t *authz;
+  authz_full_t *loaded;
+  svn_stringbuf_t *image = svn_stringbuf_create_empty(pool);
+  apr_hash_index_t *hi;
+  int i, k;
+
+  const char *users[] = { "wunga", "fanucci", "", "nobody" };
+  const char *repos[] = { "bloop", "blip", AUTHZ_ANY_REPOSITORY };
+
+  SVN_ERR(svn_test_get_srcdir(&srcdir, opts, pool));
+  SVN_ERR(svn_stream_open_readonly(&rules,
+                                   svn_dirent_join(srcdir, "authz.rules",
+                                                   pool),
+                                   pool, pool));
+  SVN_ERR(svn_stream_open_readonly(&groups,
+                                   svn_dirent_join(srcdir, "authz.groups",
+                                                   pool),
+                                   pool, pool));
+  SVN_ERR(svn_authz__parse(&authz, rules, groups, pool, pool));
+
+  /* Round-trip through the compiled image. */
+  SVN_ERR(svn_authz__write_image(svn_stream_from_stringbuf(image, pool),
+                                 authz, pool));
+  SVN_ERR(svn_authz__read_image(&loaded,
+                                svn_stream_from_stringbuf(image, pool),
+                                pool, pool));
+
+  SVN_TEST_INT_ASSERT(loaded->acls->nelts, authz->acls->nelts);
+  for (i = 0; i < authz->acls->nelts; ++i)
+    {
+      authz_acl_t *acl = &APR_ARRAY_IDX(authz->acls, i, authz_acl_t);
+      authz_acl_t *copy = &APR_ARRAY_IDX(loaded->acls, i, authz_acl_t);
+
+      SVN_TEST_INT_ASSERT(copy->sequence_number, acl->sequence_number);
+      SVN_TEST_INT_ASSERT(svn_authz__compare_rules(&copy->rule, &acl->rule),
+                          0);
+      SVN_TEST_ASSERT(copy->has_anon_access == acl->has_anon_access);
+      SVN_TEST_ASSERT(copy->anon_access == acl->anon_access);
+      SVN_TEST_ASSERT(copy->has_authn_access == acl->has_authn_access);
+      SVN_TEST_ASSERT(copy->authn_access == acl->authn_access);
+
+      SVN_TEST_INT_ASSERT(copy->user_access->nelts, acl->user_access->nelts);
+      for (k = 0; k < acl->user_access->nelts; ++k)
+        {
+          authz_ace_t *ace = &APR_ARRAY_IDX(acl->user_access, k,
+                                            authz_ace_t);
+          authz_ace_t *ace_copy = &APR_ARRAY_IDX(copy->user_access, k,
+                                                 authz_ace_t);
+
+          SVN_TEST_STRING_ASSERT(ace_copy->name, ace->name);
+          SVN_TEST_ASSERT(ace_copy->inverted == ace->inverted);
+          SVN_TEST_ASSERT(ace_copy->access == ace->access);
+          SVN_TEST_ASSERT(!ace_copy->members == !ace->members);
+          if (ace->members)
+            {
+              SVN_TEST_INT_ASSERT(apr_hash_count(ace_copy->members),
+                                  apr_hash_count(ace->members));
+              for (hi = apr_hash_first(pool, ace->members);
+                   hi;
+                   hi = apr_hash_next(hi))
+                SVN_TEST_ASSERT(svn_hash_gets(ace_copy->members,
+                                              apr_hash_this_key(hi)));
+            }
+        }
+
+      /* Identical patterns must remain interned. */
+      for (k = 0; k < i; ++k)
+        {
+          authz_acl_t *prev = &APR_ARRAY_IDX(loaded->acls, k, authz_acl_t);
+          if (prev->rule.len && copy->rule.len
+              && !strcmp(prev->rule.path[0].pattern.data,
+                         copy->rule.path[0].pattern.data))
+            SVN_TEST_ASSERT(prev->rule.path[0].pattern.data
+                            == copy->rule.path[0].pattern.data);
+        }
+    }
+
+  /* The accumulated global rights must be the same. */
+  SVN_TEST_INT_ASSERT(apr_hash_count(loaded->user_rights),
+                      apr_hash_count(authz->user_rights));
+  for (i = 0; i < (int)(sizeof(users) / sizeof(users[0])); ++i)
+    for (k = 0; k < (int)(sizeof(repos) / sizeof(repos[0])); ++k)
+      {
+        authz_rights_t expected, actual;
+        svn_boolean_t expected_explicit, actual_explicit;
+
+        expected_explicit = svn_authz__get_global_rights(&expected, authz,
+                                                         users[i], repos[k]);
+        actual_explicit = svn_authz__get_global_rights(&actual, loaded,
+                                                       users[i], repos[k]);
+        SVN_TEST_ASSERT(expected_explicit == actual_explicit);
+        SVN_TEST_ASSERT(expected.min_access == actual.min_access);
+        SVN_TEST_ASSERT(expected.max_access == actual.max_access);
+      }
+
+  /* Truncated images must be rejected. */
+  svn_stringbuf_chop(image, image->len / 2);
+  SVN_TEST_ASSERT_ERROR(
+      svn_authz__read_image(&loaded, svn_stream_from_stringbuf(image, pool),
+                            pool, pool),
+      SVN_ERR_AUTHZ_INVALID_CONFIG);
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 4;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -520,6 +632,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_authz__parse"),
     SVN_TEST_PASS2(test_global_rights,
                    "test svn_authz__get_global_rights"),
+    SVN_TEST_OPTS_PASS(test_authz_image,
+                       "test compiled authz images"),
     SVN_TEST_PASS2(issue_4741_groups,
                    "issue 4741 groups"),
     SVN_TEST_XFAIL2(reposful_reposless_stanzas_inherit,
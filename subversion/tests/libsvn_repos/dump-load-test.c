@@ -28,6 +28,7 @@
 #include "svn_error.h"
 #include "svn_fs.h"
 #include "svn_repos.h"
+#include "private/svn_io_private.h"
 #include "private/svn_repos_private.h"
 
 #include "../svn_test.h"
@@ -38,7 +39,7 @@
 /* Test dumping in the presence of the property PROP_NAME:PROP_VAL.
  * Return the dumped data in *DUMP_DATA_P (if DUMP_DATA_P is not null).
  * REPOS is an empty repository.
- * See svn_repos_dump_fs3() for START_REV, END_REV, NOTIFY_FUNC, NOTIFY_BATON.
+ * See svn_repos_dump_fs5() for START_REV, END_REV, NOTIFY_FUNC, NOTIFY_BATON.
  */
 static svn_error_t *
 test_dump_bad_props(svn_stringbuf_t **dump_data_p,
@@ -76,8 +77,8 @@ test_dump_bad_props(svn_stringbuf_t **dump_data_p,
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
 
   /* Test that a dump completes without error. */
-  SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev, end_rev,
-                             FALSE, FALSE, TRUE, TRUE,
+  SVN_ERR(svn_repos_dump_fs5(repos, stream, start_rev, end_rev,
+                             FALSE, FALSE, TRUE, TRUE, 1,
                              notify_func, notify_baton,
                              NULL, NULL, NULL, NULL,
                              pool));
@@ -120,7 +121,7 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
   svn_revnum_t youngest_rev;
   svn_string_t *loaded_prop_val;
 
-  SVN_ERR(svn_repos_load_fs6(repos, stream,
+  SVN_ERR(svn_repos_load_fs7(repos, stream,
                              SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
                              svn_repos_load_uuid_default,
                              parent_fspath,
@@ -128,6 +129,7 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
                              validate_props,
                              FALSE /*ignore_dates*/,
                              FALSE /*normalize_props*/,
+                             FALSE /*pipelined*/,
                              notify_func, notify_baton,
                              NULL, NULL, /*cancellation*/
                              pool));
@@ -273,6 +275,399 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos_notify_func_t.  Append the revision of every
+   svn_repos_notify_dump_rev_end notification to the stringbuf BATON. */
+static void
+dump_concurrent_notifier(void *baton,
+                         const svn_repos_notify_t *notify,
+                         apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *revisions = baton;
+
+  if (notify->action == svn_repos_notify_dump_rev_end)
+    svn_stringbuf_appendcstr(revisions,
+                             apr_psprintf(scratch_pool, "r%ld ",
+                                          notify->revision));
+}
+
+/* Dump revisions START_REV to END_REV of REPOS once with a single and
+   once with multiple threads and verify that the outputs match. */
+static svn_error_t *
+compare_concurrent_dump(svn_repos_t *repos,
+                        svn_revnum_t start_rev,
+                        svn_revnum_t end_rev,
+                        svn_boolean_t incremental,
+                        svn_boolean_t use_deltas,
+                        apr_pool_t *pool)
+{
+  svn_stringbuf_t *serial = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *concurrent = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *serial_revs = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *concurrent_revs = svn_stringbuf_create_empty(pool);
+
+  SVN_ERR(svn_repos_dump_fs5(repos, svn_stream_from_stringbuf(serial, pool),
+                             start_rev, end_rev, incremental, use_deltas,
+                             TRUE, TRUE, 1,
+                             dump_concurrent_notifier, serial_revs,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(concurrent, pool),
+                             start_rev, end_rev, incremental, use_deltas,
+                             TRUE, TRUE, 4,
+                             dump_concurrent_notifier, concurrent_revs,
+                             NULL, NULL, NULL, NULL, pool));
+
+  SVN_TEST_STRING_ASSERT(concurrent->data, serial->data);
+  SVN_TEST_STRING_ASSERT(concurrent_revs->data, serial_revs->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_dump_concurrent(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-concurrent",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2 .. r11: text and property changes, copies and deletions */
+  for (i = 0; i < 10; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                          apr_psprintf(iterpool,
+                                                       "mu version %d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B",
+                                      "prop",
+                                      svn_string_createf(iterpool, "%d", i),
+                                      iterpool));
+      if (i % 3 == 0)
+        {
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev,
+                                       iterpool));
+          SVN_ERR(svn_fs_copy(rev_root, "A/D",
+                              txn_root,
+                              apr_psprintf(iterpool, "D%d", i),
+                              iterpool));
+        }
+      if (i == 5)
+        SVN_ERR(svn_fs_delete(txn_root, "D0", iterpool));
+
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(compare_concurrent_dump(repos, 0, youngest_rev, FALSE, FALSE,
+                                  pool));
+  SVN_ERR(compare_concurrent_dump(repos, 0, youngest_rev, FALSE, TRUE,
+                                  pool));
+  SVN_ERR(compare_concurrent_dump(repos, 3, youngest_rev, FALSE, TRUE,
+                                  pool));
+  SVN_ERR(compare_concurrent_dump(repos, 3, youngest_rev, TRUE, FALSE,
+                                  pool));
+  SVN_ERR(compare_concurrent_dump(repos, 3, youngest_rev, TRUE, TRUE,
+                                  pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Load DUMP_DATA into a new repository called NAME with pipelining
+   enabled and verify that dumping it again with USE_DELTAS yields the
+   same data. */
+static svn_error_t *
+verify_pipelined_load(const svn_stringbuf_t *dump_data,
+                      const char *name,
+                      svn_boolean_t use_deltas,
+                      const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_stringbuf_t *reloaded = svn_stringbuf_create_empty(pool);
+  svn_string_t content;
+
+  content.data = dump_data->data;
+  content.len = dump_data->len;
+
+  SVN_ERR(svn_test__create_repos(&repos, name, opts, pool));
+  SVN_ERR(svn_repos_load_fs7(repos, svn_stream_from_string(&content, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, FALSE,
+                             TRUE /*pipelined*/,
+                             NULL, NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(reloaded, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, use_deltas, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(reloaded->data, dump_data->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_load_pipelined(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *big = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *dump_data;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2 .. r6: grow a file well beyond the size that gets processed
+     asynchronously and modify a small one. */
+  for (i = 0; i < 5; ++i)
+    {
+      int k;
+
+      svn_pool_clear(iterpool);
+      for (k = 0; k < 5000; ++k)
+        svn_stringbuf_appendcstr(big, apr_psprintf(iterpool,
+                                                   "line %d of step %d\n",
+                                                   k, i));
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      if (i == 0)
+        SVN_ERR(svn_fs_make_file(txn_root, "big", iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "big", big->data,
+                                          iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(iterpool,
+                                                       "iota %d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Round-trip with fulltexts and with deltas. */
+  dump_data = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(dump_data, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, FALSE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(verify_pipelined_load(dump_data, "test-repo-load-pipelined-2",
+                                FALSE, opts, pool));
+
+  dump_data = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(dump_data, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(verify_pipelined_load(dump_data, "test-repo-load-pipelined-3",
+                                TRUE, opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_load_compressed(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *plain = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *reloaded = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-compressed",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2 .. r6: some text changes */
+  for (i = 0; i < 5; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                          apr_psprintf(iterpool,
+                                                       "mu version %d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Dump and compress. */
+  SVN_ERR(svn_repos_dump_fs5(repos, svn_stream_from_stringbuf(plain, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_repos__dump_compress(&stream,
+                                   svn_stream_from_stringbuf(compressed,
+                                                             pool),
+                                   pool));
+  SVN_ERR(svn_stream_write(stream, plain->data, &plain->len));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_TEST_ASSERT(strcmp(compressed->data, plain->data) != 0);
+
+  /* Loading the compressed stream must restore the same repository. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-compressed-2",
+                                 opts, pool));
+  SVN_ERR(svn_repos_load_fs7(repos,
+                             svn_stream_from_stringbuf(compressed, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, FALSE, FALSE,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(reloaded, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(reloaded->data, plain->data);
+
+  /* Corrupted data must be detected. */
+  compressed->data[compressed->len - 8] ^= 0x55;
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-compressed-3",
+                                 opts, pool));
+  SVN_TEST_ASSERT_ANY_ERROR(
+    svn_repos_load_fs7(repos, svn_stream_from_stringbuf(compressed, pool),
+                       SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                       svn_repos_load_uuid_default, NULL,
+                       FALSE, FALSE, TRUE, FALSE, FALSE, FALSE,
+                       NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump a repository through the block compression and an asynchronous
+   writer, like "svnadmin dump --compress" does, and load the result
+   pipelined, i.e. decompressing in the read-ahead thread.  Use a file
+   large enough to require several full-size blocks. */
+static svn_error_t *
+test_compressed_async(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *plain = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *reloaded = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  const char *path;
+  apr_uint32_t seed = 0;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-compressed-async",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: a file that spans several maximum-size blocks */
+  for (i = 0; i < 200000; ++i)
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(pool, "line %d: %u\n", i,
+                                          svn_test_rand(&seed)));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", contents->data,
+                                      pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_repos_dump_fs5(repos, svn_stream_from_stringbuf(plain, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+
+  /* Dump again, compressing in a separate thread. */
+  SVN_ERR(svn_stream_open_unique(&stream, &path, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 pool, pool));
+  SVN_ERR(svn_repos__dump_compress(&stream, stream, pool));
+  SVN_ERR(svn_stream__create_async_writer(&stream, stream, 0, pool));
+  SVN_ERR(svn_repos_dump_fs5(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Load it pipelined and compare. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-compressed-async-2",
+                                 opts, pool));
+  SVN_ERR(svn_stream_open_readonly(&stream, path, pool, pool));
+  SVN_ERR(svn_repos_load_fs7(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, FALSE,
+                             TRUE /*pipelined*/,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(reloaded, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(reloaded->data, plain->data);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -284,6 +679,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_dump_concurrent,
+                       "test concurrent dumps"),
+    SVN_TEST_OPTS_PASS(test_load_pipelined,
+                       "test pipelined loads"),
+    SVN_TEST_OPTS_PASS(test_load_compressed,
+                       "test loading compressed dump streams"),
+    SVN_TEST_OPTS_PASS(test_compressed_async,
+                       "test compressed dumps with async I/O"),
     SVN_TEST_NULL
   };
 
@@ -38,9 +38,11 @@
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
+#include "svn_time.h"
 #include "svn_version.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_fspath.h"
 
 /* be able to look into svn_config_t */
 #include "../../libsvn_subr/config_impl.h"
@@ -1725,6 +1727,130 @@ test_authz_recursive_override(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Test that lookups reusing the results of previous lookups for parent
+ * paths, e.g. during depth-first tree walks, give the same results as
+ * independent lookups. */
+static svn_error_t *
+test_authz_tree_walk(apr_pool_t *pool)
+{
+  svn_authz_t *authz_cfg;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  const char *contents =
+    "[/]"                                                                   NL
+    "* = r"                                                                 NL
+    ""                                                                      NL
+    "[/A/B]"                                                                NL
+    "* ="                                                                   NL
+    ""                                                                      NL
+    "[/A/B/C/D]"                                                            NL
+    "plato = rw"                                                            NL
+    ""                                                                      NL
+    "[:glob:/A/*/E]"                                                        NL
+    "plato ="                                                               NL
+    ""                                                                      NL
+    "[:glob:/A/**/F]"                                                       NL
+    "plato = rw"                                                            NL
+    ""                                                                      NL
+    "[/G/H]"                                                                NL
+    "plato = rw"                                                            NL;
+
+  /* A depth-first walk with some jumps and repeated paths in between. */
+  const char *paths[] = {
+    "/", "/A", "/A/B", "/A/B/C", "/A/B/C/D", "/A/B/C/D/E", "/A/B/C/D/F",
+    "/A/B/C/E", "/A/B/C/F", "/A/B/E", "/A/B/E/F", "/A/B/F", "/A/C",
+    "/A/C/E", "/A/C/E/F", "/A/C/F", "/A/E", "/A/F", "/G", "/G/H", "/G/H/I",
+    "/A/B/C/D/X", "/G/H/I/J", "/A/C/E", "/A/B", "/A/B/C/D", "/A/B/C/D",
+    "/G", "/"
+  };
+
+  /* Directories whose children get checked in one go. */
+  const char *parents[] = {
+    "/", "/A", "/A/B", "/A/B/C", "/A/B/C/D", "/A/C", "/G", "/G/H", "/A/B/E"
+  };
+  apr_array_header_t *children = apr_array_make(pool, 4,
+                                                sizeof(const char *));
+  APR_ARRAY_PUSH(children, const char *) = "A";
+  APR_ARRAY_PUSH(children, const char *) = "D";
+  APR_ARRAY_PUSH(children, const char *) = "E";
+  APR_ARRAY_PUSH(children, const char *) = "F";
+  APR_ARRAY_PUSH(children, const char *) = "H";
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  for (i = 0; i < (int)(sizeof(paths) / sizeof(paths[0])); ++i)
+    {
+      const svn_repos_authz_access_t required[] = {
+        svn_authz_read,
+        svn_authz_write,
+        svn_authz_read | svn_authz_recursive,
+        svn_authz_write | svn_authz_recursive
+      };
+      int k;
+
+      for (k = 0; k < (int)(sizeof(required) / sizeof(required[0])); ++k)
+        {
+          svn_authz_t *fresh_cfg;
+          svn_boolean_t walk_granted, fresh_granted;
+
+          svn_pool_clear(iterpool);
+
+          SVN_ERR(svn_repos_authz_check_access(authz_cfg, NULL, paths[i],
+                                               "plato", required[k],
+                                               &walk_granted, iterpool));
+
+          SVN_ERR(authz_get_handle(&fresh_cfg, contents, FALSE, iterpool));
+          SVN_ERR(svn_repos_authz_check_access(fresh_cfg, NULL, paths[i],
+                                               "plato", required[k],
+                                               &fresh_granted, iterpool));
+
+          if (walk_granted != fresh_granted)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "Tree walk %s access %d to %s",
+                                     walk_granted ? "grants" : "denies",
+                                     (int)required[k], paths[i]);
+        }
+    }
+
+  /* Checking all children of a directory at once must give the same
+   * results as checking them one by one. */
+  for (i = 0; i < (int)(sizeof(parents) / sizeof(parents[0])); ++i)
+    {
+      apr_array_header_t *granted;
+      int k;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_repos_authz_check_children(&granted, authz_cfg, NULL,
+                                             parents[i], children, "plato",
+                                             svn_authz_write, iterpool,
+                                             iterpool));
+      SVN_TEST_INT_ASSERT(granted->nelts, children->nelts);
+
+      for (k = 0; k < children->nelts; ++k)
+        {
+          svn_boolean_t single_granted;
+          const char *path
+            = svn_fspath__join(parents[i],
+                               APR_ARRAY_IDX(children, k, const char *),
+                               iterpool);
+
+          SVN_ERR(svn_repos_authz_check_access(authz_cfg, NULL, path,
+                                               "plato", svn_authz_write,
+                                               &single_granted, iterpool));
+          if (APR_ARRAY_IDX(granted, k, svn_boolean_t) != single_granted)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "Batch check %s write access to %s",
+                                     single_granted ? "denies" : "grants",
+                                     path);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_authz_pattern_tests(apr_pool_t *pool)
 {
@@ -4466,6 +4592,615 @@ test_list(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Notification counters for test_verify_since_last. */
+typedef struct verify_counts_t
+{
+  int verified;
+  int skipped;
+} verify_counts_t;
+
+/* Implements svn_repos_notify_func_t. */
+static void
+count_verify_notifications(void *baton,
+                           const svn_repos_notify_t *notify,
+                           apr_pool_t *scratch_pool)
+{
+  verify_counts_t *counts = baton;
+
+  if (notify->action == svn_repos_notify_verify_rev_end)
+    counts->verified++;
+  else if (notify->action == svn_repos_notify_verify_rev_skipped)
+    counts->skipped++;
+}
+
+/* Run an incremental verification of REPOS and check that it verified
+   VERIFIED and skipped SKIPPED revisions. */
+static svn_error_t *
+verify_since_last(svn_repos_t *repos,
+                  int verified,
+                  int skipped,
+                  apr_pool_t *pool)
+{
+  verify_counts_t counts = { 0 };
+
+  SVN_ERR(svn_repos_verify_fs4(repos, SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                               FALSE, FALSE, TRUE,
+                               count_verify_notifications, &counts,
+                               NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(counts.verified, verified);
+  SVN_TEST_INT_ASSERT(counts.skipped, skipped);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_verify_since_last(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-verify-since-last",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree, r2: a modification */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "changed\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* The first run verifies everything, the second one nothing. */
+  SVN_ERR(verify_since_last(repos, 3, 0, pool));
+  SVN_ERR(verify_since_last(repos, 0, 3, pool));
+
+  /* Revprop changes require another verification. */
+  SVN_ERR(svn_fs_change_rev_prop2(fs, 1, SVN_PROP_REVISION_LOG, NULL,
+                                  svn_string_create("new log", pool),
+                                  pool));
+  SVN_ERR(verify_since_last(repos, 1, 2, pool));
+
+  /* So do new revisions. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "X", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(verify_since_last(repos, 1, 3, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for blame_receiver(). */
+typedef struct blame_baton_t
+{
+  /* Expected revisions, one per line. */
+  const svn_revnum_t *expected;
+  int count;
+
+  /* Number of lines received so far. */
+  int received;
+} blame_baton_t;
+
+/* Implements svn_repos_blame_receiver_t, checking the line annotations
+ * against the blame_baton_t BATON. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t line_no,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               const svn_string_t *line,
+               apr_pool_t *scratch_pool)
+{
+  blame_baton_t *b = baton;
+
+  SVN_TEST_ASSERT(line_no == b->received);
+  SVN_TEST_ASSERT(b->received < b->count);
+  SVN_TEST_ASSERT(revision == b->expected[b->received]);
+  SVN_TEST_ASSERT(rev_props
+                  && svn_hash_gets(rev_props, SVN_PROP_REVISION_DATE));
+  b->received++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Annotate /iota in REPOS as of END with DIFF_OPTIONS and verify that the
+ * lines got attributed to the COUNT revisions given in EXPECTED. */
+static svn_error_t *
+verify_blame(svn_repos_t *repos,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             const svn_revnum_t *expected,
+             int count,
+             apr_pool_t *pool)
+{
+  blame_baton_t b;
+
+  b.expected = expected;
+  b.count = count;
+  b.received = 0;
+
+  SVN_ERR(svn_repos_get_blame(repos, "/iota", 0, end, diff_options,
+                              NULL, NULL, blame_receiver, &b, NULL, NULL,
+                              pool));
+  SVN_TEST_INT_ASSERT(b.received, count);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_blame(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_node_kind_t kind;
+  svn_diff_file_options_t *diff_options;
+  static const svn_revnum_t expected_r3[] = { 2, 3, 3 };
+  static const svn_revnum_t expected_r4[] = { 2, 3, 3, 4 };
+  static const svn_revnum_t expected_r5[] = { 5, 3, 3, 4 };
+  static const svn_revnum_t expected_r5_ws[] = { 2, 3, 3, 4 };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-blame",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree, r2 and r3: edits to iota */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "a\nb\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "a\nB\nc\n",
+                                      pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(verify_blame(repos, youngest_rev, NULL, expected_r3,
+                       sizeof(expected_r3) / sizeof(expected_r3[0]), pool));
+
+  /* The result has been cached. */
+  SVN_ERR(svn_io_check_path(svn_dirent_join(svn_repos_db_env(repos, pool),
+                                            "blame-cache", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  /* Extending the file continues from the cached state. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "a\nB\nc\nd\n",
+                                      pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(verify_blame(repos, youngest_rev, NULL, expected_r4,
+                       sizeof(expected_r4) / sizeof(expected_r4[0]), pool));
+
+  /* Older versions are still annotated correctly. */
+  SVN_ERR(verify_blame(repos, 3, NULL, expected_r3,
+                       sizeof(expected_r3) / sizeof(expected_r3[0]), pool));
+
+  /* Whitespace changes only count if not ignored. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "a \nB\nc\nd\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(verify_blame(repos, youngest_rev, NULL, expected_r5,
+                       sizeof(expected_r5) / sizeof(expected_r5[0]), pool));
+
+  diff_options = svn_diff_file_options_create(pool);
+  diff_options->ignore_space = svn_diff_file_ignore_space_change;
+  SVN_ERR(verify_blame(repos, youngest_rev, diff_options, expected_r5_ws,
+                       sizeof(expected_r5_ws) / sizeof(expected_r5_ws[0]),
+                       pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the svn:date of revision REV in FS to SECONDS after the epoch,
+ * bypassing the repository layer. */
+static svn_error_t *
+set_rev_date(svn_fs_t *fs,
+             svn_revnum_t rev,
+             int seconds,
+             apr_pool_t *pool)
+{
+  const char *date = svn_time_to_cstring(apr_time_from_sec(seconds), pool);
+
+  return svn_error_trace(svn_fs_change_rev_prop2(fs, rev,
+                                                 SVN_PROP_REVISION_DATE,
+                                                 NULL,
+                                                 svn_string_create(date, pool),
+                                                 pool));
+}
+
+/* Verify that svn_repos_dated_revision() maps SECONDS after the epoch to
+ * revision EXPECTED in REPOS. */
+static svn_error_t *
+verify_dated_revision(svn_repos_t *repos,
+                      int seconds,
+                      svn_revnum_t expected,
+                      apr_pool_t *pool)
+{
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_repos_dated_revision(&rev, repos, apr_time_from_sec(seconds),
+                                   pool));
+  SVN_TEST_INT_ASSERT(rev, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_date_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_node_kind_t kind;
+  const char *date;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-date-index",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1 to r5, committed at t = 1000, 2000, ... 5000 */
+  for (i = 1; i <= 5; i++)
+    {
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_fs_make_dir(txn_root, apr_psprintf(pool, "D%d", i), pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+      SVN_ERR(set_rev_date(fs, youngest_rev, i * 1000, pool));
+    }
+  SVN_ERR(set_rev_date(fs, 0, 500, pool));
+
+  /* Without an index. */
+  SVN_ERR(verify_dated_revision(repos, 100, 0, pool));
+  SVN_ERR(verify_dated_revision(repos, 2500, 2, pool));
+
+  SVN_ERR(svn_repos_rebuild_date_index(repos, NULL, NULL, pool));
+  SVN_ERR(svn_io_check_path(svn_dirent_join(svn_repos_db_env(repos, pool),
+                                            "date-index", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(verify_dated_revision(repos, 100, 0, pool));
+  SVN_ERR(verify_dated_revision(repos, 500, 0, pool));
+  SVN_ERR(verify_dated_revision(repos, 1000, 1, pool));
+  SVN_ERR(verify_dated_revision(repos, 2500, 2, pool));
+  SVN_ERR(verify_dated_revision(repos, 5000, 5, pool));
+  SVN_ERR(verify_dated_revision(repos, 9000, 5, pool));
+
+  /* Changes that bypass the repository layer leave the index outdated
+   * but must not affect the results. */
+  SVN_ERR(set_rev_date(fs, 3, 2200, pool));
+  SVN_ERR(verify_dated_revision(repos, 2500, 3, pool));
+  SVN_ERR(verify_dated_revision(repos, 2100, 2, pool));
+
+  /* Commits and svn:date changes through the repository layer update
+   * the index. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "D6", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  date = svn_time_to_cstring(apr_time_from_sec(6000), pool);
+  SVN_ERR(svn_repos_fs_change_rev_prop4(repos, youngest_rev, NULL,
+                                        SVN_PROP_REVISION_DATE, NULL,
+                                        svn_string_create(date, pool),
+                                        FALSE, FALSE, NULL, NULL, pool));
+  SVN_ERR(verify_dated_revision(repos, 5500, 5, pool));
+  SVN_ERR(verify_dated_revision(repos, 6500, 6, pool));
+
+  /* A rebuild picks up all changes. */
+  SVN_ERR(svn_repos_rebuild_date_index(repos, NULL, NULL, pool));
+  SVN_ERR(verify_dated_revision(repos, 2500, 3, pool));
+  SVN_ERR(verify_dated_revision(repos, 6000, 6, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Install a hook script at HOOK that exits with EXIT_CODE. */
+static svn_error_t *
+set_hook(const char *hook,
+         int exit_code,
+         apr_pool_t *pool)
+{
+#ifdef WIN32
+  hook = apr_pstrcat(pool, hook, ".bat", SVN_VA_NULL);
+  SVN_ERR(svn_io_remove_file2(hook, TRUE, pool));
+  SVN_ERR(svn_io_file_create(hook,
+                             apr_psprintf(pool, "exit %d" APR_EOL_STR,
+                                          exit_code),
+                             pool));
+#else
+  SVN_ERR(svn_io_remove_file2(hook, TRUE, pool));
+  SVN_ERR(svn_io_file_create(hook,
+                             apr_psprintf(pool, "#!/bin/sh" APR_EOL_STR
+                                                "exit %d" APR_EOL_STR,
+                                          exit_code),
+                             pool));
+  SVN_ERR(svn_io_set_file_executable(hook, TRUE, FALSE, pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_hook_queue(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_array_header_t *events;
+  const svn_repos_hook_event_t *event;
+  svn_boolean_t enabled;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-hook-queue",
+                                 opts, pool));
+  SVN_ERR(set_hook(svn_repos_post_commit_hook(repos, pool), 1, pool));
+
+  SVN_ERR(svn_repos_hook_queue_status(&enabled, &events, repos, pool, pool));
+  SVN_TEST_ASSERT(!enabled);
+  SVN_TEST_ASSERT(events->nelts == 0);
+  SVN_TEST_ASSERT_ERROR(svn_repos_hook_queue_run(repos, 1, 1, FALSE,
+                                                 NULL, NULL, NULL, NULL,
+                                                 pool),
+                        SVN_ERR_REPOS_DISABLED_FEATURE);
+
+  /* With the queue enabled, a failing post-commit hook does not affect
+   * the commit. */
+  SVN_ERR(svn_repos_hook_queue_enable(repos, TRUE, pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), youngest_rev, 0,
+                            pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(youngest_rev == 1);
+
+  SVN_ERR(svn_repos_hook_queue_status(&enabled, &events, repos, pool, pool));
+  SVN_TEST_ASSERT(enabled);
+  SVN_TEST_ASSERT(events->nelts == 1);
+  event = APR_ARRAY_IDX(events, 0, const svn_repos_hook_event_t *);
+  SVN_TEST_STRING_ASSERT(event->hook, "post-commit");
+  SVN_TEST_ASSERT(event->revision == 1);
+  SVN_TEST_ASSERT(event->attempts == 0);
+  SVN_TEST_ASSERT(!event->failed);
+
+  /* Running the hook fails and, with only one attempt allowed, the
+   * event is kept as failed. */
+  SVN_ERR(svn_repos_hook_queue_run(repos, 2, 1, FALSE, NULL, NULL,
+                                   NULL, NULL, pool));
+  SVN_ERR(svn_repos_hook_queue_status(&enabled, &events, repos, pool, pool));
+  SVN_TEST_ASSERT(events->nelts == 1);
+  event = APR_ARRAY_IDX(events, 0, const svn_repos_hook_event_t *);
+  SVN_TEST_ASSERT(event->attempts == 1);
+  SVN_TEST_ASSERT(event->failed);
+  SVN_TEST_ASSERT(event->last_error != NULL);
+
+  /* A later event for the same revision must wait for the failed one. */
+  SVN_ERR(set_hook(svn_repos_post_revprop_change_hook(repos, pool), 0,
+                   pool));
+  SVN_ERR(svn_repos_fs_change_rev_prop4(repos, youngest_rev, NULL,
+                                        SVN_PROP_REVISION_LOG, NULL,
+                                        svn_string_create("log", pool),
+                                        FALSE, TRUE, NULL, NULL, pool));
+
+  /* Failed events are not run again automatically and keep the queue
+   * from being disabled. */
+  SVN_ERR(svn_repos_hook_queue_run(repos, 2, 1, FALSE, NULL, NULL,
+                                   NULL, NULL, pool));
+  SVN_ERR(svn_repos_hook_queue_status(&enabled, &events, repos, pool, pool));
+  SVN_TEST_ASSERT(events->nelts == 2);
+  event = APR_ARRAY_IDX(events, 1, const svn_repos_hook_event_t *);
+  SVN_TEST_STRING_ASSERT(event->hook, "post-revprop-change");
+  SVN_TEST_ASSERT(event->attempts == 0);
+  SVN_TEST_ASSERT_ERROR(svn_repos_hook_queue_enable(repos, FALSE, pool),
+                        SVN_ERR_REPOS_BAD_ARGS);
+
+  /* Once the hook is fixed, a retry succeeds and unblocks the later
+   * event. */
+  SVN_ERR(set_hook(svn_repos_post_commit_hook(repos, pool), 0, pool));
+  SVN_ERR(svn_repos_hook_queue_clear_failed(repos, TRUE, pool));
+  SVN_ERR(svn_repos_hook_queue_run(repos, 2, 1, FALSE, NULL, NULL,
+                                   NULL, NULL, pool));
+  SVN_ERR(svn_repos_hook_queue_status(&enabled, &events, repos, pool, pool));
+  SVN_TEST_ASSERT(events->nelts == 0);
+
+  SVN_ERR(svn_repos_hook_queue_enable(repos, FALSE, pool));
+  SVN_ERR(svn_repos_hook_queue_status(&enabled, NULL, repos, pool, pool));
+  SVN_TEST_ASSERT(!enabled);
+
+  /* Without the queue, hook failures are reported by the commit again. */
+  SVN_ERR(set_hook(svn_repos_post_commit_hook(repos, pool), 1, pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), youngest_rev, 0,
+                            pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "B", pool));
+  err = svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool);
+  SVN_TEST_ASSERT(youngest_rev == 2);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_REPOS_POST_COMMIT_HOOK_FAILED);
+
+  return SVN_NO_ERROR;
+}
+
+/* Log receiver counting how often each revision got reported in the
+   int array BATON. */
+static svn_error_t *
+count_log_entries(void *baton,
+                  svn_repos_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
+{
+  int *counts = baton;
+
+  if (SVN_IS_VALID_REVNUM(log_entry->revision))
+    counts[log_entry->revision]++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of nested branches created by test_log_deep_merges. */
+#define LOG_MERGE_DEPTH 6
+
+static svn_error_t *
+test_log_deep_merges(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_revnum_t created[LOG_MERGE_DEPTH + 1];
+  svn_revnum_t last_change[LOG_MERGE_DEPTH + 1];
+  svn_boolean_t *expected;
+  apr_array_header_t *paths;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int d, k, pass;
+
+  /* Check for feature support */
+  if (opts->server_minor_version && (opts->server_minor_version < 5))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not supported in pre-1.5 SVN");
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-deep-merges",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: /b0 with a file.  Then branch /b1 off /b0, /b2 off /b1 etc. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "b0", iterpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "b0/f", iterpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "b0/f", "b0\n", iterpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                  iterpool));
+  created[0] = youngest_rev;
+
+  for (d = 1; d <= LOG_MERGE_DEPTH; d++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, iterpool));
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_fs_copy(rev_root, apr_psprintf(iterpool, "b%d", d - 1),
+                          txn_root, apr_psprintf(iterpool, "b%d", d),
+                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+      created[d] = youngest_rev;
+    }
+
+  /* Change the file on every branch. */
+  for (d = 1; d <= LOG_MERGE_DEPTH; d++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root,
+                                          apr_psprintf(iterpool, "b%d/f", d),
+                                          apr_psprintf(iterpool, "b%d\n", d),
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+      last_change[d] = youngest_rev;
+    }
+
+  /* Merge each branch into its parent, deepest first, recording the
+     mergeinfo of all branches below. */
+  for (d = LOG_MERGE_DEPTH; d >= 1; d--)
+    {
+      svn_stringbuf_t *mergeinfo;
+
+      svn_pool_clear(iterpool);
+      mergeinfo = svn_stringbuf_create_empty(iterpool);
+      for (k = d; k <= LOG_MERGE_DEPTH; k++)
+        svn_stringbuf_appendcstr(mergeinfo,
+                                 apr_psprintf(iterpool, "/b%d:%ld-%ld\n",
+                                              k, created[k] + 1,
+                                              last_change[k]));
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root,
+                                      apr_psprintf(iterpool, "b%d", d - 1),
+                                      SVN_PROP_MERGEINFO,
+                                      svn_string_create(mergeinfo->data,
+                                                        iterpool),
+                                      iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root,
+                                          apr_psprintf(iterpool, "b%d/f",
+                                                       d - 1),
+                                          apr_psprintf(iterpool, "b%d\n", d),
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+      last_change[d - 1] = youngest_rev;
+    }
+
+  /* The log of /b0 reports its own changes and, nested, all changes and
+     merges on the branches.  Only the branch creations are not part of
+     the merged history. */
+  expected = apr_pcalloc(pool, (youngest_rev + 1) * sizeof(*expected));
+  expected[created[0]] = TRUE;
+  for (d = created[LOG_MERGE_DEPTH] + 1; d <= youngest_rev; d++)
+    expected[d] = TRUE;
+
+  paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/b0";
+
+  /* Descending and ascending order must report the same revisions. */
+  for (pass = 0; pass < 2; pass++)
+    {
+      int *counts;
+      svn_revnum_t rev;
+
+      svn_pool_clear(iterpool);
+      counts = apr_pcalloc(iterpool, (youngest_rev + 1) * sizeof(*counts));
+      SVN_ERR(svn_repos_get_logs5(repos, paths,
+                                  pass ? 1 : youngest_rev,
+                                  pass ? youngest_rev : 1,
+                                  0, FALSE, TRUE, NULL, NULL, NULL,
+                                  NULL, NULL, count_log_entries, counts,
+                                  iterpool));
+
+      for (rev = 1; rev <= youngest_rev; rev++)
+        if (counts[rev] != (expected[rev] ? 1 : 0))
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "r%ld reported %d times in %s log",
+                                   rev, counts[rev],
+                                   pass ? "ascending" : "descending");
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -4529,6 +5264,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test authz prefixes"),
     SVN_TEST_PASS2(test_authz_recursive_override,
                    "test recursively authz rule override"),
+    SVN_TEST_PASS2(test_authz_tree_walk,
+                   "test authz lookups in tree walks"),
     SVN_TEST_PASS2(test_authz_pattern_tests,
                    "test various basic authz pattern combinations"),
     SVN_TEST_PASS2(test_authz_wildcards,
@@ -4537,6 +5274,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "optional authz wildcard performance test"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(test_verify_since_last,
+                       "test incremental verification"),
+    SVN_TEST_OPTS_PASS(test_get_blame,
+                       "test svn_repos_get_blame"),
+    SVN_TEST_OPTS_PASS(test_date_index,
+                       "test svn_repos_dated_revision with a date index"),
+    SVN_TEST_OPTS_PASS(test_hook_queue,
+                       "test the asynchronous hook queue"),
+    SVN_TEST_OPTS_PASS(test_log_deep_merges,
+                       "test svn_repos_get_logs5 with nested merges"),
     SVN_TEST_NULL
   };
 
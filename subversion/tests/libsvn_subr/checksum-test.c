@@ -22,11 +22,13 @@
  */
 
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include <zlib.h>
 
 #include "svn_error.h"
 #include "svn_io.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -364,6 +366,119 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sha1_vectors(apr_pool_t *pool)
+{
+  /* Test vectors from FIPS 180-1, covering one and two block messages
+   * as well as a message spanning many blocks. */
+  struct sha1_vector_t
+    {
+      const char *data;
+      int repeat;
+      const char *digest;
+    }
+  tests[] =
+    {
+      { "abc", 1, "a9993e364706816aba3e25717850c26c9cd0d89d" },
+      { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+        "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+      { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 10000,
+        "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+      { NULL, 0, NULL }
+    };
+  const struct sha1_vector_t *t;
+
+  for (t = tests; t->data; t++)
+    {
+      svn_checksum_ctx_t *ctx = svn_checksum_ctx_create(svn_checksum_sha1,
+                                                        pool);
+      svn_checksum_t *checksum;
+      apr_size_t len = strlen(t->data);
+      int i;
+
+      /* Feed the data in odd-sized pieces to test block buffering. */
+      for (i = 0; i < t->repeat; i++)
+        {
+          SVN_ERR(svn_checksum_update(ctx, t->data, len / 3));
+          SVN_ERR(svn_checksum_update(ctx, t->data + len / 3,
+                                      len - len / 3));
+        }
+
+      SVN_ERR(svn_checksum_final(&checksum, ctx, pool));
+      SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring(checksum, pool),
+                             t->digest);
+
+      if (t->repeat == 1)
+        {
+          SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, t->data, len,
+                               pool));
+          SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring(checksum, pool),
+                                 t->digest);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksummed_stream_multi(apr_pool_t *pool)
+{
+  const svn_checksum_kind_t kinds[]
+    = { svn_checksum_md5, svn_checksum_sha1, svn_checksum_fnv1a_32x4 };
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_checksum_t *md5_checksum, *sha1_checksum;
+  svn_checksum_t *read_fnv1a_checksum;
+  svn_checksum_t **write_checksums[3];
+  svn_checksum_t **read_checksums[3];
+  svn_stream_t *stream;
+  apr_size_t len;
+  int i;
+
+  /* Enough data to have the checksums calculated in many slices. */
+  for (i = 0; i < 100000; i++)
+    svn_stringbuf_appendcstr(data, apr_psprintf(pool, "%d\n", i * 7919));
+
+  /* Calculate some checksums over written data... */
+  write_checksums[0] = &md5_checksum;
+  write_checksums[1] = &sha1_checksum;
+  write_checksums[2] = NULL;
+
+  stream = svn_stream__checksummed_multi(svn_stream_empty(pool), NULL,
+                                         write_checksums, kinds, 3, FALSE,
+                                         pool);
+  len = data->len;
+  SVN_ERR(svn_stream_write(stream, data->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  for (i = 0; i < 2; i++)
+    {
+      svn_checksum_t *expected;
+      SVN_ERR(svn_checksum(&expected, kinds[i], data->data, data->len,
+                           pool));
+      SVN_TEST_ASSERT(svn_checksum_match(expected, *write_checksums[i]));
+    }
+
+  /* ... and over read data. */
+  read_checksums[0] = NULL;
+  read_checksums[1] = NULL;
+  read_checksums[2] = &read_fnv1a_checksum;
+
+  stream = svn_stream_from_stringbuf(data, pool);
+  stream = svn_stream__checksummed_multi(stream, read_checksums, NULL,
+                                         kinds, 3, TRUE, pool);
+  SVN_ERR(svn_stream_close(stream));
+
+  {
+    svn_checksum_t *expected;
+    SVN_ERR(svn_checksum(&expected, svn_checksum_fnv1a_32x4, data->data,
+                         data->len, pool));
+    SVN_TEST_ASSERT(svn_checksum_match(expected, read_fnv1a_checksum));
+  }
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +504,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_PASS2(test_sha1_vectors,
+                   "SHA1 test vectors"),
+    SVN_TEST_PASS2(test_checksummed_stream_multi,
+                   "calculate multiple checksums over a stream"),
     SVN_TEST_NULL
   };
 
@@ -36,6 +36,8 @@
 #include "svn_error.h"
 #include "svn_hash.h"
 
+#include "private/svn_subr_private.h"
+
 
 /* Our own global variables */
 static apr_hash_t *proplist, *new_proplist;
@@ -231,6 +233,85 @@ read_hash_buffered_test(apr_pool_t *pool)
 }
 
 
+static svn_error_t *
+binary_proplist_test(apr_pool_t *pool)
+{
+  apr_hash_t *ht = apr_hash_make(pool);
+  apr_hash_t *parsed;
+  svn_stringbuf_t *binary;
+  svn_stringbuf_t *dump = svn_stringbuf_create_empty(pool);
+  svn_string_t *value;
+  apr_hash_index_t *hi;
+
+  svn_hash_sets(ht, "svn:mergeinfo", svn_string_create("/trunk:1-10", pool));
+  svn_hash_sets(ht, "svn:eol-style", svn_string_create("native", pool));
+  svn_hash_sets(ht, "wine review", svn_string_create(review, pool));
+  svn_hash_sets(ht, "empty", svn_string_create_empty(pool));
+  svn_hash_sets(ht, "a", svn_string_create("prefix of \"ab\"", pool));
+  svn_hash_sets(ht, "ab", svn_string_ncreate("bin\0ary\nvalue", 13, pool));
+
+  SVN_ERR(svn_proplist__create(&binary, ht, pool));
+  SVN_ERR(svn_hash_write2(ht, svn_stream_from_stringbuf(dump, pool),
+                          SVN_HASH_TERMINATOR, pool));
+  SVN_TEST_ASSERT(svn_proplist__is_binary(binary->data, binary->len));
+  SVN_TEST_ASSERT(!svn_proplist__is_binary(dump->data, dump->len));
+
+  /* Both formats must produce the same lookup and parser results. */
+  for (hi = apr_hash_first(pool, ht); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_string_t *expected = apr_hash_this_val(hi);
+
+      SVN_ERR(svn_proplist__get(&value, binary->data, binary->len, name,
+                                pool));
+      SVN_TEST_ASSERT(value && svn_string_compare(value, expected));
+      SVN_ERR(svn_proplist__get(&value, dump->data, dump->len, name, pool));
+      SVN_TEST_ASSERT(value && svn_string_compare(value, expected));
+    }
+
+  SVN_ERR(svn_proplist__get(&value, binary->data, binary->len, "abc", pool));
+  SVN_TEST_ASSERT(value == NULL);
+  SVN_ERR(svn_proplist__get(&value, binary->data, binary->len, "", pool));
+  SVN_TEST_ASSERT(value == NULL);
+  SVN_ERR(svn_proplist__get(&value, dump->data, dump->len, "abc", pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  SVN_ERR(svn_proplist__parse(&parsed, binary->data, binary->len, pool));
+  SVN_TEST_ASSERT(apr_hash_count(parsed) == apr_hash_count(ht));
+  for (hi = apr_hash_first(pool, ht); hi; hi = apr_hash_next(hi))
+    {
+      value = svn_hash_gets(parsed, apr_hash_this_key(hi));
+      SVN_TEST_ASSERT(value && svn_string_compare(value,
+                                                  apr_hash_this_val(hi)));
+      SVN_TEST_ASSERT(value->data[value->len] == '\0');
+    }
+
+  SVN_ERR(svn_proplist__parse(&parsed, dump->data, dump->len, pool));
+  SVN_TEST_ASSERT(apr_hash_count(parsed) == apr_hash_count(ht));
+
+  /* Empty lists. */
+  SVN_ERR(svn_proplist__create(&binary, apr_hash_make(pool), pool));
+  SVN_ERR(svn_proplist__get(&value, binary->data, binary->len, "a", pool));
+  SVN_TEST_ASSERT(value == NULL);
+  SVN_ERR(svn_proplist__parse(&parsed, binary->data, binary->len, pool));
+  SVN_TEST_ASSERT(apr_hash_count(parsed) == 0);
+
+  /* Truncated data must be detected. */
+  SVN_ERR(svn_proplist__create(&binary, ht, pool));
+  SVN_TEST_ASSERT_ERROR(svn_proplist__parse(&parsed, binary->data,
+                                            binary->len - 1, pool),
+                        SVN_ERR_MALFORMED_FILE);
+  SVN_TEST_ASSERT_ERROR(svn_proplist__get(&value, binary->data, 20,
+                                          "a", pool),
+                        SVN_ERR_MALFORMED_FILE);
+  SVN_TEST_ASSERT_ERROR(svn_proplist__get(&value, dump->data, 20,
+                                          "svn:mergeinfo", pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -252,6 +333,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "write hash out, read back in, compare"),
     SVN_TEST_PASS2(read_hash_buffered_test,
                    "read hash from buffered file"),
+    SVN_TEST_PASS2(binary_proplist_test,
+                   "binary property list format"),
     SVN_TEST_NULL
   };
 
@@ -28,6 +28,7 @@
 #include <apr.h>
 #include <apr_version.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_string.h"
 #include "svn_io.h"
@@ -1147,6 +1148,88 @@ test_apr_trunc_workaround(apr_pool_t *pool)
   return SVN_NO_ERROR;  
 }
 
+static svn_error_t *
+test_io_batch(apr_pool_t *pool)
+{
+  enum { FILE_COUNT = 100 };
+  const char *tmp_dir, *path;
+  svn_io__batch_t *batch;
+  svn_io_dirent2_t dirents[FILE_COUNT + 1];
+  const svn_io_dirent2_t *expected;
+  apr_hash_t *listing;
+  apr_file_t *file;
+  char buffers[4][16];
+  apr_size_t bytes_read[4];
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_io_batch", pool));
+
+  /* Enough files for svn_io_get_dirents3() to batch its stat calls. */
+  for (i = 0; i < FILE_COUNT; i++)
+    {
+      path = svn_dirent_join(tmp_dir, apr_psprintf(pool, "file%d", i), pool);
+      SVN_ERR(svn_io_file_create(path, apr_psprintf(pool, "%*d", i, i),
+                                 pool));
+    }
+
+  SVN_ERR(svn_io__batch_create(&batch, 8, pool));
+
+  /* Stat existing and missing nodes. */
+  for (i = 0; i < FILE_COUNT; i++)
+    SVN_ERR(svn_io__batch_stat(batch, &dirents[i],
+                               svn_dirent_join(tmp_dir,
+                                               apr_psprintf(pool, "file%d", i),
+                                               pool)));
+  SVN_ERR(svn_io__batch_stat(batch, &dirents[FILE_COUNT],
+                             svn_dirent_join(tmp_dir, "missing", pool)));
+  SVN_TEST_INT_ASSERT(svn_io__batch_size(batch), FILE_COUNT + 1);
+  SVN_ERR(svn_io__batch_run(batch, pool));
+  SVN_TEST_INT_ASSERT(svn_io__batch_size(batch), 0);
+
+  for (i = 0; i < FILE_COUNT; i++)
+    {
+      path = svn_dirent_join(tmp_dir, apr_psprintf(pool, "file%d", i), pool);
+      SVN_ERR(svn_io_stat_dirent2(&expected, path, FALSE, FALSE,
+                                  pool, pool));
+      SVN_TEST_ASSERT(dirents[i].kind == svn_node_file);
+      SVN_TEST_ASSERT(dirents[i].filesize == expected->filesize);
+      SVN_TEST_ASSERT(dirents[i].mtime == expected->mtime);
+    }
+  SVN_TEST_ASSERT(dirents[FILE_COUNT].kind == svn_node_none);
+
+  /* Read from various offsets, including beyond EOF. */
+  path = svn_dirent_join(tmp_dir, "file20", pool);
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool));
+  for (i = 0; i < 4; i++)
+    SVN_ERR(svn_io__batch_read(batch, file, i * 6, buffers[i],
+                               sizeof(buffers[i]), &bytes_read[i]));
+  SVN_ERR(svn_io__batch_run(batch, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_TEST_INT_ASSERT(bytes_read[0], 16);
+  SVN_TEST_INT_ASSERT(bytes_read[1], 14);
+  SVN_TEST_INT_ASSERT(bytes_read[2], 8);
+  SVN_TEST_INT_ASSERT(bytes_read[3], 2);
+  SVN_TEST_ASSERT(memcmp(buffers[0], "                ", 16) == 0);
+  SVN_TEST_ASSERT(memcmp(buffers[2], "      20", 8) == 0);
+  SVN_TEST_ASSERT(memcmp(buffers[3], "20", 2) == 0);
+
+  /* Directory listings must be the same, batched or not. */
+  SVN_ERR(svn_io_get_dirents3(&listing, tmp_dir, FALSE, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(listing), FILE_COUNT);
+  for (i = 0; i < FILE_COUNT; i++)
+    {
+      const svn_io_dirent2_t *dirent
+        = svn_hash_gets(listing, apr_psprintf(pool, "file%d", i));
+
+      SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+      SVN_TEST_ASSERT(dirent->filesize == dirents[i].filesize);
+      SVN_TEST_ASSERT(dirent->mtime == dirents[i].mtime);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 3;
@@ -1184,6 +1267,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_open_uniquely_named()"),
     SVN_TEST_PASS2(test_apr_trunc_workaround,
                    "test workaround for APR in svn_io_file_trunc"),
+    SVN_TEST_PASS2(test_io_batch,
+                   "test batched file system requests"),
     SVN_TEST_NULL
   };
 
@@ -37,6 +37,7 @@
 #include "svn_error.h"
 #include "svn_string.h"   /* This includes <apr_*.h> */
 #include "private/svn_packed_data.h"
+#include "private/svn_subr_private.h"
 
 /* Take the WRITE_ROOT, serialize its contents, parse it again into a new
  * data root and return it in *READ_ROOT.  Allocate it in POOL.
@@ -553,6 +554,67 @@ test_full_structure(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Check that the bulk LEB128 coder round-trips values of all lengths and
+ * handles incomplete and corrupt input. */
+static svn_error_t *
+test_leb128_coder(apr_pool_t *pool)
+{
+  enum { COUNT = 1000 };
+  apr_uint64_t *values = apr_palloc(pool, COUNT * sizeof(*values));
+  apr_uint64_t *decoded = apr_palloc(pool, COUNT * sizeof(*decoded));
+  apr_size_t *ends = apr_palloc(pool, COUNT * sizeof(*ends));
+  unsigned char *buffer
+    = apr_palloc(pool, COUNT * SVN__MAX_ENCODED_UINT_LEN);
+  const unsigned char *end;
+  const unsigned char *p;
+  apr_uint32_t seed = 0x4711;
+  apr_size_t count;
+  apr_size_t i;
+
+  /* Mix short runs of small values with values of any length. */
+  for (i = 0; i < COUNT; ++i)
+    {
+      apr_uint64_t value = ((apr_uint64_t)svn_test_rand(&seed) << 32)
+                         + svn_test_rand(&seed);
+      values[i] = (i % 3) ? value >> (value % 64) : value % 128;
+    }
+  values[0] = 0;
+  values[1] = APR_UINT64_MAX;
+
+  end = svn__leb128_encode(buffer, values, COUNT);
+
+  /* Complete round-trip. */
+  count = COUNT;
+  p = svn__leb128_decode(decoded, ends, &count, buffer, end);
+  SVN_TEST_ASSERT(p == end);
+  SVN_TEST_ASSERT(count == COUNT);
+  SVN_TEST_ASSERT(ends[COUNT - 1] == (apr_size_t)(end - buffer));
+  for (i = 0; i < COUNT; ++i)
+    SVN_TEST_ASSERT(decoded[i] == values[i]);
+
+  /* Partial decoding stops after *COUNT values. */
+  count = 17;
+  p = svn__leb128_decode(decoded, NULL, &count, buffer, end);
+  SVN_TEST_ASSERT(count == 17);
+  SVN_TEST_ASSERT(p == buffer + ends[16]);
+
+  /* An incomplete last value is not decoded. */
+  count = COUNT;
+  p = svn__leb128_decode(decoded, ends, &count, buffer, end - 1);
+  SVN_TEST_ASSERT(count == COUNT - 1);
+  SVN_TEST_ASSERT(p == buffer + ends[COUNT - 2]);
+
+  /* Values longer than SVN__MAX_ENCODED_UINT_LEN are rejected. */
+  memset(buffer + ends[49], 0xff, 2 * SVN__MAX_ENCODED_UINT_LEN);
+  count = COUNT;
+  SVN_TEST_ASSERT(!svn__leb128_decode(decoded, NULL, &count, buffer, end));
+  SVN_TEST_ASSERT(count == 50);
+  for (i = 0; i < count; ++i)
+    SVN_TEST_ASSERT(decoded[i] == values[i]);
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -572,6 +634,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test empty, nested structure"),
     SVN_TEST_PASS2(test_full_structure,
                    "test nested structure"),
+    SVN_TEST_PASS2(test_leb128_coder,
+                   "test bulk 7b/8b integer coder"),
     SVN_TEST_NULL
   };
 
@@ -21,6 +21,9 @@
  * ====================================================================
  */
 
+#include <stdio.h>
+#include <string.h>
+
 #include <apr_pools.h>
 #include <apr_thread_proc.h>
 #include <apr_thread_cond.h>
@@ -117,6 +120,59 @@ test_root_pool_concurrency(apr_pool_t *pool)
 
   return SVN_NO_ERROR;
 }
+static svn_error_t *
+test_pool_profile(apr_pool_t *pool)
+{
+  /* Explicit tag, so we can find it in the report. */
+  static const char tag[] = "root-pools-test:profile";
+  apr_pool_t *iterpool;
+  FILE *stream;
+  char line[1024];
+  svn_boolean_t found = FALSE;
+  int i;
+
+  svn_pool__profile_start();
+
+  iterpool = svn_pool_create_ex_debug(pool, NULL, tag);
+  for (i = 0; i < 10; ++i)
+    {
+      svn_pool_clear(iterpool);
+      do_some_allocations(iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  stream = tmpfile();
+  SVN_TEST_ASSERT(stream != NULL);
+  svn_pool__profile_report(stream);
+  rewind(stream);
+
+  while (fgets(line, sizeof(line), stream))
+    if (strstr(line, tag))
+      {
+        apr_uint64_t peak, total, created, cycles, live;
+
+        SVN_TEST_ASSERT(sscanf(line, "%" APR_UINT64_T_FMT
+                                     " %" APR_UINT64_T_FMT
+                                     " %" APR_UINT64_T_FMT
+                                     " %" APR_UINT64_T_FMT
+                                     " %" APR_UINT64_T_FMT,
+                               &peak, &total, &created, &cycles,
+                               &live) == 5);
+
+        /* One pool with 10 clears and one destroy. */
+        SVN_TEST_ASSERT(created == 1);
+        SVN_TEST_ASSERT(cycles == 11);
+        SVN_TEST_ASSERT(live == 0);
+        SVN_TEST_ASSERT(peak <= total);
+        found = TRUE;
+      }
+
+  fclose(stream);
+  SVN_TEST_ASSERT(found);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* The test table.  */
@@ -131,6 +187,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_SKIP2(test_root_pool_concurrency,
                    ! APR_HAS_THREADS,
                    "test concurrent root pool recycling"),
+    SVN_TEST_PASS2(test_pool_profile,
+                   "test pool allocation profiling"),
     SVN_TEST_NULL
   };
 
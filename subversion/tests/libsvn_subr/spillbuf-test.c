@@ -22,6 +22,7 @@
  */
 
 #include "svn_types.h"
+#include "svn_pools.h"
 
 #include "private/svn_subr_private.h"
 
@@ -558,6 +559,119 @@ test_spillbuf_file_attrs_spill_all(apr_pool_t *pool)
   return test_spillbuf__file_attrs(pool, TRUE, buf);
 }
 
+/* Verify that BUF spilled SPILLED bytes to disk, which have all been
+   read back by now.  */
+static svn_error_t *
+check_async_spill(svn_spillbuf_t *buf,
+                  svn_filesize_t spilled)
+{
+  svn_spillbuf_stats_t stats;
+
+  svn_spillbuf__get_stats(&stats, buf);
+  SVN_TEST_ASSERT(stats.spill_files == 1);
+  SVN_TEST_ASSERT(stats.spilled == spilled);
+  SVN_TEST_ASSERT(svn_spillbuf__get_size(buf) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_spillbuf_basic_async(apr_pool_t *pool)
+{
+  apr_size_t len = strlen(basic_data);  /* Don't include basic_data's NUL  */
+  svn_spillbuf_t *buf = svn_spillbuf__create_async(len, 10 * len, pool);
+
+  /* 10 of the 20 copies fit into memory, the others go to disk.  */
+  SVN_ERR(test_spillbuf__basic(pool, len, buf));
+  return svn_error_trace(check_async_spill(buf, 10 * len));
+}
+
+static svn_error_t *
+test_spillbuf_interleaving_async(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create_async(8 /* blocksize */,
+                                                   15 /* maxsize */,
+                                                   pool);
+
+  SVN_ERR(test_spillbuf__interleaving(pool, buf));
+  return svn_error_trace(check_async_spill(buf, 6));
+}
+
+/* Push a few MB through an asynchronous spill buffer, reading while
+   writing, and verify the contents as well as the usage statistics.  */
+static svn_error_t *
+test_spillbuf_async_stats(apr_pool_t *pool)
+{
+  enum { CHUNK = 3001, CHUNKS = 2000, BLOCKSIZE = 1000, MAXSIZE = 5000 };
+  svn_spillbuf_t *buf = svn_spillbuf__create_async(BLOCKSIZE, MAXSIZE, pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_spillbuf_stats_t stats;
+  char *chunk = apr_palloc(pool, CHUNK);
+  apr_uint64_t written = 0;
+  apr_uint64_t read = 0;
+  int i;
+
+  for (i = 0; i < CHUNKS; ++i)
+    {
+      apr_size_t k;
+
+      svn_pool_clear(iterpool);
+
+      for (k = 0; k < CHUNK; ++k)
+        chunk[k] = (char)((written + k) % 251);
+      SVN_ERR(svn_spillbuf__write(buf, chunk, CHUNK, iterpool));
+      written += CHUNK;
+
+      /* Read back at a slower pace than we write.  */
+      if (i % 2)
+        {
+          const char *readptr;
+          apr_size_t readlen;
+
+          SVN_ERR(svn_spillbuf__read(&readptr, &readlen, buf, iterpool));
+          SVN_TEST_ASSERT(readptr != NULL);
+          SVN_TEST_ASSERT(readlen > 0 && readlen <= BLOCKSIZE);
+          for (k = 0; k < readlen; ++k)
+            SVN_TEST_ASSERT(readptr[k] == (char)((read + k) % 251));
+          read += readlen;
+        }
+
+      SVN_TEST_ASSERT(svn_spillbuf__get_size(buf)
+                      == (svn_filesize_t)(written - read));
+    }
+
+  while (TRUE)
+    {
+      const char *readptr;
+      apr_size_t readlen;
+      apr_size_t k;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_spillbuf__read(&readptr, &readlen, buf, iterpool));
+      if (readptr == NULL)
+        break;
+
+      for (k = 0; k < readlen; ++k)
+        SVN_TEST_ASSERT(readptr[k] == (char)((read + k) % 251));
+      read += readlen;
+    }
+
+  SVN_TEST_ASSERT(read == written);
+  SVN_TEST_ASSERT(svn_spillbuf__get_size(buf) == 0);
+
+  svn_spillbuf__get_stats(&stats, buf);
+  SVN_TEST_ASSERT(stats.spill_files >= 1);
+  SVN_TEST_ASSERT(stats.spilled > 0);
+  SVN_TEST_ASSERT(stats.spilled <= (svn_filesize_t)written);
+  SVN_TEST_ASSERT(stats.memory_peak <= MAXSIZE + CHUNK);
+  SVN_TEST_ASSERT(stats.blocks_allocated > 0);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -589,6 +703,12 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_spillbuf_file_attrs, "check spill file properties"),
     SVN_TEST_PASS2(test_spillbuf_file_attrs_spill_all,
                    "check spill file properties (spill-all-data)"),
+    SVN_TEST_PASS2(test_spillbuf_basic_async,
+                   "basic spill buffer test (async)"),
+    SVN_TEST_PASS2(test_spillbuf_interleaving_async,
+                   "interleaving reads and writes (async)"),
+    SVN_TEST_PASS2(test_spillbuf_async_stats,
+                   "async spill buffer contents and statistics"),
     SVN_TEST_NULL
   };
 
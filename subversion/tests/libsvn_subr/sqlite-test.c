@@ -21,6 +21,9 @@
  * ====================================================================
  */
 
+#include <stdio.h>
+#include <string.h>
+
 #include "private/svn_sqlite.h"
 #include "../svn_test.h"
 
@@ -42,7 +45,7 @@ open_db(svn_sqlite__db_t **sdb,
   db_abspath = svn_dirent_join(db_dir, db_name, pool);
 
   SVN_ERR(svn_sqlite__open(sdb, db_abspath, svn_sqlite__mode_rwcreate,
-                           statements, 0, NULL, timeout, pool, pool));
+                           statements, 0, NULL, timeout, NULL, pool, pool));
 
   if (db_abspath_p)
     *db_abspath_p = db_abspath;
@@ -143,7 +146,7 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   SVN_ERR(open_db(&sdb1, &db_abspath, "txn_commit_busy",
                   statements, 250, pool));
   SVN_ERR(svn_sqlite__open(&sdb2, db_abspath, svn_sqlite__mode_readwrite,
-                           statements, 0, NULL, 250, pool, pool));
+                           statements, 0, NULL, 250, NULL, pool, pool));
   SVN_ERR(svn_sqlite__exec_statements(sdb1, 0));
 
   /* Begin two deferred transactions. */
@@ -170,6 +173,156 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sqlite_tuning(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  const char *db_abspath;
+  svn_sqlite__tuning_t tuning;
+
+  static const char *const statements[] = {
+    "PRAGMA journal_mode",
+
+    "PRAGMA cache_size",
+
+    NULL
+  };
+
+  SVN_ERR(open_db(&sdb, &db_abspath, "tuning", statements, 0, pool));
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  /* Reopen with non-default settings. */
+  tuning.wal = TRUE;
+  tuning.mmap_size = 0;
+  tuning.cache_size = 4 * 1024 * 1024;
+  SVN_ERR(svn_sqlite__open(&sdb, db_abspath, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0, &tuning, pool, pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 0));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  SVN_TEST_STRING_ASSERT(svn_sqlite__column_text(stmt, 0, NULL), "wal");
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Negative values are in KiB. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  SVN_TEST_INT_ASSERT(svn_sqlite__column_int64(stmt, 0), -4096);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  /* The default settings switch back to a rollback journal. */
+  SVN_ERR(svn_sqlite__open(&sdb, db_abspath, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0, NULL, pool, pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 0));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  SVN_TEST_STRING_ASSERT(svn_sqlite__column_text(stmt, 0, NULL), "truncate");
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sqlite_profile(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  FILE *stream;
+  char line[1024];
+  int found = 0;
+  int i;
+
+  static const char *const statements[] = {
+    "CREATE TABLE profile ("
+    "    id INTEGER PRIMARY KEY,"
+    "    value TEXT"
+    ")",
+
+    "INSERT INTO profile(id, value) VALUES (?1, ?2)",
+
+    "SELECT value FROM profile ORDER BY value",
+
+    NULL
+  };
+
+  svn_sqlite__profile_start();
+
+  SVN_ERR(open_db(&sdb, NULL, "profile", statements, 0, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+
+  /* 5 executions of one step each. */
+  for (i = 0; i < 5; i++)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+      SVN_ERR(svn_sqlite__bindf(stmt, "is", (apr_int64_t)i,
+                                apr_psprintf(pool, "value %d", 5 - i)));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  /* A single execution returning 5 rows, i.e. 6 steps, with a table
+     scan and a sort. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+  do
+    SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Statistics get merged into the report when closing the connection. */
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  stream = tmpfile();
+  SVN_TEST_ASSERT(stream != NULL);
+  svn_sqlite__profile_report(stream);
+  rewind(stream);
+
+  while (fgets(line, sizeof(line), stream))
+    {
+      char name[64];
+      char stmt_name[16];
+      apr_uint64_t executions, steps, rows, scan_steps, sorts;
+
+      if (sscanf(line, "%63s %15s %" APR_UINT64_T_FMT
+                       " %" APR_UINT64_T_FMT " %" APR_UINT64_T_FMT
+                       " %" APR_UINT64_T_FMT " %" APR_UINT64_T_FMT,
+                 name, stmt_name, &executions, &steps, &rows,
+                 &scan_steps, &sorts) != 7
+          || strcmp(name, "profile") != 0)
+        continue;
+
+      if (strcmp(stmt_name, "0") == 0)
+        {
+          SVN_TEST_ASSERT(executions == 1);
+          found |= 1;
+        }
+      else if (strcmp(stmt_name, "1") == 0)
+        {
+          SVN_TEST_ASSERT(executions == 5);
+          SVN_TEST_ASSERT(steps == 5);
+          SVN_TEST_ASSERT(rows == 0);
+          found |= 2;
+        }
+      else if (strcmp(stmt_name, "2") == 0)
+        {
+          SVN_TEST_ASSERT(executions == 1);
+          SVN_TEST_ASSERT(steps == 6);
+          SVN_TEST_ASSERT(rows == 5);
+          SVN_TEST_ASSERT(scan_steps > 0);
+          SVN_TEST_ASSERT(sorts == 1);
+          found |= 4;
+        }
+    }
+
+  fclose(stream);
+  SVN_TEST_INT_ASSERT(found, 7);
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = 1;
 
@@ -180,6 +333,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_tuning,
+                   "sqlite connection tuning"),
+    SVN_TEST_PASS2(test_sqlite_profile,
+                   "sqlite statement profiling"),
     SVN_TEST_NULL
   };
 
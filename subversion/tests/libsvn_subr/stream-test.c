@@ -1000,6 +1000,62 @@ test_stream_readline_file_crlf(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_stream_copy_file(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *src_file, *dst_file, *copy_file;
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *expected;
+  svn_stringbuf_t *actual;
+  svn_stream_t *src, *dst;
+  char buffer[10];
+  apr_size_t len;
+  int i;
+
+  SVN_ERR(svn_dirent_get_absolute(&tmp_dir, "test_stream_copy_file", pool));
+  SVN_ERR(svn_io_remove_dir2(tmp_dir, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_make_dir_recursively(tmp_dir, pool));
+  svn_test_add_dir_cleanup(tmp_dir);
+
+  /* Make the file larger than the buffers used by the read/write
+   * fallback, so that it is copied in more than one piece there. */
+  for (i = 0; i < 10000; i++)
+    svn_stringbuf_appendcstr(data,
+                             apr_psprintf(pool, "line %d of the source\n", i));
+
+  src_file = svn_dirent_join(tmp_dir, "src", pool);
+  dst_file = svn_dirent_join(tmp_dir, "dst", pool);
+  copy_file = svn_dirent_join(tmp_dir, "copy", pool);
+  SVN_ERR(svn_io_file_create(src_file, data->data, pool));
+
+  /* Copy between two file streams that have already been read from and
+   * written to, respectively.  The copy must continue at the current
+   * positions of both. */
+  SVN_ERR(svn_stream_open_readonly(&src, src_file, pool, pool));
+  len = sizeof(buffer);
+  SVN_ERR(svn_stream_read_full(src, buffer, &len));
+  SVN_TEST_ASSERT(len == sizeof(buffer));
+
+  SVN_ERR(svn_stream_open_writable(&dst, dst_file, pool, pool));
+  SVN_ERR(svn_stream_puts(dst, "prefix"));
+
+  SVN_ERR(svn_stream_copy3(src, dst, NULL, NULL, pool));
+
+  expected = svn_stringbuf_create("prefix", pool);
+  svn_stringbuf_appendbytes(expected, data->data + sizeof(buffer),
+                            data->len - sizeof(buffer));
+  SVN_ERR(svn_stringbuf_from_file2(&actual, dst_file, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual, expected));
+
+  /* Plain file copies. */
+  SVN_ERR(svn_io_copy_file(src_file, copy_file, FALSE, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&actual, copy_file, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual, data));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1037,6 +1093,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading LF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_crlf,
                    "test reading CRLF-terminated lines from file"),
+    SVN_TEST_PASS2(test_stream_copy_file,
+                   "test copying between file streams"),
     SVN_TEST_NULL
   };
 
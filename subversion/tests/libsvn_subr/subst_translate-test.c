@@ -500,6 +500,93 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Translate a few thousand lines with keywords and the EOLs chosen by
+ * EOL_FOR_LINE, which returns the source EOL for line number I, to EOL_STR
+ * and compare the result with what we expect.  Use POOL for allocations. */
+static svn_error_t *
+test_one_long_translation(const char *(*eol_for_line)(int i),
+                          const char *eol_str,
+                          svn_boolean_t repair,
+                          apr_pool_t *pool)
+{
+  svn_stringbuf_t *source = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  apr_hash_t *keywords = apr_hash_make(pool);
+  const char *result;
+  int i, k;
+
+  svn_hash_sets(keywords, "Rev", svn_string_create("42", pool));
+
+  for (i = 0; i < 5000; i++)
+    {
+      /* Lines of varying length, so that EOLs hit all positions within
+       * any block size that the implementation might use. */
+      for (k = 0; k < (i * 7) % 61; k++)
+        {
+          svn_stringbuf_appendbyte(source, (char)('a' + k % 26));
+          svn_stringbuf_appendbyte(expected, (char)('a' + k % 26));
+        }
+
+      if (i % 37 == 0)
+        {
+          svn_stringbuf_appendcstr(source, " $Rev$ $ $Rev: 1 $");
+          svn_stringbuf_appendcstr(expected, " $Rev: 42 $ $ $Rev: 42 $");
+        }
+
+      svn_stringbuf_appendcstr(source, eol_for_line(i));
+      svn_stringbuf_appendcstr(expected, eol_str);
+    }
+
+  SVN_ERR(svn_subst_translate_cstring2(source->data, &result, eol_str,
+                                       repair, keywords, TRUE, pool));
+  SVN_TEST_STRING_ASSERT(result, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* EOL_FOR_LINE callbacks for test_one_long_translation(). */
+static const char *
+crlf_eol(int i)
+{
+  return "\r\n";
+}
+
+static const char *
+lf_eol(int i)
+{
+  return "\n";
+}
+
+static const char *
+mixed_eol(int i)
+{
+  if (i % 101 == 0)
+    return "\n";
+  if (i % 211 == 0)
+    return "\r";
+
+  return "\r\n";
+}
+
+static svn_error_t *
+test_svn_subst_translate_long_runs(apr_pool_t *pool)
+{
+  /* EOLs that are already in the target format. */
+  SVN_ERR(test_one_long_translation(crlf_eol, "\r\n", FALSE, pool));
+  SVN_ERR(test_one_long_translation(lf_eol, "\n", FALSE, pool));
+
+  /* EOLs that need translation. */
+  SVN_ERR(test_one_long_translation(crlf_eol, "\n", FALSE, pool));
+  SVN_ERR(test_one_long_translation(lf_eol, "\r", FALSE, pool));
+
+  /* Inconsistent EOLs, most of which are already in the target format. */
+  SVN_ERR(test_one_long_translation(mixed_eol, "\r\n", TRUE, pool));
+  SVN_ERR(test_one_long_translation(mixed_eol, "\n", TRUE, pool));
+  SVN_ERR(test_one_long_translation(mixed_eol, "\r", TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +606,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_translate_long_runs,
+                   "test translating long runs of lines"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,254 @@
+/*
+ * task-test.c -- test the ordered task queue
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_task.h"
+
+#include "../svn_test.h"
+
+/* Number of tasks to run per test case. */
+#define TASK_COUNT 500
+
+/* Shared state of all tasks in a test case. */
+typedef struct output_t
+{
+  /* Task indexes in the order in which they have been output. */
+  int order[TASK_COUNT];
+  int count;
+} output_t;
+
+/* Baton of a single task. */
+typedef struct task_baton_t
+{
+  int index;
+
+  /* If set, the process step shall fail. */
+  svn_boolean_t fail;
+
+  output_t *output;
+} task_baton_t;
+
+/* Implements svn_task__process_func_t.  Do some busy work, so that tasks
+ * take different amounts of time, and return the square of the index. */
+static svn_error_t *
+square_index(void **result,
+             void *task_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  task_baton_t *baton = task_baton;
+  apr_int64_t *square = apr_palloc(result_pool, sizeof(*square));
+  int i;
+
+  for (i = 0; i < (baton->index * 7919) % 97; ++i)
+    apr_palloc(scratch_pool, 1000);
+
+  if (baton->fail)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Task %d failed", baton->index);
+
+  *square = (apr_int64_t)baton->index * baton->index;
+  *result = square;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Verify RESULT and record the
+ * order in which we got called. */
+static svn_error_t *
+record_output(void *result,
+              void *task_baton,
+              apr_pool_t *scratch_pool)
+{
+  task_baton_t *baton = task_baton;
+  apr_int64_t *square = result;
+
+  SVN_TEST_ASSERT(*square == (apr_int64_t)baton->index * baton->index);
+  SVN_TEST_ASSERT(baton->output->count < TASK_COUNT);
+  baton->output->order[baton->output->count++] = baton->index;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add a task with INDEX to QUEUE and make it fail if FAIL is set. */
+static svn_error_t *
+add_task(svn_task__queue_t *queue,
+         output_t *output,
+         int index,
+         svn_boolean_t fail,
+         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *task_pool = svn_pool_create(NULL);
+  task_baton_t *baton = apr_pcalloc(task_pool, sizeof(*baton));
+
+  baton->index = index;
+  baton->fail = fail;
+  baton->output = output;
+
+  return svn_error_trace(svn_task__queue_add(queue, square_index,
+                                             record_output, baton,
+                                             task_pool, scratch_pool));
+}
+
+/* Run TASK_COUNT tasks through a queue with THREAD_COUNT threads and
+ * verify that they get output in order. */
+static svn_error_t *
+run_ordered(int thread_count,
+            apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  output_t *output = apr_pcalloc(pool, sizeof(*output));
+  int i;
+
+  SVN_ERR(svn_task__queue_create(&queue, thread_count, 0, pool));
+
+  for (i = 0; i < TASK_COUNT; ++i)
+    {
+      SVN_ERR(add_task(queue, output, i, FALSE, pool));
+
+      /* The queue must never hold back more tasks than it allows to be
+       * pending. */
+      SVN_TEST_ASSERT(output->count > i - 2 * MAX(thread_count, 1));
+    }
+
+  SVN_ERR(svn_task__queue_drain(queue, pool));
+
+  SVN_TEST_INT_ASSERT(output->count, TASK_COUNT);
+  for (i = 0; i < TASK_COUNT; ++i)
+    SVN_TEST_INT_ASSERT(output->order[i], i);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sequential_queue(apr_pool_t *pool)
+{
+  return svn_error_trace(run_ordered(1, pool));
+}
+
+static svn_error_t *
+test_concurrent_queue(apr_pool_t *pool)
+{
+  return svn_error_trace(run_ordered(8, pool));
+}
+
+static svn_error_t *
+test_queue_error(apr_pool_t *pool)
+{
+  enum { FAILING_TASK = 50 };
+  svn_task__queue_t *queue;
+  output_t *output = apr_pcalloc(pool, sizeof(*output));
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_task__queue_create(&queue, 4, 0, pool));
+
+  for (i = 0; i < TASK_COUNT && !err; ++i)
+    err = add_task(queue, output, i, i == FAILING_TASK, pool);
+
+  if (!err)
+    err = svn_task__queue_drain(queue, pool);
+
+  /* The error must be reported and all tasks preceding the failed one
+   * must have been output.  Tasks still in the queue get discarded when
+   * POOL gets cleaned up. */
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_TEST_FAILED);
+  SVN_TEST_INT_ASSERT(output->count, FAILING_TASK);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_queue_discard(apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  output_t *output = apr_pcalloc(pool, sizeof(*output));
+  int i;
+
+  SVN_ERR(svn_task__queue_create(&queue, 4, TASK_COUNT, queue_pool));
+  for (i = 0; i < TASK_COUNT; ++i)
+    SVN_ERR(add_task(queue, output, i, FALSE, pool));
+
+  /* Destroying the queue without draining it must not output anything
+   * nor leak threads or tasks. */
+  svn_pool_destroy(queue_pool);
+  SVN_TEST_INT_ASSERT(output->count, 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_queue_wait(apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  output_t *output = apr_pcalloc(pool, sizeof(*output));
+  int i;
+
+  SVN_ERR(svn_task__queue_create(&queue, 4, 0, pool));
+
+  /* Nothing to wait for. */
+  SVN_ERR(svn_task__queue_wait(queue, pool));
+
+  for (i = 0; i < TASK_COUNT; ++i)
+    SVN_ERR(add_task(queue, output, i, FALSE, pool));
+
+  /* Every call waits for at least one task, so this must terminate
+   * with all tasks output in order. */
+  for (i = 0; output->count < TASK_COUNT; ++i)
+    {
+      SVN_TEST_ASSERT(i <= TASK_COUNT);
+      SVN_ERR(svn_task__queue_wait(queue, pool));
+    }
+
+  for (i = 0; i < TASK_COUNT; ++i)
+    SVN_TEST_INT_ASSERT(output->order[i], i);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_sequential_queue,
+                   "test sequential task execution"),
+    SVN_TEST_PASS2(test_concurrent_queue,
+                   "test concurrent task execution order"),
+    SVN_TEST_PASS2(test_queue_error,
+                   "test task error reporting"),
+    SVN_TEST_PASS2(test_queue_discard,
+                   "test discarding pending tasks"),
+    SVN_TEST_PASS2(test_queue_wait,
+                   "test waiting for some tasks"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
@@ -216,6 +216,103 @@ utf_validate2(apr_pool_t *pool)
 }
 
 /* Test conversion from different codepages to utf8. */
+/* Append the UTF-8 encoding of code point CP to BUF at *LEN. */
+static void
+append_code_point(char *buf, apr_size_t *len, apr_uint32_t cp)
+{
+  unsigned char *p = (unsigned char *)buf + *len;
+
+  if (cp < 0x80)
+    {
+      p[0] = (unsigned char)cp;
+      *len += 1;
+    }
+  else if (cp < 0x800)
+    {
+      p[0] = (unsigned char)(0xc0 | (cp >> 6));
+      p[1] = (unsigned char)(0x80 | (cp & 0x3f));
+      *len += 2;
+    }
+  else if (cp < 0x10000)
+    {
+      p[0] = (unsigned char)(0xe0 | (cp >> 12));
+      p[1] = (unsigned char)(0x80 | ((cp >> 6) & 0x3f));
+      p[2] = (unsigned char)(0x80 | (cp & 0x3f));
+      *len += 3;
+    }
+  else
+    {
+      p[0] = (unsigned char)(0xf0 | (cp >> 18));
+      p[1] = (unsigned char)(0x80 | ((cp >> 12) & 0x3f));
+      p[2] = (unsigned char)(0x80 | ((cp >> 6) & 0x3f));
+      p[3] = (unsigned char)(0x80 | (cp & 0x3f));
+      *len += 4;
+    }
+}
+
+/* Compare the validation functions on long, mostly valid strings, which
+   exercise the block-wise checks rather than the state machine alone. */
+static svn_error_t *
+utf_validate3(apr_pool_t *pool)
+{
+  /* Bytes that start or end invalid sequences in interesting ways. */
+  static const unsigned char special[] =
+    { 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0, 0xc1, 0xc2,
+      0xe0, 0xed, 0xef, 0xf0, 0xf4, 0xf5, 0xff };
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 20000; ++i)
+    {
+      char str[256];
+      apr_size_t len = 0;
+      apr_size_t target = range_rand(0, 200);
+      int errors = range_rand(0, 3);
+      const char *last;
+
+      /* A valid string with a mix of 1 to 4 byte characters, including
+         the (invalid) surrogates range. */
+      while (len < target)
+        {
+          switch (range_rand(0, 3))
+            {
+            case 0:
+              append_code_point(str, &len, range_rand(0, 0x7f));
+              break;
+            case 1:
+              append_code_point(str, &len, range_rand(0x80, 0x7ff));
+              break;
+            case 2:
+              append_code_point(str, &len, range_rand(0x800, 0xffff));
+              break;
+            default:
+              append_code_point(str, &len, range_rand(0x10000, 0x10ffff));
+              break;
+            }
+        }
+
+      /* Damage it a bit. */
+      while (errors-- > 0 && len > 0)
+        {
+          apr_size_t pos = range_rand(0, (apr_uint32_t)len - 1);
+
+          if (range_rand(0, 1))
+            str[pos] = (char)special[range_rand(0, sizeof(special) - 1)];
+          else
+            len = pos;
+        }
+
+      last = svn_utf__last_valid2(str, len);
+      if (svn_utf__last_valid(str, len) != last
+          || svn_utf__is_valid(str, len) != (last == str + len))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "is_valid3 test %d failed", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
 {
@@ -1010,6 +1107,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate3,
+                   "test validation of long strings"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,